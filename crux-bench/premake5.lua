@@ -0,0 +1,59 @@
+project "crux-bench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+
+    staticruntime "On"
+
+    targetdir (BinDir.. "/%{prj.name}")
+    objdir (TmpDir.. "/%{prj.name}")
+
+    files {
+        "src/**.h",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "src",
+
+        "%{wks.location}/include",
+        "%{wks.location}/crux-common/include"
+    }
+
+    links {
+        "crux-render-sw",
+        "crux-window",
+        "crux-common"
+    }
+
+    -- The startup benchmark loads copies of the stub library
+    dependson {
+        "crux-bench-stub"
+    }
+
+    filter "system:linux"
+        links {
+            "X11",
+            "Xext",
+            "dl",
+            "pthread"
+        }
+
+    filter ""
+
+-- Stand-in for a plugin or optional system module, built next to crux-bench
+project "crux-bench-stub"
+    kind "SharedLib"
+    language "C++"
+    cppdialect "C++20"
+
+    staticruntime "On"
+
+    targetdir (BinDir.. "/crux-bench")
+    objdir (TmpDir.. "/%{prj.name}")
+
+    files {
+        "stub/**.cpp"
+    }
+
+    filter ""
@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+namespace crux::bench {
+	void Harness::Record(const std::string& name, std::size_t itemsPerCall, std::uint64_t iterations, std::vector<double>& samples) {
+		std::sort(samples.begin(), samples.end());
+
+		Result result;
+		result.name = name;
+		result.itemsPerCall = itemsPerCall;
+		result.iterations = iterations;
+		result.bestNsPerItem = samples.front();
+		result.medianNsPerItem = samples[samples.size() / 2];
+		results.push_back(result);
+
+		printf("%-48s %12.3f ns/item (median %.3f)\n", name.c_str(), result.bestNsPerItem, result.medianNsPerItem);
+		fflush(stdout);
+	}
+
+	void Harness::Fail(const std::string& name, const std::string& reason) {
+		++failures;
+		printf("%-48s FAILED, %s\n", name.c_str(), reason.c_str());
+		fflush(stdout);
+	}
+
+	namespace {
+		void WriteEscaped(FILE* out, const std::string& text) {
+			for (char c : text) {
+				if (c == '"' || c == '\\')
+					fprintf(out, "\\%c", c);
+				else if ((unsigned char)c < 0x20)
+					fprintf(out, "\\u%04x", (unsigned)c);
+				else
+					fputc(c, out);
+			}
+		}
+	}
+
+	void Harness::Print() const {
+		printf("\n%-48s %14s %14s %12s\n", "benchmark", "best ns/item", "median", "items/call");
+		for (const auto& r : results)
+			printf("%-48s %14.3f %14.3f %12zu\n", r.name.c_str(), r.bestNsPerItem, r.medianNsPerItem, r.itemsPerCall);
+	}
+
+	bool Harness::WriteJson(const std::string& path) const {
+		FILE* out = fopen(path.c_str(), "wb");
+		if (!out)
+			return false;
+
+		char date[32] = "";
+		const std::time_t now = std::time(nullptr);
+		if (const std::tm* utc = std::gmtime(&now))
+			std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", utc);
+
+#if defined(NDEBUG)
+		const char* buildType = "release";
+#else
+		const char* buildType = "debug";
+#endif
+
+		fprintf(out, "{\n  \"context\": {\n");
+		fprintf(out, "    \"date\": \"%s\",\n", date);
+		fprintf(out, "    \"executable\": \"crux-bench\",\n");
+		fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+		fprintf(out, "    \"library_build_type\": \"%s\"\n", buildType);
+		fprintf(out, "  },\n  \"benchmarks\": [");
+
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			fprintf(out, "%s\n    {\"name\": \"", i ? "," : "");
+			WriteEscaped(out, r.name);
+			fprintf(out, "\", \"run_name\": \"");
+			WriteEscaped(out, r.name);
+			fprintf(out, "\", \"run_type\": \"iteration\", \"iterations\": %llu, \"real_time\": %.4f, \"cpu_time\": %.4f, \"time_unit\": \"ns\", "
+				"\"items_per_call\": %zu, \"median_ns_per_item\": %.4f, \"items_per_second\": %.1f}",
+				(unsigned long long)r.iterations, r.bestNsPerItem, r.bestNsPerItem, r.itemsPerCall, r.medianNsPerItem,
+				r.bestNsPerItem > 0.0 ? 1e9 / r.bestNsPerItem : 0.0);
+		}
+
+		fprintf(out, "\n  ]\n}\n");
+		const bool written = !ferror(out);
+		return fclose(out) == 0 && written;
+	}
+}
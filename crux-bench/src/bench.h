@@ -0,0 +1,173 @@
+#pragma once
+
+/*
+ * Small self-contained benchmark harness for the crux libraries.
+ * Each suite registers its cases through a Harness, which times them
+ * and prints a summary table once everything has run.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace crux::bench {
+	/**
+	 * @brief Prevents the compiler from discarding a computed value.
+	 * @param value Value, or memory, that must be considered observed
+	*/
+	template<typename T>
+	inline void DoNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+		static volatile const void* sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r"(&value) : "memory");
+#endif
+	}
+
+	/**
+	 * @brief Timing result of a single benchmark case.
+	*/
+	struct Result {
+		// Suite and case name, ie. "vector2/add/batch"
+		std::string name;
+
+		// Items processed per call of the benchmark body
+		std::size_t itemsPerCall = 1;
+
+		// Calls made per timed sample
+		std::uint64_t iterations = 0;
+
+		// Best (lowest) nanoseconds per item across the samples
+		double bestNsPerItem = 0.0;
+
+		// Median nanoseconds per item across the samples
+		double medianNsPerItem = 0.0;
+	};
+
+	/**
+	 * @brief Runs and records benchmark cases.
+	*/
+	class Harness {
+	public:
+		/**
+		 * @brief Construct a harness.
+		 * @param filter Only cases whose name contains this string are run. Empty runs all.
+		*/
+		Harness(const std::string& filter = "") : filter(filter) {}
+
+		/**
+		 * @brief Times the given callable.
+		 * The call count is calibrated so each sample runs for a few milliseconds,
+		 * then several samples are taken to report the best and median.
+		 * @param name Case name, used for filtering and reporting
+		 * @param itemsPerCall How many items a single call processes, for per-item timings
+		 * @param fn Benchmark body
+		*/
+		template<typename Fn>
+		void Run(const std::string& name, std::size_t itemsPerCall, Fn&& fn) {
+			if (!filter.empty() && name.find(filter) == std::string::npos)
+				return;
+
+			using clock = std::chrono::steady_clock;
+			constexpr int SampleCount = 7;
+			constexpr double SampleTargetNs = 20'000'000.0;
+
+			//Calibrate iterations per sample, doubling until a sample is long enough
+			std::uint64_t iterations = 1;
+			for (;;) {
+				auto start = clock::now();
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					fn();
+				double elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+				if (elapsed >= SampleTargetNs * 0.5 || iterations >= (1ull << 30))
+					break;
+				iterations *= 2;
+			}
+
+			std::vector<double> samples;
+			samples.reserve(SampleCount);
+			for (int s = 0; s < SampleCount; ++s) {
+				auto start = clock::now();
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					fn();
+				double elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+				samples.push_back(elapsed / ((double)iterations * (double)itemsPerCall));
+			}
+
+			Record(name, itemsPerCall, iterations, samples);
+		}
+
+		/**
+		 * @brief Records a case that times itself.
+		 * For work that can not run back to back in a loop, ie. because every
+		 * run needs a setup or teardown that must stay out of the timing.
+		 * @param name Case name, used for filtering and reporting
+		 * @param sampleCount Number of runs
+		 * @param fn Runs the case once, returning the nanoseconds the timed part took
+		*/
+		template<typename Fn>
+		void RunTimed(const std::string& name, int sampleCount, Fn&& fn) {
+			if (!filter.empty() && name.find(filter) == std::string::npos)
+				return;
+
+			std::vector<double> samples;
+			samples.reserve(sampleCount);
+			for (int s = 0; s < sampleCount; ++s)
+				samples.push_back((double)fn());
+
+			Record(name, 1, 1, samples);
+		}
+
+		/**
+		 * @brief Reports a correctness check that did not hold.
+		 * Checks run regardless of the filter, and any failure makes crux-bench exit nonzero.
+		 * @param name Case or check name
+		 * @param reason What went wrong
+		*/
+		void Fail(const std::string& name, const std::string& reason);
+
+		// @return Every result recorded so far, in run order
+		const std::vector<Result>& GetResults() const { return results; }
+
+		// @return Number of failed correctness checks
+		std::size_t GetFailureCount() const { return failures; }
+
+		// Prints a table of all results to stdout
+		void Print() const;
+
+		/**
+		 * @brief Writes all results as JSON, laid out like Google Benchmark's
+		 * --benchmark_format=json so CI tooling for it can track them across commits.
+		 * real_time and cpu_time are the best ns per item, median_ns_per_item is added.
+		 * @param path Output file
+		 * @return False if the file could not be written
+		*/
+		bool WriteJson(const std::string& path) const;
+
+	private:
+		void Record(const std::string& name, std::size_t itemsPerCall, std::uint64_t iterations, std::vector<double>& samples);
+
+		std::string filter;
+		std::vector<Result> results;
+		std::size_t failures = 0;
+	};
+
+	// Suites, each defined in their own bench_*.cpp file
+	void RunVector2(Harness& harness);
+	void RunMatrix(Harness& harness);
+	void RunJobs(Harness& harness);
+	void RunAllocators(Harness& harness);
+	void RunStartup(Harness& harness);
+	void RunStrings(Harness& harness);
+	void RunLibraries(Harness& harness);
+	void RunWindow(Harness& harness);
+	void RunRender(Harness& harness);
+}
@@ -0,0 +1,97 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include <crux-common/allocators.h>
+
+namespace crux::bench {
+	namespace {
+		// Allocations per benchmark call, roughly a frame's worth of small temporaries
+		constexpr std::size_t Count = 4096;
+
+		// Mixed small sizes, fixed so every allocator sees the same sequence
+		std::vector<std::size_t> MakeSizes() {
+			std::vector<std::size_t> sizes(Count);
+			std::uint32_t state = 0x12345678u;
+			for (std::size_t& size : sizes) {
+				state = state * 1664525u + 1013904223u;
+				size = 8 + (state >> 24);
+			}
+			return sizes;
+		}
+	}
+
+	void RunAllocators(Harness& harness) {
+		const std::vector<std::size_t> sizes = MakeSizes();
+		std::vector<void*> ptrs(Count);
+
+		//Allocate a frame's worth then free it all, the arena's use case
+		harness.Run("allocators/frame/malloc", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i)
+				ptrs[i] = std::malloc(sizes[i]);
+			DoNotOptimize(ptrs);
+			for (std::size_t i = 0; i < Count; ++i)
+				std::free(ptrs[i]);
+		});
+
+		memory::Arena arena;
+		harness.Run("allocators/frame/arena", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i)
+				ptrs[i] = arena.Allocate(sizes[i]);
+			DoNotOptimize(ptrs);
+			arena.Reset();
+		});
+
+		memory::Tlsf tlsf;
+		harness.Run("allocators/frame/tlsf", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i)
+				ptrs[i] = tlsf.Allocate(sizes[i]);
+			DoNotOptimize(ptrs);
+			for (std::size_t i = 0; i < Count; ++i)
+				tlsf.Free(ptrs[i]);
+		});
+
+		//Fixed-size objects freed in a different order than allocated
+		constexpr std::size_t ObjectSize = 64;
+		harness.Run("allocators/fixed/new", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i)
+				ptrs[i] = ::operator new(ObjectSize);
+			DoNotOptimize(ptrs);
+			for (std::size_t i = 0; i < Count; i += 2)
+				::operator delete(ptrs[i]);
+			for (std::size_t i = 1; i < Count; i += 2)
+				::operator delete(ptrs[i]);
+		});
+
+		memory::Pool pool(ObjectSize);
+		harness.Run("allocators/fixed/pool", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i)
+				ptrs[i] = pool.Allocate();
+			DoNotOptimize(ptrs);
+			for (std::size_t i = 0; i < Count; i += 2)
+				pool.Free(ptrs[i]);
+			for (std::size_t i = 1; i < Count; i += 2)
+				pool.Free(ptrs[i]);
+		});
+
+		//Standard containers through the pmr adapters
+		harness.Run("allocators/pmr_vector/default", Count, [&] {
+			std::pmr::vector<int> values;
+			for (std::size_t i = 0; i < Count; ++i)
+				values.push_back((int)i);
+			DoNotOptimize(values);
+		});
+
+		memory::ArenaResource arenaResource(arena);
+		harness.Run("allocators/pmr_vector/arena", Count, [&] {
+			{
+				std::pmr::vector<int> values(&arenaResource);
+				for (std::size_t i = 0; i < Count; ++i)
+					values.push_back((int)i);
+				DoNotOptimize(values);
+			}
+			arena.Reset();
+		});
+	}
+}
@@ -0,0 +1,95 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <vector>
+
+#include <crux-common/clock.h>
+#include <crux-common/jobs.h>
+
+namespace crux::bench {
+	namespace {
+		// Jobs per ParallelFor call, enough to keep every thread busy for a few milliseconds
+		constexpr std::size_t JobCount = 2048;
+
+		// Target length of a single job
+		constexpr uint64bit JobNs = 10'000;
+
+		// Dependent arithmetic the compiler can not vectorize or fold away
+		inline uint64bit Work(uint64bit seed, uint64bit rounds) {
+			uint64bit x = seed | 1;
+			for (uint64bit i = 0; i < rounds; ++i)
+				x = x * 6364136223846793005ull + 1442695040888963407ull;
+			return x;
+		}
+
+		// @return Rounds of Work() taking roughly JobNs on this machine
+		uint64bit CalibrateRounds() {
+			uint64bit rounds = 1024;
+			for (;;) {
+				const uint64bit start = clock::Now();
+				DoNotOptimize(Work(start, rounds));
+				const uint64bit elapsed = clock::Now() - start;
+				if (elapsed >= 1'000'000 || rounds >= (1ull << 32))
+					return rounds * JobNs / (elapsed ? elapsed : 1);
+				rounds *= 2;
+			}
+		}
+
+		// Thread counts to measure, doubling up to the hardware concurrency
+		std::vector<uint> ThreadCounts() {
+			const uint hardware = JobSystem::DefaultWorkerCount() + 1;
+			std::vector<uint> counts;
+			for (uint n = 1; n < hardware; n *= 2)
+				counts.push_back(n);
+			counts.push_back(hardware);
+			return counts;
+		}
+	}
+
+	void RunJobs(Harness& harness) {
+		const uint64bit rounds = CalibrateRounds();
+		std::vector<uint64bit> results(JobCount);
+
+		struct Scaling {
+			uint threads;
+			std::string name;
+		};
+		std::vector<Scaling> scaling;
+
+		for (uint threads : ThreadCounts()) {
+			JobSystem jobs(threads - 1);
+
+			const std::string name = "jobs/parallel_for/10us/threads=" + std::to_string(threads);
+			harness.Run(name, JobCount, [&] {
+				jobs.ParallelFor(0, JobCount, 1, [&](std::size_t first, std::size_t last) {
+					for (std::size_t i = first; i < last; ++i)
+						results[i] = Work(i, rounds);
+				});
+				DoNotOptimize(results);
+			});
+			scaling.push_back({ threads, name });
+		}
+
+		//Speedup over the single thread run, ideal is equal to the thread count
+		const std::vector<Result>& all = harness.GetResults();
+		auto find = [&](const std::string& name) -> const Result* {
+			for (const Result& r : all)
+				if (r.name == name)
+					return &r;
+			return nullptr;
+		};
+
+		const Result* single = scaling.empty() ? nullptr : find(scaling.front().name);
+		if (!single)
+			return;
+
+		printf("\njob scaling (10us jobs)\n%-10s %10s %12s\n", "threads", "speedup", "efficiency");
+		for (const Scaling& s : scaling) {
+			if (const Result* r = find(s.name)) {
+				const double speedup = single->bestNsPerItem / r->bestNsPerItem;
+				printf("%-10u %10.2fx %11.1f%%\n", s.threads, speedup, 100.0 * speedup / (double)s.threads);
+			}
+		}
+		fflush(stdout);
+	}
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <string_view>
+
+#include <crux-common/dynamic_library.h>
+#include <crux-common/platform.h>
+
+namespace crux::bench {
+	namespace {
+		// A library every install has, and symbols it exports
+#if CRUX_WIN32
+		constexpr const char* LibraryName = "kernel32.dll";
+		constexpr std::string_view Symbols[] = { "GetTickCount", "GetLastError", "Sleep", "GetCurrentThreadId" };
+#else
+		constexpr const char* LibraryName = "libm.so.6";
+		constexpr std::string_view Symbols[] = { "cos", "sin", "sqrt", "atan2" };
+#endif
+
+		constexpr std::size_t SymbolCount = sizeof(Symbols) / sizeof(Symbols[0]);
+	}
+
+	void RunLibraries(Harness& harness) {
+		auto library = DynamicLibrary::Load(LibraryName);
+		if (!library) {
+			printf("%-48s skipped, %s did not load\n", "library", LibraryName);
+			return;
+		}
+
+		harness.Run("library/find", 1, [&] {
+			DoNotOptimize(DynamicLibrary::Find(LibraryName));
+		});
+
+		//Hits the per-library cache after the first call
+		harness.Run("library/symbol/cached", 1, [&] {
+			DoNotOptimize(library->GetSymbol(Symbols[0]));
+		});
+
+		//Missing symbols are cached too
+		harness.Run("library/symbol/missing", 1, [&] {
+			DoNotOptimize(library->GetSymbol("crux_not_exported"));
+		});
+
+		void* addresses[SymbolCount];
+		harness.Run("library/symbols/batch", SymbolCount, [&] {
+			DoNotOptimize(library->GetSymbols(Symbols, addresses));
+			DoNotOptimize(addresses);
+		});
+
+		//What every lookup cost before the cache, straight to dlsym()/GetProcAddress()
+		harness.Run("library/symbol/native", 1, [&] {
+#if CRUX_WIN32
+			DoNotOptimize(internal::win32::FindLibrarySymbol(library->GetNativeHandle(), "GetTickCount"));
+#elif CRUX_UNIX
+			DoNotOptimize(internal::nix::FindLibrarySymbol(library->GetNativeHandle(), "cos"));
+#endif
+		});
+
+		//The name keyed map behind the older LoadNixLibrary()/LoadWinLibrary() API
+#if CRUX_WIN32
+		internal::win32::LoadWinLibrary(LibraryName);
+		harness.Run("library/platform_map/get", 1, [&] {
+			DoNotOptimize(internal::win32::GetWinLibrary(LibraryName));
+		});
+#elif CRUX_UNIX
+		internal::nix::LoadNixLibrary(LibraryName);
+		harness.Run("library/platform_map/get", 1, [&] {
+			DoNotOptimize(internal::nix::GetNixLibrary(LibraryName));
+		});
+#endif
+	}
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <vector>
+
+#include <crux-common/types.h>
+#include <crux-common/matrix4x4_batch.h>
+
+namespace crux::bench {
+	namespace {
+		// Scalar reference, a plain column-major 4x4 multiply with no intrinsics
+		void ReferenceMultiply(const float* a, const float* b, float* out) {
+			for (int col = 0; col < 4; ++col)
+				for (int row = 0; row < 4; ++row)
+					out[col * 4 + row] = a[row] * b[col * 4] + a[4 + row] * b[col * 4 + 1] + a[8 + row] * b[col * 4 + 2] + a[12 + row] * b[col * 4 + 3];
+		}
+
+		// Scalar reference point transform, one vertex at a time
+		void ReferenceTransformPoints(const mat4f& m, const vec3f* in, vec3f* out, std::size_t n) {
+			for (std::size_t i = 0; i < n; ++i) {
+				const vec3f p = in[i];
+				out[i].x = m[0].x * p.x + m[1].x * p.y + m[2].x * p.z + m[3].x;
+				out[i].y = m[0].y * p.x + m[1].y * p.y + m[2].y * p.z + m[3].y;
+				out[i].z = m[0].z * p.x + m[1].z * p.y + m[2].z * p.z + m[3].z;
+			}
+		}
+
+		constexpr std::size_t VertexCount = 100'000;
+		constexpr std::size_t MatrixCount = 1024;
+	}
+
+	void RunMatrix(Harness& harness) {
+		const mat4f model = mat4f::TRS(vec3f(1.0f, -2.0f, 3.0f), quatf::FromAxisAngle(Normalize(vec3f(1.0f, 1.0f, 0.0f)), 0.7f), vec3f(2.0f));
+		const mat4f view = mat4f::LookAt(vec3f(0.0f, 2.0f, 8.0f), vec3f(0.0f), vec3f(0.0f, 1.0f, 0.0f));
+
+		std::vector<mat4f> matrices(MatrixCount, model), results(MatrixCount);
+		for (std::size_t i = 0; i < MatrixCount; ++i)
+			matrices[i][3].x = (float)i;
+
+		harness.Run("matrix4x4/multiply/scalar", MatrixCount, [&] {
+			for (std::size_t i = 0; i < MatrixCount; ++i)
+				ReferenceMultiply(view.data(), matrices[i].data(), results[i].data());
+			DoNotOptimize(results);
+		});
+		harness.Run("matrix4x4/multiply/simd", MatrixCount, [&] {
+			for (std::size_t i = 0; i < MatrixCount; ++i)
+				results[i] = view * matrices[i];
+			DoNotOptimize(results);
+		});
+		harness.Run("matrix4x4/multiply/batch", MatrixCount, [&] {
+			batch::Multiply(view, matrices, results);
+			DoNotOptimize(results);
+		});
+
+		harness.Run("matrix4x4/inverse/scalar", MatrixCount, [&] {
+			for (std::size_t i = 0; i < MatrixCount; ++i)
+				internal::InverseScalar(matrices[i], results[i]);
+			DoNotOptimize(results);
+		});
+		harness.Run("matrix4x4/inverse/simd", MatrixCount, [&] {
+			for (std::size_t i = 0; i < MatrixCount; ++i)
+				results[i] = Inverse(matrices[i]).value_or(mat4f());
+			DoNotOptimize(results);
+		});
+
+		std::vector<vec3f> points(VertexCount), transformed(VertexCount);
+		for (std::size_t i = 0; i < VertexCount; ++i)
+			points[i] = vec3f((float)(i % 97), (float)(i % 13) * 0.5f, -(float)(i % 31));
+
+		const mat4f mv = view * model;
+		harness.Run("matrix4x4/transform_points/scalar", VertexCount, [&] {
+			ReferenceTransformPoints(mv, points.data(), transformed.data(), VertexCount);
+			DoNotOptimize(transformed);
+		});
+		harness.Run("matrix4x4/transform_points/batch", VertexCount, [&] {
+			batch::TransformPoints(mv, points, transformed);
+			DoNotOptimize(transformed);
+		});
+
+		std::vector<vec4f> vectors(VertexCount, vec4f(1.0f, 2.0f, 3.0f, 1.0f)), vectorsOut(VertexCount);
+		harness.Run("matrix4x4/transform_vec4/scalar", VertexCount, [&] {
+			for (std::size_t i = 0; i < VertexCount; ++i)
+				vectorsOut[i] = mv * vectors[i];
+			DoNotOptimize(vectorsOut);
+		});
+		harness.Run("matrix4x4/transform_vec4/batch", VertexCount, [&] {
+			batch::Transform(mv, vectors, vectorsOut);
+			DoNotOptimize(vectorsOut);
+		});
+	}
+}
@@ -0,0 +1,132 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <crux-common/jobs.h>
+#include <crux-window/window.h>
+#include <crux-render-sw/rasterizer.h>
+
+namespace crux::bench {
+	namespace {
+		constexpr uint Width = 1920;
+		constexpr uint Height = 1080;
+
+		// Triangles per frame in the small triangle cases
+		constexpr std::size_t TriangleCount = 100'000;
+
+		// Corners land within this many pixels of the triangle's center, around 20 pixels of area
+		constexpr float SmallExtent = 4.0f;
+
+		enum class Shading {
+			FLAT,
+			GOURAUD,
+			BLENDED,
+		};
+
+		std::vector<render::Vertex> MakeTriangles(std::size_t count, float extent, Shading shading) {
+			std::mt19937 rng(1234);
+			std::uniform_real_distribution<float> centerX(0.0f, (float)Width);
+			std::uniform_real_distribution<float> centerY(0.0f, (float)Height);
+			std::uniform_real_distribution<float> offset(-extent, extent);
+			std::uniform_int_distribution<int> channel(0, 255);
+
+			std::vector<render::Vertex> vertices;
+			vertices.reserve(count * 3);
+			for (std::size_t i = 0; i < count; ++i) {
+				const vec2f center(centerX(rng), centerY(rng));
+				const uint8bit alpha = shading == Shading::BLENDED ? (uint8bit)128 : (uint8bit)255;
+				const uint32bit color = render::Rgba((uint8bit)channel(rng), (uint8bit)channel(rng), (uint8bit)channel(rng), alpha);
+				for (int k = 0; k < 3; ++k) {
+					render::Vertex& vertex = vertices.emplace_back();
+					vertex.position = vec2f(center.x + offset(rng), center.y + offset(rng));
+					vertex.color = shading == Shading::GOURAUD ? render::Rgba((uint8bit)channel(rng), (uint8bit)channel(rng), (uint8bit)channel(rng)) : color;
+				}
+			}
+			return vertices;
+		}
+
+		// Single threaded, then one thread per core
+		std::vector<uint> ThreadCounts() {
+			const uint hardware = JobSystem::DefaultWorkerCount() + 1;
+			if (hardware == 1)
+				return { 1 };
+			return { 1, hardware };
+		}
+	}
+
+	/*
+	 * Draws into a headless window's framebuffer, so the numbers are the
+	 * rasterizer alone and the suite runs on a CI machine without a display.
+	 */
+	void RunRender(Harness& harness) {
+		WindowProperties props;
+		props.title = "crux-bench";
+		props.width = Width;
+		props.height = Height;
+		props.headless = true;
+
+		auto created = Window::Create(props);
+		Framebuffer* target = created ? (*created)->GetFramebuffer() : nullptr;
+		if (!target) {
+			printf("%-48s skipped, no headless window\n", "render");
+			return;
+		}
+		WinPtr window = *created;
+
+		const std::vector<render::Vertex> flat = MakeTriangles(TriangleCount, SmallExtent, Shading::FLAT);
+		const std::vector<render::Vertex> gouraud = MakeTriangles(TriangleCount, SmallExtent, Shading::GOURAUD);
+		const std::vector<render::Vertex> blended = MakeTriangles(TriangleCount, SmallExtent, Shading::BLENDED);
+
+		//Two triangles covering the target, measures fill rate per pixel
+		const render::Vertex fullscreen[6] = {
+			{ vec2f(0.0f, 0.0f), render::Rgba(40, 80, 120, 128) },
+			{ vec2f((float)Width, 0.0f), render::Rgba(40, 80, 120, 128) },
+			{ vec2f((float)Width, (float)Height), render::Rgba(40, 80, 120, 128) },
+			{ vec2f(0.0f, 0.0f), render::Rgba(40, 80, 120, 128) },
+			{ vec2f((float)Width, (float)Height), render::Rgba(40, 80, 120, 128) },
+			{ vec2f(0.0f, (float)Height), render::Rgba(40, 80, 120, 128) },
+		};
+
+		for (uint threads : ThreadCounts()) {
+			JobSystem jobs(threads - 1);
+			render::Rasterizer rasterizer(threads > 1 ? &jobs : nullptr);
+			const std::string suffix = "/threads=" + std::to_string(threads);
+
+			auto draw = [&](const std::vector<render::Vertex>& vertices) {
+				rasterizer.Begin(*target);
+				rasterizer.DrawTriangles(vertices);
+				rasterizer.End();
+				DoNotOptimize(target->GetPixels());
+			};
+
+			harness.Run("render/1080p/small/flat" + suffix, TriangleCount, [&] { draw(flat); });
+			harness.Run("render/1080p/small/gouraud" + suffix, TriangleCount, [&] { draw(gouraud); });
+			harness.Run("render/1080p/small/blended" + suffix, TriangleCount, [&] { draw(blended); });
+
+			harness.Run("render/1080p/clear" + suffix, (std::size_t)Width * Height, [&] {
+				rasterizer.Begin(*target);
+				rasterizer.Clear(render::Rgba(0, 0, 0));
+				rasterizer.End();
+				DoNotOptimize(target->GetPixels());
+			});
+			harness.Run("render/1080p/fill/blended" + suffix, (std::size_t)Width * Height, [&] {
+				rasterizer.Begin(*target);
+				rasterizer.DrawTriangles(fullscreen);
+				rasterizer.End();
+				DoNotOptimize(target->GetPixels());
+			});
+
+			//What a frame costs end to end, clear, draw and present
+			harness.Run("render/1080p/frame" + suffix, 1, [&] {
+				rasterizer.Begin(*target);
+				rasterizer.Clear(render::Rgba(0, 0, 0));
+				rasterizer.DrawTriangles(flat);
+				rasterizer.End();
+				DoNotOptimize(window->Present());
+			});
+		}
+	}
+}
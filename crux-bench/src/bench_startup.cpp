@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <crux-common/clock.h>
+#include <crux-common/dynamic_library.h>
+#include <crux-common/jobs.h>
+#include <crux-common/library_preload.h>
+#include <crux-common/platform.h>
+#include <crux-window/window.h>
+
+namespace crux::bench {
+	namespace {
+		// Libraries loaded per simulated startup
+		constexpr std::size_t LibraryCount = 16;
+
+		// Runs per case, every run loads from scratch so they are comparatively slow
+		constexpr int SampleCount = 25;
+
+#if CRUX_WIN32
+		constexpr const char* StubFile = "crux-bench-stub.dll";
+		constexpr const char* StubExtension = ".dll";
+#else
+		constexpr const char* StubFile = "libcrux-bench-stub.so";
+		constexpr const char* StubExtension = ".so";
+#endif
+
+		// @return Directory holding the running executable, empty if unknown
+		std::filesystem::path ExecutableDirectory() {
+#if CRUX_UNIX
+			std::error_code error;
+			std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", error);
+			return error ? std::filesystem::path() : exe.parent_path();
+#else
+			return std::filesystem::current_path();
+#endif
+		}
+
+		/**
+		 * @brief Copies the stub library under distinct names, so every copy is loaded on its own.
+		 * @return Paths of the copies, empty if the stub was not found
+		*/
+		std::vector<string> MakeStubCopies(const std::filesystem::path& directory) {
+			const std::filesystem::path stub = ExecutableDirectory() / StubFile;
+			std::error_code error;
+			if (!std::filesystem::exists(stub, error))
+				return {};
+
+			std::filesystem::create_directories(directory, error);
+			std::vector<string> names;
+			for (std::size_t i = 0; i < LibraryCount; ++i) {
+				const std::filesystem::path copy = directory / ("stub_" + std::to_string(i) + StubExtension);
+				std::filesystem::copy_file(stub, copy, std::filesystem::copy_options::overwrite_existing, error);
+				if (error)
+					return {};
+				names.push_back(copy.string());
+			}
+			return names;
+		}
+
+		// The first frame of a headless window, standing in for getting a window on screen
+		WinPtr OpenFirstWindow() {
+			WindowProperties props;
+			props.title = "crux-bench";
+			props.width = 1280;
+			props.height = 720;
+			props.headless = true;
+
+			auto window = Window::Create(props);
+			if (!window)
+				return nullptr;
+
+			if (Framebuffer* fb = (*window)->GetFramebuffer()) {
+				fb->Clear(0xFF202020u);
+				(*window)->Present();
+			}
+			return *window;
+		}
+
+		using StubFn = std::uint32_t();
+	}
+
+	void RunStartup(Harness& harness) {
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "crux-bench-stubs";
+		const std::vector<string> names = MakeStubCopies(directory);
+		if (names.empty()) {
+			printf("%-48s skipped, %s not found next to the executable\n", "startup", StubFile);
+			return;
+		}
+
+		JobSystem jobs;
+		const std::string suffix = "/libs=" + std::to_string(LibraryCount) + "/threads=" + std::to_string(jobs.GetWorkerCount() + 1);
+
+		//Every library loaded one after the other before the window, the old LoadNixLibraries() way
+		harness.RunTimed("startup/sequential/first_window" + suffix, SampleCount, [&] {
+			const uint64bit start = clock::Now();
+			std::vector<DynamicLibrary> loaded;
+			for (const string& name : names) {
+				if (auto library = DynamicLibrary::Load(name))
+					loaded.push_back(std::move(*library));
+			}
+			WinPtr window = OpenFirstWindow();
+			return clock::Now() - start;
+		});
+
+		//Loads queued on the workers, the window opens meanwhile
+		harness.RunTimed("startup/preload/first_window" + suffix, SampleCount, [&] {
+			const uint64bit start = clock::Now();
+			LibraryPreload preload(jobs, names);
+			WinPtr window = OpenFirstWindow();
+			const uint64bit elapsed = clock::Now() - start;
+			preload.Wait();
+			return elapsed;
+		});
+
+		harness.RunTimed("startup/preload/all_loaded" + suffix, SampleCount, [&] {
+			const uint64bit start = clock::Now();
+			LibraryPreload preload(jobs, names);
+			WinPtr window = OpenFirstWindow();
+			preload.Wait();
+			return clock::Now() - start;
+		});
+
+		//Nothing loaded until a symbol is used, which for optional modules may be never
+		harness.RunTimed("startup/lazy/first_window" + suffix, SampleCount, [&] {
+			const uint64bit start = clock::Now();
+			std::deque<LazyLibrary> lazy;
+			for (const string& name : names)
+				lazy.emplace_back(name);
+			WinPtr window = OpenFirstWindow();
+			return clock::Now() - start;
+		});
+
+		harness.RunTimed("startup/lazy/all_used" + suffix, SampleCount, [&] {
+			const uint64bit start = clock::Now();
+			std::deque<LazyLibrary> lazy;
+			for (const string& name : names)
+				lazy.emplace_back(name);
+			WinPtr window = OpenFirstWindow();
+			for (LazyLibrary& library : lazy) {
+				if (StubFn* checksum = library.GetFunction<StubFn>("crux_stub_checksum"))
+					DoNotOptimize(checksum());
+			}
+			return clock::Now() - start;
+		});
+
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+	}
+}
@@ -0,0 +1,92 @@
+#include "bench.h"
+
+#include <string>
+#include <vector>
+
+#include <crux-common/small_string.h>
+#include <crux-common/utf.h>
+
+namespace crux::bench {
+	namespace {
+		// Window title sized, the common case for the Win32 conversions
+		constexpr std::size_t TitleLength = 32;
+
+		// Long enough for the SIMD paths to dominate
+		constexpr std::size_t TextLength = 4096;
+
+		std::string MakeAscii(std::size_t length) {
+			std::string text;
+			text.reserve(length);
+			for (std::size_t i = 0; text.size() < length; ++i)
+				text += (char)('a' + i % 26);
+			return text;
+		}
+
+		// Latin, Greek, CJK and an emoji, so every sequence length shows up
+		std::string MakeMixed(std::size_t length) {
+			const char* pieces[] = { "crux ", "\xC3\xA9t\xC3\xA9 ", "\xCE\xBB\xCF\x8C\xCE\xB3\xCE\xBF\xCF\x82 ", "\xE6\xBC\xA2\xE5\xAD\x97 ", "\xF0\x9F\x98\x80 " };
+			std::string text;
+			for (std::size_t i = 0; text.size() < length; ++i)
+				text += pieces[i % 5];
+			return text;
+		}
+
+		std::u16string ToUtf16(const std::string& text) {
+			std::u16string converted(utf::MaxUtf16Length(text.size()), u'\0');
+			converted.resize(utf::Utf8ToUtf16(text, converted.data(), converted.size()).written);
+			return converted;
+		}
+	}
+
+	void RunStrings(Harness& harness) {
+		const std::string title = MakeAscii(TitleLength);
+		const std::string ascii = MakeAscii(TextLength);
+		const std::string mixed = MakeMixed(TextLength);
+		const std::u16string asciiWide = ToUtf16(ascii);
+		const std::u16string mixedWide = ToUtf16(mixed);
+
+		std::vector<char16_t> utf16(utf::MaxUtf16Length(TextLength + 8));
+		std::vector<char> utf8(utf::MaxUtf8LengthFromUtf16(TextLength + 8));
+
+		harness.Run("string/utf8_to_utf16/ascii/32", title.size(), [&] {
+			DoNotOptimize(utf::Utf8ToUtf16(title, utf16.data(), utf16.size()));
+			DoNotOptimize(utf16);
+		});
+		harness.Run("string/utf8_to_utf16/ascii/4096", ascii.size(), [&] {
+			DoNotOptimize(utf::Utf8ToUtf16(ascii, utf16.data(), utf16.size()));
+			DoNotOptimize(utf16);
+		});
+		harness.Run("string/utf8_to_utf16/mixed/4096", mixed.size(), [&] {
+			DoNotOptimize(utf::Utf8ToUtf16(mixed, utf16.data(), utf16.size()));
+			DoNotOptimize(utf16);
+		});
+
+		harness.Run("string/utf16_to_utf8/ascii/4096", asciiWide.size(), [&] {
+			DoNotOptimize(utf::Utf16ToUtf8(asciiWide, utf8.data(), utf8.size()));
+			DoNotOptimize(utf8);
+		});
+		harness.Run("string/utf16_to_utf8/mixed/4096", mixedWide.size(), [&] {
+			DoNotOptimize(utf::Utf16ToUtf8(mixedWide, utf8.data(), utf8.size()));
+			DoNotOptimize(utf8);
+		});
+
+		//The shape of the Win32 title and path conversions, into an inline buffer or a heap string
+		small_string<wchar_t, 260> wideBuffer;
+		harness.Run("string/utf8_to_wide/small_string/32", title.size(), [&] {
+			utf::Utf8ToWide(title, wideBuffer);
+			DoNotOptimize(wideBuffer);
+		});
+		harness.Run("string/utf8_to_wide/wstring/32", title.size(), [&] {
+			std::wstring wide;
+			utf::Utf8ToWide(title, wide);
+			DoNotOptimize(wide);
+		});
+
+		std::string roundTrip;
+		harness.Run("string/round_trip/wide/32", title.size(), [&] {
+			utf::Utf8ToWide(title, wideBuffer);
+			utf::WideToUtf8(wideBuffer.view(), roundTrip);
+			DoNotOptimize(roundTrip);
+		});
+	}
+}
@@ -0,0 +1,159 @@
+#include "bench.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <crux-common/types.h>
+#include <crux-common/vector2_batch.h>
+#include <crux-common/vector2_soa.h>
+
+namespace crux::bench {
+	namespace {
+		// Mirrors the original generic vector2 template, one component at a time
+		struct scalar_vec2 {
+			float x, y;
+		};
+
+		inline scalar_vec2 operator+(const scalar_vec2& lhs, const scalar_vec2& rhs) { return { lhs.x + rhs.x, lhs.y + rhs.y }; }
+		inline scalar_vec2 operator-(const scalar_vec2& lhs, const scalar_vec2& rhs) { return { lhs.x - rhs.x, lhs.y - rhs.y }; }
+		inline scalar_vec2 operator*(const scalar_vec2& lhs, const scalar_vec2& rhs) { return { lhs.x * rhs.x, lhs.y * rhs.y }; }
+
+		// Enough vec2f positions to stand in for a busy frame
+		constexpr std::size_t Count = 100'000;
+
+		template<typename V>
+		std::vector<V> MakeData(float seed) {
+			std::vector<V> data(Count);
+			for (std::size_t i = 0; i < Count; ++i) {
+				data[i].x = seed + (float)(i % 1024) * 0.25f;
+				data[i].y = seed - (float)(i % 512) * 0.5f;
+			}
+			return data;
+		}
+	}
+
+	void RunVector2(Harness& harness) {
+		auto sa = MakeData<scalar_vec2>(1.0f), sb = MakeData<scalar_vec2>(3.0f), sout = MakeData<scalar_vec2>(0.0f);
+		auto va = MakeData<vec2f>(1.0f), vb = MakeData<vec2f>(3.0f), vout = MakeData<vec2f>(0.0f);
+		std::vector<float> fout(Count);
+
+		// Add
+		harness.Run("vector2/add/scalar", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) sout[i] = sa[i] + sb[i];
+			DoNotOptimize(sout);
+		});
+		harness.Run("vector2/add/operator", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) vout[i] = va[i] + vb[i];
+			DoNotOptimize(vout);
+		});
+		harness.Run("vector2/add/batch", Count, [&] {
+			batch::Add(va, vb, vout);
+			DoNotOptimize(vout);
+		});
+
+		// Mul
+		harness.Run("vector2/mul/scalar", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) sout[i] = sa[i] * sb[i];
+			DoNotOptimize(sout);
+		});
+		harness.Run("vector2/mul/operator", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) vout[i] = va[i] * vb[i];
+			DoNotOptimize(vout);
+		});
+		harness.Run("vector2/mul/batch", Count, [&] {
+			batch::Mul(va, vb, vout);
+			DoNotOptimize(vout);
+		});
+
+		// Lerp
+		harness.Run("vector2/lerp/scalar", Count, [&] {
+			const scalar_vec2 t{ 0.3f, 0.3f };
+			for (std::size_t i = 0; i < Count; ++i) sout[i] = sa[i] + (sb[i] - sa[i]) * t;
+			DoNotOptimize(sout);
+		});
+		harness.Run("vector2/lerp/batch", Count, [&] {
+			batch::Lerp(va, vb, 0.3f, vout);
+			DoNotOptimize(vout);
+		});
+
+		// Dot
+		harness.Run("vector2/dot/scalar", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) fout[i] = sa[i].x * sb[i].x + sa[i].y * sb[i].y;
+			DoNotOptimize(fout);
+		});
+		harness.Run("vector2/dot/batch", Count, [&] {
+			batch::Dot(va, vb, fout);
+			DoNotOptimize(fout);
+		});
+
+		// Length
+		harness.Run("vector2/length/scalar", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) fout[i] = std::sqrt(sa[i].x * sa[i].x + sa[i].y * sa[i].y);
+			DoNotOptimize(fout);
+		});
+		harness.Run("vector2/length/batch", Count, [&] {
+			batch::Length(va, fout);
+			DoNotOptimize(fout);
+		});
+
+		// Normalize
+		harness.Run("vector2/normalize/scalar", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) {
+				float len = std::sqrt(sa[i].x * sa[i].x + sa[i].y * sa[i].y);
+				float inv = len > 0.0f ? 1.0f / len : 0.0f;
+				sout[i] = { sa[i].x * inv, sa[i].y * inv };
+			}
+			DoNotOptimize(sout);
+		});
+		harness.Run("vector2/normalize/batch", Count, [&] {
+			batch::Normalize(va, vout);
+			DoNotOptimize(vout);
+		});
+
+		// Particle style update, position += velocity * dt
+		const float dt = 1.0f / 60.0f;
+		harness.Run("vector2/integrate/aos", Count, [&] {
+			for (std::size_t i = 0; i < Count; ++i) vout[i] += va[i] * vec2f(dt);
+			DoNotOptimize(vout);
+		});
+
+		vector2_soa<float> positions(vout), velocities(va);
+		harness.Run("vector2/integrate/soa", Count, [&] {
+			batch::Accumulate(positions, velocities, dt);
+			DoNotOptimize(positions);
+		});
+
+		harness.Run("vector2/soa/assign", Count, [&] {
+			positions.assign(va);
+			DoNotOptimize(positions);
+		});
+		harness.Run("vector2/soa/copy_to", Count, [&] {
+			positions.copy_to(vout);
+			DoNotOptimize(vout);
+		});
+
+		//Growing from empty, every reallocation has to carry the elements already pushed
+		vector2_soa<float> grown;
+		harness.Run("vector2/soa/push_back", Count, [&] {
+			grown = vector2_soa<float>();
+			for (std::size_t i = 0; i < Count; ++i)
+				grown.push_back(va[i]);
+			DoNotOptimize(grown);
+		});
+
+		//Checked on its own vector, the case above does not run when filtered out
+		vector2_soa<float> checked;
+		for (std::size_t i = 0; i < Count; ++i)
+			checked.push_back(va[i]);
+
+		std::size_t mismatched = checked.size() == Count ? 0 : Count;
+		for (std::size_t i = 0; i < checked.size() && i < Count; ++i) {
+			const vec2f value = checked[i];
+			if (value.x != va[i].x || value.y != va[i].y)
+				++mismatched;
+		}
+		if (mismatched > 0)
+			harness.Fail("vector2/soa/push_back", std::to_string(mismatched) + " of " + std::to_string(Count) + " elements lost while growing");
+	}
+}
@@ -0,0 +1,238 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <crux-window/window.h>
+#include <crux-window/window.headless.h>
+#include <crux-window/swapchain.h>
+#include <crux-window/window_manager.h>
+
+namespace crux::bench {
+	namespace {
+		// Events moved per PollEvents() call, the example loop uses the same
+		constexpr std::size_t EventBatch = 64;
+	}
+
+	/*
+	 * Runs on the headless backend, so the numbers cover crux's own bookkeeping
+	 * (atomics, queues, framebuffer resizes) without an OS round trip, and the
+	 * suite runs the same on a CI machine without a display.
+	 */
+	void RunWindow(Harness& harness) {
+		WindowProperties props;
+		props.title = "crux-bench";
+		props.width = 640;
+		props.height = 480;
+		props.headless = true;
+
+		auto created = Window::Create(props);
+		if (!created) {
+			printf("%-48s skipped, no headless window\n", "window");
+			return;
+		}
+		WinPtr window = *created;
+		auto headless = std::static_pointer_cast<WindowHeadless>(window);
+
+		Event events[EventBatch];
+		auto drain = [&] {
+			while (window->PollEvents(events) == EventBatch) {}
+		};
+
+		harness.Run("window/get/size", 1, [&] {
+			DoNotOptimize(window->GetSize());
+		});
+		harness.Run("window/get/properties", 1, [&] {
+			DoNotOptimize(window->GetProperties());
+		});
+
+		//Set then read back, the resize events are drained every 32 calls so the queue never fills
+		uint counter = 0;
+		harness.Run("window/roundtrip/position", 1, [&] {
+			window->SetPosition(vec2i((int)(counter & 255), 10));
+			DoNotOptimize(window->GetPosition());
+			if ((++counter & 31) == 0)
+				drain();
+		});
+		harness.Run("window/roundtrip/size/same", 1, [&] {
+			window->SetSize(vec2u(640u, 480u));
+			DoNotOptimize(window->GetSize());
+			if ((++counter & 31) == 0)
+				drain();
+		});
+		harness.Run("window/roundtrip/size/alternating", 1, [&] {
+			//A live resize, the back buffer keeps its largest allocation so only the first call allocates
+			window->SetSize((++counter & 1) ? vec2u(640u, 480u) : vec2u(800u, 600u));
+			DoNotOptimize(window->GetSize());
+			if ((counter & 31) == 0)
+				drain();
+		});
+
+		//The same three changes applied one by one and as a batch, which sends one move and one resize
+		harness.Run("window/update/separate", 1, [&] {
+			const uint width = (++counter & 1) ? 640u : 800u;
+			window->SetWidth(width);
+			window->SetHeight(width * 3 / 4);
+			window->SetPositionX((int)(counter & 255));
+			if ((counter & 15) == 0)
+				drain();
+		});
+		harness.Run("window/update/batched", 1, [&] {
+			const uint width = (++counter & 1) ? 640u : 800u;
+			window->BeginUpdate();
+			window->SetWidth(width);
+			window->SetHeight(width * 3 / 4);
+			window->SetPositionX((int)(counter & 255));
+			window->EndUpdate();
+			if ((counter & 31) == 0)
+				drain();
+		});
+
+		//Reapplying what the window already has, nothing reaches the backend
+		const WindowProperties current = window->GetProperties();
+		harness.Run("window/update/apply_unchanged", 1, [&] {
+			window->ApplyProperties(current);
+		});
+		drain();
+
+		const std::string titles[2] = { "crux-bench", "crux-bench (resized)" };
+		harness.Run("window/roundtrip/title", 1, [&] {
+			window->SetTitle(titles[++counter & 1]);
+			DoNotOptimize(window->GetTitle());
+		});
+		drain();
+
+		//Producer and consumer on the same thread, the queue cost alone
+		Event injected;
+		injected.type = EventType::MOUSE_MOVE;
+		harness.Run("window/events/inject_poll", EventBatch, [&] {
+			for (std::size_t i = 0; i < EventBatch; ++i) {
+				injected.mouseMove = { (int)i, (int)i };
+				headless->InjectEvent(injected);
+			}
+			DoNotOptimize(window->PollEvents(events));
+			DoNotOptimize(events);
+		});
+
+		harness.Run("window/events/poll_empty", 1, [&] {
+			DoNotOptimize(window->PollEvents(events));
+		});
+
+		harness.Run("window/present/640x480", 1, [&] {
+			DoNotOptimize(window->Present());
+		});
+
+		//Partial presents copy only the marked pixels, here a HUD sized strip
+		window->MarkDirty();
+		window->Present();
+		harness.Run("window/present/dirty/256x64", 1, [&] {
+			window->MarkDirty(PixelRect::FromSize(0, 0, 256, 64));
+			DoNotOptimize(window->Present());
+		});
+
+		//Past three quarters of the surface a partial present falls back to one full copy
+		harness.Run("window/present/dirty/full", 1, [&] {
+			window->MarkDirty();
+			DoNotOptimize(window->Present());
+		});
+
+		//Frames handed through a swapchain, unpaced so the cost is the queueing and the copy into the window
+		const struct {
+			const char* name;
+			PresentMode mode;
+		} modes[] = {
+			{ "immediate", PresentMode::IMMEDIATE },
+			{ "fifo", PresentMode::FIFO },
+			{ "mailbox", PresentMode::MAILBOX },
+		};
+		for (const auto& entry : modes) {
+			SwapchainProperties chainProps;
+			chainProps.mode = entry.mode;
+			chainProps.refreshRate = 0.0;
+
+			auto chain = Swapchain::Create(window, chainProps);
+			if (!chain)
+				continue;
+			Swapchain& swapchain = **chain;
+			harness.Run(std::string("window/swapchain/") + entry.name + "/640x480", 1, [&] {
+				DoNotOptimize(swapchain.Acquire()->GetPixels());
+				DoNotOptimize(swapchain.Present());
+			});
+		}
+
+		//An editor's worth of tool windows, created and torn down through the manager
+		constexpr std::size_t ToolWindows = 32;
+		WindowProperties toolProps;
+		toolProps.title = "crux-bench tool";
+		toolProps.width = 64;
+		toolProps.height = 64;
+		toolProps.headless = true;
+
+		WindowManager manager;
+		WindowId tools[ToolWindows];
+		harness.Run("window/manager/create_destroy/32", ToolWindows, [&] {
+			for (WindowId& id : tools)
+				id = manager.Create(toolProps).value_or(WindowId());
+			for (WindowId id : tools)
+				manager.Destroy(id);
+		});
+
+		//One event per window per frame, gathered by the manager or window by window. Headless windows
+		//have no OS messages, so this is the cost of tagging events, the native cases below cover the pump
+		for (WindowId& id : tools)
+			id = manager.Create(toolProps).value_or(WindowId());
+		WindowEvent gathered[ToolWindows * 2];
+		harness.Run("window/manager/poll/32", ToolWindows, [&] {
+			for (Window* tool : manager.GetWindows())
+				static_cast<WindowHeadless*>(tool)->InjectEvent(injected);
+			DoNotOptimize(manager.PollEvents(gathered));
+			DoNotOptimize(gathered);
+		});
+		harness.Run("window/manager/poll_each/32", ToolWindows, [&] {
+			for (Window* tool : manager.GetWindows()) {
+				static_cast<WindowHeadless*>(tool)->InjectEvent(injected);
+				DoNotOptimize(tool->PollEvents(events));
+			}
+			DoNotOptimize(events);
+		});
+		manager.Clear();
+
+		//Idle native tool windows, the per frame cost of finding out nothing happened. The manager
+		//pumps them in one pass, on X11 one poll() over the connection they share
+		WindowProperties nativeProps = toolProps;
+		nativeProps.headless = false;
+		nativeProps.threadedMessagePump = false;
+		//The rest are only created once the first shows a display is there, each failure logs a warning
+		if (manager.Create(nativeProps)) {
+			for (std::size_t i = 1; i < ToolWindows; ++i)
+				manager.Create(nativeProps);
+		}
+		if (manager.GetCount() == ToolWindows) {
+			harness.Run("window/manager/native/poll/32", ToolWindows, [&] {
+				DoNotOptimize(manager.PollEvents(gathered));
+				DoNotOptimize(gathered);
+			});
+			harness.Run("window/manager/native/poll_each/32", ToolWindows, [&] {
+				for (Window* tool : manager.GetWindows())
+					DoNotOptimize(tool->PollEvents(events));
+				DoNotOptimize(events);
+			});
+		} else {
+			printf("%-48s skipped, no display\n", "window/manager/native");
+		}
+		manager.Clear();
+
+		//Scattered small updates, past DirtyRegion::MaxRects the closest ones get merged
+		PixelRect scattered[32];
+		for (uint i = 0; i < 32; ++i)
+			scattered[i] = PixelRect::FromSize((int)(i * 97 % 600), (int)(i * 53 % 440), 16, 16);
+		DirtyRegion region;
+		harness.Run("window/dirty_region/add/32", 32, [&] {
+			region.Clear();
+			for (const PixelRect& rect : scattered)
+				region.Add(rect);
+			DoNotOptimize(region);
+		});
+	}
+}
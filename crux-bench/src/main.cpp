@@ -0,0 +1,42 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv) {
+	//Usage: crux-bench [filter] [--json results.json]
+	std::string filter;
+	std::string jsonPath;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonPath = argv[++i];
+		else
+			filter = argv[i];
+	}
+
+	crux::bench::Harness harness(filter);
+
+	crux::bench::RunVector2(harness);
+	crux::bench::RunMatrix(harness);
+	crux::bench::RunJobs(harness);
+	crux::bench::RunAllocators(harness);
+	crux::bench::RunStrings(harness);
+	crux::bench::RunLibraries(harness);
+	crux::bench::RunWindow(harness);
+	crux::bench::RunRender(harness);
+	crux::bench::RunStartup(harness);
+
+	harness.Print();
+
+	if (!jsonPath.empty() && !harness.WriteJson(jsonPath)) {
+		fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+		return 1;
+	}
+
+	if (harness.GetFailureCount() > 0) {
+		fprintf(stderr, "%zu correctness checks failed\n", harness.GetFailureCount());
+		return 1;
+	}
+	return 0;
+}
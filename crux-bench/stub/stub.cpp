@@ -0,0 +1,45 @@
+/*
+ * Stub shared library for the startup benchmark.
+ * Its static initializer builds a lookup table, standing in for the
+ * relocation and initialization work of a real module, and it exports a
+ * couple of functions to resolve.
+ */
+
+#include <cstdint>
+
+#if defined(_WIN32)
+	#define CRUX_STUB_EXPORT extern "C" __declspec(dllexport)
+#else
+	#define CRUX_STUB_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace {
+	constexpr std::uint32_t TableSize = 1 << 16;
+
+	struct Table {
+		std::uint32_t values[TableSize];
+
+		Table() {
+			std::uint32_t x = 2463534242u;
+			for (std::uint32_t i = 0; i < TableSize; ++i) {
+				x ^= x << 13;
+				x ^= x >> 17;
+				x ^= x << 5;
+				values[i] = x;
+			}
+		}
+	};
+
+	Table table;
+}
+
+CRUX_STUB_EXPORT std::uint32_t crux_stub_checksum() {
+	std::uint32_t sum = 0;
+	for (std::uint32_t value : table.values)
+		sum += value;
+	return sum;
+}
+
+CRUX_STUB_EXPORT std::uint32_t crux_stub_lookup(std::uint32_t index) {
+	return table.values[index % TableSize];
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+/*
+ * Custom allocators, in the crux::memory namespace.
+ * Arena is a bump allocator for frame or scope lifetimes, Pool hands out
+ * fixed-size blocks, and Tlsf is a general purpose allocator with O(1)
+ * allocate and free. Each has a std::pmr::memory_resource adapter so the
+ * standard containers (std::pmr::vector, std::pmr::string, ...) can use it.
+ *
+ * None of them are thread-safe, give each thread its own instance.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace crux::memory {
+	// Alignment guaranteed by Allocate when none is given, suitable for any scalar type
+	constexpr std::size_t DefaultAlignment = alignof(std::max_align_t);
+
+	/**
+	 * @brief Rounds a size or address up to a power of two alignment.
+	*/
+	constexpr std::size_t AlignUp(std::size_t value, std::size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	/**
+	 * @brief Linear (bump) allocator.
+	 *
+	 * Allocation moves a pointer forward, individual frees do not exist.
+	 * Instead everything is dropped at once with Reset(), or back to an
+	 * earlier point with Rewind(). Memory comes in blocks from an upstream
+	 * resource, and blocks are kept across Reset() so an arena reused every
+	 * frame stops touching the heap once it has grown to the frame's needs.
+	*/
+	class Arena {
+		struct Block;
+	public:
+		// Size of the blocks requested from upstream, larger allocations get a block of their own size
+		static constexpr std::size_t DefaultBlockSize = 64 * 1024;
+
+		/**
+		 * @brief A position in the arena to rewind to.
+		*/
+		struct Marker {
+			Block* block = nullptr;
+			std::size_t offset = 0;
+			std::size_t used = 0;
+		};
+
+		/**
+		 * @brief Construct an arena growing from an upstream resource.
+		 * @param blockSize Bytes per upstream block
+		 * @param upstream Resource the blocks come from
+		*/
+		explicit Arena(std::size_t blockSize = DefaultBlockSize, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		/**
+		 * @brief Construct an arena over a caller owned buffer, ie. on the stack.
+		 * @param buffer Memory to allocate from, must outlive the arena
+		 * @param size Bytes in buffer
+		 * @param upstream Resource to grow from once the buffer is full, nullptr to fail instead
+		*/
+		Arena(void* buffer, std::size_t size, std::pmr::memory_resource* upstream = nullptr);
+
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		/**
+		 * @brief Allocates memory, a pointer bump unless the current block is full.
+		 * @param size Bytes to allocate
+		 * @param alignment Power of two alignment
+		 * @return The memory, or nullptr if it is full and has no upstream
+		*/
+		void* Allocate(std::size_t size, std::size_t alignment = DefaultAlignment);
+
+		/**
+		 * @brief Allocates and constructs an object.
+		 * Destructors are never run by the arena, so only trivially destructible types are allowed.
+		 * @return The object, or nullptr if the arena is out of memory
+		*/
+		template<typename T, typename... Args>
+		T* New(Args&&... args) {
+			static_assert(std::is_trivially_destructible<T>::value, "Arena never runs destructors");
+			void* memory = Allocate(sizeof(T), alignof(T));
+			return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+		}
+
+		// @return The current position, for a later Rewind
+		inline Marker GetMarker() const { return { current, offset, used }; }
+
+		// Frees everything allocated since the marker was taken
+		void Rewind(const Marker& marker);
+
+		// Frees everything, keeping the blocks for reuse
+		void Reset();
+
+		// Frees everything and returns the blocks to upstream
+		void Release();
+
+		// @return Bytes handed out since the last Reset, including alignment padding
+		inline std::size_t GetUsed() const { return used; }
+
+		// @return Highest GetUsed() seen
+		inline std::size_t GetPeak() const { return peak; }
+
+		// @return Bytes in all the blocks held
+		inline std::size_t GetCapacity() const { return capacity; }
+
+	private:
+		std::pmr::memory_resource* upstream;
+		std::size_t blockSize;
+
+		// First block of the chain, blocks after current are retained from before a Reset
+		Block* head = nullptr;
+		Block* current = nullptr;
+		std::size_t offset = 0;
+
+		std::size_t used = 0;
+		std::size_t peak = 0;
+		std::size_t capacity = 0;
+	};
+
+	/**
+	 * @brief Fixed-size block allocator.
+	 *
+	 * Blocks are carved out of larger chunks and recycled through an
+	 * intrusive free list, so allocate and free are a couple of pointer
+	 * moves and never fragment.
+	*/
+	class Pool {
+		struct Chunk;
+	public:
+		/**
+		 * @brief Construct a pool.
+		 * @param blockSize Bytes per block
+		 * @param blockAlignment Power of two alignment of every block
+		 * @param blocksPerChunk Blocks requested from upstream at a time
+		 * @param upstream Resource the chunks come from
+		*/
+		Pool(std::size_t blockSize, std::size_t blockAlignment = DefaultAlignment, std::size_t blocksPerChunk = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		~Pool();
+
+		Pool(const Pool&) = delete;
+		Pool& operator=(const Pool&) = delete;
+
+		/**
+		 * @brief Takes a block from the pool.
+		 * @return A block of GetBlockSize() bytes, or nullptr if upstream is exhausted
+		*/
+		void* Allocate();
+
+		// Returns a block obtained from Allocate to the pool
+		void Free(void* block);
+
+		/**
+		 * @brief Allocates and constructs an object, which must fit in a block.
+		 * @return The object, or nullptr if the pool is out of memory
+		*/
+		template<typename T, typename... Args>
+		T* New(Args&&... args) {
+			void* memory = Allocate();
+			return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+		}
+
+		// Destroys an object made with New and returns its block
+		template<typename T>
+		void Delete(T* object) {
+			if (!object)
+				return;
+			object->~T();
+			Free(object);
+		}
+
+		// Returns every chunk to upstream, outstanding blocks become invalid
+		void Release();
+
+		// @return Usable bytes per block
+		inline std::size_t GetBlockSize() const { return blockSize; }
+
+		// @return Alignment of every block
+		inline std::size_t GetBlockAlignment() const { return blockAlignment; }
+
+		// @return Blocks currently handed out
+		inline std::size_t GetUsedCount() const { return usedCount; }
+
+		// @return Blocks held, handed out or free
+		inline std::size_t GetCapacityCount() const { return capacityCount; }
+
+	private:
+		// Carves a new chunk into blocks and pushes them on the free list
+		bool Grow();
+
+		std::pmr::memory_resource* upstream;
+		std::size_t blockSize;
+		std::size_t blockAlignment;
+
+		// Distance between blocks, the block size rounded up to the alignment
+		std::size_t stride;
+		std::size_t blocksPerChunk;
+
+		Chunk* chunks = nullptr;
+		void* freeList = nullptr;
+
+		std::size_t usedCount = 0;
+		std::size_t capacityCount = 0;
+	};
+
+	/**
+	 * @brief Two-Level Segregated Fit general purpose allocator.
+	 *
+	 * Free blocks are binned by size in a two level table, a first level per
+	 * power of two split into SecondLevelCount linear steps, with a bitmap
+	 * per level so the smallest fitting bin is found with two bit scans.
+	 * Allocate and Free are O(1) regardless of the heap's state, and freed
+	 * blocks merge with free neighbours immediately to bound fragmentation.
+	 * See Masmano et al., "TLSF: a New Dynamic Memory Allocator for
+	 * Real-Time Systems" (2004).
+	 *
+	 * Memory comes from upstream in regions, a new one is added when no
+	 * free block fits. Every block carries a 16 byte header.
+	*/
+	class Tlsf {
+		struct Block;
+		struct Region;
+	public:
+		// Bytes requested from upstream per region, larger allocations get a region of their own size
+		static constexpr std::size_t DefaultRegionSize = 1024 * 1024;
+
+		// Log2 of the linear subdivisions of each power of two size class
+		static constexpr std::size_t SecondLevelLog2 = 5;
+		static constexpr std::size_t SecondLevelCount = 1 << SecondLevelLog2;
+
+		// Granularity of block sizes, and the alignment of every allocation
+		static constexpr std::size_t Granularity = 16;
+
+		// Sizes below this all live in the first first-level class, in linear steps
+		static constexpr std::size_t SmallBlockSize = SecondLevelCount * Granularity;
+
+		// Largest allocation supported, 2^FirstLevelMax bytes
+		static constexpr std::size_t FirstLevelMax = 38;
+		static constexpr std::size_t FirstLevelShift = SecondLevelLog2 + 4;
+		static constexpr std::size_t FirstLevelCount = FirstLevelMax - FirstLevelShift + 1;
+
+		/**
+		 * @brief Construct an allocator growing from an upstream resource.
+		 * @param regionSize Bytes per upstream region
+		 * @param upstream Resource the regions come from
+		*/
+		explicit Tlsf(std::size_t regionSize = DefaultRegionSize, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		~Tlsf();
+
+		Tlsf(const Tlsf&) = delete;
+		Tlsf& operator=(const Tlsf&) = delete;
+
+		/**
+		 * @brief Allocates memory.
+		 * @param size Bytes to allocate
+		 * @param alignment Power of two alignment
+		 * @return The memory, or nullptr if upstream is exhausted
+		*/
+		void* Allocate(std::size_t size, std::size_t alignment = DefaultAlignment);
+
+		// Frees memory from Allocate, nullptr is ignored
+		void Free(void* ptr);
+
+		// Returns every region to upstream, outstanding allocations become invalid
+		void Release();
+
+		// @return Payload bytes currently allocated
+		inline std::size_t GetUsed() const { return used; }
+
+		// @return Highest GetUsed() seen
+		inline std::size_t GetPeak() const { return peak; }
+
+		// @return Bytes in all the regions held
+		inline std::size_t GetCapacity() const { return capacity; }
+
+	private:
+		bool AddRegion(std::size_t minPayload);
+
+		void InsertFree(Block* block);
+		void RemoveFree(Block* block);
+		Block* FindFree(std::size_t size);
+
+		// Splits the tail beyond size off block into a new free block, if big enough to be one
+		void TrimTail(Block* block, std::size_t size);
+
+		// Splits the first gap bytes off block into a free block, returning the remainder
+		Block* TrimHead(Block* block, std::size_t gap);
+
+		// Merges a free block with its free physical neighbours
+		Block* Merge(Block* block);
+
+		std::pmr::memory_resource* upstream;
+		std::size_t regionSize;
+		Region* regions = nullptr;
+
+		uint32_t firstLevelMap = 0;
+		uint32_t secondLevelMap[FirstLevelCount] = {};
+		Block* freeLists[FirstLevelCount][SecondLevelCount] = {};
+
+		std::size_t used = 0;
+		std::size_t peak = 0;
+		std::size_t capacity = 0;
+	};
+
+	/**
+	 * @brief std::pmr adapter over an Arena.
+	 * Deallocation is a no-op, memory comes back when the arena is reset.
+	*/
+	class ArenaResource final : public std::pmr::memory_resource {
+	public:
+		explicit ArenaResource(Arena& arena) : arena(arena) {}
+
+		inline Arena& GetArena() const { return arena; }
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void*, std::size_t, std::size_t) override {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		Arena& arena;
+	};
+
+	/**
+	 * @brief std::pmr adapter over a Pool.
+	 * Requests that do not fit a block, by size or alignment, go to the upstream resource.
+	*/
+	class PoolResource final : public std::pmr::memory_resource {
+	public:
+		explicit PoolResource(Pool& pool, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) : pool(pool), upstream(upstream) {}
+
+		inline Pool& GetPool() const { return pool; }
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		inline bool Fits(std::size_t bytes, std::size_t alignment) const {
+			return bytes <= pool.GetBlockSize() && alignment <= pool.GetBlockAlignment();
+		}
+
+		Pool& pool;
+		std::pmr::memory_resource* upstream;
+	};
+
+	/**
+	 * @brief std::pmr adapter over a Tlsf allocator.
+	*/
+	class TlsfResource final : public std::pmr::memory_resource {
+	public:
+		explicit TlsfResource(Tlsf& tlsf) : tlsf(tlsf) {}
+
+		inline Tlsf& GetTlsf() const { return tlsf; }
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* ptr, std::size_t, std::size_t) override { tlsf.Free(ptr); }
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+		Tlsf& tlsf;
+	};
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+/*
+ * Monotonic timing and frame pacing.
+ * All timestamps and durations are integer nanoseconds from a monotonic
+ * clock, so they never jump with wall-clock adjustments and can be
+ * subtracted without losing precision over long sessions.
+ */
+
+#include <vector>
+
+#include "types.h"
+
+namespace crux::clock {
+	// Nanoseconds in one millisecond
+	constexpr uint64bit Millisecond = 1'000'000ull;
+
+	// Nanoseconds in one second
+	constexpr uint64bit Second = 1'000'000'000ull;
+
+	/**
+	 * @brief Reads the monotonic clock.
+	 * @return Nanoseconds since an unspecified fixed point (usually boot)
+	*/
+	uint64bit Now();
+
+	/**
+	 * @brief Converts a nanosecond duration into seconds.
+	*/
+	constexpr double ToSeconds(uint64bit ns) { return (double)ns / (double)Second; }
+
+	/**
+	 * @brief Converts a nanosecond duration into milliseconds.
+	*/
+	constexpr double ToMilliseconds(uint64bit ns) { return (double)ns / (double)Millisecond; }
+
+	/**
+	 * @brief Converts a rate in hertz into the nanoseconds between ticks.
+	 * @return Period in nanoseconds, 0 if the rate is not positive
+	*/
+	constexpr uint64bit FromHertz(double hz) { return hz > 0.0 ? (uint64bit)((double)Second / hz) : 0; }
+
+	/**
+	 * @brief Blocks in the OS scheduler until at least the given deadline.
+	 * Cheap on power, but wakes up late by the scheduler and timer slack,
+	 * anywhere from tens of microseconds to a couple of milliseconds.
+	 * @param deadline Timestamp from Now() to sleep until
+	*/
+	void SleepUntil(uint64bit deadline);
+
+	/**
+	 * @brief Waits until the given deadline as precisely as possible.
+	 *
+	 * Hybrid wait, sleeps in the OS for most of the interval then spins
+	 * for the remainder. The spin margin is learned per thread from how
+	 * late previous sleeps woke up, so on a quiet system the CPU only
+	 * spins for roughly the timer slack, while still landing within
+	 * a few microseconds of the deadline.
+	 * @param deadline Timestamp from Now() to wait until
+	*/
+	void WaitUntil(uint64bit deadline);
+}
+
+namespace crux {
+	/**
+	 * @brief Summary of recent frame times, all in nanoseconds.
+	*/
+	struct FrameStatistics {
+		// Number of frames the statistics cover
+		uint count = 0;
+
+		uint64bit mean = 0;
+		uint64bit p50 = 0;
+		uint64bit p99 = 0;
+		uint64bit min = 0;
+		uint64bit max = 0;
+	};
+
+	/**
+	 * @brief Rolling window of frame times.
+	 * Recording is constant time, the percentiles are computed on demand.
+	*/
+	class FrameHistory {
+	public:
+		/**
+		 * @brief Construct a history keeping the most recent frames.
+		 * @param capacity Number of frames kept, older ones are overwritten
+		*/
+		explicit FrameHistory(uint capacity = 240);
+
+		// Records a frame time in nanoseconds, replacing the oldest once full
+		void Record(uint64bit frameTime);
+
+		// Forgets all recorded frames
+		void Clear();
+
+		// @return Number of frames currently held
+		inline uint GetCount() const { return count; }
+
+		// @return Number of frames held once full
+		inline uint GetCapacity() const { return (uint)samples.size(); }
+
+		/**
+		 * @brief Computes the statistics over the held frames.
+		 * @return Statistics, all zero if nothing was recorded
+		*/
+		FrameStatistics GetStatistics() const;
+
+	private:
+		std::vector<uint64bit> samples;
+
+		// Next slot to write
+		uint next = 0;
+
+		uint count = 0;
+
+		// Scratch for the percentile selection, kept to avoid allocating per call
+		mutable std::vector<uint64bit> sorted;
+	};
+
+	/**
+	 * @brief Fixed timestep accumulator, for simulation decoupled from the frame rate.
+	 *
+	 * Each frame, feed the elapsed time to Accumulate() and run the returned
+	 * number of fixed steps. GetAlpha() is then the fraction of a step left
+	 * over, for interpolating the rendered state between the last two steps.
+	*/
+	class FixedTimestep {
+	public:
+		/**
+		 * @brief Construct an accumulator.
+		 * @param step Length of one simulation step in nanoseconds
+		 * @param maxSteps Limit of steps per frame, time beyond it is dropped
+		 * so a slow frame can not snowball into ever more simulation work
+		*/
+		explicit FixedTimestep(uint64bit step, uint maxSteps = 8);
+
+		/**
+		 * @brief Adds elapsed time and consumes it in whole steps.
+		 * @param elapsed Nanoseconds since the last call
+		 * @return Number of fixed steps to run this frame
+		*/
+		uint Accumulate(uint64bit elapsed);
+
+		// @return Fraction of a step left in the accumulator, in [0, 1)
+		inline double GetAlpha() const { return (double)accumulator / (double)step; }
+
+		// @return Length of one step in nanoseconds
+		inline uint64bit GetStep() const { return step; }
+
+		// @return Length of one step in seconds, for use as the simulation delta
+		inline double GetStepSeconds() const { return clock::ToSeconds(step); }
+
+		// @return Total nanoseconds dropped because of the step limit
+		inline uint64bit GetDroppedTime() const { return dropped; }
+
+		// Empties the accumulator
+		inline void Reset() { accumulator = 0; }
+
+	private:
+		uint64bit step;
+		uint maxSteps;
+		uint64bit accumulator = 0;
+		uint64bit dropped = 0;
+	};
+
+	/**
+	 * @brief Measures and paces frames.
+	 *
+	 * Call Tick() once per frame. With a target rate it first waits, with
+	 * clock::WaitUntil, until the next frame is due, so an idle or light
+	 * loop sleeps instead of spinning. Deadlines advance by whole periods
+	 * from the first frame, rather than from when Tick() returned, so
+	 * wake-up error does not accumulate into drift. After a stall longer
+	 * than a period the schedule restarts from now instead of rushing
+	 * to catch up.
+	*/
+	class FrameTimer {
+	public:
+		/**
+		 * @brief Construct a frame timer.
+		 * @param targetHz Frames per second to pace to, 0 leaves the loop unpaced
+		 * @param historySize Number of frames kept for the statistics
+		*/
+		explicit FrameTimer(double targetHz = 0.0, uint historySize = 240);
+
+		/**
+		 * @brief Changes the pacing rate, ie. lower it while the window is idle or hidden.
+		 * @param hz Frames per second, 0 disables pacing
+		*/
+		void SetTargetRate(double hz);
+
+		// @return Pacing period in nanoseconds, 0 when unpaced
+		inline uint64bit GetTargetPeriod() const { return period; }
+
+		/**
+		 * @brief Ends the current frame, waiting for the target rate if one is set.
+		 * @return Nanoseconds since the previous Tick(), 0 on the first call
+		*/
+		uint64bit Tick();
+
+		// @return Nanoseconds between the last two Tick() calls
+		inline uint64bit GetDelta() const { return delta; }
+
+		// @return Seconds between the last two Tick() calls
+		inline double GetDeltaSeconds() const { return clock::ToSeconds(delta); }
+
+		// @return Nanoseconds of the last frame spent working, that is excluding the pacing wait
+		inline uint64bit GetWorkTime() const { return workTime; }
+
+		// @return Number of Tick() calls so far
+		inline uint64bit GetFrameCount() const { return frameCount; }
+
+		// @return Rolling statistics of the frame deltas
+		inline FrameStatistics GetStatistics() const { return frames.GetStatistics(); }
+
+		// @return Rolling statistics of the work times
+		inline FrameStatistics GetWorkStatistics() const { return work.GetStatistics(); }
+
+	private:
+		uint64bit period = 0;
+
+		// When the next frame is due, 0 before the first Tick()
+		uint64bit deadline = 0;
+
+		uint64bit last = 0;
+		uint64bit delta = 0;
+		uint64bit workTime = 0;
+		uint64bit frameCount = 0;
+
+		FrameHistory frames;
+		FrameHistory work;
+	};
+}
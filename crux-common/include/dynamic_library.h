@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+ * Portable shared library loading, dlopen()/dlsym() on Linux and
+ * LoadLibrary()/GetProcAddress() on Win32.
+ * Every name is loaded once and shared between handles through a
+ * reference count, the OS library is closed with the last handle.
+ * Symbol lookups are cached per library, repeated lookups only take a
+ * shared lock so concurrent readers never wait on each other.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "optional.h"
+#include "span.h"
+#include "types.h"
+
+namespace crux {
+	namespace internal {
+		struct LibraryModule;
+	}
+
+	/**
+	 * @brief Reference counted handle to a loaded shared library.
+	 *
+	 * Copies share the library, which stays loaded until the last copy
+	 * is destroyed. Loading a name that is already loaded returns another
+	 * handle to the same library instead of opening it again.
+	 * Handles may be copied, and symbols resolved, from any thread.
+	*/
+	class DynamicLibrary {
+	public:
+		/**
+		 * @brief Loads a shared library, or shares it if already loaded.
+		 * @param name Library name (OS specific, ie. "libX11.so.6" or "user32.dll")
+		 * @return Handle, or empty if the OS failed to load it (see GetLastErrorString())
+		*/
+		static optional<DynamicLibrary> Load(const string& name);
+
+		/**
+		 * @brief Gets another handle to a library loaded earlier, without loading it.
+		 * @param name Library name as passed to Load()
+		 * @return Handle, or empty if no handle to it is alive
+		*/
+		static optional<DynamicLibrary> Find(std::string_view name);
+
+		// @return Number of distinct libraries currently loaded
+		static std::size_t GetLoadedCount();
+
+		DynamicLibrary() noexcept = default;
+		DynamicLibrary(const DynamicLibrary& other) noexcept;
+		DynamicLibrary(DynamicLibrary&& other) noexcept;
+		DynamicLibrary& operator=(const DynamicLibrary& other) noexcept;
+		DynamicLibrary& operator=(DynamicLibrary&& other) noexcept;
+		~DynamicLibrary();
+
+		// @return True if the handle refers to a loaded library
+		inline bool IsLoaded() const noexcept { return module != nullptr; }
+		inline explicit operator bool() const noexcept { return IsLoaded(); }
+
+		// @return Name the library was loaded under, empty for an empty handle
+		std::string_view GetName() const noexcept;
+
+		// @return The OS handle (void* from dlopen(), HMODULE on Win32)
+		void* GetNativeHandle() const noexcept;
+
+		// @return Number of handles sharing this library
+		uint GetReferenceCount() const noexcept;
+
+		// Drops this handle, closing the library if it was the last one
+		void Reset() noexcept;
+
+		/**
+		 * @brief Resolves an exported symbol.
+		 * Results, including missing symbols, are cached, only the first
+		 * lookup of a name reaches the OS.
+		 * @param symbol Exported name
+		 * @return Address of the symbol, or nullptr if not exported
+		*/
+		void* GetSymbol(std::string_view symbol) const;
+
+		/**
+		 * @brief GetSymbol() cast to a function pointer.
+		 * @tparam Fn Function type, ie. int(const char*)
+		*/
+		template<typename Fn>
+		inline Fn* GetFunction(std::string_view symbol) const {
+			return reinterpret_cast<Fn*>(GetSymbol(symbol));
+		}
+
+		/**
+		 * @brief Resolves several symbols at once, taking the cache locks once for the batch.
+		 * @param symbols Exported names
+		 * @param out Receives each address, or nullptr, in the order of symbols, must be as long
+		 * @return Number of symbols found
+		*/
+		std::size_t GetSymbols(span<const std::string_view> symbols, span<void*> out) const;
+
+	private:
+		explicit DynamicLibrary(internal::LibraryModule* module) noexcept : module(module) {}
+
+		internal::LibraryModule* module = nullptr;
+	};
+
+	/**
+	 * @brief Library loaded the first time one of its symbols is needed.
+	 *
+	 * Lets startup name every optional module up front without paying
+	 * for the ones a run never touches. The load is attempted once, a
+	 * failed load stays failed. Safe to use from several threads.
+	*/
+	class LazyLibrary {
+	public:
+		explicit LazyLibrary(string name) : name(std::move(name)) {}
+
+		LazyLibrary(const LazyLibrary&) = delete;
+		LazyLibrary& operator=(const LazyLibrary&) = delete;
+
+		inline const string& GetName() const noexcept { return name; }
+
+		// @return True once a load was attempted, successful or not
+		inline bool IsResolved() const noexcept { return resolved.load(std::memory_order_acquire); }
+
+		// @return True if the library was loaded, without triggering the load
+		inline bool IsLoaded() const noexcept { return IsResolved() && library.has_value(); }
+
+		/**
+		 * @brief Loads the library if not attempted yet.
+		 * @return The library, or empty if it failed to load
+		*/
+		const optional<DynamicLibrary>& Get();
+
+		// @return DynamicLibrary::GetSymbol(), loading the library first if needed
+		void* GetSymbol(std::string_view symbol);
+
+		template<typename Fn>
+		inline Fn* GetFunction(std::string_view symbol) {
+			return reinterpret_cast<Fn*>(GetSymbol(symbol));
+		}
+
+		// @return DynamicLibrary::GetSymbols(), loading the library first if needed
+		std::size_t GetSymbols(span<const std::string_view> symbols, span<void*> out);
+
+	private:
+		string name;
+		std::once_flag once;
+		std::atomic<bool> resolved{ false };
+		optional<DynamicLibrary> library;
+	};
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+/*
+ * Work-stealing job system.
+ * Each worker thread owns a Chase-Lev deque, new jobs go to the bottom of
+ * the submitting worker's deque and idle workers steal from the top of
+ * the others. Completion is tracked with JobCounter, which can be waited
+ * on (the waiting thread runs jobs meanwhile) or used as a dependency.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+#include "ws_deque.h"
+
+namespace crux {
+	class JobCounter;
+
+	namespace internal {
+		/**
+		 * @brief A queued job, the callable is stored inline to avoid a second allocation.
+		*/
+		struct Job {
+			// Bytes available for the callable's captures
+			static constexpr std::size_t StorageSize = 64;
+
+			void (*invoke)(void* storage) = nullptr;
+			void (*destroy)(void* storage) = nullptr;
+
+			// Decremented once the job has run, may be null
+			JobCounter* counter = nullptr;
+
+			alignas(std::max_align_t) unsigned char storage[StorageSize];
+		};
+	}
+
+	/**
+	 * @brief Counts outstanding jobs.
+	 *
+	 * Incremented when a job referencing it is submitted and decremented when
+	 * that job finishes. JobSystem::Wait blocks until it reaches zero, and
+	 * JobSystem::RunAfter holds jobs back until then.
+	 * A counter must outlive the jobs referencing it, and waiting on it is
+	 * the usual way to guarantee that.
+	*/
+	class JobCounter {
+		friend class JobSystem;
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		// @return True once every job referencing the counter has finished
+		inline bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+		// @return Number of jobs still outstanding
+		inline uint GetPending() const { return pending.load(std::memory_order_acquire); }
+
+	private:
+		std::atomic<uint> pending{ 0 };
+
+		// Guards continuations, and is held while the count drops to zero
+		std::mutex lock;
+
+		// Jobs submitted through RunAfter, released when the count reaches zero
+		std::vector<internal::Job*> continuations;
+	};
+
+	/**
+	 * @brief Scheduler running jobs on a pool of worker threads.
+	 *
+	 * The thread constructing the system acts as an extra worker while it
+	 * waits, so a system with N workers runs jobs on N+1 threads. Jobs may
+	 * be submitted from any thread, those from outside the pool go through
+	 * a shared queue. Idle workers spin briefly then sleep until new work
+	 * is submitted.
+	 *
+	 * Callables must fit in internal::Job::StorageSize bytes, capture large
+	 * state by reference or pointer.
+	*/
+	class JobSystem {
+	public:
+		// Jobs each worker's deque can hold before submissions run inline
+		static constexpr std::size_t DequeCapacity = 4096;
+
+		/**
+		 * @brief Construct a job system and start its workers.
+		 * @param workerCount Background worker threads, see DefaultWorkerCount()
+		*/
+		explicit JobSystem(uint workerCount = DefaultWorkerCount());
+
+		/**
+		 * @brief Stops and joins the workers.
+		 * Jobs that have not started are discarded without running,
+		 * wait on their counters first to have them complete.
+		*/
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// @return One worker per hardware thread, less the constructing thread
+		static uint DefaultWorkerCount();
+
+		// @return Number of background worker threads
+		inline uint GetWorkerCount() const { return workerSlots - 1; }
+
+		// @return Number of threads running jobs, the workers plus the constructing thread
+		inline uint GetThreadCount() const { return workerSlots; }
+
+		/**
+		 * @brief Submits a job.
+		 * @param fn Callable taking no arguments
+		 * @param counter Optional counter incremented now and decremented once fn returns
+		*/
+		template<typename Fn>
+		void Run(Fn&& fn, JobCounter* counter = nullptr) {
+			if (counter)
+				counter->pending.fetch_add(1, std::memory_order_relaxed);
+			Submit(MakeJob(std::forward<Fn>(fn), counter));
+		}
+
+		/**
+		 * @brief Submits a job once all jobs of a dependency have finished.
+		 * Runs straight away if the dependency is already done.
+		 * @param dependency Counter to wait for, must outlive the jobs it tracks
+		 * @param fn Callable taking no arguments
+		 * @param counter Optional counter incremented now and decremented once fn returns
+		*/
+		template<typename Fn>
+		void RunAfter(JobCounter& dependency, Fn&& fn, JobCounter* counter = nullptr) {
+			if (counter)
+				counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+			internal::Job* job = MakeJob(std::forward<Fn>(fn), counter);
+			{
+				std::lock_guard<std::mutex> guard(dependency.lock);
+				if (!dependency.IsDone()) {
+					dependency.continuations.push_back(job);
+					return;
+				}
+			}
+			Submit(job);
+		}
+
+		/**
+		 * @brief Blocks until the counter reaches zero, running jobs in the meantime.
+		 * Safe to call from within a job, which keeps the worker busy instead of stalling it.
+		*/
+		void Wait(JobCounter& counter);
+
+		/**
+		 * @brief Runs one queued job on the calling thread, if any is available.
+		 * For waits not expressed as a JobCounter, poll this instead of idling.
+		 * @return True if a job ran
+		*/
+		bool TryRunPending();
+
+		/**
+		 * @brief Splits a range into jobs and waits for all of them.
+		 *
+		 * The range is halved recursively, the upper half submitted as a job
+		 * and the lower half split further, so idle workers steal large
+		 * chunks first and only the last levels are fine grained.
+		 * @param begin First index
+		 * @param end One past the last index
+		 * @param grain Largest sub-range run by a single call of fn
+		 * @param fn Callable taking (std::size_t first, std::size_t last) for a half-open sub-range
+		*/
+		template<typename Fn>
+		void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, const Fn& fn) {
+			if (end <= begin)
+				return;
+
+			JobCounter counter;
+			ParallelForRange(begin, end, std::max<std::size_t>(grain, 1), fn, counter);
+			Wait(counter);
+		}
+
+	private:
+		/**
+		 * @brief Per thread state, padded so neighbouring workers do not false share.
+		*/
+		struct alignas(ws_deque<internal::Job*>::CacheLine) Worker {
+			Worker() : jobs(DequeCapacity) {}
+
+			ws_deque<internal::Job*> jobs;
+			std::thread thread;
+
+			// Seed for picking steal victims
+			uint32bit random = 0;
+		};
+
+		template<typename Fn>
+		internal::Job* MakeJob(Fn&& fn, JobCounter* counter) {
+			using Callable = std::decay_t<Fn>;
+			static_assert(sizeof(Callable) <= internal::Job::StorageSize, "Job callable is too large, capture by reference instead");
+			static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job callable is over-aligned");
+
+			internal::Job* job = AllocateJob();
+			new (job->storage) Callable(std::forward<Fn>(fn));
+			job->invoke = [](void* storage) { (*static_cast<Callable*>(storage))(); };
+			job->destroy = [](void* storage) { static_cast<Callable*>(storage)->~Callable(); };
+			job->counter = counter;
+			return job;
+		}
+
+		template<typename Fn>
+		void ParallelForRange(std::size_t first, std::size_t last, std::size_t grain, const Fn& fn, JobCounter& counter) {
+			while (last - first > grain) {
+				const std::size_t mid = first + (last - first) / 2;
+				Run([this, mid, last, grain, &fn, &counter] { ParallelForRange(mid, last, grain, fn, counter); }, &counter);
+				last = mid;
+			}
+			fn(first, last);
+		}
+
+		// Body of the background worker threads
+		void WorkerLoop(uint index);
+
+		// Queues a job on the calling worker, or the shared queue from outside the pool
+		void Submit(internal::Job* job);
+
+		/**
+		 * @brief Finds a job for the given worker, from its own deque, the
+		 * shared queue, then by stealing.
+		 * @param index Worker slot, or an out of range value for threads outside the pool
+		 * @return Job to run, or nullptr if none was found
+		*/
+		internal::Job* FindJob(uint index);
+
+		// Runs a job, releases it and signals its counter
+		void Execute(internal::Job* job);
+
+		// Decrements a counter, releasing its continuations when it reaches zero
+		void FinishJob(JobCounter& counter);
+
+		// Wakes a sleeping worker, if any
+		void Notify();
+
+		// @return Worker slot of the calling thread, or an out of range value if outside the pool
+		uint GetCurrentIndex() const;
+
+		static internal::Job* AllocateJob();
+		static void FreeJob(internal::Job* job);
+
+		// Slot 0 belongs to the constructing thread, the others to the background threads
+		std::unique_ptr<Worker[]> workers;
+		uint workerSlots = 0;
+
+		// Jobs submitted from threads outside the pool
+		std::mutex injectLock;
+		std::deque<internal::Job*> injected;
+		std::atomic<std::size_t> injectedCount{ 0 };
+
+		// Sleeping workers wait on sleepCondition until the epoch changes
+		std::mutex sleepLock;
+		std::condition_variable sleepCondition;
+		std::atomic<uint64bit> epoch{ 0 };
+		std::atomic<uint> sleeping{ 0 };
+
+		std::atomic<bool> stopping{ false };
+	};
+}
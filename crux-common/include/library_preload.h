@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ * Background loading of shared libraries on a JobSystem.
+ * Loading a library is mostly file I/O, relocation and static
+ * initialization, none of which the main thread needs to wait on
+ * before it can get a window on screen.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "dynamic_library.h"
+#include "jobs.h"
+#include "optional.h"
+#include "task.h"
+
+namespace crux {
+	/**
+	 * @brief Loads a set of libraries in parallel, one job per library.
+	 *
+	 * The loads are queued on construction and run on the job system's
+	 * workers while the caller carries on. Get() waits for a single
+	 * library, so startup only blocks on the modules it needs right away.
+	 * Waiting runs queued jobs on the calling thread, so this also works
+	 * on a job system without workers (the loads then happen on first wait).
+	 * Destruction waits for loads still running.
+	*/
+	class LibraryPreload {
+	public:
+		/**
+		 * @brief Queues the loads.
+		 * @param jobs Job system to load on, must outlive the preload
+		 * @param names Library names (OS specific)
+		*/
+		LibraryPreload(JobSystem& jobs, const std::vector<string>& names);
+		~LibraryPreload();
+
+		LibraryPreload(const LibraryPreload&) = delete;
+		LibraryPreload& operator=(const LibraryPreload&) = delete;
+
+		// @return Number of libraries requested
+		inline std::size_t GetCount() const noexcept { return count; }
+
+		// @return True once every load has finished, successful or not
+		inline bool IsReady() const { return counter.IsDone(); }
+
+		// @return True once the library at index has finished loading, successful or not
+		bool IsReady(std::size_t index) const;
+
+		// Waits for every load to finish
+		void Wait();
+
+		/**
+		 * @brief Waits for one library.
+		 * @param index Position of the library in the names given on construction
+		 * @return The library, or empty if it failed to load
+		*/
+		const optional<DynamicLibrary>& Get(std::size_t index);
+
+		/**
+		 * @brief Waits for one library, looked up by name.
+		 * @return The library, or empty if it failed to load or was not requested
+		*/
+		optional<DynamicLibrary> Get(std::string_view name);
+
+	private:
+		struct Slot {
+			string name;
+			optional<DynamicLibrary> library;
+			std::atomic<bool> done{ false };
+		};
+
+		JobSystem& jobs;
+		std::unique_ptr<Slot[]> slots;
+		std::size_t count;
+		JobCounter counter;
+	};
+
+	/**
+	 * @brief Loads a library on a job system worker.
+	 * The task is lazy like every task, the load is queued when it is first awaited.
+	 * @param name Library name (OS specific)
+	 * @param jobs Job system to load on
+	 * @return Task producing the library, or empty if it failed to load
+	*/
+	task<optional<DynamicLibrary>> LoadLibraryAsync(string name, JobSystem& jobs);
+}
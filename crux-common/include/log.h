@@ -0,0 +1,343 @@
+#pragma once
+
+/*
+ * Asynchronous logging.
+ * A log call captures its arguments by value into a fixed size record and
+ * pushes it onto a lock-free queue, the printf style formatting and the
+ * writes to the sinks happen later on a background thread started by
+ * Start(). Until then (and after Stop()) records are formatted and written
+ * right away on the calling thread.
+ *
+ * Use the CRUX_LOG_* macros, calls below CRUX_LOG_LEVEL are compiled out
+ * entirely, their arguments are not even evaluated.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "types.h"
+
+namespace crux::log {
+	/**
+	 * @brief Severity of a log record, in increasing order.
+	*/
+	enum class Level : uint8bit {
+		TRACE = 0,
+		DEBUG,
+		INFO,
+		WARN,
+		ERR, //Not ERROR, wingdi.h defines that as a macro
+		FATAL,
+
+		OFF
+	};
+}
+
+/*
+ * Lowest level compiled in, as the numeric value of a crux::log::Level.
+ * Defaults to everything in debug builds and INFO otherwise.
+ */
+#ifndef CRUX_LOG_LEVEL
+	#if CRUX_DEBUG
+		#define CRUX_LOG_LEVEL 0
+	#else
+		#define CRUX_LOG_LEVEL 2
+	#endif
+#endif
+
+/*
+ * Logs a printf style message at the given level (TRACE, DEBUG, INFO, WARN, ERR or FATAL).
+ * The format must be a string literal, or otherwise outlive the logging thread.
+ */
+#define CRUX_LOG(level, ...) \
+	do { \
+		if constexpr ((int)::crux::log::Level::level >= CRUX_LOG_LEVEL) { \
+			if (::crux::log::IsEnabled(::crux::log::Level::level)) \
+				::crux::log::Write(::crux::log::Level::level, __FILE__, __LINE__, __VA_ARGS__); \
+		} \
+	} while (0)
+
+#define CRUX_LOG_TRACE(...) CRUX_LOG(TRACE, __VA_ARGS__)
+#define CRUX_LOG_DEBUG(...) CRUX_LOG(DEBUG, __VA_ARGS__)
+#define CRUX_LOG_INFO(...) CRUX_LOG(INFO, __VA_ARGS__)
+#define CRUX_LOG_WARN(...) CRUX_LOG(WARN, __VA_ARGS__)
+#define CRUX_LOG_ERROR(...) CRUX_LOG(ERR, __VA_ARGS__)
+#define CRUX_LOG_FATAL(...) CRUX_LOG(FATAL, __VA_ARGS__)
+
+namespace crux::log {
+	/**
+	 * @brief An OS error code, turned into its message only when the record is formatted.
+	 * Formats as the message with %s and as the number with %d, %u or %x.
+	*/
+	struct SystemError {
+		uint32bit code = 0;
+	};
+
+	/**
+	 * @brief Captures the calling thread's last OS error, errno or GetLastError().
+	 * Looking up the message is left to the logging thread.
+	*/
+	SystemError LastError();
+
+	/**
+	 * @brief One log record as handed to the sinks.
+	*/
+	struct Entry {
+		// clock::Now() when the record was logged
+		uint64bit timestamp = 0;
+
+		Level level = Level::INFO;
+
+		// Small number identifying the logging thread, in order of their first log call
+		uint32bit thread = 0;
+
+		// Source location of the log call
+		const char* file = "";
+		uint32bit line = 0;
+
+		// Formatted message alone
+		std::string_view message;
+
+		// Whole line with the timestamp, level and thread in front, ends in a newline
+		std::string_view text;
+	};
+
+	/**
+	 * @brief Destination of formatted records.
+	 * Sinks are only called from one thread at a time, the logging thread
+	 * once Start() was called, so they need no locking of their own.
+	*/
+	class Sink {
+	public:
+		virtual ~Sink() = default;
+
+		// Writes one record
+		virtual void Write(const Entry& entry) = 0;
+
+		// Pushes out anything buffered, called whenever the queue runs empty
+		virtual void Flush() {}
+	};
+
+	/**
+	 * @brief Writes to stdout, ERR and FATAL records go to stderr.
+	*/
+	class ConsoleSink : public Sink {
+	public:
+		void Write(const Entry& entry) override;
+		void Flush() override;
+	};
+
+	/**
+	 * @brief Writes to a file, kept open for the sink's lifetime.
+	*/
+	class FileSink : public Sink {
+	public:
+		/**
+		 * @param path File to write to (UTF-8)
+		 * @param append Keep existing contents instead of truncating
+		*/
+		explicit FileSink(const string& path, bool append = true);
+		~FileSink() override;
+
+		FileSink(const FileSink&) = delete;
+		FileSink& operator=(const FileSink&) = delete;
+
+		// @return True if the file could be opened
+		inline bool IsOpen() const noexcept { return file != nullptr; }
+
+		void Write(const Entry& entry) override;
+		void Flush() override;
+
+	private:
+		std::FILE* file = nullptr;
+	};
+
+	/**
+	 * @brief Settings of the logging thread, see Start().
+	*/
+	struct Config {
+		// Records the queue holds before new ones are dropped, rounded up to a power of two
+		std::size_t capacity = 4096;
+
+		// Adds a ConsoleSink if no sink was added beforehand
+		bool console = true;
+	};
+
+	/**
+	 * @brief Starts the logging thread, from here on log calls only queue their records.
+	 * The queue is created by the first call and kept for the rest of the run,
+	 * later calls reuse it whatever their capacity.
+	*/
+	void Start(const Config& config = {});
+
+	/**
+	 * @brief Writes out everything queued and joins the logging thread.
+	 * Later log calls are written synchronously again. Call it once other
+	 * threads stopped logging, records racing with it may be held back until the next Start().
+	*/
+	void Stop();
+
+	// @return True between Start() and Stop()
+	bool IsRunning();
+
+	/**
+	 * @brief Blocks until every record logged before the call has reached the sinks,
+	 * and the sinks were flushed.
+	*/
+	void Flush();
+
+	/**
+	 * @brief Adds a destination for the records.
+	 * Before Start() or after Stop() with no sink, records go to stdout.
+	*/
+	void AddSink(std::unique_ptr<Sink> sink);
+
+	// Removes every sink
+	void ClearSinks();
+
+	// @return Records dropped since startup because the queue was full
+	uint64bit GetDroppedCount();
+
+	// @return Display name of the level, ie. "INFO"
+	const char* GetLevelName(Level level);
+
+	namespace internal {
+		// Runtime threshold, read by IsEnabled() on every log call
+		inline std::atomic<uint8bit> CurrentLevel{ (uint8bit)Level::TRACE };
+
+		enum class ArgType : uint8bit {
+			INT = 0,
+			UINT,
+			DOUBLE,
+			POINTER,
+			STRING,
+			SYSTEM_ERROR
+		};
+
+		// Size of one queue slot
+		constexpr std::size_t RecordSize = 256;
+
+		// Most arguments a single call may pass
+		constexpr std::size_t MaxArguments = 16;
+
+		/**
+		 * @brief A log call as captured on the calling thread.
+		 * Values are stored back to back in payload, strings as a 16 bit
+		 * length followed by the characters, truncated when out of room.
+		*/
+		struct Record {
+			uint64bit timestamp;
+			const char* format;
+			const char* file;
+			uint32bit line;
+			uint32bit thread;
+			Level level;
+			uint8bit argCount;
+			uint16bit size;
+			ArgType types[MaxArguments];
+			byte payload[RecordSize - 52]; //Whatever the fields above leave of the slot
+		};
+		static_assert(sizeof(Record) == RecordSize, "log records must fill exactly one queue slot");
+
+		// Starts the calling thread's record, the buffer is thread local and reused by every call
+		Record& BeginRecord(Level level, const char* file, uint32bit line, const char* format);
+
+		// Queues the record, or writes it right away when the logging thread is not running
+		void Submit(Record& record);
+
+		inline void Append(Record& record, ArgType type, const void* data, std::size_t size) {
+			if (record.size + size > sizeof(record.payload) || record.argCount >= MaxArguments)
+				return;
+
+			std::memcpy(record.payload + record.size, data, size);
+			record.size += (uint16bit)size;
+			record.types[record.argCount++] = type;
+		}
+
+		inline void AppendString(Record& record, std::string_view text) {
+			if (record.size + sizeof(uint16bit) > sizeof(record.payload) || record.argCount >= MaxArguments)
+				return;
+
+			//Truncated to whatever room is left
+			std::size_t length = sizeof(record.payload) - record.size - sizeof(uint16bit);
+			if (text.size() < length)
+				length = text.size();
+
+			const uint16bit stored = (uint16bit)length;
+			std::memcpy(record.payload + record.size, &stored, sizeof(stored));
+			std::memcpy(record.payload + record.size + sizeof(stored), text.data(), length);
+			record.size += (uint16bit)(sizeof(stored) + length);
+			record.types[record.argCount++] = ArgType::STRING;
+		}
+
+		template<typename T>
+		inline void Encode(Record& record, const T& value) {
+			using Type = std::decay_t<T>;
+
+			if constexpr (std::is_same_v<Type, SystemError>) {
+				Append(record, ArgType::SYSTEM_ERROR, &value.code, sizeof(value.code));
+			} else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+				AppendString(record, value ? std::string_view(value) : std::string_view("(null)"));
+			} else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+				AppendString(record, std::string_view(value));
+			} else if constexpr (std::is_enum_v<Type>) {
+				Encode(record, (std::underlying_type_t<Type>)value);
+			} else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+				const long long stored = value;
+				Append(record, ArgType::INT, &stored, sizeof(stored));
+			} else if constexpr (std::is_integral_v<Type>) {
+				const unsigned long long stored = value;
+				Append(record, ArgType::UINT, &stored, sizeof(stored));
+			} else if constexpr (std::is_floating_point_v<Type>) {
+				const double stored = (double)value;
+				Append(record, ArgType::DOUBLE, &stored, sizeof(stored));
+			} else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+				const void* stored = (const void*)value;
+				Append(record, ArgType::POINTER, &stored, sizeof(stored));
+			} else {
+				static_assert(std::is_pointer_v<Type>, "unsupported log argument type");
+			}
+		}
+	}
+
+	// @return True if records at the given level currently pass the runtime threshold
+	inline bool IsEnabled(Level level) {
+		return (uint8bit)level >= internal::CurrentLevel.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Runtime threshold, on top of CRUX_LOG_LEVEL which already removed lower calls.
+	*/
+	inline void SetLevel(Level level) {
+		internal::CurrentLevel.store((uint8bit)level, std::memory_order_relaxed);
+	}
+
+	// @return The runtime threshold
+	inline Level GetLevel() {
+		return (Level)internal::CurrentLevel.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Logs a record, prefer the CRUX_LOG_* macros which also filter at compile time.
+	 *
+	 * The format takes printf conversions (without * widths), each formatted
+	 * with the type the argument was captured as, so a mismatched length
+	 * modifier cannot read garbage. Strings are copied, everything else is
+	 * stored by value. Arguments that no longer fit in the record are dropped.
+	 * @param format printf style format, must stay valid until the record is written (a literal)
+	*/
+	template<typename... Args>
+	void Write(Level level, const char* file, uint32bit line, const char* format, const Args&... args) {
+		static_assert(sizeof...(Args) <= internal::MaxArguments, "too many log arguments");
+
+		internal::Record& record = internal::BeginRecord(level, file, line, format);
+		(internal::Encode(record, args), ...);
+		internal::Submit(record);
+	}
+}
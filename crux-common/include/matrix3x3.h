@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+
+#include "optional.h"
+#include "quaternion.h"
+#include "vector3.h"
+
+namespace crux {
+	/**
+	 * @brief 3x3 matrix, stored column-major and multiplied against column vectors.
+	 *
+	 * Indexing is m[column][row]. Default constructs to the identity matrix.
+	*/
+	template<typename T>
+	struct matrix3x3 {
+		using value_type = T;
+		using column_type = vector3<T>;
+
+		vector3<T> columns[3];
+
+		constexpr matrix3x3() : columns{ { T{ 1 }, T{}, T{} }, { T{}, T{ 1 }, T{} }, { T{}, T{}, T{ 1 } } } {}
+		constexpr explicit matrix3x3(const T& diagonal) : columns{ { diagonal, T{}, T{} }, { T{}, diagonal, T{} }, { T{}, T{}, diagonal } } {}
+		constexpr matrix3x3(const vector3<T>& c0, const vector3<T>& c1, const vector3<T>& c2) : columns{ c0, c1, c2 } {}
+
+		constexpr matrix3x3(const matrix3x3<T>&) = default;
+		constexpr matrix3x3(matrix3x3<T>&&) = default;
+		constexpr matrix3x3<T>& operator=(const matrix3x3<T>&) = default;
+		constexpr matrix3x3<T>& operator=(matrix3x3<T>&&) = default;
+
+		constexpr matrix3x3<T>& operator*=(const matrix3x3<T>& obj) { return *this = *this * obj; }
+
+		constexpr vector3<T>& operator[](std::size_t col) { return columns[col]; }
+		constexpr const vector3<T>& operator[](std::size_t col) const { return columns[col]; }
+
+		// @return The identity matrix
+		static constexpr matrix3x3<T> Identity() { return matrix3x3<T>(); }
+
+		// @return A scaling matrix
+		static constexpr matrix3x3<T> Scale(const vector3<T>& scale) {
+			return matrix3x3<T>({ scale.x, T{}, T{} }, { T{}, scale.y, T{} }, { T{}, T{}, scale.z });
+		}
+
+		// @return The rotation matrix equivalent of a unit quaternion
+		static constexpr matrix3x3<T> Rotation(const quaternion<T>& q) {
+			const T xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+			const T xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+			const T wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+			return matrix3x3<T>(
+				{ T{ 1 } - T{ 2 } * (yy + zz), T{ 2 } * (xy + wz), T{ 2 } * (xz - wy) },
+				{ T{ 2 } * (xy - wz), T{ 1 } - T{ 2 } * (xx + zz), T{ 2 } * (yz + wx) },
+				{ T{ 2 } * (xz + wy), T{ 2 } * (yz - wx), T{ 1 } - T{ 2 } * (xx + yy) }
+			);
+		}
+	};
+
+	template<typename T>
+	constexpr bool operator==(const matrix3x3<T>& lhs, const matrix3x3<T>& rhs) { return lhs[0] == rhs[0] && lhs[1] == rhs[1] && lhs[2] == rhs[2]; }
+
+	template<typename T>
+	constexpr bool operator!=(const matrix3x3<T>& lhs, const matrix3x3<T>& rhs) { return !(lhs == rhs); }
+
+	template<typename T>
+	constexpr vector3<T> operator*(const matrix3x3<T>& lhs, const vector3<T>& rhs) {
+		return lhs[0] * rhs.x + lhs[1] * rhs.y + lhs[2] * rhs.z;
+	}
+
+	template<typename T>
+	constexpr matrix3x3<T> operator*(const matrix3x3<T>& lhs, const matrix3x3<T>& rhs) {
+		return matrix3x3<T>(lhs * rhs[0], lhs * rhs[1], lhs * rhs[2]);
+	}
+
+	template<typename T>
+	constexpr matrix3x3<T> operator*(const matrix3x3<T>& lhs, const typename matrix3x3<T>::value_type& rhs) {
+		return matrix3x3<T>(lhs[0] * rhs, lhs[1] * rhs, lhs[2] * rhs);
+	}
+
+	template<typename T>
+	constexpr matrix3x3<T> Transpose(const matrix3x3<T>& obj) {
+		return matrix3x3<T>(
+			{ obj[0].x, obj[1].x, obj[2].x },
+			{ obj[0].y, obj[1].y, obj[2].y },
+			{ obj[0].z, obj[1].z, obj[2].z }
+		);
+	}
+
+	template<typename T>
+	constexpr T Determinant(const matrix3x3<T>& obj) { return Dot(obj[0], Cross(obj[1], obj[2])); }
+
+	/**
+	 * @brief Inverts the matrix.
+	 * @return The inverse, or nullopt if the matrix is singular
+	*/
+	template<typename T>
+	constexpr optional<matrix3x3<T>> Inverse(const matrix3x3<T>& obj) {
+		//The rows of the inverse are the cross products of column pairs, over the determinant
+		const vector3<T> r0 = Cross(obj[1], obj[2]);
+		const vector3<T> r1 = Cross(obj[2], obj[0]);
+		const vector3<T> r2 = Cross(obj[0], obj[1]);
+		const T det = Dot(obj[0], r0);
+		if (det == T{})
+			return nullopt;
+
+		return Transpose(matrix3x3<T>(r0, r1, r2)) * (T{ 1 } / det);
+	}
+
+	template<typename T>
+	std::ostream& operator<<(std::ostream& out, const matrix3x3<T>& obj) {
+		out << "matrix3x3{" << obj[0] << ", " << obj[1] << ", " << obj[2] << "}";
+		return out;
+	}
+
+	static_assert(std::is_trivially_copyable_v<matrix3x3<float>>, "matrix3x3 must be trivially copyable");
+	static_assert(sizeof(matrix3x3<float>) == 9 * sizeof(float), "matrix3x3 must not be padded");
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+/*
+ * Bounded lock-free multi-producer/single-consumer ring buffer.
+ * Any number of threads may push concurrently, exactly one thread may pop.
+ * Neither side takes a lock or allocates after construction.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace crux {
+	/**
+	 * @brief Bounded lock-free multi-producer/single-consumer queue.
+	 *
+	 * Every slot carries a sequence number telling whether it is free for the
+	 * producer claiming that lap or holds a value for the consumer. Producers
+	 * race for the tail with a single compare-exchange and then write their
+	 * slot independently, so a producer stalled mid-write only holds up the
+	 * consumer at that slot, never the other producers.
+	 * The capacity is rounded up to a power of two so indices wrap with a mask.
+	 * @tparam T Element type, must be trivially copyable
+	*/
+	template<typename T>
+	class mpsc_queue {
+		static_assert(std::is_trivially_copyable<T>::value, "mpsc_queue elements must be trivially copyable");
+
+	public:
+		// Assumed size of a cache line, used to keep the indices from false sharing
+		static constexpr std::size_t CacheLine = 64;
+
+		/**
+		 * @brief Construct a queue holding at least the given number of elements.
+		 * @param minCapacity Requested capacity, rounded up to a power of two (minimum 2)
+		*/
+		explicit mpsc_queue(std::size_t minCapacity) {
+			std::size_t cap = 2;
+			while (cap < minCapacity)
+				cap <<= 1;
+			mask = cap - 1;
+			slots = std::make_unique<Slot[]>(cap);
+			for (std::size_t i = 0; i < cap; ++i)
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpsc_queue(const mpsc_queue&) = delete;
+		mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+		/**
+		 * @brief Producer side, appends an element. Safe to call from any thread.
+		 * @return False if the queue is full, the element is not added
+		*/
+		bool try_push(const T& value) {
+			std::size_t t = tail.load(std::memory_order_relaxed);
+			Slot* slot;
+			for (;;) {
+				slot = &slots[t & mask];
+				const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				const std::ptrdiff_t lap = (std::ptrdiff_t)(sequence - t);
+				if (lap == 0) {
+					if (tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed))
+						break;
+				} else if (lap < 0) {
+					//The consumer has not freed this slot from the previous lap yet
+					return false;
+				} else {
+					t = tail.load(std::memory_order_relaxed);
+				}
+			}
+
+			slot->value = value;
+			slot->sequence.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Consumer side, removes the oldest element.
+		 * @return False if the queue is empty or the oldest push is still being written, out is untouched
+		*/
+		bool try_pop(T& out) {
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			Slot& slot = slots[h & mask];
+			if (slot.sequence.load(std::memory_order_acquire) != h + 1)
+				return false;
+
+			out = slot.value;
+			slot.sequence.store(h + mask + 1, std::memory_order_release);
+			head.store(h + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// @return Approximate element count, including pushes still being written
+		std::size_t size_approx() const {
+			const std::size_t h = head.load(std::memory_order_acquire);
+			const std::size_t t = tail.load(std::memory_order_acquire);
+			return t - h;
+		}
+
+		// @return True if the queue looked empty at the time of the call
+		bool empty() const { return size_approx() == 0; }
+
+		// @return Maximum number of elements the queue can hold
+		std::size_t capacity() const { return mask + 1; }
+
+	private:
+		struct Slot {
+			std::atomic<std::size_t> sequence{ 0 };
+			T value;
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		std::size_t mask = 0;
+
+		//Consumer owned, atomic only so size_approx() can read it
+		alignas(CacheLine) std::atomic<std::size_t> head{ 0 };
+
+		//Shared by every producer
+		alignas(CacheLine) std::atomic<std::size_t> tail{ 0 };
+	};
+}
@@ -7,11 +7,91 @@
 
 //Macro variables for switching code later
 #ifndef CRUX_PLATFORM
-	#ifdef CRUX_WIN32
+	#if defined(CRUX_WIN32) && CRUX_WIN32
 		#define CRUX_PLATFORM "Win32"
+	#elif defined(CRUX_UNIX) && CRUX_UNIX
+		#define CRUX_PLATFORM "Linux"
 	#elif defined(WIN32) || defined(__WIN32__) || defined(__MINGW32__)
 		#define CRUX_WIN32 1
 		#define CRUX_PLATFORM "Win32"
+	#elif defined(__linux__)
+		#define CRUX_UNIX 1
+		#define CRUX_PLATFORM "Linux"
+	#endif
+#endif
+
+//SIMD instruction sets the compiler is allowed to emit for this target.
+//Define CRUX_NO_SIMD to force the scalar fallbacks everywhere.
+#ifndef CRUX_SIMD_SSE2
+	#if !defined(CRUX_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+		#define CRUX_SIMD_SSE2 1
+	#else
+		#define CRUX_SIMD_SSE2 0
+	#endif
+#endif
+
+#ifndef CRUX_SIMD_SSE41
+	#if CRUX_SIMD_SSE2 && (defined(__SSE4_1__) || defined(__AVX__))
+		#define CRUX_SIMD_SSE41 1
+	#else
+		#define CRUX_SIMD_SSE41 0
+	#endif
+#endif
+
+#ifndef CRUX_SIMD_AVX
+	#if CRUX_SIMD_SSE2 && defined(__AVX__)
+		#define CRUX_SIMD_AVX 1
+	#else
+		#define CRUX_SIMD_AVX 0
+	#endif
+#endif
+
+#ifndef CRUX_SIMD_AVX2
+	#if CRUX_SIMD_AVX && defined(__AVX2__)
+		#define CRUX_SIMD_AVX2 1
+	#else
+		#define CRUX_SIMD_AVX2 0
+	#endif
+#endif
+
+#ifndef CRUX_SIMD_FMA
+	#if CRUX_SIMD_AVX && (defined(__FMA__) || defined(__AVX2__))
+		#define CRUX_SIMD_FMA 1
+	#else
+		#define CRUX_SIMD_FMA 0
+	#endif
+#endif
+
+//Marks a pointer as not aliasing any other pointer in scope, to help loop vectorization
+#ifndef CRUX_RESTRICT
+	#define CRUX_RESTRICT __restrict
+#endif
+
+//Lets constexpr functions pick a runtime-only path (ie. intrinsics) outside of constant evaluation
+#ifndef CRUX_IS_CONSTANT_EVALUATED
+	#if defined(__has_builtin)
+		#if __has_builtin(__builtin_is_constant_evaluated)
+			#define CRUX_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+		#endif
+	#endif
+#endif
+#if !defined(CRUX_IS_CONSTANT_EVALUATED) && ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+	#define CRUX_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#ifndef CRUX_IS_CONSTANT_EVALUATED
+	//Without the builtin, always take the portable constexpr-safe path
+	#define CRUX_IS_CONSTANT_EVALUATED() true
+#endif
+
+//Hints to the CPU that this is a spin-wait loop, saving power and freeing the core for its sibling thread
+#ifndef CRUX_CPU_PAUSE
+	#if CRUX_SIMD_SSE2
+		#include <emmintrin.h>
+		#define CRUX_CPU_PAUSE() _mm_pause()
+	#elif defined(__aarch64__) || defined(__arm__)
+		#define CRUX_CPU_PAUSE() __asm__ __volatile__("yield")
+	#else
+		#define CRUX_CPU_PAUSE() ((void)0)
 	#endif
 #endif
 
@@ -28,6 +108,8 @@ namespace crux {
 	/// Define the platform using the macro definitions for global usage
 #if CRUX_WIN32
 	const Platform TargetPlatform = Platform::WINDOWS;
+#elif CRUX_UNIX
+	const Platform TargetPlatform = Platform::LINUX;
 #else
 	const Platform TargetPlatform = Platform::NONE;
 #endif
@@ -35,4 +117,6 @@ namespace crux {
 
 #if CRUX_WIN32
 #include "platform.win32.h"
+#elif CRUX_UNIX
+#include "platform.nix.h"
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+ * Null terminated character buffer with inline storage.
+ * Strings up to N-1 characters live inside the object, longer ones move
+ * to the heap. Meant for short lived conversions, ie. a window title or
+ * a file path handed to an OS call, that should not allocate.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace crux {
+	/**
+	 * @brief Null terminated string buffer keeping up to N-1 characters inline.
+	 *
+	 * Only the operations conversions need are provided: resize() to reserve
+	 * room, data() to write into it, and c_str()/view() to read it back.
+	 * @tparam Char Character type
+	 * @tparam N Inline capacity in characters, including the terminator
+	*/
+	template<typename Char, std::size_t N = 256>
+	class small_string {
+		static_assert(N >= 2, "small_string needs room for at least one character and the terminator");
+
+	public:
+		using value_type = Char;
+		using size_type = std::size_t;
+
+		small_string() noexcept {
+			local[0] = Char(0);
+		}
+
+		explicit small_string(std::basic_string_view<Char> text) : small_string() {
+			assign(text);
+		}
+
+		small_string(const small_string& other) : small_string() {
+			assign(other.view());
+		}
+
+		small_string(small_string&& other) noexcept : small_string() {
+			swap(other);
+		}
+
+		small_string& operator=(const small_string& other) {
+			if (this != &other)
+				assign(other.view());
+			return *this;
+		}
+
+		small_string& operator=(small_string&& other) noexcept {
+			if (this != &other) {
+				small_string tmp(std::move(other));
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		~small_string() {
+			if (ptr != local)
+				delete[] ptr;
+		}
+
+		// @return Characters, not counting the terminator
+		inline size_type size() const noexcept { return count; }
+		inline bool empty() const noexcept { return count == 0; }
+
+		// @return Characters that fit without reallocating, not counting the terminator
+		inline size_type capacity() const noexcept { return cap - 1; }
+
+		// @return True while the contents are held in the inline buffer
+		inline bool IsInline() const noexcept { return ptr == local; }
+
+		inline Char* data() noexcept { return ptr; }
+		inline const Char* data() const noexcept { return ptr; }
+		inline const Char* c_str() const noexcept { return ptr; }
+
+		inline std::basic_string_view<Char> view() const noexcept { return { ptr, count }; }
+		inline operator std::basic_string_view<Char>() const noexcept { return view(); }
+
+		inline Char& operator[](size_type index) noexcept { return ptr[index]; }
+		inline const Char& operator[](size_type index) const noexcept { return ptr[index]; }
+
+		/**
+		 * @brief Changes the length, keeping the existing characters that still fit.
+		 * Characters added are left uninitialized for the caller to write,
+		 * the terminator is always placed after the new end.
+		 * @param newSize Length in characters
+		*/
+		void resize(size_type newSize) {
+			reserve(newSize);
+			count = newSize;
+			ptr[count] = Char(0);
+		}
+
+		// Makes room for newCapacity characters, moving to the heap when the inline buffer is too small
+		void reserve(size_type newCapacity) {
+			if (newCapacity < cap)
+				return;
+
+			//Grow geometrically so repeated appends stay linear
+			size_type grown = cap * 2;
+			if (grown < newCapacity + 1)
+				grown = newCapacity + 1;
+
+			Char* next = new Char[grown];
+			std::memcpy(next, ptr, (count + 1) * sizeof(Char));
+			if (ptr != local)
+				delete[] ptr;
+			ptr = next;
+			cap = grown;
+		}
+
+		void assign(std::basic_string_view<Char> text) {
+			resize(text.size());
+			if (!text.empty())
+				std::memcpy(ptr, text.data(), text.size() * sizeof(Char));
+		}
+
+		inline void clear() noexcept {
+			count = 0;
+			ptr[0] = Char(0);
+		}
+
+		void swap(small_string& other) noexcept {
+			if (ptr != local && other.ptr != other.local) {
+				std::swap(ptr, other.ptr);
+			} else {
+				//At least one side is inline, its characters have to be copied across
+				small_string& inl = ptr == local ? *this : other;
+				small_string& rest = ptr == local ? other : *this;
+				Char saved[N];
+				std::memcpy(saved, inl.local, (inl.count + 1) * sizeof(Char));
+				if (rest.ptr == rest.local) {
+					std::memcpy(inl.local, rest.local, (rest.count + 1) * sizeof(Char));
+				} else {
+					inl.ptr = rest.ptr;
+				}
+				std::memcpy(rest.local, saved, (inl.count + 1) * sizeof(Char));
+				rest.ptr = rest.local;
+			}
+			std::swap(count, other.count);
+			std::swap(cap, other.cap);
+		}
+
+	private:
+		Char* ptr = local;
+		size_type count = 0;
+		size_type cap = N;
+		Char local[N];
+	};
+}
@@ -0,0 +1,391 @@
+#pragma once
+
+/*
+ * C++20 coroutine tasks.
+ * A task<T> is a lazily started coroutine producing a T. It runs when
+ * first awaited, and resumes its awaiter through symmetric transfer
+ * once it completes. Together with Schedule() a coroutine can hop onto
+ * a JobSystem worker, so long running work suspends instead of
+ * blocking a thread.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "jobs.h"
+#include "optional.h"
+#include "platform.h"
+
+namespace crux {
+	template<typename T = void>
+	class task;
+
+	namespace internal {
+		/**
+		 * @brief Shared part of the task promises, handles suspension and the continuation.
+		*/
+		struct task_promise_base {
+			// Resumes whoever awaited the task, through symmetric transfer so chains do not grow the stack
+			struct final_awaiter {
+				bool await_ready() const noexcept { return false; }
+
+				template<typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+					return handle.promise().continuation;
+				}
+
+				void await_resume() const noexcept {}
+			};
+
+			// Tasks are lazy, nothing runs until awaited
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			final_awaiter final_suspend() const noexcept { return {}; }
+
+			// The library is built without relying on exceptions
+			void unhandled_exception() const noexcept { std::terminate(); }
+
+			std::coroutine_handle<> continuation = std::noop_coroutine();
+		};
+
+		template<typename T>
+		struct task_promise : task_promise_base {
+			task<T> get_return_object() noexcept;
+
+			template<typename U>
+			void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+
+			optional<T> result;
+		};
+
+		template<>
+		struct task_promise<void> : task_promise_base {
+			task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+		};
+	}
+
+	/**
+	 * @brief Lazily started coroutine producing a value of type T.
+	 *
+	 * Await it from another coroutine, or block on it with SyncWait().
+	 * The task owns the coroutine frame and destroys it with itself.
+	 * Awaiting a completed task returns its result straight away, so a
+	 * task can be awaited again (as an lvalue) to read the result.
+	 * @tparam T Result type, void for none
+	*/
+	template<typename T>
+	class task {
+	public:
+		using promise_type = internal::task_promise<T>;
+		using handle_type = std::coroutine_handle<promise_type>;
+
+		task() noexcept = default;
+		explicit task(handle_type handle) noexcept : handle(handle) {}
+
+		task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+		task& operator=(task&& other) noexcept {
+			if (this != &other) {
+				if (handle)
+					handle.destroy();
+				handle = std::exchange(other.handle, nullptr);
+			}
+			return *this;
+		}
+
+		task(const task&) = delete;
+		task& operator=(const task&) = delete;
+
+		~task() {
+			if (handle)
+				handle.destroy();
+		}
+
+		// @return True if the task holds a coroutine
+		inline bool IsValid() const noexcept { return (bool)handle; }
+
+		// @return True once the coroutine has run to completion
+		inline bool IsReady() const noexcept { return handle && handle.done(); }
+
+		/**
+		 * @brief Awaiter starting the task and suspending the awaiter until it completes.
+		 * @tparam Move True to move the result out (rvalue tasks), false to return a reference
+		*/
+		template<bool Move>
+		struct awaiter {
+			handle_type handle;
+
+			bool await_ready() const noexcept { return !handle || handle.done(); }
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+
+			std::conditional_t<Move, T, std::add_lvalue_reference_t<T>> await_resume() {
+				if constexpr (std::is_void_v<T>) {
+					return;
+				} else if constexpr (Move) {
+					return std::move(*handle.promise().result);
+				} else {
+					return *handle.promise().result;
+				}
+			}
+		};
+
+		awaiter<false> operator co_await() & noexcept { return { handle }; }
+		awaiter<true> operator co_await() && noexcept { return { handle }; }
+
+	private:
+		handle_type handle = nullptr;
+	};
+
+	namespace internal {
+		template<typename T>
+		task<T> task_promise<T>::get_return_object() noexcept {
+			return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+		}
+
+		inline task<void> task_promise<void>::get_return_object() noexcept {
+			return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+		}
+
+		/**
+		 * @brief One-shot signal set from the coroutine's final suspension.
+		 * Set() notifies under the lock, so a waiter can not return and
+		 * destroy the event while the setting thread still touches it.
+		*/
+		struct sync_wait_event {
+			std::atomic<bool> done{ false };
+			std::mutex lock;
+			std::condition_variable condition;
+
+			void Set() {
+				std::lock_guard<std::mutex> guard(lock);
+				done.store(true, std::memory_order_release);
+				condition.notify_all();
+			}
+
+			void Wait() {
+				std::unique_lock<std::mutex> guard(lock);
+				condition.wait(guard, [this] { return done.load(std::memory_order_acquire); });
+			}
+
+			// Waits by running jobs instead of sleeping
+			void Wait(JobSystem& jobs) {
+				while (!done.load(std::memory_order_acquire)) {
+					if (!jobs.TryRunPending())
+						CRUX_CPU_PAUSE();
+				}
+				std::lock_guard<std::mutex> guard(lock);
+			}
+		};
+
+		/**
+		 * @brief Eagerly owned coroutine signalling an event when it finishes,
+		 * the bridge between blocking code and a task.
+		*/
+		struct signal_task {
+			struct promise_type {
+				sync_wait_event* event = nullptr;
+
+				signal_task get_return_object() noexcept { return signal_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+
+				auto final_suspend() const noexcept {
+					struct signal_awaiter {
+						bool await_ready() const noexcept { return false; }
+						void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept { handle.promise().event->Set(); }
+						void await_resume() const noexcept {}
+					};
+					return signal_awaiter{};
+				}
+
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+
+			explicit signal_task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+			signal_task(signal_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+			signal_task(const signal_task&) = delete;
+
+			~signal_task() {
+				if (handle)
+					handle.destroy();
+			}
+
+			void Start(sync_wait_event& event) {
+				handle.promise().event = &event;
+				handle.resume();
+			}
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		template<typename T>
+		signal_task MakeSignalTask(task<T>& awaited) {
+			co_await awaited;
+		}
+
+		/**
+		 * @brief Counts down the tasks of a WhenAll, the last one to finish resumes the awaiter.
+		*/
+		struct when_all_latch {
+			// Starts at the task count plus one, the extra reference is held by the awaiter while starting them
+			std::atomic<std::size_t> remaining;
+			std::coroutine_handle<> awaiting;
+
+			explicit when_all_latch(std::size_t count) : remaining(count + 1) {}
+
+			// @return True if this was the last reference
+			bool Release() { return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+		};
+
+		struct when_all_task {
+			struct promise_type {
+				when_all_latch* latch = nullptr;
+
+				when_all_task get_return_object() noexcept { return when_all_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+
+				auto final_suspend() const noexcept {
+					struct release_awaiter {
+						bool await_ready() const noexcept { return false; }
+						std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+							when_all_latch* latch = handle.promise().latch;
+							return latch->Release() ? latch->awaiting : std::noop_coroutine();
+						}
+						void await_resume() const noexcept {}
+					};
+					return release_awaiter{};
+				}
+
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+
+			explicit when_all_task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+			when_all_task(when_all_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+			when_all_task(const when_all_task&) = delete;
+
+			~when_all_task() {
+				if (handle)
+					handle.destroy();
+			}
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		template<typename T>
+		when_all_task MakeWhenAllTask(task<T>& awaited) {
+			co_await awaited;
+		}
+
+		template<typename T>
+		struct when_all_awaiter {
+			std::vector<when_all_task> children;
+			when_all_latch latch;
+
+			explicit when_all_awaiter(std::vector<task<T>>& tasks) : latch(tasks.size()) {
+				children.reserve(tasks.size());
+				for (task<T>& t : tasks)
+					children.push_back(MakeWhenAllTask(t));
+			}
+
+			bool await_ready() const noexcept { return children.empty(); }
+
+			bool await_suspend(std::coroutine_handle<> awaiting) {
+				latch.awaiting = awaiting;
+				for (when_all_task& child : children) {
+					child.handle.promise().latch = &latch;
+					child.handle.resume();
+				}
+
+				//Every child finished synchronously, carry on without suspending
+				return !latch.Release();
+			}
+
+			void await_resume() const noexcept {}
+		};
+	}
+
+	/**
+	 * @brief Awaitable moving the awaiting coroutine onto a job system worker.
+	 * Everything after the co_await runs as a job, so the current thread
+	 * is free to carry on with other work.
+	 * @param jobs Job system to resume on
+	*/
+	inline auto Schedule(JobSystem& jobs) noexcept {
+		struct schedule_awaiter {
+			JobSystem& jobs;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) const { jobs.Run([handle] { handle.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+		return schedule_awaiter{ jobs };
+	}
+
+	/**
+	 * @brief Awaitable starting every task and resuming once all of them completed.
+	 *
+	 * Tasks are started one after the other on the awaiting thread, they run
+	 * concurrently only if they suspend, ie. by awaiting Schedule() first.
+	 * The results stay in the tasks, await each one afterwards to read it.
+	 * @param tasks Tasks to run, must stay alive until the await completes
+	*/
+	template<typename T>
+	inline auto WhenAll(std::vector<task<T>>& tasks) {
+		return internal::when_all_awaiter<T>(tasks);
+	}
+
+	/**
+	 * @brief Runs a task to completion, blocking the calling thread.
+	 * @return The task's result
+	*/
+	template<typename T>
+	T SyncWait(task<T>& awaited) {
+		internal::sync_wait_event event;
+		internal::signal_task bridge = internal::MakeSignalTask(awaited);
+		bridge.Start(event);
+		event.Wait();
+
+		if constexpr (!std::is_void_v<T>)
+			return std::move(awaited).operator co_await().await_resume();
+	}
+
+	template<typename T>
+	T SyncWait(task<T>&& awaited) {
+		return SyncWait(awaited);
+	}
+
+	/**
+	 * @brief Runs a task to completion, running queued jobs on the calling
+	 * thread while waiting instead of blocking it.
+	 * Required when the caller is itself a thread of the job system the task
+	 * schedules onto, and that system has no other workers.
+	 * @return The task's result
+	*/
+	template<typename T>
+	T SyncWait(JobSystem& jobs, task<T>& awaited) {
+		internal::sync_wait_event event;
+		internal::signal_task bridge = internal::MakeSignalTask(awaited);
+		bridge.Start(event);
+		event.Wait(jobs);
+
+		if constexpr (!std::is_void_v<T>)
+			return std::move(awaited).operator co_await().await_resume();
+	}
+
+	template<typename T>
+	T SyncWait(JobSystem& jobs, task<T>&& awaited) {
+		return SyncWait(jobs, awaited);
+	}
+}
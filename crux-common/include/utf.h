@@ -0,0 +1,156 @@
+#pragma once
+
+/*
+ * UTF-8, UTF-16 and UTF-32 transcoding.
+ * Conversions write into caller provided buffers and never allocate,
+ * runs of ASCII are converted a vector register at a time (SSE2/AVX2).
+ * Invalid input (malformed UTF-8, lone surrogates, out of range code
+ * points) is replaced with U+FFFD and flagged in the Result.
+ */
+
+#include <cstddef>
+#include <string_view>
+
+namespace crux::utf {
+	// Substituted for every invalid sequence
+	constexpr char32_t ReplacementCharacter = 0xFFFD;
+
+	/**
+	 * @brief Outcome of a conversion.
+	 * Conversion stops before the first code point that does not fit the
+	 * output, so read < input size means the output was too small.
+	*/
+	struct Result {
+		// Input code units consumed
+		std::size_t read = 0;
+
+		// Output code units written
+		std::size_t written = 0;
+
+		// False if any invalid sequence was replaced
+		bool valid = true;
+	};
+
+	// @return Output units Utf8ToUtf16() can need at most for the given UTF-8 length
+	constexpr std::size_t MaxUtf16Length(std::size_t utf8Length) { return utf8Length; }
+
+	// @return Output units Utf8ToUtf32() can need at most for the given UTF-8 length
+	constexpr std::size_t MaxUtf32Length(std::size_t utf8Length) { return utf8Length; }
+
+	// @return Output bytes Utf16ToUtf8() can need at most for the given UTF-16 length
+	constexpr std::size_t MaxUtf8LengthFromUtf16(std::size_t utf16Length) { return utf16Length * 3; }
+
+	// @return Output bytes Utf32ToUtf8() can need at most for the given UTF-32 length
+	constexpr std::size_t MaxUtf8LengthFromUtf32(std::size_t utf32Length) { return utf32Length * 4; }
+
+	// @return Output units Utf8ToWide() can need at most, wchar_t is UTF-16 on Windows and UTF-32 elsewhere
+	constexpr std::size_t MaxWideLength(std::size_t utf8Length) { return utf8Length; }
+
+	// @return Output bytes WideToUtf8() can need at most
+	constexpr std::size_t MaxUtf8LengthFromWide(std::size_t wideLength) { return wideLength * (sizeof(wchar_t) == 2 ? 3 : 4); }
+
+	// @return True if every byte is below 0x80, in which case all the encodings match unit for unit
+	bool IsAscii(std::string_view input);
+
+	// @return Exact UTF-16 units the UTF-8 input converts to, invalid sequences counted as replaced
+	std::size_t Utf16Length(std::string_view input);
+
+	// @return Exact UTF-32 units the UTF-8 input converts to
+	std::size_t Utf32Length(std::string_view input);
+
+	// @return Exact UTF-8 bytes the UTF-16 input converts to
+	std::size_t Utf8Length(std::u16string_view input);
+
+	// @return Exact UTF-8 bytes the UTF-32 input converts to
+	std::size_t Utf8Length(std::u32string_view input);
+
+	// @return Exact wchar_t units the UTF-8 input converts to
+	std::size_t WideLength(std::string_view input);
+
+	// @return Exact UTF-8 bytes the wide input converts to
+	std::size_t Utf8Length(std::wstring_view input);
+
+	/**
+	 * @brief Converts UTF-8 to UTF-16.
+	 * @param input UTF-8 text
+	 * @param output Buffer receiving UTF-16 units, not null terminated
+	 * @param capacity Units available in output, MaxUtf16Length() always suffices
+	 * @return Units read and written
+	*/
+	Result Utf8ToUtf16(std::string_view input, char16_t* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts UTF-16 to UTF-8.
+	 * @param input UTF-16 text
+	 * @param output Buffer receiving UTF-8 bytes, not null terminated
+	 * @param capacity Bytes available in output, MaxUtf8LengthFromUtf16() always suffices
+	 * @return Units read and written
+	*/
+	Result Utf16ToUtf8(std::u16string_view input, char* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts UTF-8 to UTF-32.
+	 * @param input UTF-8 text
+	 * @param output Buffer receiving code points, not null terminated
+	 * @param capacity Code points available in output, MaxUtf32Length() always suffices
+	 * @return Units read and written
+	*/
+	Result Utf8ToUtf32(std::string_view input, char32_t* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts UTF-32 to UTF-8.
+	 * @param input Code points
+	 * @param output Buffer receiving UTF-8 bytes, not null terminated
+	 * @param capacity Bytes available in output, MaxUtf8LengthFromUtf32() always suffices
+	 * @return Units read and written
+	*/
+	Result Utf32ToUtf8(std::u32string_view input, char* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts UTF-8 to the platform's wide encoding (UTF-16 on Windows, UTF-32 elsewhere).
+	 * @param input UTF-8 text
+	 * @param output Buffer receiving wide units, not null terminated
+	 * @param capacity Units available in output, MaxWideLength() always suffices
+	 * @return Units read and written
+	*/
+	Result Utf8ToWide(std::string_view input, wchar_t* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts the platform's wide encoding to UTF-8.
+	 * @param input Wide text
+	 * @param output Buffer receiving UTF-8 bytes, not null terminated
+	 * @param capacity Bytes available in output, MaxUtf8LengthFromWide() always suffices
+	 * @return Units read and written
+	*/
+	Result WideToUtf8(std::wstring_view input, char* output, std::size_t capacity);
+
+	/**
+	 * @brief Converts UTF-8 into a resizable wide string, ie. std::wstring or small_string<wchar_t>.
+	 * Sized for the worst case first so the text is only walked once.
+	 * @param input UTF-8 text
+	 * @param output String replaced with the converted text
+	 * @return False if invalid sequences were replaced
+	*/
+	template<typename WideString>
+	bool Utf8ToWide(std::string_view input, WideString& output) {
+		output.resize(MaxWideLength(input.size()));
+		const Result result = Utf8ToWide(input, output.data(), output.size());
+		output.resize(result.written);
+		return result.valid;
+	}
+
+	/**
+	 * @brief Converts wide text into a resizable string, ie. std::string or small_string<char>.
+	 * The exact length is measured first, the worst case is up to four times the input.
+	 * @param input Wide text
+	 * @param output String replaced with the converted text
+	 * @return False if invalid sequences were replaced
+	*/
+	template<typename String>
+	bool WideToUtf8(std::wstring_view input, String& output) {
+		output.resize(Utf8Length(input));
+		const Result result = WideToUtf8(input, output.data(), output.size());
+		output.resize(result.written);
+		return result.valid;
+	}
+}
@@ -1,61 +1,167 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
+#include <type_traits>
+
+#include "platform.h"
 
 namespace crux {
+	/**
+	 * @brief Two component vector.
+	 *
+	 * Trivially copyable and standard-layout, so arrays of it can be memcpy'd
+	 * and handed to SIMD code as interleaved {x, y} pairs. Every operator is
+	 * constexpr, allowing vector constants to be folded at compile time.
+	*/
 	template<typename T>
 	struct vector2 {
+		using value_type = T;
+
 		T x, y;
 
-		vector2() : x(T{}), y(T{}) {}
-		vector2(const vector2<T>& copy) : x(copy.x), y(copy.y) {}
+		constexpr vector2() : x(T{}), y(T{}) {}
+		constexpr vector2(const T& init) : x(init), y(init) {}
+		constexpr vector2(const T& initX, const T& initY) : x(initX), y(initY) {}
+
+		constexpr vector2(const vector2<T>&) = default;
+		constexpr vector2(vector2<T>&&) = default;
+		constexpr vector2<T>& operator=(const vector2<T>&) = default;
+		constexpr vector2<T>& operator=(vector2<T>&&) = default;
 
-		vector2(const T& init) : x(init), y(init) {}
-		vector2(const T& initX, const T& initY) : x(initX), y(initY) {}
-		
-		const vector2<T>& operator=(const vector2<T>& obj) { x = obj.x; y = obj.y; return *this; }
-		const vector2<T>& operator+=(const vector2<T>& obj) { x += obj.x; y += obj.y; return *this; }
-		const vector2<T>& operator-=(const vector2<T>& obj) { x -= obj.x; y -= obj.y; return *this; }
-		const vector2<T>& operator*=(const vector2<T>& obj) { x *= obj.x; y *= obj.y; return *this; }
-		const vector2<T>& operator/=(const vector2<T>& obj) { x /= obj.x; y /= obj.y; return *this; }
+		constexpr vector2<T>& operator+=(const vector2<T>& obj) { return *this = *this + obj; }
+		constexpr vector2<T>& operator-=(const vector2<T>& obj) { return *this = *this - obj; }
+		constexpr vector2<T>& operator*=(const vector2<T>& obj) { return *this = *this * obj; }
+		constexpr vector2<T>& operator/=(const vector2<T>& obj) { return *this = *this / obj; }
 
-		T& operator[](std::size_t idx) { return ( idx == 0 ? x : y); }
-		const T& operator[](std::size_t idx) const { return (idx == 0 ? x : y); }
+		constexpr T& operator[](std::size_t idx) { return ( idx == 0 ? x : y); }
+		constexpr const T& operator[](std::size_t idx) const { return (idx == 0 ? x : y); }
 	};
+}
+
+#include "vector2.simd.h"
 
+namespace crux {
 	template<typename T>
-	bool operator==(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y; }
+	constexpr bool operator==(const vector2<T>& lhs, const vector2<T>& rhs) {
+		if constexpr (internal::simd::lanes<T>::enabled) {
+			if (!CRUX_IS_CONSTANT_EVALUATED())
+				return internal::simd::lanes<T>::equal(lhs, rhs);
+		}
+		return lhs.x == rhs.x && lhs.y == rhs.y;
+	}
 
 	template<typename T>
-	bool operator!=(const vector2<T>& lhs, const vector2<T>& rhs) { return !(lhs == rhs); }
+	constexpr bool operator!=(const vector2<T>& lhs, const vector2<T>& rhs) { return !(lhs == rhs); }
 
 	template<typename T>
-	bool operator<(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x < rhs.x || lhs.y < rhs.y; }
+	constexpr bool operator<(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x < rhs.x || lhs.y < rhs.y; }
 
 	template<typename T>
-	bool operator>(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x > rhs.x || lhs.y > rhs.y; }
+	constexpr bool operator>(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x > rhs.x || lhs.y > rhs.y; }
 
 	template<typename T>
-	bool operator<=(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs == rhs || lhs < rhs; }
+	constexpr bool operator<=(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs == rhs || lhs < rhs; }
 
 	template<typename T>
-	bool operator>=(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs == rhs || lhs > rhs; }
+	constexpr bool operator>=(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs == rhs || lhs > rhs; }
+
+	template<typename T>
+	constexpr vector2<T> operator+(const vector2<T>& lhs, const vector2<T>& rhs) {
+		if constexpr (internal::simd::lanes<T>::enabled) {
+			if (!CRUX_IS_CONSTANT_EVALUATED())
+				return internal::simd::lanes<T>::add(lhs, rhs);
+		}
+		return vector2<T>(lhs.x + rhs.x, lhs.y + rhs.y);
+	}
+
+	template<typename T>
+	constexpr vector2<T> operator-(const vector2<T>& lhs, const vector2<T>& rhs) {
+		if constexpr (internal::simd::lanes<T>::enabled) {
+			if (!CRUX_IS_CONSTANT_EVALUATED())
+				return internal::simd::lanes<T>::sub(lhs, rhs);
+		}
+		return vector2<T>(lhs.x - rhs.x, lhs.y - rhs.y);
+	}
+
+	template<typename T>
+	constexpr vector2<T> operator*(const vector2<T>& lhs, const vector2<T>& rhs) {
+		if constexpr (internal::simd::lanes<T>::has_mul) {
+			if (!CRUX_IS_CONSTANT_EVALUATED())
+				return internal::simd::lanes<T>::mul(lhs, rhs);
+		}
+		return vector2<T>(lhs.x * rhs.x, lhs.y * rhs.y);
+	}
+
+	template<typename T>
+	constexpr vector2<T> operator/(const vector2<T>& lhs, const vector2<T>& rhs) {
+		if constexpr (internal::simd::lanes<T>::has_div) {
+			if (!CRUX_IS_CONSTANT_EVALUATED())
+				return internal::simd::lanes<T>::div(lhs, rhs);
+		}
+		return vector2<T>(lhs.x / rhs.x, lhs.y / rhs.y);
+	}
 
 	template<typename T>
-	vector2<T> operator+(const vector2<T>& lhs, const vector2<T>& rhs) { return vector2<T>(lhs.x + rhs.x, lhs.y + rhs.y); }
+	constexpr vector2<T> operator-(const vector2<T>& obj) { return vector2<T>(-obj.x, -obj.y); }
 
+	// Scalar overloads, the scalar is not deduced so vec2f * 2 picks T from the vector
 	template<typename T>
-	vector2<T> operator-(const vector2<T>& lhs, const vector2<T>& rhs) { return vector2<T>(lhs.x - rhs.x, lhs.y - rhs.y); }
+	constexpr vector2<T> operator*(const vector2<T>& lhs, const typename vector2<T>::value_type& rhs) { return vector2<T>(lhs.x * rhs, lhs.y * rhs); }
 
 	template<typename T>
-	vector2<T> operator*(const vector2<T>& lhs, const vector2<T>& rhs) { return vector2<T>(lhs.x * rhs.x, lhs.y * rhs.y); }
+	constexpr vector2<T> operator*(const typename vector2<T>::value_type& lhs, const vector2<T>& rhs) { return vector2<T>(lhs * rhs.x, lhs * rhs.y); }
 
 	template<typename T>
-	vector2<T> operator/(const vector2<T>& lhs, const vector2<T>& rhs) { return vector2<T>(lhs.x / rhs.x, lhs.y / rhs.y); }
+	constexpr vector2<T> operator/(const vector2<T>& lhs, const typename vector2<T>::value_type& rhs) { return vector2<T>(lhs.x / rhs, lhs.y / rhs); }
+
+	// @return The dot product, lhs.x * rhs.x + lhs.y * rhs.y
+	template<typename T>
+	constexpr T Dot(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x * rhs.x + lhs.y * rhs.y; }
+
+	// @return The z component of the 3D cross product, positive when rhs is counter-clockwise of lhs
+	template<typename T>
+	constexpr T Cross(const vector2<T>& lhs, const vector2<T>& rhs) { return lhs.x * rhs.y - lhs.y * rhs.x; }
+
+	// @return The squared length, avoiding the square-root when only comparing lengths
+	template<typename T>
+	constexpr T LengthSquared(const vector2<T>& obj) { return Dot(obj, obj); }
+
+	// @return Component-wise minimum
+	template<typename T>
+	constexpr vector2<T> Min(const vector2<T>& lhs, const vector2<T>& rhs) {
+		return vector2<T>(rhs.x < lhs.x ? rhs.x : lhs.x, rhs.y < lhs.y ? rhs.y : lhs.y);
+	}
+
+	// @return Component-wise maximum
+	template<typename T>
+	constexpr vector2<T> Max(const vector2<T>& lhs, const vector2<T>& rhs) {
+		return vector2<T>(lhs.x < rhs.x ? rhs.x : lhs.x, lhs.y < rhs.y ? rhs.y : lhs.y);
+	}
+
+	// @return Each component clamped between the matching components of lo and hi
+	template<typename T>
+	constexpr vector2<T> Clamp(const vector2<T>& obj, const vector2<T>& lo, const vector2<T>& hi) { return Min(Max(obj, lo), hi); }
+
+	// @return Component-wise absolute value
+	template<typename T>
+	constexpr vector2<T> Abs(const vector2<T>& obj) {
+		if constexpr (std::is_unsigned_v<T>)
+			return obj;
+		else
+			return vector2<T>(obj.x < T{} ? -obj.x : obj.x, obj.y < T{} ? -obj.y : obj.y);
+	}
 
 	template<typename T>
 	std::ostream& operator<<(std::ostream& out, const vector2<T>& obj) {
 		out << "vector2{" << obj.x << ", " << obj.y << "}";
 		return out;
 	}
+
+	//Layout guarantees relied on by the SIMD and batch code
+	static_assert(std::is_trivially_copyable_v<vector2<float>>, "vector2 must be trivially copyable");
+	static_assert(std::is_standard_layout_v<vector2<float>>, "vector2 must be standard-layout");
+	static_assert(sizeof(vector2<float>) == 2 * sizeof(float), "vector2 must not be padded");
+	static_assert(offsetof(vector2<float>, y) == sizeof(float), "vector2 components must be contiguous");
+	static_assert(std::is_trivially_copyable_v<vector2<int>> && sizeof(vector2<int>) == 2 * sizeof(int), "vector2<int> layout");
 }
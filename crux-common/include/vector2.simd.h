@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+ * SIMD lane specializations used by the vector2 operators.
+ * Each supported component type gets an explicit specialization of lanes<T>,
+ * anything else (or a build without SSE2) keeps the scalar code path.
+ *
+ * These are opt-in with CRUX_VECTOR2_SIMD_OPS. A single vector2 only fills half
+ * of a register, and the intrinsics stop the compiler from vectorizing whole
+ * loops of vector2 math on its own, which measures slower in crux-bench.
+ * For arrays, use the kernels in vector2_batch.h instead.
+ */
+
+#include <cstdint>
+
+#include "platform.h"
+
+#ifndef CRUX_VECTOR2_SIMD_OPS
+	#define CRUX_VECTOR2_SIMD_OPS 0
+#endif
+
+#if CRUX_SIMD_SSE2 && CRUX_VECTOR2_SIMD_OPS
+	#include <emmintrin.h>
+	#if CRUX_SIMD_SSE41
+		#include <smmintrin.h>
+	#endif
+#endif
+
+namespace crux::internal::simd {
+	/**
+	 * @brief Describes how a vector2<T> maps onto SIMD registers.
+	 * The primary template is disabled, meaning the generic scalar code is used.
+	*/
+	template<typename T>
+	struct lanes {
+		static constexpr bool enabled = false;
+		static constexpr bool has_mul = false;
+		static constexpr bool has_div = false;
+	};
+
+#if CRUX_SIMD_SSE2 && CRUX_VECTOR2_SIMD_OPS
+	// vec2f, both components in the low half of an XMM register
+	template<>
+	struct lanes<float> {
+		static constexpr bool enabled = true;
+		static constexpr bool has_mul = true;
+		static constexpr bool has_div = true;
+
+		// Duplicates x/y into the upper half so unused lanes never divide 0/0
+		static __m128 load(const vector2<float>& v) {
+			__m128 r = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&v)));
+			return _mm_movelh_ps(r, r);
+		}
+
+		static vector2<float> store(__m128 r) {
+			vector2<float> out;
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(&out), _mm_castps_si128(r));
+			return out;
+		}
+
+		static vector2<float> add(const vector2<float>& a, const vector2<float>& b) { return store(_mm_add_ps(load(a), load(b))); }
+		static vector2<float> sub(const vector2<float>& a, const vector2<float>& b) { return store(_mm_sub_ps(load(a), load(b))); }
+		static vector2<float> mul(const vector2<float>& a, const vector2<float>& b) { return store(_mm_mul_ps(load(a), load(b))); }
+		static vector2<float> div(const vector2<float>& a, const vector2<float>& b) { return store(_mm_div_ps(load(a), load(b))); }
+
+		static bool equal(const vector2<float>& a, const vector2<float>& b) {
+			return (_mm_movemask_ps(_mm_cmpeq_ps(load(a), load(b))) & 0x3) == 0x3;
+		}
+	};
+
+	// Shared by vec2i and vec2u where the components are 32bit integers
+	template<typename T>
+	struct lanes_int32 {
+		static constexpr bool enabled = true;
+		static constexpr bool has_mul = true;
+		static constexpr bool has_div = false;
+
+		static __m128i load(const vector2<T>& v) { return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&v)); }
+
+		static vector2<T> store(__m128i r) {
+			vector2<T> out;
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(&out), r);
+			return out;
+		}
+
+		static vector2<T> add(const vector2<T>& a, const vector2<T>& b) { return store(_mm_add_epi32(load(a), load(b))); }
+		static vector2<T> sub(const vector2<T>& a, const vector2<T>& b) { return store(_mm_sub_epi32(load(a), load(b))); }
+
+		static vector2<T> mul(const vector2<T>& a, const vector2<T>& b) {
+#if CRUX_SIMD_SSE41
+			return store(_mm_mullo_epi32(load(a), load(b)));
+#else
+			//SSE2 has no 32bit low multiply, so multiply each lane as 64bit and keep the low halves
+			__m128i va = load(a), vb = load(b);
+			__m128i even = _mm_mul_epu32(va, vb);
+			__m128i odd = _mm_mul_epu32(_mm_srli_si128(va, 4), _mm_srli_si128(vb, 4));
+			return store(_mm_unpacklo_epi32(even, odd));
+#endif
+		}
+
+		static bool equal(const vector2<T>& a, const vector2<T>& b) {
+			return (_mm_movemask_epi8(_mm_cmpeq_epi32(load(a), load(b))) & 0xFF) == 0xFF;
+		}
+	};
+
+	template<>
+	struct lanes<std::int32_t> : lanes_int32<std::int32_t> {};
+
+	template<>
+	struct lanes<std::uint32_t> : lanes_int32<std::uint32_t> {};
+#endif // CRUX_SIMD_SSE2 && CRUX_VECTOR2_SIMD_OPS
+}
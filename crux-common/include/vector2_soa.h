@@ -0,0 +1,359 @@
+#pragma once
+
+/*
+ * Structure-of-arrays container for vector2, keeping every x and every y
+ * in their own aligned arrays so bulk math runs down contiguous lanes.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "platform.h"
+#include "span.h"
+#include "vector2.h"
+
+#if CRUX_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace crux {
+	/**
+	 * @brief Container of vector2<T> stored as separate x and y arrays.
+	 *
+	 * Elements are addressed through a proxy reference that converts to
+	 * and from vector2<T>, so code written against vector2 keeps working.
+	 * The component arrays are aligned to vector2_soa::Alignment bytes and
+	 * padded to a whole number of SIMD registers.
+	*/
+	template<typename T>
+	class vector2_soa {
+		static_assert(std::is_arithmetic_v<T>, "vector2_soa requires an arithmetic component type");
+
+	public:
+		// Byte alignment of each component array, wide enough for AVX loads
+		static constexpr std::size_t Alignment = 32;
+
+		/**
+		 * @brief Proxy to one element, behaving like a vector2<T>&.
+		*/
+		class reference {
+		public:
+			T& x;
+			T& y;
+
+			reference(T& refX, T& refY) : x(refX), y(refY) {}
+			reference(const reference&) = default;
+
+			operator vector2<T>() const { return vector2<T>(x, y); }
+
+			reference& operator=(const vector2<T>& obj) { x = obj.x; y = obj.y; return *this; }
+			reference& operator=(const reference& obj) { return *this = vector2<T>(obj); }
+			reference& operator+=(const vector2<T>& obj) { x += obj.x; y += obj.y; return *this; }
+			reference& operator-=(const vector2<T>& obj) { x -= obj.x; y -= obj.y; return *this; }
+			reference& operator*=(const vector2<T>& obj) { x *= obj.x; y *= obj.y; return *this; }
+			reference& operator/=(const vector2<T>& obj) { x /= obj.x; y /= obj.y; return *this; }
+		};
+
+		vector2_soa() = default;
+
+		// Construct with count zeroed elements
+		explicit vector2_soa(std::size_t count) { resize(count); }
+
+		// Construct by de-interleaving a contiguous run of vector2
+		explicit vector2_soa(span<const vector2<T>> values) { assign(values); }
+
+		vector2_soa(const vector2_soa& copy) {
+			reserve(copy.count);
+			count = copy.count;
+			std::copy_n(copy.xs, count, xs);
+			std::copy_n(copy.ys, count, ys);
+		}
+
+		vector2_soa(vector2_soa&& other) noexcept { swap(other); }
+
+		vector2_soa& operator=(const vector2_soa& obj) {
+			if (this != &obj) {
+				vector2_soa copy(obj);
+				swap(copy);
+			}
+			return *this;
+		}
+
+		vector2_soa& operator=(vector2_soa&& obj) noexcept {
+			if (this != &obj) {
+				vector2_soa moved(std::move(obj));
+				swap(moved);
+			}
+			return *this;
+		}
+
+		~vector2_soa() { Release(); }
+
+		void swap(vector2_soa& other) noexcept {
+			std::swap(block, other.block);
+			std::swap(xs, other.xs);
+			std::swap(ys, other.ys);
+			std::swap(count, other.count);
+			std::swap(cap, other.cap);
+		}
+
+		std::size_t size() const { return count; }
+		std::size_t capacity() const { return cap; }
+		bool empty() const { return count == 0; }
+
+		/**
+		 * @brief Grows the component arrays to hold at least the given count.
+		 * Existing elements are kept, capacity never shrinks.
+		*/
+		void reserve(std::size_t wanted) {
+			if (wanted <= cap)
+				return;
+
+			//Round up to whole registers so kernels can run full-width without a tail
+			constexpr std::size_t perLine = Alignment / sizeof(T) > 0 ? Alignment / sizeof(T) : 1;
+			std::size_t newCap = std::max(wanted, cap + cap / 2);
+			newCap = (newCap + perLine - 1) / perLine * perLine;
+
+			void* newBlock = ::operator new(newCap * 2 * sizeof(T), std::align_val_t(Alignment));
+			T* newXs = static_cast<T*>(newBlock);
+			T* newYs = newXs + newCap;
+			std::copy_n(xs, count, newXs);
+			std::copy_n(ys, count, newYs);
+
+			//Not Release(), which would also forget the elements just copied
+			if (block)
+				::operator delete(block, std::align_val_t(Alignment));
+			block = newBlock;
+			xs = newXs;
+			ys = newYs;
+			cap = newCap;
+		}
+
+		// Resizes the container, new elements are zeroed
+		void resize(std::size_t newCount) {
+			reserve(newCount);
+			if (newCount > count) {
+				std::fill(xs + count, xs + newCount, T{});
+				std::fill(ys + count, ys + newCount, T{});
+			}
+			count = newCount;
+		}
+
+		void clear() { count = 0; }
+
+		void push_back(const vector2<T>& value) {
+			if (count == cap)
+				reserve(count + 1);
+			xs[count] = value.x;
+			ys[count] = value.y;
+			++count;
+		}
+
+		reference operator[](std::size_t idx) { return reference(xs[idx], ys[idx]); }
+		vector2<T> operator[](std::size_t idx) const { return vector2<T>(xs[idx], ys[idx]); }
+
+		// @return Pointer to the aligned array of x components
+		T* x_data() { return xs; }
+		const T* x_data() const { return xs; }
+
+		// @return Pointer to the aligned array of y components
+		T* y_data() { return ys; }
+		const T* y_data() const { return ys; }
+
+		span<T> x_span() { return { xs, count }; }
+		span<const T> x_span() const { return { xs, count }; }
+
+		span<T> y_span() { return { ys, count }; }
+		span<const T> y_span() const { return { ys, count }; }
+
+		/**
+		 * @brief Replaces the contents by de-interleaving the given vectors.
+		 * This is a single pass straight into the component arrays, no
+		 * intermediate buffer is allocated.
+		 * @param values Contiguous vector2 values, ie. a std::vector<vec2f>
+		*/
+		void assign(span<const vector2<T>> values) {
+			count = 0;
+			reserve(values.size());
+			const vector2<T>* src = values.data();
+			T* CRUX_RESTRICT dx = xs;
+			T* CRUX_RESTRICT dy = ys;
+			for (std::size_t i = 0; i < values.size(); ++i) {
+				dx[i] = src[i].x;
+				dy[i] = src[i].y;
+			}
+			count = values.size();
+		}
+
+		/**
+		 * @brief Interleaves the contents back into caller-owned vector2 storage.
+		 * @param out Destination, ie. a std::vector<vec2f> that has been resized
+		 * @return Number of elements written, the smaller of size() and out.size()
+		*/
+		std::size_t copy_to(span<vector2<T>> out) const {
+			const std::size_t n = std::min(count, out.size());
+			vector2<T>* dst = out.data();
+			const T* CRUX_RESTRICT sx = xs;
+			const T* CRUX_RESTRICT sy = ys;
+			for (std::size_t i = 0; i < n; ++i) {
+				dst[i].x = sx[i];
+				dst[i].y = sy[i];
+			}
+			return n;
+		}
+
+	private:
+		void Release() {
+			if (block)
+				::operator delete(block, std::align_val_t(Alignment));
+			block = nullptr;
+			xs = ys = nullptr;
+			count = cap = 0;
+		}
+
+		// Single allocation holding the x array followed by the y array
+		void* block = nullptr;
+		T* xs = nullptr;
+		T* ys = nullptr;
+		std::size_t count = 0;
+		std::size_t cap = 0;
+	};
+
+	/*
+	 * Bulk kernels over vector2_soa. These are written as plain loops over
+	 * non-aliasing component arrays, which compilers turn into full-width SIMD.
+	 */
+	namespace batch {
+		/**
+		 * @brief Applies out[i] = in[i] * scale + offset to every element.
+		 * The output is resized to match the input, and may be the input itself.
+		*/
+		template<typename T>
+		void Transform(const vector2_soa<T>& in, const vector2<T>& scale, const vector2<T>& offset, vector2_soa<T>& out) {
+			if (&in != &out)
+				out.resize(in.size());
+			const std::size_t n = in.size();
+			const T* ix = in.x_data();
+			const T* iy = in.y_data();
+			T* ox = out.x_data();
+			T* oy = out.y_data();
+			for (std::size_t i = 0; i < n; ++i) {
+				ox[i] = ix[i] * scale.x + offset.x;
+				oy[i] = iy[i] * scale.y + offset.y;
+			}
+		}
+
+		/**
+		 * @brief Applies a callable taking and returning vector2<T> to every element.
+		 * The output is resized to match the input, and may be the input itself.
+		*/
+		template<typename T, typename Fn>
+		void Transform(const vector2_soa<T>& in, vector2_soa<T>& out, Fn&& fn) {
+			if (&in != &out)
+				out.resize(in.size());
+			const std::size_t n = in.size();
+			const T* ix = in.x_data();
+			const T* iy = in.y_data();
+			T* ox = out.x_data();
+			T* oy = out.y_data();
+			for (std::size_t i = 0; i < n; ++i) {
+				const vector2<T> r = fn(vector2<T>(ix[i], iy[i]));
+				ox[i] = r.x;
+				oy[i] = r.y;
+			}
+		}
+
+		/**
+		 * @brief Accumulates dst[i] += src[i] * scale, ie. position += velocity * dt.
+		 * Only the shorter of the two containers worth of elements are processed.
+		 * dst and src must be different containers, the loop assumes they do not
+		 * overlap. Scale a container by itself with Transform instead.
+		 * @return Number of elements updated
+		*/
+		template<typename T>
+		std::size_t Accumulate(vector2_soa<T>& dst, const vector2_soa<T>& src, T scale = T{ 1 }) {
+			const std::size_t n = std::min(dst.size(), src.size());
+			T* CRUX_RESTRICT dx = dst.x_data();
+			T* CRUX_RESTRICT dy = dst.y_data();
+			const T* CRUX_RESTRICT sx = src.x_data();
+			const T* CRUX_RESTRICT sy = src.y_data();
+
+			std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+			//Spelled out, below -O3 the compilers leave this loop scalar. Aligned, both containers start on Alignment
+			if constexpr (std::is_same_v<T, float>) {
+				const __m128 s = _mm_set1_ps(scale);
+				for (; i + 4 <= n; i += 4) {
+					_mm_store_ps(dx + i, _mm_add_ps(_mm_load_ps(dx + i), _mm_mul_ps(_mm_load_ps(sx + i), s)));
+					_mm_store_ps(dy + i, _mm_add_ps(_mm_load_ps(dy + i), _mm_mul_ps(_mm_load_ps(sy + i), s)));
+				}
+			}
+#endif
+			for (; i < n; ++i) {
+				dx[i] += sx[i] * scale;
+				dy[i] += sy[i] * scale;
+			}
+			return n;
+		}
+
+		/**
+		 * @brief Sums every element of the container.
+		 * @return Component-wise total
+		*/
+		template<typename T>
+		vector2<T> Sum(const vector2_soa<T>& in) {
+			const std::size_t n = in.size();
+			const T* ix = in.x_data();
+			const T* iy = in.y_data();
+			T sx{}, sy{};
+			for (std::size_t i = 0; i < n; ++i) {
+				sx += ix[i];
+				sy += iy[i];
+			}
+			return vector2<T>(sx, sy);
+		}
+
+		/**
+		 * @brief Compares two containers element by element.
+		 * @param out Receives 1 where lhs[i] == rhs[i], 0 otherwise
+		 * @return Number of equal elements
+		*/
+		template<typename T>
+		std::size_t Equal(const vector2_soa<T>& lhs, const vector2_soa<T>& rhs, span<std::uint8_t> out) {
+			const std::size_t n = std::min({ lhs.size(), rhs.size(), out.size() });
+			const T* ax = lhs.x_data();
+			const T* ay = lhs.y_data();
+			const T* bx = rhs.x_data();
+			const T* by = rhs.y_data();
+			std::uint8_t* o = out.data();
+			std::size_t matches = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				o[i] = (std::uint8_t)((ax[i] == bx[i]) & (ay[i] == by[i]));
+				matches += o[i];
+			}
+			return matches;
+		}
+
+		/**
+		 * @brief Tests each element against an inclusive axis-aligned box, ie. for culling.
+		 * @param out Receives 1 where min <= in[i] <= max on both axes, 0 otherwise
+		 * @return Number of elements inside the box
+		*/
+		template<typename T>
+		std::size_t Within(const vector2_soa<T>& in, const vector2<T>& min, const vector2<T>& max, span<std::uint8_t> out) {
+			const std::size_t n = std::min(in.size(), out.size());
+			const T* ix = in.x_data();
+			const T* iy = in.y_data();
+			std::uint8_t* o = out.data();
+			std::size_t inside = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				o[i] = (std::uint8_t)((ix[i] >= min.x) & (ix[i] <= max.x) & (iy[i] >= min.y) & (iy[i] <= max.y));
+				inside += o[i];
+			}
+			return inside;
+		}
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+
+#include "vector2.h"
+
+namespace crux {
+	/**
+	 * @brief Three component vector.
+	 *
+	 * Follows vector2: trivially copyable, standard-layout and constexpr throughout.
+	*/
+	template<typename T>
+	struct vector3 {
+		using value_type = T;
+
+		T x, y, z;
+
+		constexpr vector3() : x(T{}), y(T{}), z(T{}) {}
+		constexpr vector3(const T& init) : x(init), y(init), z(init) {}
+		constexpr vector3(const T& initX, const T& initY, const T& initZ) : x(initX), y(initY), z(initZ) {}
+		constexpr vector3(const vector2<T>& xy, const T& initZ) : x(xy.x), y(xy.y), z(initZ) {}
+
+		constexpr vector3(const vector3<T>&) = default;
+		constexpr vector3(vector3<T>&&) = default;
+		constexpr vector3<T>& operator=(const vector3<T>&) = default;
+		constexpr vector3<T>& operator=(vector3<T>&&) = default;
+
+		constexpr vector3<T>& operator+=(const vector3<T>& obj) { return *this = *this + obj; }
+		constexpr vector3<T>& operator-=(const vector3<T>& obj) { return *this = *this - obj; }
+		constexpr vector3<T>& operator*=(const vector3<T>& obj) { return *this = *this * obj; }
+		constexpr vector3<T>& operator/=(const vector3<T>& obj) { return *this = *this / obj; }
+
+		constexpr T& operator[](std::size_t idx) { return (idx == 0 ? x : (idx == 1 ? y : z)); }
+		constexpr const T& operator[](std::size_t idx) const { return (idx == 0 ? x : (idx == 1 ? y : z)); }
+
+		// @return The x and y components as a vector2
+		constexpr vector2<T> xy() const { return vector2<T>(x, y); }
+	};
+
+	template<typename T>
+	constexpr bool operator==(const vector3<T>& lhs, const vector3<T>& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z; }
+
+	template<typename T>
+	constexpr bool operator!=(const vector3<T>& lhs, const vector3<T>& rhs) { return !(lhs == rhs); }
+
+	template<typename T>
+	constexpr vector3<T> operator+(const vector3<T>& lhs, const vector3<T>& rhs) { return vector3<T>(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator-(const vector3<T>& lhs, const vector3<T>& rhs) { return vector3<T>(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator*(const vector3<T>& lhs, const vector3<T>& rhs) { return vector3<T>(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator/(const vector3<T>& lhs, const vector3<T>& rhs) { return vector3<T>(lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator-(const vector3<T>& obj) { return vector3<T>(-obj.x, -obj.y, -obj.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator*(const vector3<T>& lhs, const typename vector3<T>::value_type& rhs) { return vector3<T>(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs); }
+
+	template<typename T>
+	constexpr vector3<T> operator*(const typename vector3<T>::value_type& lhs, const vector3<T>& rhs) { return vector3<T>(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z); }
+
+	template<typename T>
+	constexpr vector3<T> operator/(const vector3<T>& lhs, const typename vector3<T>::value_type& rhs) { return vector3<T>(lhs.x / rhs, lhs.y / rhs, lhs.z / rhs); }
+
+	// @return The dot product
+	template<typename T>
+	constexpr T Dot(const vector3<T>& lhs, const vector3<T>& rhs) { return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z; }
+
+	// @return The right-handed cross product
+	template<typename T>
+	constexpr vector3<T> Cross(const vector3<T>& lhs, const vector3<T>& rhs) {
+		return vector3<T>(
+			lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.z * rhs.x - lhs.x * rhs.z,
+			lhs.x * rhs.y - lhs.y * rhs.x
+		);
+	}
+
+	// @return The squared length, avoiding the square-root when only comparing lengths
+	template<typename T>
+	constexpr T LengthSquared(const vector3<T>& obj) { return Dot(obj, obj); }
+
+	// @return The euclidean length
+	template<typename T>
+	T Length(const vector3<T>& obj) { return (T)std::sqrt(LengthSquared(obj)); }
+
+	// @return The vector scaled to unit length, or zero if the vector has no length
+	template<typename T>
+	vector3<T> Normalize(const vector3<T>& obj) {
+		const T len = Length(obj);
+		return len > T{} ? obj / len : vector3<T>();
+	}
+
+	// @return Component-wise minimum
+	template<typename T>
+	constexpr vector3<T> Min(const vector3<T>& lhs, const vector3<T>& rhs) {
+		return vector3<T>(rhs.x < lhs.x ? rhs.x : lhs.x, rhs.y < lhs.y ? rhs.y : lhs.y, rhs.z < lhs.z ? rhs.z : lhs.z);
+	}
+
+	// @return Component-wise maximum
+	template<typename T>
+	constexpr vector3<T> Max(const vector3<T>& lhs, const vector3<T>& rhs) {
+		return vector3<T>(lhs.x < rhs.x ? rhs.x : lhs.x, lhs.y < rhs.y ? rhs.y : lhs.y, lhs.z < rhs.z ? rhs.z : lhs.z);
+	}
+
+	// @return Each component clamped between the matching components of lo and hi
+	template<typename T>
+	constexpr vector3<T> Clamp(const vector3<T>& obj, const vector3<T>& lo, const vector3<T>& hi) { return Min(Max(obj, lo), hi); }
+
+	// @return Component-wise absolute value
+	template<typename T>
+	constexpr vector3<T> Abs(const vector3<T>& obj) {
+		if constexpr (std::is_unsigned_v<T>)
+			return obj;
+		else
+			return vector3<T>(obj.x < T{} ? -obj.x : obj.x, obj.y < T{} ? -obj.y : obj.y, obj.z < T{} ? -obj.z : obj.z);
+	}
+
+	template<typename T>
+	std::ostream& operator<<(std::ostream& out, const vector3<T>& obj) {
+		out << "vector3{" << obj.x << ", " << obj.y << ", " << obj.z << "}";
+		return out;
+	}
+
+	static_assert(std::is_trivially_copyable_v<vector3<float>>, "vector3 must be trivially copyable");
+	static_assert(sizeof(vector3<float>) == 3 * sizeof(float), "vector3 must not be padded");
+}
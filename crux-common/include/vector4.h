@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+
+#include "vector3.h"
+
+namespace crux {
+	/**
+	 * @brief Four component vector, w being the homogeneous coordinate for points (1) and directions (0).
+	 *
+	 * Follows vector2: trivially copyable, standard-layout and constexpr throughout.
+	 * Four floats fill one SSE register exactly, which the matrix4x4 kernels rely on.
+	*/
+	template<typename T>
+	struct vector4 {
+		using value_type = T;
+
+		T x, y, z, w;
+
+		constexpr vector4() : x(T{}), y(T{}), z(T{}), w(T{}) {}
+		constexpr vector4(const T& init) : x(init), y(init), z(init), w(init) {}
+		constexpr vector4(const T& initX, const T& initY, const T& initZ, const T& initW) : x(initX), y(initY), z(initZ), w(initW) {}
+		constexpr vector4(const vector3<T>& xyz, const T& initW) : x(xyz.x), y(xyz.y), z(xyz.z), w(initW) {}
+
+		constexpr vector4(const vector4<T>&) = default;
+		constexpr vector4(vector4<T>&&) = default;
+		constexpr vector4<T>& operator=(const vector4<T>&) = default;
+		constexpr vector4<T>& operator=(vector4<T>&&) = default;
+
+		constexpr vector4<T>& operator+=(const vector4<T>& obj) { return *this = *this + obj; }
+		constexpr vector4<T>& operator-=(const vector4<T>& obj) { return *this = *this - obj; }
+		constexpr vector4<T>& operator*=(const vector4<T>& obj) { return *this = *this * obj; }
+		constexpr vector4<T>& operator/=(const vector4<T>& obj) { return *this = *this / obj; }
+
+		constexpr T& operator[](std::size_t idx) { return (idx == 0 ? x : (idx == 1 ? y : (idx == 2 ? z : w))); }
+		constexpr const T& operator[](std::size_t idx) const { return (idx == 0 ? x : (idx == 1 ? y : (idx == 2 ? z : w))); }
+
+		// @return The x, y and z components as a vector4
+		constexpr vector3<T> xyz() const { return vector3<T>(x, y, z); }
+	};
+
+	template<typename T>
+	constexpr bool operator==(const vector4<T>& lhs, const vector4<T>& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.w == rhs.w; }
+
+	template<typename T>
+	constexpr bool operator!=(const vector4<T>& lhs, const vector4<T>& rhs) { return !(lhs == rhs); }
+
+	template<typename T>
+	constexpr vector4<T> operator+(const vector4<T>& lhs, const vector4<T>& rhs) { return vector4<T>(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator-(const vector4<T>& lhs, const vector4<T>& rhs) { return vector4<T>(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator*(const vector4<T>& lhs, const vector4<T>& rhs) { return vector4<T>(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator/(const vector4<T>& lhs, const vector4<T>& rhs) { return vector4<T>(lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z, lhs.w / rhs.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator-(const vector4<T>& obj) { return vector4<T>(-obj.x, -obj.y, -obj.z, -obj.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator*(const vector4<T>& lhs, const typename vector4<T>::value_type& rhs) { return vector4<T>(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs, lhs.w * rhs); }
+
+	template<typename T>
+	constexpr vector4<T> operator*(const typename vector4<T>::value_type& lhs, const vector4<T>& rhs) { return vector4<T>(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z, lhs * rhs.w); }
+
+	template<typename T>
+	constexpr vector4<T> operator/(const vector4<T>& lhs, const typename vector4<T>::value_type& rhs) { return vector4<T>(lhs.x / rhs, lhs.y / rhs, lhs.z / rhs, lhs.w / rhs); }
+
+	// @return The dot product
+	template<typename T>
+	constexpr T Dot(const vector4<T>& lhs, const vector4<T>& rhs) { return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w; }
+
+	// @return The squared length, avoiding the square-root when only comparing lengths
+	template<typename T>
+	constexpr T LengthSquared(const vector4<T>& obj) { return Dot(obj, obj); }
+
+	// @return The euclidean length
+	template<typename T>
+	T Length(const vector4<T>& obj) { return (T)std::sqrt(LengthSquared(obj)); }
+
+	// @return The vector scaled to unit length, or zero if the vector has no length
+	template<typename T>
+	vector4<T> Normalize(const vector4<T>& obj) {
+		const T len = Length(obj);
+		return len > T{} ? obj / len : vector4<T>();
+	}
+
+	// @return Component-wise minimum
+	template<typename T>
+	constexpr vector4<T> Min(const vector4<T>& lhs, const vector4<T>& rhs) {
+		return vector4<T>(rhs.x < lhs.x ? rhs.x : lhs.x, rhs.y < lhs.y ? rhs.y : lhs.y, rhs.z < lhs.z ? rhs.z : lhs.z, rhs.w < lhs.w ? rhs.w : lhs.w);
+	}
+
+	// @return Component-wise maximum
+	template<typename T>
+	constexpr vector4<T> Max(const vector4<T>& lhs, const vector4<T>& rhs) {
+		return vector4<T>(lhs.x < rhs.x ? rhs.x : lhs.x, lhs.y < rhs.y ? rhs.y : lhs.y, lhs.z < rhs.z ? rhs.z : lhs.z, lhs.w < rhs.w ? rhs.w : lhs.w);
+	}
+
+	// @return Each component clamped between the matching components of lo and hi
+	template<typename T>
+	constexpr vector4<T> Clamp(const vector4<T>& obj, const vector4<T>& lo, const vector4<T>& hi) { return Min(Max(obj, lo), hi); }
+
+	// @return Component-wise absolute value
+	template<typename T>
+	constexpr vector4<T> Abs(const vector4<T>& obj) {
+		if constexpr (std::is_unsigned_v<T>)
+			return obj;
+		else
+			return vector4<T>(obj.x < T{} ? -obj.x : obj.x, obj.y < T{} ? -obj.y : obj.y, obj.z < T{} ? -obj.z : obj.z, obj.w < T{} ? -obj.w : obj.w);
+	}
+
+	template<typename T>
+	std::ostream& operator<<(std::ostream& out, const vector4<T>& obj) {
+		out << "vector4{" << obj.x << ", " << obj.y << ", " << obj.z << ", " << obj.w << "}";
+		return out;
+	}
+
+	static_assert(std::is_trivially_copyable_v<vector4<float>>, "vector4 must be trivially copyable");
+	static_assert(sizeof(vector4<float>) == 4 * sizeof(float), "vector4 must not be padded");
+}
@@ -1,7 +1,7 @@
 project "crux-common"
     kind "StaticLib"
     language "C++"
-    cppdialect "C++17"
+    cppdialect "C++20"
 
     staticruntime "On"
 
@@ -23,9 +23,17 @@ project "crux-common"
 
     filter "system:windows"
         removefiles {
-            "**.nix.h"
-            "**.nix.cpp"
-            "**.mac.h"
+            "**.nix.h",
+            "**.nix.cpp",
+            "**.mac.h",
+            "**.mac.cpp"
+        }
+
+    filter "system:linux"
+        removefiles {
+            "**.win32.h",
+            "**.win32.cpp",
+            "**.mac.h",
             "**.mac.cpp"
         }
 
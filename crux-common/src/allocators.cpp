@@ -0,0 +1,575 @@
+#include "allocators.h"
+
+#include <algorithm>
+
+#include "memory_tracking.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace crux::memory {
+	namespace {
+		// @return Index of the highest set bit, value must not be 0
+		inline std::size_t HighestBit(std::size_t value) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse64(&index, (unsigned long long)value);
+			return (std::size_t)index;
+#else
+			return (std::size_t)(63 - __builtin_clzll((unsigned long long)value));
+#endif
+		}
+
+		// @return Index of the lowest set bit, value must not be 0
+		inline std::size_t LowestBit(uint32_t value) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return (std::size_t)index;
+#else
+			return (std::size_t)__builtin_ctz(value);
+#endif
+		}
+	}
+
+	/*
+	 * Arena
+	 */
+
+	struct Arena::Block {
+		Block* next;
+
+		// Usable bytes after the header
+		std::size_t size;
+
+		// False for the caller provided buffer, which is never returned upstream
+		bool owned;
+
+		inline char* Data() { return reinterpret_cast<char*>(this) + HeaderSize; }
+
+		static constexpr std::size_t HeaderSize = AlignUp(sizeof(Block*) + sizeof(std::size_t) + sizeof(bool), DefaultAlignment);
+	};
+
+	Arena::Arena(std::size_t blockSize, std::pmr::memory_resource* upstream)
+		: upstream(upstream), blockSize(std::max<std::size_t>(blockSize, 64)) {}
+
+	Arena::Arena(void* buffer, std::size_t size, std::pmr::memory_resource* upstream)
+		: upstream(upstream), blockSize(std::max<std::size_t>(size, DefaultBlockSize)) {
+		const std::uintptr_t start = (std::uintptr_t)AlignUp((std::size_t)buffer, alignof(Block));
+		const std::uintptr_t end = (std::uintptr_t)buffer + size;
+		if (buffer && start + Block::HeaderSize < end) {
+			head = reinterpret_cast<Block*>(start);
+			head->next = nullptr;
+			head->size = (std::size_t)(end - start) - Block::HeaderSize;
+			head->owned = false;
+			current = head;
+			capacity = head->size;
+		}
+	}
+
+	Arena::~Arena() {
+		Release();
+	}
+
+	void* Arena::Allocate(std::size_t size, std::size_t alignment) {
+		if (size == 0)
+			size = 1;
+
+		for (;;) {
+			if (current) {
+				const std::uintptr_t base = (std::uintptr_t)current->Data();
+				const std::uintptr_t start = base + offset;
+				const std::uintptr_t aligned = (std::uintptr_t)AlignUp((std::size_t)start, alignment);
+				if (aligned + size <= base + current->size) {
+					offset = (std::size_t)(aligned + size - base);
+					used += (std::size_t)(aligned + size - start);
+					peak = std::max(peak, used);
+#if CRUX_TRACK_ALLOCATIONS
+					internal::RecordAllocatorAllocation(AllocatorKind::ARENA, (std::size_t)(aligned + size - start));
+#endif
+					return (void*)aligned;
+				}
+
+				//Move on to a block retained from before the last Reset
+				if (current->next) {
+					current = current->next;
+					offset = 0;
+					continue;
+				}
+			}
+
+			if (!upstream)
+				return nullptr;
+
+			const std::size_t bytes = std::max(blockSize, size + alignment);
+			Block* block = static_cast<Block*>(upstream->allocate(Block::HeaderSize + bytes, DefaultAlignment));
+			block->size = bytes;
+			block->owned = true;
+
+			//Insert after the current block so retained blocks further down are not lost
+			if (current) {
+				block->next = current->next;
+				current->next = block;
+			} else {
+				block->next = nullptr;
+				head = block;
+			}
+			current = block;
+			offset = 0;
+			capacity += bytes;
+		}
+	}
+
+	void Arena::Rewind(const Marker& marker) {
+		if (!marker.block) {
+			Reset();
+			return;
+		}
+
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::ARENA, used - marker.used, 0);
+#endif
+		current = marker.block;
+		offset = marker.offset;
+		used = marker.used;
+	}
+
+	void Arena::Reset() {
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::ARENA, used, 0);
+#endif
+		current = head;
+		offset = 0;
+		used = 0;
+	}
+
+	void Arena::Release() {
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::ARENA, used, 0);
+#endif
+
+		//The caller's buffer, if any, is always the head and stays
+		Block* keep = (head && !head->owned) ? head : nullptr;
+
+		Block* block = keep ? head->next : head;
+		while (block) {
+			Block* next = block->next;
+			upstream->deallocate(block, Block::HeaderSize + block->size, DefaultAlignment);
+			block = next;
+		}
+
+		head = keep;
+		if (keep)
+			keep->next = nullptr;
+		current = head;
+		offset = 0;
+		used = 0;
+		capacity = keep ? keep->size : 0;
+	}
+
+	/*
+	 * Pool
+	 */
+
+	struct Pool::Chunk {
+		Chunk* next;
+		std::size_t bytes;
+	};
+
+	Pool::Pool(std::size_t blockSize, std::size_t blockAlignment, std::size_t blocksPerChunk, std::pmr::memory_resource* upstream)
+		: upstream(upstream), blockSize(blockSize), blocksPerChunk(std::max<std::size_t>(blocksPerChunk, 1)) {
+		//Free blocks hold the free list link, so they must fit and align a pointer
+		this->blockAlignment = std::max(blockAlignment, alignof(void*));
+		stride = AlignUp(std::max(blockSize, sizeof(void*)), this->blockAlignment);
+	}
+
+	Pool::~Pool() {
+		Release();
+	}
+
+	void* Pool::Allocate() {
+		if (!freeList && !Grow())
+			return nullptr;
+
+		void* block = freeList;
+		freeList = *static_cast<void**>(block);
+		++usedCount;
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorAllocation(AllocatorKind::POOL, stride);
+#endif
+		return block;
+	}
+
+	void Pool::Free(void* block) {
+		if (!block)
+			return;
+
+		*static_cast<void**>(block) = freeList;
+		freeList = block;
+		--usedCount;
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::POOL, stride, 1);
+#endif
+	}
+
+	bool Pool::Grow() {
+		const std::size_t alignment = std::max(blockAlignment, alignof(Chunk));
+		const std::size_t headerSize = AlignUp(sizeof(Chunk), blockAlignment);
+		const std::size_t bytes = headerSize + stride * blocksPerChunk;
+
+		Chunk* chunk = static_cast<Chunk*>(upstream->allocate(bytes, alignment));
+		if (!chunk)
+			return false;
+
+		chunk->next = chunks;
+		chunk->bytes = bytes;
+		chunks = chunk;
+
+		//Push in reverse so blocks are handed out in address order
+		char* first = reinterpret_cast<char*>(chunk) + headerSize;
+		for (std::size_t i = blocksPerChunk; i-- > 0;) {
+			void* block = first + i * stride;
+			*static_cast<void**>(block) = freeList;
+			freeList = block;
+		}
+		capacityCount += blocksPerChunk;
+		return true;
+	}
+
+	void Pool::Release() {
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::POOL, usedCount * stride, usedCount);
+#endif
+
+		const std::size_t alignment = std::max(blockAlignment, alignof(Chunk));
+		while (chunks) {
+			Chunk* next = chunks->next;
+			upstream->deallocate(chunks, chunks->bytes, alignment);
+			chunks = next;
+		}
+
+		freeList = nullptr;
+		usedCount = 0;
+		capacityCount = 0;
+	}
+
+	/*
+	 * Tlsf
+	 */
+
+	/**
+	 * @brief Header in front of every block.
+	 * The free list links are only valid while the block is free, they
+	 * overlay the start of the payload.
+	*/
+	struct Tlsf::Block {
+		// Physically preceding block in the region, nullptr for the first
+		Block* prevPhysical;
+
+		// Payload size in bytes, the low bits hold the flags
+		std::size_t sizeAndFlags;
+
+		Block* nextFree;
+		Block* prevFree;
+
+		static constexpr std::size_t FreeFlag = 1;
+		static constexpr std::size_t FlagMask = Granularity - 1;
+
+		// Bytes of header before the payload
+		static constexpr std::size_t HeaderSize = sizeof(Block*) + sizeof(std::size_t);
+
+		// Smallest payload, enough to hold the free list links
+		static constexpr std::size_t MinPayload = 2 * sizeof(Block*);
+
+		inline std::size_t GetSize() const { return sizeAndFlags & ~FlagMask; }
+		inline void SetSize(std::size_t size) { sizeAndFlags = size | (sizeAndFlags & FlagMask); }
+
+		inline bool IsFree() const { return (sizeAndFlags & FreeFlag) != 0; }
+		inline void SetFree(bool free) { sizeAndFlags = free ? (sizeAndFlags | FreeFlag) : (sizeAndFlags & ~FreeFlag); }
+
+		inline void* GetPayload() { return reinterpret_cast<char*>(this) + HeaderSize; }
+		inline Block* GetNext() { return reinterpret_cast<Block*>(reinterpret_cast<char*>(this) + HeaderSize + GetSize()); }
+
+		static inline Block* FromPayload(void* ptr) { return reinterpret_cast<Block*>(static_cast<char*>(ptr) - HeaderSize); }
+	};
+
+	// Header of a region from upstream, followed by its blocks and an empty sentinel block
+	struct Tlsf::Region {
+		Region* next;
+		std::size_t bytes;
+	};
+
+	namespace {
+		// Smallest block that can stand on its own, header plus minimum payload
+		constexpr std::size_t TlsfMinBlock = 2 * Tlsf::Granularity;
+
+		/**
+		 * @brief Maps a block size to its first and second level bin.
+		*/
+		inline void MapSize(std::size_t size, std::size_t& fl, std::size_t& sl) {
+			if (size < Tlsf::SmallBlockSize) {
+				fl = 0;
+				sl = size / Tlsf::Granularity;
+			} else {
+				const std::size_t high = HighestBit(size);
+				sl = (size >> (high - Tlsf::SecondLevelLog2)) ^ Tlsf::SecondLevelCount;
+				fl = high - (Tlsf::FirstLevelShift - 1);
+			}
+		}
+
+		/**
+		 * @brief Rounds a size up to the next bin boundary, every block in that
+		 * bin or above is then large enough for it.
+		*/
+		inline std::size_t RoundToBin(std::size_t size) {
+			if (size >= Tlsf::SmallBlockSize)
+				size += ((std::size_t)1 << (HighestBit(size) - Tlsf::SecondLevelLog2)) - 1;
+			return size;
+		}
+	}
+
+	Tlsf::Tlsf(std::size_t regionSize, std::pmr::memory_resource* upstream)
+		: upstream(upstream), regionSize(std::max<std::size_t>(regionSize, 4096)) {
+		static_assert(Block::HeaderSize == Granularity, "Tlsf block headers must keep payloads aligned");
+		static_assert(sizeof(Region) <= Granularity, "Tlsf region header must fit in one granule");
+	}
+
+	Tlsf::~Tlsf() {
+		Release();
+	}
+
+	void* Tlsf::Allocate(std::size_t size, std::size_t alignment) {
+		if (size >= ((std::size_t)1 << (FirstLevelMax - 1)))
+			return nullptr;
+
+		const std::size_t payload = AlignUp(std::max(size, Block::MinPayload), Granularity);
+		const bool overAligned = alignment > Granularity;
+
+		//Over aligned requests need room to move the payload forward, leaving a free block behind
+		const std::size_t search = overAligned ? payload + alignment + TlsfMinBlock : payload;
+
+		Block* block = FindFree(search);
+		if (!block) {
+			if (!AddRegion(search))
+				return nullptr;
+			block = FindFree(search);
+			if (!block)
+				return nullptr;
+		}
+
+		if (overAligned) {
+			const std::uintptr_t start = (std::uintptr_t)block->GetPayload();
+			std::uintptr_t aligned = (std::uintptr_t)AlignUp((std::size_t)start, alignment);
+
+			//A gap too small to hold a free block is pushed out to the next aligned address
+			if (aligned != start && aligned - start < TlsfMinBlock)
+				aligned = (std::uintptr_t)AlignUp((std::size_t)start + TlsfMinBlock, alignment);
+			if (aligned != start)
+				block = TrimHead(block, (std::size_t)(aligned - start));
+		}
+
+		TrimTail(block, payload);
+		block->SetFree(false);
+
+		used += block->GetSize();
+		peak = std::max(peak, used);
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorAllocation(AllocatorKind::TLSF, block->GetSize());
+#endif
+		return block->GetPayload();
+	}
+
+	void Tlsf::Free(void* ptr) {
+		if (!ptr)
+			return;
+
+		Block* block = Block::FromPayload(ptr);
+		used -= block->GetSize();
+#if CRUX_TRACK_ALLOCATIONS
+		internal::RecordAllocatorFree(AllocatorKind::TLSF, block->GetSize(), 1);
+#endif
+		block->SetFree(true);
+		InsertFree(Merge(block));
+	}
+
+	void Tlsf::Release() {
+		while (regions) {
+			Region* next = regions->next;
+			upstream->deallocate(regions, regions->bytes, Granularity);
+			regions = next;
+		}
+
+		firstLevelMap = 0;
+		std::fill(std::begin(secondLevelMap), std::end(secondLevelMap), 0u);
+		for (auto& row : freeLists)
+			std::fill(std::begin(row), std::end(row), nullptr);
+		used = 0;
+		capacity = 0;
+	}
+
+	bool Tlsf::AddRegion(std::size_t minPayload) {
+		//Region header, first block header, payload, and the sentinel header
+		const std::size_t overhead = Granularity + Block::HeaderSize + Block::HeaderSize;
+		//Sized so FindFree, which rounds the request up to a bin boundary, is sure to find it
+		const std::size_t bytes = AlignUp(std::max(regionSize, RoundToBin(minPayload) + overhead), Granularity);
+
+		Region* region = static_cast<Region*>(upstream->allocate(bytes, Granularity));
+		if (!region)
+			return false;
+
+		region->next = regions;
+		region->bytes = bytes;
+		regions = region;
+		capacity += bytes;
+
+		Block* block = reinterpret_cast<Block*>(reinterpret_cast<char*>(region) + Granularity);
+		block->prevPhysical = nullptr;
+		block->sizeAndFlags = bytes - overhead;
+
+		//Zero sized, never free, stops merges running off the end of the region
+		Block* sentinel = block->GetNext();
+		sentinel->prevPhysical = block;
+		sentinel->sizeAndFlags = 0;
+
+		block->SetFree(true);
+		InsertFree(block);
+		return true;
+	}
+
+	void Tlsf::InsertFree(Block* block) {
+		std::size_t fl, sl;
+		MapSize(block->GetSize(), fl, sl);
+
+		Block* head = freeLists[fl][sl];
+		block->nextFree = head;
+		block->prevFree = nullptr;
+		if (head)
+			head->prevFree = block;
+		freeLists[fl][sl] = block;
+
+		firstLevelMap |= 1u << fl;
+		secondLevelMap[fl] |= 1u << sl;
+	}
+
+	void Tlsf::RemoveFree(Block* block) {
+		std::size_t fl, sl;
+		MapSize(block->GetSize(), fl, sl);
+
+		if (block->prevFree)
+			block->prevFree->nextFree = block->nextFree;
+		if (block->nextFree)
+			block->nextFree->prevFree = block->prevFree;
+
+		if (freeLists[fl][sl] == block) {
+			freeLists[fl][sl] = block->nextFree;
+			if (!block->nextFree) {
+				secondLevelMap[fl] &= ~(1u << sl);
+				if (!secondLevelMap[fl])
+					firstLevelMap &= ~(1u << fl);
+			}
+		}
+	}
+
+	Tlsf::Block* Tlsf::FindFree(std::size_t size) {
+		std::size_t fl, sl;
+		MapSize(RoundToBin(size), fl, sl);
+		if (fl >= FirstLevelCount)
+			return nullptr;
+
+		uint32_t slMap = secondLevelMap[fl] & (~0u << sl);
+		if (!slMap) {
+			const uint32_t flMap = firstLevelMap & (~0u << (fl + 1));
+			if (!flMap)
+				return nullptr;
+			fl = LowestBit(flMap);
+			slMap = secondLevelMap[fl];
+		}
+		sl = LowestBit(slMap);
+
+		Block* block = freeLists[fl][sl];
+		RemoveFree(block);
+		return block;
+	}
+
+	void Tlsf::TrimTail(Block* block, std::size_t size) {
+		const std::size_t total = block->GetSize();
+		if (total < size + TlsfMinBlock)
+			return;
+
+		Block* rest = reinterpret_cast<Block*>(static_cast<char*>(block->GetPayload()) + size);
+		rest->prevPhysical = block;
+		rest->sizeAndFlags = total - size - Block::HeaderSize;
+		rest->GetNext()->prevPhysical = rest;
+		block->SetSize(size);
+
+		//The block came off a free list, so its old neighbour is in use and rest can not merge
+		rest->SetFree(true);
+		InsertFree(rest);
+	}
+
+	Tlsf::Block* Tlsf::TrimHead(Block* block, std::size_t gap) {
+		Block* rest = reinterpret_cast<Block*>(reinterpret_cast<char*>(block) + gap);
+		rest->prevPhysical = block;
+		rest->sizeAndFlags = block->GetSize() - gap;
+		rest->GetNext()->prevPhysical = rest;
+
+		block->SetSize(gap - Block::HeaderSize);
+		block->SetFree(true);
+		InsertFree(block);
+		return rest;
+	}
+
+	Tlsf::Block* Tlsf::Merge(Block* block) {
+		Block* prev = block->prevPhysical;
+		if (prev && prev->IsFree()) {
+			RemoveFree(prev);
+			prev->SetSize(prev->GetSize() + Block::HeaderSize + block->GetSize());
+			prev->GetNext()->prevPhysical = prev;
+			block = prev;
+		}
+
+		Block* next = block->GetNext();
+		if (next->IsFree()) {
+			RemoveFree(next);
+			block->SetSize(block->GetSize() + Block::HeaderSize + next->GetSize());
+			block->GetNext()->prevPhysical = block;
+		}
+		return block;
+	}
+
+	/*
+	 * Resources
+	 */
+
+	void* ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+		void* ptr = arena.Allocate(bytes, alignment);
+		if (!ptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
+
+	void* PoolResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+		if (!Fits(bytes, alignment))
+			return upstream->allocate(bytes, alignment);
+
+		void* ptr = pool.Allocate();
+		if (!ptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
+
+	void PoolResource::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) {
+		if (Fits(bytes, alignment))
+			pool.Free(ptr);
+		else
+			upstream->deallocate(ptr, bytes, alignment);
+	}
+
+	void* TlsfResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+		void* ptr = tlsf.Allocate(bytes, alignment);
+		if (!ptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
+}
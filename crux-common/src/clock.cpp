@@ -0,0 +1,266 @@
+#include "clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "platform.h"
+#include "profile.h"
+
+#if CRUX_WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN 1
+	#endif
+	#include <windows.h>
+
+	//Added in Windows 10 1803, older SDKs lack the define
+	#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+	#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+	#endif
+#elif CRUX_UNIX
+	#include <cerrno>
+	#include <time.h>
+#endif
+
+namespace crux::clock {
+	namespace {
+		/**
+		 * @brief Running estimate of how late the OS wakes a sleeping thread.
+		 * Exponential moving mean and variance, so it adapts when the
+		 * system load or timer resolution changes.
+		*/
+		struct SleepEstimate {
+			// Start pessimistic, the first few waits spin more until the estimate settles
+			double mean = 1'000'000.0;
+			double variance = 0.0;
+
+			void Update(double overshoot) {
+				constexpr double Weight = 1.0 / 16.0;
+				const double diff = overshoot - mean;
+				mean += Weight * diff;
+				variance = (1.0 - Weight) * (variance + Weight * diff * diff);
+			}
+
+			// @return Nanoseconds before a deadline to stop sleeping and start spinning
+			uint64bit Margin() const {
+				constexpr double MinMargin = 20'000.0;
+				constexpr double MaxMargin = 4'000'000.0;
+				return (uint64bit)std::clamp(mean + 2.0 * std::sqrt(variance), MinMargin, MaxMargin);
+			}
+		};
+
+		thread_local SleepEstimate sleepEstimate;
+
+#if CRUX_WIN32
+		/**
+		 * @brief Per thread waitable timer, high resolution where the OS supports it.
+		 * Plain Sleep() rounds up to the 15.6ms system tick unless timeBeginPeriod
+		 * raises the resolution for the whole system.
+		*/
+		struct WaitableTimer {
+			HANDLE handle;
+
+			WaitableTimer() {
+				handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+				if (!handle)
+					handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+			}
+
+			~WaitableTimer() {
+				if (handle)
+					CloseHandle(handle);
+			}
+		};
+
+		thread_local WaitableTimer waitableTimer;
+
+		// @return Ticks per second of QueryPerformanceCounter, fixed at boot
+		uint64bit GetPerformanceFrequency() {
+			static const uint64bit frequency = [] {
+				LARGE_INTEGER freq;
+				QueryPerformanceFrequency(&freq);
+				return (uint64bit)freq.QuadPart;
+			}();
+			return frequency;
+		}
+#endif
+	}
+
+	uint64bit Now() {
+#if CRUX_WIN32
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		const uint64bit ticks = (uint64bit)counter.QuadPart;
+		const uint64bit freq = GetPerformanceFrequency();
+
+		//Split so the multiplication can not overflow for long uptimes
+		return (ticks / freq) * Second + ((ticks % freq) * Second) / freq;
+#elif CRUX_UNIX
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64bit)ts.tv_sec * Second + (uint64bit)ts.tv_nsec;
+#else
+		return (uint64bit)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	void SleepUntil(uint64bit deadline) {
+		const uint64bit now = Now();
+		if (now >= deadline)
+			return;
+
+#if CRUX_WIN32
+		if (waitableTimer.handle) {
+			//Negative due times are relative, in 100ns units
+			LARGE_INTEGER due;
+			due.QuadPart = -(LONGLONG)((deadline - now + 99) / 100);
+			if (SetWaitableTimer(waitableTimer.handle, &due, 0, nullptr, nullptr, FALSE)) {
+				WaitForSingleObject(waitableTimer.handle, INFINITE);
+				return;
+			}
+		}
+		Sleep((DWORD)((deadline - now + Millisecond - 1) / Millisecond));
+#elif CRUX_UNIX
+		//Absolute deadline, so restarting after a signal does not extend the sleep
+		timespec ts;
+		ts.tv_sec = (time_t)(deadline / Second);
+		ts.tv_nsec = (long)(deadline % Second);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+		std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+#endif
+	}
+
+	void WaitUntil(uint64bit deadline) {
+		SleepEstimate& estimate = sleepEstimate;
+		for (;;) {
+			const uint64bit now = Now();
+			if (now >= deadline)
+				return;
+
+			const uint64bit margin = estimate.Margin();
+			if (deadline - now <= margin)
+				break;
+
+			const uint64bit target = deadline - margin;
+			SleepUntil(target);
+
+			const uint64bit woke = Now();
+			estimate.Update(woke > target ? (double)(woke - target) : 0.0);
+		}
+
+		//Spin out the remainder, too short to trust to the scheduler
+		while (Now() < deadline)
+			CRUX_CPU_PAUSE();
+	}
+}
+
+namespace crux {
+	FrameHistory::FrameHistory(uint capacity) : samples(std::max(capacity, 1u), 0) {}
+
+	void FrameHistory::Record(uint64bit frameTime) {
+		samples[next] = frameTime;
+		next = (next + 1) % (uint)samples.size();
+		if (count < samples.size())
+			++count;
+	}
+
+	void FrameHistory::Clear() {
+		next = 0;
+		count = 0;
+	}
+
+	FrameStatistics FrameHistory::GetStatistics() const {
+		FrameStatistics stats;
+		if (count == 0)
+			return stats;
+
+		//Until full the held frames are the first count slots, after that all of them
+		sorted.assign(samples.begin(), samples.begin() + count);
+		std::sort(sorted.begin(), sorted.end());
+
+		uint64bit total = 0;
+		for (uint64bit frame : sorted)
+			total += frame;
+
+		//Nearest-rank percentiles
+		auto percentile = [&](double p) {
+			const std::size_t rank = (std::size_t)std::ceil(p * (double)count);
+			return sorted[std::min<std::size_t>(rank > 0 ? rank - 1 : 0, count - 1)];
+		};
+
+		stats.count = count;
+		stats.mean = total / count;
+		stats.p50 = percentile(0.50);
+		stats.p99 = percentile(0.99);
+		stats.min = sorted.front();
+		stats.max = sorted.back();
+		return stats;
+	}
+
+	FixedTimestep::FixedTimestep(uint64bit step, uint maxSteps)
+		: step(std::max<uint64bit>(step, 1)), maxSteps(std::max(maxSteps, 1u)) {}
+
+	uint FixedTimestep::Accumulate(uint64bit elapsed) {
+		accumulator += elapsed;
+
+		uint64bit steps = accumulator / step;
+		if (steps > maxSteps) {
+			//Drop whole steps beyond the limit but keep the fraction, so interpolation stays smooth
+			dropped += (steps - maxSteps) * step;
+			accumulator -= (steps - maxSteps) * step;
+			steps = maxSteps;
+		}
+
+		accumulator -= steps * step;
+		return (uint)steps;
+	}
+
+	FrameTimer::FrameTimer(double targetHz, uint historySize)
+		: period(clock::FromHertz(targetHz)), frames(historySize), work(historySize) {}
+
+	void FrameTimer::SetTargetRate(double hz) {
+		period = clock::FromHertz(hz);
+
+		//Restart the schedule from the next Tick() at the new rate
+		deadline = 0;
+	}
+
+	uint64bit FrameTimer::Tick() {
+		uint64bit now = clock::Now();
+		if (frameCount == 0) {
+			last = now;
+			deadline = now + period;
+			++frameCount;
+			CRUX_PROFILE_FRAME();
+			return 0;
+		}
+
+		workTime = now - last;
+		work.Record(workTime);
+
+		if (period > 0) {
+			if (deadline == 0)
+				deadline = now + period;
+
+			if (now < deadline) {
+				CRUX_PROFILE_SCOPE("FrameTimer::Wait");
+				clock::WaitUntil(deadline);
+				now = clock::Now();
+				deadline += period;
+			} else {
+				//Late by more than a frame, skip the missed slots rather than bursting through them
+				deadline = (now - deadline >= period) ? now + period : deadline + period;
+			}
+		}
+
+		delta = now - last;
+		last = now;
+		frames.Record(delta);
+		++frameCount;
+		CRUX_PROFILE_FRAME();
+		return delta;
+	}
+}
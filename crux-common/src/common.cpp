@@ -1,13 +1,16 @@
 #include "common.h"
 
+#include "log.h"
 #include "platform.h"
 
 namespace crux {
 	void TestCommon() {
-		printf("crux-common is active\n");
+		CRUX_LOG_INFO("crux-common is active");
 
 		if (TargetPlatform == Platform::WINDOWS) {
-			printf("platform is windows\n");
+			CRUX_LOG_INFO("platform is windows");
+		} else if (TargetPlatform == Platform::LINUX) {
+			CRUX_LOG_INFO("platform is linux");
 		}
 	}
 }
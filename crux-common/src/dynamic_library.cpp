@@ -0,0 +1,310 @@
+#include "dynamic_library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "memory_tracking.h"
+#include "platform.h"
+#include "small_string.h"
+
+namespace crux {
+	namespace {
+		// Hashes std::string keys and std::string_view lookups alike, so finding a name does not copy it
+		struct StringHash {
+			using is_transparent = void;
+
+			std::size_t operator()(std::string_view text) const noexcept {
+				return std::hash<std::string_view>{}(text);
+			}
+		};
+
+		template<typename T>
+		using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+		void* OpenNative(const string& name) {
+#if CRUX_WIN32
+			return internal::win32::OpenLibrary(name);
+#elif CRUX_UNIX
+			return internal::nix::OpenLibrary(name);
+#else
+			return nullptr;
+#endif
+		}
+
+		void CloseNative(void* handle) {
+#if CRUX_WIN32
+			internal::win32::CloseLibrary(handle);
+#elif CRUX_UNIX
+			internal::nix::CloseLibrary(handle);
+#endif
+		}
+
+		void* FindNative(void* handle, std::string_view symbol) {
+			//The OS wants a null terminated name
+			const small_string<char, 128> terminated(symbol);
+#if CRUX_WIN32
+			return internal::win32::FindLibrarySymbol(handle, terminated.c_str());
+#elif CRUX_UNIX
+			return internal::nix::FindLibrarySymbol(handle, terminated.c_str());
+#else
+			return nullptr;
+#endif
+		}
+	}
+
+	namespace internal {
+		/**
+		 * @brief One loaded library, shared by every DynamicLibrary handle to it.
+		*/
+		struct LibraryModule {
+			LibraryModule(const string& name, void* handle) : name(name), handle(handle) {}
+
+			const string name;
+			void* const handle;
+
+			// Handles alive, the module is closed and deleted when it drops to zero
+			std::atomic<uint> references{ 1 };
+
+			// Resolved symbols, missing ones are cached as nullptr
+			std::shared_mutex symbolLock;
+			StringMap<void*> symbols;
+		};
+	}
+
+	namespace {
+		// Loaded libraries by name, entries are only removed by the release dropping the last reference
+		struct Registry {
+			std::shared_mutex lock;
+			StringMap<internal::LibraryModule*> modules;
+		};
+
+		// Never destroyed, so libraries held by other statics can still be released during exit
+		Registry& GetRegistry() {
+			static Registry& registry = *new Registry;
+			return registry;
+		}
+
+		// Adds a reference unless the module already dropped to zero and is on its way out
+		bool TryAcquire(internal::LibraryModule* module) {
+			uint count = module->references.load(std::memory_order_relaxed);
+			while (count != 0) {
+				if (module->references.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+					return true;
+			}
+			return false;
+		}
+
+		void Acquire(internal::LibraryModule* module) {
+			module->references.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Release(internal::LibraryModule* module) {
+			if (module->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			{
+				//A Load() racing with this release may already have replaced the entry
+				Registry& registry = GetRegistry();
+				std::unique_lock<std::shared_mutex> lock(registry.lock);
+				auto entry = registry.modules.find(module->name);
+				if (entry != registry.modules.end() && entry->second == module)
+					registry.modules.erase(entry);
+			}
+
+			CloseNative(module->handle);
+			delete module;
+		}
+	}
+
+	optional<DynamicLibrary> DynamicLibrary::Load(const string& name) {
+		CRUX_MEMORY_TAG(PLATFORM);
+
+		if (auto existing = Find(name))
+			return existing;
+
+		//Opened outside the lock, a slow load must not hold up lookups of other libraries
+		void* handle = OpenNative(name);
+		if (!handle)
+			return {};
+
+		Registry& registry = GetRegistry();
+		std::unique_lock<std::shared_mutex> lock(registry.lock);
+		auto entry = registry.modules.find(name);
+		if (entry != registry.modules.end() && TryAcquire(entry->second)) {
+			//Another thread loaded it meanwhile, the OS counts our open so it has to be closed again
+			internal::LibraryModule* module = entry->second;
+			lock.unlock();
+			CloseNative(handle);
+			return DynamicLibrary(module);
+		}
+
+		internal::LibraryModule* module = new internal::LibraryModule(name, handle);
+		if (entry != registry.modules.end())
+			entry->second = module;
+		else
+			registry.modules.emplace(name, module);
+		return DynamicLibrary(module);
+	}
+
+	optional<DynamicLibrary> DynamicLibrary::Find(std::string_view name) {
+		Registry& registry = GetRegistry();
+		std::shared_lock<std::shared_mutex> lock(registry.lock);
+		auto entry = registry.modules.find(name);
+		if (entry != registry.modules.end() && TryAcquire(entry->second))
+			return DynamicLibrary(entry->second);
+		return {};
+	}
+
+	std::size_t DynamicLibrary::GetLoadedCount() {
+		Registry& registry = GetRegistry();
+		std::shared_lock<std::shared_mutex> lock(registry.lock);
+		return registry.modules.size();
+	}
+
+	DynamicLibrary::DynamicLibrary(const DynamicLibrary& other) noexcept : module(other.module) {
+		if (module)
+			Acquire(module);
+	}
+
+	DynamicLibrary::DynamicLibrary(DynamicLibrary&& other) noexcept : module(other.module) {
+		other.module = nullptr;
+	}
+
+	DynamicLibrary& DynamicLibrary::operator=(const DynamicLibrary& other) noexcept {
+		if (module != other.module) {
+			if (other.module)
+				Acquire(other.module);
+			Reset();
+			module = other.module;
+		}
+		return *this;
+	}
+
+	DynamicLibrary& DynamicLibrary::operator=(DynamicLibrary&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			module = other.module;
+			other.module = nullptr;
+		}
+		return *this;
+	}
+
+	DynamicLibrary::~DynamicLibrary() {
+		Reset();
+	}
+
+	std::string_view DynamicLibrary::GetName() const noexcept {
+		return module ? std::string_view(module->name) : std::string_view();
+	}
+
+	void* DynamicLibrary::GetNativeHandle() const noexcept {
+		return module ? module->handle : nullptr;
+	}
+
+	uint DynamicLibrary::GetReferenceCount() const noexcept {
+		return module ? module->references.load(std::memory_order_relaxed) : 0;
+	}
+
+	void DynamicLibrary::Reset() noexcept {
+		if (module) {
+			Release(module);
+			module = nullptr;
+		}
+	}
+
+	void* DynamicLibrary::GetSymbol(std::string_view symbol) const {
+		if (!module)
+			return nullptr;
+
+		{
+			std::shared_lock<std::shared_mutex> lock(module->symbolLock);
+			auto cached = module->symbols.find(symbol);
+			if (cached != module->symbols.end())
+				return cached->second;
+		}
+
+		CRUX_MEMORY_TAG(PLATFORM);
+		void* address = FindNative(module->handle, symbol);
+
+		//A racing lookup may have inserted it already, the address is the same either way
+		std::unique_lock<std::shared_mutex> lock(module->symbolLock);
+		module->symbols.emplace(string(symbol), address);
+		return address;
+	}
+
+	std::size_t DynamicLibrary::GetSymbols(span<const std::string_view> symbols, span<void*> out) const {
+		const std::size_t count = std::min(symbols.size(), out.size());
+		if (!module) {
+			std::fill(out.begin(), out.end(), nullptr);
+			return 0;
+		}
+
+		//Marks the slots that missed the cache, no symbol can resolve to its address
+		static char unresolved;
+		bool anyMissing = false;
+		{
+			std::shared_lock<std::shared_mutex> lock(module->symbolLock);
+			for (std::size_t i = 0; i < count; ++i) {
+				auto cached = module->symbols.find(symbols[i]);
+				if (cached != module->symbols.end()) {
+					out[i] = cached->second;
+				} else {
+					out[i] = &unresolved;
+					anyMissing = true;
+				}
+			}
+		}
+
+		if (anyMissing) {
+			CRUX_MEMORY_TAG(PLATFORM);
+
+			//Resolve outside the lock, then publish the whole batch under one exclusive lock
+			std::size_t first = count;
+			for (std::size_t i = 0; i < count; ++i) {
+				if (out[i] == &unresolved) {
+					out[i] = FindNative(module->handle, symbols[i]);
+					first = std::min(first, i);
+				}
+			}
+
+			std::unique_lock<std::shared_mutex> lock(module->symbolLock);
+			for (std::size_t i = first; i < count; ++i) {
+				if (module->symbols.find(symbols[i]) == module->symbols.end())
+					module->symbols.emplace(string(symbols[i]), out[i]);
+			}
+		}
+
+		std::size_t found = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			found += out[i] != nullptr;
+		for (std::size_t i = count; i < out.size(); ++i)
+			out[i] = nullptr;
+		return found;
+	}
+
+	const optional<DynamicLibrary>& LazyLibrary::Get() {
+		std::call_once(once, [this] {
+			library = DynamicLibrary::Load(name);
+			resolved.store(true, std::memory_order_release);
+		});
+		return library;
+	}
+
+	void* LazyLibrary::GetSymbol(std::string_view symbol) {
+		const optional<DynamicLibrary>& loaded = Get();
+		return loaded ? loaded->GetSymbol(symbol) : nullptr;
+	}
+
+	std::size_t LazyLibrary::GetSymbols(span<const std::string_view> symbols, span<void*> out) {
+		const optional<DynamicLibrary>& loaded = Get();
+		if (!loaded) {
+			std::fill(out.begin(), out.end(), nullptr);
+			return 0;
+		}
+		return loaded->GetSymbols(symbols, out);
+	}
+}
@@ -0,0 +1,279 @@
+#include "jobs.h"
+
+#include "memory_tracking.h"
+#include "platform.h"
+#include "profile.h"
+
+namespace crux {
+	namespace {
+		// Failed searches before an idle worker goes to sleep
+		constexpr uint SpinLimit = 64;
+
+		// Recycled jobs kept per thread, beyond this they are returned to the heap
+		constexpr std::size_t JobCacheLimit = 1024;
+
+		// Slot reported for threads that are not part of the calling system
+		constexpr uint NoWorker = ~0u;
+
+		/**
+		 * @brief Which job system, and which slot in it, the calling thread is.
+		*/
+		struct ThreadContext {
+			const JobSystem* system = nullptr;
+			uint index = NoWorker;
+		};
+
+		thread_local ThreadContext threadContext;
+
+		/**
+		 * @brief Recycled job allocations of the calling thread.
+		 * Jobs are freed by whichever thread ran them, so the caches balance
+		 * out between the submitting and the stealing threads.
+		*/
+		struct JobCache {
+			std::vector<internal::Job*> free;
+
+			~JobCache() {
+				for (internal::Job* job : free)
+					delete job;
+			}
+		};
+
+		thread_local JobCache jobCache;
+
+		// xorshift32, only needs to spread the steal attempts
+		inline uint32bit NextRandom(uint32bit& state) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	}
+
+	JobSystem::JobSystem(uint workerCount) {
+		workerSlots = workerCount + 1;
+		workers = std::make_unique<Worker[]>(workerSlots);
+		for (uint i = 0; i < workerSlots; ++i)
+			workers[i].random = 0x9E3779B9u * (i + 1);
+
+		threadContext = { this, 0 };
+		for (uint i = 1; i < workerSlots; ++i)
+			workers[i].thread = std::thread(&JobSystem::WorkerLoop, this, i);
+	}
+
+	JobSystem::~JobSystem() {
+		stopping.store(true, std::memory_order_seq_cst);
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			epoch.fetch_add(1, std::memory_order_seq_cst);
+		}
+		sleepCondition.notify_all();
+
+		for (uint i = 1; i < workerSlots; ++i) {
+			if (workers[i].thread.joinable())
+				workers[i].thread.join();
+		}
+
+		//Discard anything left over without running it
+		auto discard = [](internal::Job* job) {
+			job->destroy(job->storage);
+			FreeJob(job);
+		};
+		internal::Job* job;
+		for (uint i = 0; i < workerSlots; ++i) {
+			while (workers[i].jobs.steal(job))
+				discard(job);
+		}
+		for (internal::Job* queued : injected)
+			discard(queued);
+		injected.clear();
+
+		if (threadContext.system == this)
+			threadContext = {};
+	}
+
+	uint JobSystem::DefaultWorkerCount() {
+		const uint hardware = std::thread::hardware_concurrency();
+		return hardware > 1 ? hardware - 1 : 0;
+	}
+
+	void JobSystem::Wait(JobCounter& counter) {
+		while (!counter.IsDone()) {
+			if (!TryRunPending())
+				CRUX_CPU_PAUSE();
+		}
+
+		//The last decrement happens under the lock, taking it ensures the finishing thread is done with the counter
+		std::lock_guard<std::mutex> guard(counter.lock);
+	}
+
+	bool JobSystem::TryRunPending() {
+		internal::Job* job = FindJob(GetCurrentIndex());
+		if (!job)
+			return false;
+
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::WorkerLoop(uint index) {
+		threadContext = { this, index };
+		CRUX_PROFILE_THREAD(("Job worker " + std::to_string(index)).c_str());
+
+		uint misses = 0;
+		while (!stopping.load(std::memory_order_acquire)) {
+			if (internal::Job* job = FindJob(index)) {
+				Execute(job);
+				misses = 0;
+				continue;
+			}
+
+			if (++misses < SpinLimit) {
+				CRUX_CPU_PAUSE();
+				continue;
+			}
+
+			//Announce the sleep before the final check, any submission after it bumps the epoch
+			const uint64bit seen = epoch.load(std::memory_order_seq_cst);
+			sleeping.fetch_add(1, std::memory_order_seq_cst);
+			if (internal::Job* job = FindJob(index)) {
+				sleeping.fetch_sub(1, std::memory_order_relaxed);
+				Execute(job);
+				misses = 0;
+				continue;
+			}
+
+			{
+				std::unique_lock<std::mutex> guard(sleepLock);
+				sleepCondition.wait(guard, [&] {
+					return epoch.load(std::memory_order_seq_cst) != seen;
+				});
+			}
+			sleeping.fetch_sub(1, std::memory_order_relaxed);
+			misses = 0;
+		}
+
+		threadContext = {};
+	}
+
+	void JobSystem::Submit(internal::Job* job) {
+		const uint index = GetCurrentIndex();
+		if (index != NoWorker) {
+			if (!workers[index].jobs.push(job)) {
+				//Deque full, running it now also throttles the producer
+				Execute(job);
+				return;
+			}
+		} else {
+			std::lock_guard<std::mutex> guard(injectLock);
+			injected.push_back(job);
+			injectedCount.fetch_add(1, std::memory_order_release);
+		}
+
+		Notify();
+	}
+
+	internal::Job* JobSystem::FindJob(uint index) {
+		internal::Job* job = nullptr;
+		if (index != NoWorker && workers[index].jobs.pop(job))
+			return job;
+
+		if (injectedCount.load(std::memory_order_acquire) > 0) {
+			std::lock_guard<std::mutex> guard(injectLock);
+			if (!injected.empty()) {
+				job = injected.front();
+				injected.pop_front();
+				injectedCount.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		//Start at a random victim so thieves do not all hammer the same deque
+		uint32bit seed = index != NoWorker ? workers[index].random : (uint32bit)(std::size_t)&job;
+		const uint start = NextRandom(seed) % workerSlots;
+		if (index != NoWorker)
+			workers[index].random = seed;
+
+		for (uint i = 0; i < workerSlots; ++i) {
+			const uint victim = (start + i) % workerSlots;
+			if (victim != index && workers[victim].jobs.steal(job))
+				return job;
+		}
+		return nullptr;
+	}
+
+	void JobSystem::Execute(internal::Job* job) {
+		{
+			CRUX_PROFILE_SCOPE("Job");
+			job->invoke(job->storage);
+		}
+		job->destroy(job->storage);
+
+		JobCounter* counter = job->counter;
+		FreeJob(job);
+		if (counter)
+			FinishJob(*counter);
+	}
+
+	void JobSystem::FinishJob(JobCounter& counter) {
+		uint pending = counter.pending.load(std::memory_order_relaxed);
+		for (;;) {
+			if (pending > 1) {
+				if (counter.pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+					return;
+				continue;
+			}
+
+			//Dropping to zero is done under the lock, so RunAfter can not slip a continuation in behind it
+			std::vector<internal::Job*> released;
+			{
+				std::lock_guard<std::mutex> guard(counter.lock);
+				if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+					//Raced with a new submission, the count did not reach zero after all
+					return;
+				}
+				released.swap(counter.continuations);
+			}
+
+			for (internal::Job* job : released)
+				Submit(job);
+			return;
+		}
+	}
+
+	void JobSystem::Notify() {
+		epoch.fetch_add(1, std::memory_order_seq_cst);
+		if (sleeping.load(std::memory_order_seq_cst) == 0)
+			return;
+
+		//Taking the lock orders the notify after a worker's predicate check
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+		}
+		sleepCondition.notify_one();
+	}
+
+	uint JobSystem::GetCurrentIndex() const {
+		return threadContext.system == this ? threadContext.index : NoWorker;
+	}
+
+	internal::Job* JobSystem::AllocateJob() {
+		std::vector<internal::Job*>& cache = jobCache.free;
+		if (cache.empty()) {
+			CRUX_MEMORY_TAG(JOBS);
+			return new internal::Job();
+		}
+
+		internal::Job* job = cache.back();
+		cache.pop_back();
+		return job;
+	}
+
+	void JobSystem::FreeJob(internal::Job* job) {
+		std::vector<internal::Job*>& cache = jobCache.free;
+		if (cache.size() < JobCacheLimit)
+			cache.push_back(job);
+		else
+			delete job;
+	}
+}
@@ -0,0 +1,56 @@
+#include "library_preload.h"
+
+#include "memory_tracking.h"
+#include "platform.h"
+
+namespace crux {
+	LibraryPreload::LibraryPreload(JobSystem& jobs, const std::vector<string>& names)
+		: jobs(jobs), slots(std::make_unique<Slot[]>(names.size())), count(names.size()) {
+		CRUX_MEMORY_TAG(PLATFORM);
+
+		for (std::size_t i = 0; i < count; ++i)
+			slots[i].name = names[i];
+
+		for (std::size_t i = 0; i < count; ++i) {
+			Slot* slot = &slots[i];
+			jobs.Run([slot] {
+				slot->library = DynamicLibrary::Load(slot->name);
+				slot->done.store(true, std::memory_order_release);
+			}, &counter);
+		}
+	}
+
+	LibraryPreload::~LibraryPreload() {
+		Wait();
+	}
+
+	bool LibraryPreload::IsReady(std::size_t index) const {
+		return index < count && slots[index].done.load(std::memory_order_acquire);
+	}
+
+	void LibraryPreload::Wait() {
+		jobs.Wait(counter);
+	}
+
+	const optional<DynamicLibrary>& LibraryPreload::Get(std::size_t index) {
+		Slot& slot = slots[index];
+		while (!slot.done.load(std::memory_order_acquire)) {
+			if (!jobs.TryRunPending())
+				CRUX_CPU_PAUSE();
+		}
+		return slot.library;
+	}
+
+	optional<DynamicLibrary> LibraryPreload::Get(std::string_view name) {
+		for (std::size_t i = 0; i < count; ++i) {
+			if (slots[i].name == name)
+				return Get(i);
+		}
+		return {};
+	}
+
+	task<optional<DynamicLibrary>> LoadLibraryAsync(string name, JobSystem& jobs) {
+		co_await Schedule(jobs);
+		co_return DynamicLibrary::Load(name);
+	}
+}
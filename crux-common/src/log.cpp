@@ -0,0 +1,571 @@
+#include "log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+#include "mpsc_queue.h"
+#include "platform.h"
+
+namespace crux::log {
+	namespace {
+		using internal::ArgType;
+		using internal::Record;
+
+		constexpr const char* LevelNames[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL", "OFF" };
+
+		// Records written per hold of the sink lock, so AddSink() is never held off for long
+		constexpr std::size_t BatchSize = 256;
+
+		// Longest the logging thread sleeps, bounds the delay should a wake-up be missed
+		constexpr std::chrono::milliseconds IdleWait(10);
+
+		// Time 0 of the printed timestamps
+		const uint64bit Epoch = clock::Now();
+
+		std::atomic<uint32bit> NextThread{ 0 };
+
+		struct Logger {
+			// Created by the first Start(), never freed so producers racing a Stop() stay safe
+			std::unique_ptr<mpsc_queue<Record>> queue;
+			std::atomic<bool> running{ false };
+			std::thread thread;
+
+			// Serializes Start() and Stop()
+			std::mutex controlLock;
+
+			// Held while formatting and writing, by the logging thread or a synchronous write
+			std::mutex sinkLock;
+			std::vector<std::unique_ptr<Sink>> sinks;
+			ConsoleSink fallback;
+			std::string message;
+			std::string text;
+			bool dirty = false;
+			uint64bit reportedDropped = 0;
+
+			// Wakes the logging thread, producers only notify while it is idle
+			std::mutex wakeLock;
+			std::condition_variable wake;
+			std::atomic<bool> idle{ false };
+			bool stopping = false;
+
+			// Flush() tickets, completed in the order they were queued
+			std::mutex flushLock;
+			std::condition_variable flushed;
+			uint64bit flushRequested = 0;
+			uint64bit flushDone = 0;
+
+			std::atomic<uint64bit> dropped{ 0 };
+
+			~Logger();
+		};
+
+		Logger& GetLogger() {
+			static Logger logger;
+			return logger;
+		}
+
+		const char* BaseName(const char* path) {
+			const char* name = path;
+			for (const char* c = path; *c; ++c) {
+				if (*c == '/' || *c == '\\')
+					name = c + 1;
+			}
+			return name;
+		}
+
+		template<typename... Args>
+		void AppendPrintf(std::string& out, const char* format, Args... args) {
+			char buffer[128];
+			const int length = std::snprintf(buffer, sizeof(buffer), format, args...);
+			if (length <= 0)
+				return;
+
+			if ((std::size_t)length < sizeof(buffer)) {
+				out.append(buffer, (std::size_t)length);
+			} else {
+				const std::size_t start = out.size();
+				out.resize(start + (std::size_t)length + 1);
+				std::snprintf(out.data() + start, (std::size_t)length + 1, format, args...);
+				out.resize(start + (std::size_t)length);
+			}
+		}
+
+		template<typename T>
+		T Read(const Record& record, std::size_t& offset) {
+			T value;
+			std::memcpy(&value, record.payload + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		/**
+		 * @brief A printf conversion taken apart, see FormatRecord().
+		*/
+		struct Conversion {
+			// "%" followed by the flags and width
+			char spec[32];
+			std::size_t length = 0;
+
+			// Negative without a precision
+			int precision = -1;
+
+			char type = 0;
+
+			void Push(char c) {
+				if (length < 24)
+					spec[length++] = c;
+			}
+
+			// @return The spec completed with the given length modifier and conversion
+			const char* Finish(const char* suffix) {
+				std::size_t end = length;
+				if (precision >= 0)
+					end += (std::size_t)std::snprintf(spec + end, sizeof(spec) - end, ".%d", precision);
+				std::snprintf(spec + end, sizeof(spec) - end, "%s", suffix);
+				return spec;
+			}
+		};
+
+		void AppendText(std::string& out, Conversion& conversion, std::string_view text) {
+			if (conversion.precision >= 0 && (std::size_t)conversion.precision < text.size())
+				text = text.substr(0, (std::size_t)conversion.precision);
+			conversion.precision = -1;
+
+			//A plain %s needs no snprintf pass
+			if (conversion.length == 1) {
+				out.append(text);
+				return;
+			}
+			AppendPrintf(out, conversion.Finish(".*s"), (int)text.size(), text.data());
+		}
+
+		void AppendInteger(std::string& out, Conversion& conversion, unsigned long long value, bool isSigned) {
+			const char type = conversion.type;
+			if (type == 'c') {
+				AppendPrintf(out, conversion.Finish("c"), (int)value);
+			} else if (type == 'o' || type == 'x' || type == 'X' || (type == 'u' && isSigned)) {
+				const char suffix[] = { 'l', 'l', type, 0 };
+				AppendPrintf(out, conversion.Finish(suffix), value);
+			} else if (isSigned) {
+				AppendPrintf(out, conversion.Finish("lld"), (long long)value);
+			} else {
+				AppendPrintf(out, conversion.Finish("llu"), value);
+			}
+		}
+
+		string DescribeError(uint32bit code) {
+#if CRUX_WIN32
+			string message = crux::internal::win32::GetErrorString(code);
+#elif CRUX_UNIX
+			string message = crux::internal::nix::GetErrorString(code);
+#else
+			string message;
+#endif
+			//FormatMessage() ends its messages with a line break
+			while (!message.empty() && (message.back() == '\n' || message.back() == '\r' || message.back() == ' '))
+				message.pop_back();
+			if (message.empty())
+				message = "error " + std::to_string(code);
+			return message;
+		}
+
+		void AppendArgument(std::string& out, const Record& record, std::size_t& offset, ArgType type, Conversion& conversion) {
+			switch (type) {
+				case ArgType::INT:
+					AppendInteger(out, conversion, (unsigned long long)Read<long long>(record, offset), true);
+					break;
+				case ArgType::UINT:
+					AppendInteger(out, conversion, Read<unsigned long long>(record, offset), false);
+					break;
+				case ArgType::DOUBLE: {
+					const char floating[] = "fFeEgGaA";
+					const char suffix[] = { std::memchr(floating, conversion.type, sizeof(floating) - 1) ? conversion.type : 'g', 0 };
+					AppendPrintf(out, conversion.Finish(suffix), Read<double>(record, offset));
+					break;
+				}
+				case ArgType::POINTER:
+					AppendPrintf(out, conversion.Finish("p"), Read<const void*>(record, offset));
+					break;
+				case ArgType::STRING: {
+					const uint16bit length = Read<uint16bit>(record, offset);
+					const std::string_view text((const char*)record.payload + offset, length);
+					offset += length;
+					AppendText(out, conversion, text);
+					break;
+				}
+				case ArgType::SYSTEM_ERROR: {
+					const uint32bit code = Read<uint32bit>(record, offset);
+					if (std::strchr("diouxX", conversion.type))
+						AppendInteger(out, conversion, code, false);
+					else
+						AppendText(out, conversion, DescribeError(code));
+					break;
+				}
+			}
+		}
+
+		/**
+		 * @brief Expands the record's printf format with its captured arguments.
+		 * Length modifiers are ignored, each argument is printed with the type
+		 * it was captured as. Conversions without an argument are copied as is.
+		*/
+		void FormatRecord(const Record& record, std::string& out) {
+			const char* f = record.format;
+			std::size_t offset = 0;
+			uint argument = 0;
+
+			while (*f) {
+				if (*f != '%') {
+					const char* start = f;
+					while (*f && *f != '%')
+						++f;
+					out.append(start, (std::size_t)(f - start));
+					continue;
+				}
+
+				if (f[1] == '%') {
+					out += '%';
+					f += 2;
+					continue;
+				}
+
+				const char* start = f++;
+				Conversion conversion;
+				conversion.Push('%');
+				while (*f && std::strchr("-+ #0*", *f)) {
+					if (*f != '*')
+						conversion.Push(*f);
+					++f;
+				}
+				while ((*f >= '0' && *f <= '9') || *f == '*') {
+					if (*f != '*')
+						conversion.Push(*f);
+					++f;
+				}
+				if (*f == '.') {
+					conversion.precision = 0;
+					for (++f; (*f >= '0' && *f <= '9') || *f == '*'; ++f) {
+						if (*f != '*' && conversion.precision < 1000)
+							conversion.precision = conversion.precision * 10 + (*f - '0');
+					}
+				}
+				while (*f && std::strchr("hlLqjzt", *f))
+					++f;
+
+				if (!*f) {
+					out.append(start);
+					break;
+				}
+				conversion.type = *f++;
+
+				if (argument >= record.argCount) {
+					out.append(start, (std::size_t)(f - start));
+					continue;
+				}
+				AppendArgument(out, record, offset, record.types[argument++], conversion);
+			}
+		}
+
+		// Formats and hands the record to every sink, sinkLock must be held
+		void WriteRecord(Logger& logger, const Record& record) {
+			logger.message.clear();
+			FormatRecord(record, logger.message);
+
+			logger.text.clear();
+			const double seconds = (double)(int64_t)(record.timestamp - Epoch) / (double)clock::Second;
+			AppendPrintf(logger.text, "[%12.6f] %-5s #%-2u ", seconds, LevelNames[(std::size_t)record.level], record.thread);
+			logger.text += logger.message;
+			if (record.level >= Level::ERR)
+				AppendPrintf(logger.text, " (%s:%u)", BaseName(record.file), record.line);
+			logger.text += '\n';
+
+			Entry entry;
+			entry.timestamp = record.timestamp;
+			entry.level = record.level;
+			entry.thread = record.thread;
+			entry.file = record.file;
+			entry.line = record.line;
+			entry.message = logger.message;
+			entry.text = logger.text;
+
+			if (logger.sinks.empty()) {
+				logger.fallback.Write(entry);
+			} else {
+				for (auto& sink : logger.sinks)
+					sink->Write(entry);
+			}
+			logger.dirty = true;
+		}
+
+		// sinkLock must be held
+		void FlushSinks(Logger& logger) {
+			if (!logger.dirty)
+				return;
+
+			if (logger.sinks.empty()) {
+				logger.fallback.Flush();
+			} else {
+				for (auto& sink : logger.sinks)
+					sink->Flush();
+			}
+			logger.dirty = false;
+		}
+
+		// Writes a notice if records were dropped since the last one, sinkLock must be held
+		void ReportDropped(Logger& logger) {
+			const uint64bit dropped = logger.dropped.load(std::memory_order_relaxed);
+			if (dropped == logger.reportedDropped)
+				return;
+
+			Record notice{};
+			notice.timestamp = clock::Now();
+			notice.format = "%llu log record(s) dropped, the queue was full";
+			notice.file = __FILE__;
+			notice.line = __LINE__;
+			notice.level = Level::WARN;
+			internal::Encode(notice, dropped - logger.reportedDropped);
+			logger.reportedDropped = dropped;
+			WriteRecord(logger, notice);
+		}
+
+		// Flush() markers have no format, the ticket rides in the timestamp
+		void Process(Logger& logger, const Record& record) {
+			if (record.format) {
+				WriteRecord(logger, record);
+				return;
+			}
+
+			FlushSinks(logger);
+			std::lock_guard<std::mutex> lock(logger.flushLock);
+			if (record.timestamp > logger.flushDone)
+				logger.flushDone = record.timestamp;
+			logger.flushed.notify_all();
+		}
+
+		// @return Number of records taken off the queue
+		std::size_t Drain(Logger& logger, std::size_t limit) {
+			std::lock_guard<std::mutex> lock(logger.sinkLock);
+
+			Record record;
+			std::size_t count = 0;
+			while (count < limit && logger.queue->try_pop(record)) {
+				Process(logger, record);
+				++count;
+			}
+
+			ReportDropped(logger);
+			if (!count)
+				FlushSinks(logger);
+			return count;
+		}
+
+		void Run(Logger& logger) {
+			for (;;) {
+				if (Drain(logger, BatchSize))
+					continue;
+
+				std::unique_lock<std::mutex> lock(logger.wakeLock);
+				if (logger.stopping)
+					break;
+
+				//A push still being written keeps the queue non-empty, spin on it instead of sleeping
+				logger.idle.store(true);
+				if (logger.queue->empty())
+					logger.wake.wait_for(lock, IdleWait);
+				logger.idle.store(false, std::memory_order_relaxed);
+			}
+
+			//Whatever got queued before running was cleared
+			while (Drain(logger, ~(std::size_t)0) || !logger.queue->empty())
+				std::this_thread::yield();
+		}
+
+		void StopLogger(Logger& logger) {
+			std::lock_guard<std::mutex> control(logger.controlLock);
+			if (!logger.running.load(std::memory_order_relaxed))
+				return;
+
+			//New records are written synchronously from here on
+			logger.running.store(false, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> lock(logger.wakeLock);
+				logger.stopping = true;
+			}
+			logger.wake.notify_one();
+			logger.thread.join();
+
+			std::lock_guard<std::mutex> lock(logger.flushLock);
+			logger.flushed.notify_all();
+		}
+
+		Logger::~Logger() {
+			StopLogger(*this);
+		}
+	}
+
+	namespace internal {
+		Record& BeginRecord(Level level, const char* file, uint32bit line, const char* format) {
+			thread_local Record record;
+			thread_local const uint32bit thread = NextThread.fetch_add(1, std::memory_order_relaxed) + 1;
+
+			record.timestamp = clock::Now();
+			record.format = format;
+			record.file = file;
+			record.line = line;
+			record.thread = thread;
+			record.level = level;
+			record.argCount = 0;
+			record.size = 0;
+			return record;
+		}
+
+		void Submit(Record& record) {
+			Logger& logger = GetLogger();
+			if (logger.running.load(std::memory_order_acquire)) {
+				if (logger.queue->try_push(record)) {
+					//Only the first record after the logging thread went idle pays for the wake-up
+					if (logger.idle.load() && logger.idle.exchange(false))
+						logger.wake.notify_one();
+				} else {
+					logger.dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			} else {
+				std::lock_guard<std::mutex> lock(logger.sinkLock);
+				WriteRecord(logger, record);
+				if (record.level >= Level::ERR)
+					FlushSinks(logger);
+			}
+
+			//The process is likely about to go down, get the record out first
+			if (record.level >= Level::FATAL)
+				Flush();
+		}
+	}
+
+	SystemError LastError() {
+#if CRUX_WIN32
+		return { crux::internal::win32::GetLastErrorCode() };
+#elif CRUX_UNIX
+		return { crux::internal::nix::GetLastErrorCode() };
+#else
+		return {};
+#endif
+	}
+
+	void ConsoleSink::Write(const Entry& entry) {
+		std::FILE* out = entry.level >= Level::ERR ? stderr : stdout;
+		std::fwrite(entry.text.data(), 1, entry.text.size(), out);
+	}
+
+	void ConsoleSink::Flush() {
+		std::fflush(stdout);
+		std::fflush(stderr);
+	}
+
+	FileSink::FileSink(const string& path, bool append) {
+		file = std::fopen(path.c_str(), append ? "ab" : "wb");
+	}
+
+	FileSink::~FileSink() {
+		if (file)
+			std::fclose(file);
+	}
+
+	void FileSink::Write(const Entry& entry) {
+		if (file)
+			std::fwrite(entry.text.data(), 1, entry.text.size(), file);
+	}
+
+	void FileSink::Flush() {
+		if (file)
+			std::fflush(file);
+	}
+
+	void Start(const Config& config) {
+		Logger& logger = GetLogger();
+		std::lock_guard<std::mutex> control(logger.controlLock);
+		if (logger.running.load(std::memory_order_relaxed))
+			return;
+
+		if (!logger.queue)
+			logger.queue = std::make_unique<mpsc_queue<Record>>(config.capacity);
+
+		{
+			std::lock_guard<std::mutex> lock(logger.sinkLock);
+			if (config.console && logger.sinks.empty())
+				logger.sinks.push_back(std::make_unique<ConsoleSink>());
+		}
+		{
+			std::lock_guard<std::mutex> lock(logger.wakeLock);
+			logger.stopping = false;
+		}
+
+		logger.running.store(true, std::memory_order_release);
+		logger.thread = std::thread(Run, std::ref(logger));
+	}
+
+	void Stop() {
+		StopLogger(GetLogger());
+	}
+
+	bool IsRunning() {
+		return GetLogger().running.load(std::memory_order_acquire);
+	}
+
+	void Flush() {
+		Logger& logger = GetLogger();
+		if (!logger.running.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock(logger.sinkLock);
+			FlushSinks(logger);
+			return;
+		}
+
+		Record marker{};
+		{
+			std::lock_guard<std::mutex> lock(logger.flushLock);
+			marker.timestamp = ++logger.flushRequested;
+		}
+
+		//The marker must not be dropped, wait for room instead
+		while (!logger.queue->try_push(marker)) {
+			if (!logger.running.load(std::memory_order_acquire))
+				return;
+			std::this_thread::yield();
+		}
+		logger.wake.notify_one();
+
+		std::unique_lock<std::mutex> lock(logger.flushLock);
+		logger.flushed.wait(lock, [&] {
+			return logger.flushDone >= marker.timestamp || !logger.running.load(std::memory_order_acquire);
+		});
+	}
+
+	void AddSink(std::unique_ptr<Sink> sink) {
+		if (!sink)
+			return;
+
+		Logger& logger = GetLogger();
+		std::lock_guard<std::mutex> lock(logger.sinkLock);
+		logger.sinks.push_back(std::move(sink));
+	}
+
+	void ClearSinks() {
+		Logger& logger = GetLogger();
+		std::lock_guard<std::mutex> lock(logger.sinkLock);
+		FlushSinks(logger);
+		logger.sinks.clear();
+	}
+
+	uint64bit GetDroppedCount() {
+		return GetLogger().dropped.load(std::memory_order_relaxed);
+	}
+
+	const char* GetLevelName(Level level) {
+		return (std::size_t)level < std::size(LevelNames) ? LevelNames[(std::size_t)level] : "?";
+	}
+}
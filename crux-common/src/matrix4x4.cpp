@@ -0,0 +1,157 @@
+#include "matrix4x4.h"
+
+#if CRUX_SIMD_AVX
+#include <immintrin.h>
+#elif CRUX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace crux::internal::simd {
+#if CRUX_SIMD_AVX
+	void Multiply4x4(const float* lhs, const float* rhs, float* out) {
+		//Each lhs column is broadcast to both 128bit halves, two rhs columns are handled per register
+		const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 0));
+		const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 4));
+		const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 8));
+		const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 12));
+		const __m256 b01 = _mm256_loadu_ps(rhs);
+		const __m256 b23 = _mm256_loadu_ps(rhs + 8);
+
+		auto column = [&](__m256 b) {
+#if CRUX_SIMD_FMA
+			__m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00));
+			r = _mm256_fmadd_ps(a1, _mm256_permute_ps(b, 0x55), r);
+			r = _mm256_fmadd_ps(a2, _mm256_permute_ps(b, 0xAA), r);
+			return _mm256_fmadd_ps(a3, _mm256_permute_ps(b, 0xFF), r);
+#else
+			__m256 r0 = _mm256_add_ps(_mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00)), _mm256_mul_ps(a1, _mm256_permute_ps(b, 0x55)));
+			__m256 r1 = _mm256_add_ps(_mm256_mul_ps(a2, _mm256_permute_ps(b, 0xAA)), _mm256_mul_ps(a3, _mm256_permute_ps(b, 0xFF)));
+			return _mm256_add_ps(r0, r1);
+#endif
+		};
+
+		const __m256 r01 = column(b01);
+		const __m256 r23 = column(b23);
+		_mm256_storeu_ps(out, r01);
+		_mm256_storeu_ps(out + 8, r23);
+	}
+#elif CRUX_SIMD_SSE2
+	void Multiply4x4(const float* lhs, const float* rhs, float* out) {
+		const __m128 a0 = _mm_loadu_ps(lhs + 0);
+		const __m128 a1 = _mm_loadu_ps(lhs + 4);
+		const __m128 a2 = _mm_loadu_ps(lhs + 8);
+		const __m128 a3 = _mm_loadu_ps(lhs + 12);
+		__m128 b[4] = { _mm_loadu_ps(rhs), _mm_loadu_ps(rhs + 4), _mm_loadu_ps(rhs + 8), _mm_loadu_ps(rhs + 12) };
+
+		//All inputs are loaded before storing, so out may alias lhs or rhs
+		for (int col = 0; col < 4; ++col) {
+			__m128 r0 = _mm_add_ps(
+				_mm_mul_ps(a0, _mm_shuffle_ps(b[col], b[col], _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm_mul_ps(a1, _mm_shuffle_ps(b[col], b[col], _MM_SHUFFLE(1, 1, 1, 1))));
+			__m128 r1 = _mm_add_ps(
+				_mm_mul_ps(a2, _mm_shuffle_ps(b[col], b[col], _MM_SHUFFLE(2, 2, 2, 2))),
+				_mm_mul_ps(a3, _mm_shuffle_ps(b[col], b[col], _MM_SHUFFLE(3, 3, 3, 3))));
+			b[col] = _mm_add_ps(r0, r1);
+		}
+
+		for (int col = 0; col < 4; ++col)
+			_mm_storeu_ps(out + col * 4, b[col]);
+	}
+#else
+	void Multiply4x4(const float* lhs, const float* rhs, float* out) {
+		float result[16];
+		for (int col = 0; col < 4; ++col) {
+			for (int row = 0; row < 4; ++row) {
+				result[col * 4 + row] =
+					lhs[0 * 4 + row] * rhs[col * 4 + 0] +
+					lhs[1 * 4 + row] * rhs[col * 4 + 1] +
+					lhs[2 * 4 + row] * rhs[col * 4 + 2] +
+					lhs[3 * 4 + row] * rhs[col * 4 + 3];
+			}
+		}
+		for (int i = 0; i < 16; ++i)
+			out[i] = result[i];
+	}
+#endif
+
+#if CRUX_SIMD_SSE2
+	/*
+	 * Cofactor inverse using the twelve 2x2 sub-determinants, the same formula as
+	 * the scalar crux::Inverse, evaluated one output column at a time.
+	 * With r0..r3 the input columns and Pn = {cn, cn, sn, sn}:
+	 *   out0 = {+,-,+,-} * (V1*P5 - V2*P4 + V3*P3)
+	 *   out1 = {-,+,-,+} * (V0*P5 - V2*P2 + V3*P1)
+	 *   out2 = {+,-,+,-} * (V0*P4 - V1*P2 + V3*P0)
+	 *   out3 = {-,+,-,+} * (V0*P3 - V1*P1 + V2*P0)
+	 * where Vk = {r1[k], r0[k], r3[k], r2[k]}.
+	 */
+	bool Inverse4x4(const float* in, float* out) {
+		const __m128 r0 = _mm_loadu_ps(in + 0);
+		const __m128 r1 = _mm_loadu_ps(in + 4);
+		const __m128 r2 = _mm_loadu_ps(in + 8);
+		const __m128 r3 = _mm_loadu_ps(in + 12);
+
+		//Xk = {r2[k], r2[k], r0[k], r0[k]}, Yk = {r3[k], r3[k], r1[k], r1[k]}
+		const __m128 x0 = _mm_shuffle_ps(r2, r0, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 x1 = _mm_shuffle_ps(r2, r0, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 x2 = _mm_shuffle_ps(r2, r0, _MM_SHUFFLE(2, 2, 2, 2));
+		const __m128 x3 = _mm_shuffle_ps(r2, r0, _MM_SHUFFLE(3, 3, 3, 3));
+		const __m128 y0 = _mm_shuffle_ps(r3, r1, _MM_SHUFFLE(0, 0, 0, 0));
+		const __m128 y1 = _mm_shuffle_ps(r3, r1, _MM_SHUFFLE(1, 1, 1, 1));
+		const __m128 y2 = _mm_shuffle_ps(r3, r1, _MM_SHUFFLE(2, 2, 2, 2));
+		const __m128 y3 = _mm_shuffle_ps(r3, r1, _MM_SHUFFLE(3, 3, 3, 3));
+
+		//Sub-determinants for the component pairs (0,1) (0,2) (0,3) (1,2) (1,3) (2,3)
+		const __m128 p0 = _mm_sub_ps(_mm_mul_ps(x0, y1), _mm_mul_ps(x1, y0));
+		const __m128 p1 = _mm_sub_ps(_mm_mul_ps(x0, y2), _mm_mul_ps(x2, y0));
+		const __m128 p2 = _mm_sub_ps(_mm_mul_ps(x0, y3), _mm_mul_ps(x3, y0));
+		const __m128 p3 = _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(x2, y1));
+		const __m128 p4 = _mm_sub_ps(_mm_mul_ps(x1, y3), _mm_mul_ps(x3, y1));
+		const __m128 p5 = _mm_sub_ps(_mm_mul_ps(x2, y3), _mm_mul_ps(x3, y2));
+
+		//Vk = {r1[k], r0[k], r3[k], r2[k]}
+		auto v = [&](__m128 u, __m128 w) { return _mm_shuffle_ps(u, w, _MM_SHUFFLE(0, 2, 0, 2)); };
+		const __m128 v0 = v(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(0, 0, 0, 0)));
+		const __m128 v1 = v(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(1, 1, 1, 1)));
+		const __m128 v2 = v(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(2, 2, 2, 2)));
+		const __m128 v3 = v(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(3, 3, 3, 3)));
+
+		const __m128 signA = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+		const __m128 signB = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+
+		const __m128 o0 = _mm_mul_ps(signA, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v1, p5), _mm_mul_ps(v2, p4)), _mm_mul_ps(v3, p3)));
+		const __m128 o1 = _mm_mul_ps(signB, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v0, p5), _mm_mul_ps(v2, p2)), _mm_mul_ps(v3, p1)));
+		const __m128 o2 = _mm_mul_ps(signA, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v0, p4), _mm_mul_ps(v1, p2)), _mm_mul_ps(v3, p0)));
+		const __m128 o3 = _mm_mul_ps(signB, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v0, p3), _mm_mul_ps(v1, p1)), _mm_mul_ps(v2, p0)));
+
+		//Determinant is the first input column dotted with the first row of the adjugate
+		const __m128 row0 = _mm_movelh_ps(_mm_unpacklo_ps(o0, o1), _mm_unpacklo_ps(o2, o3));
+		__m128 det = _mm_mul_ps(r0, row0);
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+		det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		if (_mm_cvtss_f32(det) == 0.0f)
+			return false;
+
+		const __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		_mm_storeu_ps(out + 0, _mm_mul_ps(o0, inv));
+		_mm_storeu_ps(out + 4, _mm_mul_ps(o1, inv));
+		_mm_storeu_ps(out + 8, _mm_mul_ps(o2, inv));
+		_mm_storeu_ps(out + 12, _mm_mul_ps(o3, inv));
+		return true;
+	}
+#else
+	bool Inverse4x4(const float* in, float* out) {
+		matrix4x4<float> m(0.0f), result(0.0f);
+		for (int i = 0; i < 16; ++i)
+			m.data()[i] = in[i];
+
+		if (!InverseScalar(m, result))
+			return false;
+
+		for (int i = 0; i < 16; ++i)
+			out[i] = result.data()[i];
+		return true;
+	}
+#endif
+}
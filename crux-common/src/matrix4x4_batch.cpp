@@ -0,0 +1,158 @@
+#include "matrix4x4_batch.h"
+
+#include <algorithm>
+
+#include "platform.h"
+
+#if CRUX_SIMD_AVX
+#include <immintrin.h>
+#elif CRUX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace crux::batch {
+	std::size_t Transform(const mat4f& m, span<const vec4f> in, span<vec4f> out) {
+		const std::size_t n = std::min(in.size(), out.size());
+		const vec4f* src = in.data();
+		vec4f* dst = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_AVX
+		//Two vectors per register, each 128bit half multiplied by the same columns
+		const __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[0].x));
+		const __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[1].x));
+		const __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[2].x));
+		const __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m[3].x));
+		for (; i + 2 <= n; i += 2) {
+			const __m256 v = _mm256_loadu_ps(&src[i].x);
+			__m256 r0 = _mm256_add_ps(_mm256_mul_ps(c0, _mm256_permute_ps(v, 0x00)), _mm256_mul_ps(c1, _mm256_permute_ps(v, 0x55)));
+			__m256 r1 = _mm256_add_ps(_mm256_mul_ps(c2, _mm256_permute_ps(v, 0xAA)), _mm256_mul_ps(c3, _mm256_permute_ps(v, 0xFF)));
+			_mm256_storeu_ps(&dst[i].x, _mm256_add_ps(r0, r1));
+		}
+#elif CRUX_SIMD_SSE2
+		const __m128 c0 = _mm_loadu_ps(&m[0].x);
+		const __m128 c1 = _mm_loadu_ps(&m[1].x);
+		const __m128 c2 = _mm_loadu_ps(&m[2].x);
+		const __m128 c3 = _mm_loadu_ps(&m[3].x);
+		for (; i < n; ++i) {
+			const __m128 v = _mm_loadu_ps(&src[i].x);
+			__m128 r0 = _mm_add_ps(_mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			__m128 r1 = _mm_add_ps(_mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))), _mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(&dst[i].x, _mm_add_ps(r0, r1));
+		}
+#endif
+		for (; i < n; ++i)
+			dst[i] = m * src[i];
+		return n;
+	}
+
+#if CRUX_SIMD_SSE2
+	namespace {
+		/*
+		 * Four packed vec3s fill three registers, x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+		 * Rather than transposing them to x, y and z registers and back, each output
+		 * register is computed in place: the inputs are broadcast to the lanes they
+		 * feed, and the matrix columns are rotated to the component each lane holds.
+		 */
+		struct PackedColumns {
+			// Component held by each lane of the three registers
+			static constexpr int Lanes[3][4] = { { 0, 1, 2, 0 }, { 1, 2, 0, 1 }, { 2, 0, 1, 2 } };
+
+			// [register][column]
+			__m128 m[3][4];
+
+			explicit PackedColumns(const mat4f& mat) {
+				for (int r = 0; r < 3; ++r)
+					for (int col = 0; col < 4; ++col)
+						m[r][col] = _mm_setr_ps(mat[col][Lanes[r][0]], mat[col][Lanes[r][1]], mat[col][Lanes[r][2]], mat[col][Lanes[r][3]]);
+			}
+
+			// @return One output register from the broadcast inputs, without the translation column when Point is false
+			template<bool Point>
+			inline __m128 Apply(int r, __m128 x, __m128 y, __m128 z) const {
+#if CRUX_SIMD_FMA
+				__m128 out = Point ? _mm_fmadd_ps(m[r][0], x, m[r][3]) : _mm_mul_ps(m[r][0], x);
+				out = _mm_fmadd_ps(m[r][1], y, out);
+				return _mm_fmadd_ps(m[r][2], z, out);
+#else
+				__m128 out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[r][0], x), _mm_mul_ps(m[r][1], y)), _mm_mul_ps(m[r][2], z));
+				return Point ? _mm_add_ps(out, m[r][3]) : out;
+#endif
+			}
+		};
+
+		// Transforms vec3s 4 at a time, returns how many were done, the caller finishes the rest
+		template<bool Point>
+		std::size_t Transform3(const mat4f& mat, const vec3f* src, vec3f* dst, std::size_t n) {
+			static_assert(sizeof(vec3f) == 3 * sizeof(float), "vec3f must be packed");
+
+			const PackedColumns columns(mat);
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				//All loaded before storing, so in and out may alias
+				const float* s = &src[i].x;
+				const __m128 a = _mm_loadu_ps(s);
+				const __m128 b = _mm_loadu_ps(s + 4);
+				const __m128 c = _mm_loadu_ps(s + 8);
+
+				//x0 y0 z0 x1
+				const __m128 ab01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+				const __m128 ab12 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+				const __m128 out0 = columns.Apply<Point>(0,
+					_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 0, 0)),
+					_mm_shuffle_ps(ab01, ab01, _MM_SHUFFLE(2, 0, 0, 0)),
+					_mm_shuffle_ps(ab12, ab12, _MM_SHUFFLE(2, 0, 0, 0)));
+
+				//y1 z1 x2 y2
+				const __m128 out1 = columns.Apply<Point>(1,
+					_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 3, 3)),
+					_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 0, 0)),
+					_mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 1, 1)));
+
+				//z2 x3 y3 z3
+				const __m128 bc12 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+				const __m128 bc23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+				const __m128 out2 = columns.Apply<Point>(2,
+					_mm_shuffle_ps(bc12, bc12, _MM_SHUFFLE(2, 2, 2, 0)),
+					_mm_shuffle_ps(bc23, bc23, _MM_SHUFFLE(2, 2, 2, 0)),
+					_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 0)));
+
+				float* d = &dst[i].x;
+				_mm_storeu_ps(d, out0);
+				_mm_storeu_ps(d + 4, out1);
+				_mm_storeu_ps(d + 8, out2);
+			}
+			return i;
+		}
+	}
+#endif
+
+	std::size_t TransformPoints(const mat4f& m, span<const vec3f> in, span<vec3f> out) {
+		const std::size_t n = std::min(in.size(), out.size());
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		i = Transform3<true>(m, in.data(), out.data(), n);
+#endif
+		for (; i < n; ++i)
+			out[i] = TransformPoint(m, in[i]);
+		return n;
+	}
+
+	std::size_t TransformDirections(const mat4f& m, span<const vec3f> in, span<vec3f> out) {
+		const std::size_t n = std::min(in.size(), out.size());
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		i = Transform3<false>(m, in.data(), out.data(), n);
+#endif
+		for (; i < n; ++i)
+			out[i] = TransformDirection(m, in[i]);
+		return n;
+	}
+
+	std::size_t Multiply(const mat4f& parent, span<const mat4f> in, span<mat4f> out) {
+		const std::size_t n = std::min(in.size(), out.size());
+		for (std::size_t i = 0; i < n; ++i)
+			internal::simd::Multiply4x4(parent.data(), in[i].data(), out[i].data());
+		return n;
+	}
+}
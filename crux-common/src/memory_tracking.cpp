@@ -0,0 +1,390 @@
+#include "memory_tracking.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "allocators.h"
+#include "platform.h"
+
+namespace crux::memory {
+	namespace {
+		// Tag of the calling thread's allocations, trivially initialized so operator new can read it at any time
+		thread_local MemoryTag currentTag = MemoryTag::UNTAGGED;
+
+		const char* const TagNames[MemoryTagCount] = {
+			"Untagged",
+			"Window",
+			"Events",
+			"String",
+			"Platform",
+			"Jobs",
+			"User",
+		};
+
+		const char* const AllocatorNames[AllocatorKindCount] = {
+			"Arena",
+			"Pool",
+			"Tlsf",
+		};
+	}
+
+	const char* GetTagName(MemoryTag tag) {
+		return (std::size_t)tag < MemoryTagCount ? TagNames[(std::size_t)tag] : "Unknown";
+	}
+
+	const char* GetAllocatorName(AllocatorKind kind) {
+		return (std::size_t)kind < AllocatorKindCount ? AllocatorNames[(std::size_t)kind] : "Unknown";
+	}
+
+	MemoryTag GetCurrentTag() {
+		return currentTag;
+	}
+
+	ScopedTag::ScopedTag(MemoryTag tag) : previous(currentTag) {
+		currentTag = tag;
+	}
+
+	ScopedTag::~ScopedTag() {
+		currentTag = previous;
+	}
+}
+
+#if CRUX_TRACK_ALLOCATIONS
+
+namespace crux::memory {
+	namespace {
+		/**
+		 * @brief Lock-free counterpart of AllocationCounters.
+		*/
+		struct AtomicCounters {
+			std::atomic<uint64bit> allocations{ 0 };
+			std::atomic<uint64bit> frees{ 0 };
+			std::atomic<uint64bit> liveBytes{ 0 };
+			std::atomic<uint64bit> peakBytes{ 0 };
+			std::atomic<uint64bit> totalBytes{ 0 };
+
+			void Allocated(std::size_t bytes) {
+				allocations.fetch_add(1, std::memory_order_relaxed);
+				totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+				const uint64bit live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+				uint64bit peak = peakBytes.load(std::memory_order_relaxed);
+				while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+			}
+
+			void Freed(std::size_t bytes, std::size_t count) {
+				frees.fetch_add(count, std::memory_order_relaxed);
+				liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+			}
+
+			AllocationCounters Load() const {
+				AllocationCounters out;
+				out.allocations = allocations.load(std::memory_order_relaxed);
+				out.frees = frees.load(std::memory_order_relaxed);
+				out.liveBytes = liveBytes.load(std::memory_order_relaxed);
+				out.peakBytes = peakBytes.load(std::memory_order_relaxed);
+				out.totalBytes = totalBytes.load(std::memory_order_relaxed);
+				return out;
+			}
+		};
+
+		/**
+		 * @brief Spin lock guarding the live list.
+		 * std::mutex is not constant initialized on every standard library,
+		 * and operator new can run before any dynamic initialization.
+		*/
+		struct SpinLock {
+			std::atomic_flag flag;
+
+			void lock() {
+				while (flag.test_and_set(std::memory_order_acquire)) {
+					while (flag.test(std::memory_order_relaxed))
+						CRUX_CPU_PAUSE();
+				}
+			}
+
+			void unlock() { flag.clear(std::memory_order_release); }
+		};
+
+		/**
+		 * @brief Placed in front of every tracked heap allocation, links it into the live list.
+		*/
+		struct AllocationHeader {
+			AllocationHeader* prev;
+			AllocationHeader* next;
+
+			// Start of the underlying malloc, differs from the header for over aligned allocations
+			void* raw;
+
+			// Bytes requested
+			std::size_t size;
+
+			// Running allocation number, stable between runs of a deterministic program
+			uint64bit sequence;
+
+			MemoryTag tag;
+		};
+
+		constexpr std::size_t HeaderSize = AlignUp(sizeof(AllocationHeader), alignof(std::max_align_t));
+
+		struct TrackerState {
+			AtomicCounters heap;
+			AtomicCounters tags[MemoryTagCount];
+			AtomicCounters allocators[AllocatorKindCount];
+
+			std::atomic<uint64bit> frame{ 0 };
+			std::atomic<uint64bit> frameAllocations{ 0 };
+			std::atomic<uint64bit> frameBytes{ 0 };
+			std::atomic<uint64bit> lastFrameAllocations{ 0 };
+			std::atomic<uint64bit> lastFrameBytes{ 0 };
+
+			std::atomic<uint64bit> sequence{ 0 };
+
+			SpinLock liveLock;
+			AllocationHeader* live = nullptr;
+		};
+
+		constinit TrackerState state;
+
+		void* TrackedAllocate(std::size_t size, std::size_t alignment) {
+			if (size == 0)
+				size = 1;
+			if (alignment < alignof(std::max_align_t))
+				alignment = alignof(std::max_align_t);
+
+			//Over aligned requests reserve room to slide the payload up to the alignment
+			const std::size_t slack = alignment > alignof(std::max_align_t) ? alignment : 0;
+			if (size > SIZE_MAX - HeaderSize - slack)
+				return nullptr;
+
+			void* raw = std::malloc(HeaderSize + slack + size);
+			if (!raw)
+				return nullptr;
+
+			char* payload = reinterpret_cast<char*>(AlignUp((std::size_t)raw + HeaderSize, alignment));
+			AllocationHeader* header = reinterpret_cast<AllocationHeader*>(payload - HeaderSize);
+			header->raw = raw;
+			header->size = size;
+			header->sequence = state.sequence.fetch_add(1, std::memory_order_relaxed);
+			header->tag = currentTag;
+			header->prev = nullptr;
+
+			state.liveLock.lock();
+			header->next = state.live;
+			if (state.live)
+				state.live->prev = header;
+			state.live = header;
+			state.liveLock.unlock();
+
+			state.heap.Allocated(size);
+			state.tags[(std::size_t)header->tag].Allocated(size);
+			state.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+			state.frameBytes.fetch_add(size, std::memory_order_relaxed);
+			return payload;
+		}
+
+		void TrackedFree(void* ptr) {
+			if (!ptr)
+				return;
+
+			AllocationHeader* header = reinterpret_cast<AllocationHeader*>(static_cast<char*>(ptr) - HeaderSize);
+
+			state.liveLock.lock();
+			if (header->prev)
+				header->prev->next = header->next;
+			else
+				state.live = header->next;
+			if (header->next)
+				header->next->prev = header->prev;
+			state.liveLock.unlock();
+
+			state.heap.Freed(header->size, 1);
+			state.tags[(std::size_t)header->tag].Freed(header->size, 1);
+			std::free(header->raw);
+		}
+
+		// Standard operator new behaviour, retrying through the new handler before giving up
+		void* AllocateOrThrow(std::size_t size, std::size_t alignment) {
+			for (;;) {
+				if (void* ptr = TrackedAllocate(size, alignment))
+					return ptr;
+
+				std::new_handler handler = std::get_new_handler();
+				if (!handler)
+					throw std::bad_alloc();
+				handler();
+			}
+		}
+
+		void* AllocateOrNull(std::size_t size, std::size_t alignment) noexcept {
+			try {
+				return AllocateOrThrow(size, alignment);
+			} catch (...) {
+				return nullptr;
+			}
+		}
+
+		/**
+		 * @brief Reports whatever is still allocated once static destruction reaches this unit.
+		 * Objects destroyed after it, and deliberate process lifetime
+		 * allocations, show up in the report too.
+		*/
+		struct LeakReporter {
+			~LeakReporter() {
+				if (state.heap.allocations.load() != state.heap.frees.load())
+					ReportLeaks(stderr);
+			}
+		};
+
+		LeakReporter leakReporter;
+	}
+
+	MemoryStats Stats() {
+		MemoryStats out;
+		out.enabled = true;
+		out.heap = state.heap.Load();
+		for (std::size_t i = 0; i < MemoryTagCount; ++i)
+			out.tags[i] = state.tags[i].Load();
+		for (std::size_t i = 0; i < AllocatorKindCount; ++i)
+			out.allocators[i] = state.allocators[i].Load();
+
+		out.frame = state.frame.load(std::memory_order_relaxed);
+		out.frameAllocations = state.frameAllocations.load(std::memory_order_relaxed);
+		out.frameBytes = state.frameBytes.load(std::memory_order_relaxed);
+		out.lastFrameAllocations = state.lastFrameAllocations.load(std::memory_order_relaxed);
+		out.lastFrameBytes = state.lastFrameBytes.load(std::memory_order_relaxed);
+		return out;
+	}
+
+	void MarkFrame() {
+		state.lastFrameAllocations.store(state.frameAllocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		state.lastFrameBytes.store(state.frameBytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		state.frame.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	uint64bit ReportLeaks(std::FILE* out, std::size_t maxListed) {
+		struct Listed {
+			std::size_t size;
+			uint64bit sequence;
+			MemoryTag tag;
+		};
+
+		//Gathered under the lock into malloc memory, allocating through operator new here would deadlock
+		Listed* listed = maxListed > 0 ? static_cast<Listed*>(std::malloc(sizeof(Listed) * maxListed)) : nullptr;
+		std::size_t listedCount = 0;
+		uint64bit counts[MemoryTagCount] = {};
+		uint64bit bytes[MemoryTagCount] = {};
+		uint64bit total = 0;
+
+		state.liveLock.lock();
+		for (AllocationHeader* header = state.live; header; header = header->next) {
+			counts[(std::size_t)header->tag]++;
+			bytes[(std::size_t)header->tag] += header->size;
+			++total;
+			if (listed && listedCount < maxListed)
+				listed[listedCount++] = { header->size, header->sequence, header->tag };
+		}
+		state.liveLock.unlock();
+
+		if (total == 0) {
+			std::fprintf(out, "[crux] No live heap allocations\n");
+		} else {
+			std::fprintf(out, "[crux] %llu live heap allocation(s):\n", (unsigned long long)total);
+			for (std::size_t i = 0; i < MemoryTagCount; ++i) {
+				if (counts[i] > 0)
+					std::fprintf(out, "  %-10s %8llu allocation(s) %12llu bytes\n", TagNames[i], (unsigned long long)counts[i], (unsigned long long)bytes[i]);
+			}
+			for (std::size_t i = 0; i < listedCount; ++i)
+				std::fprintf(out, "  #%llu %zu bytes (%s)\n", (unsigned long long)listed[i].sequence, listed[i].size, TagNames[(std::size_t)listed[i].tag]);
+			if (total > listedCount)
+				std::fprintf(out, "  ... %llu more\n", (unsigned long long)(total - listedCount));
+		}
+
+		std::free(listed);
+		return total;
+	}
+
+	namespace internal {
+		void RecordAllocatorAllocation(AllocatorKind kind, std::size_t bytes) {
+			state.allocators[(std::size_t)kind].Allocated(bytes);
+		}
+
+		void RecordAllocatorFree(AllocatorKind kind, std::size_t bytes, std::size_t count) {
+			state.allocators[(std::size_t)kind].Freed(bytes, count);
+		}
+	}
+}
+
+/*
+ * Replacement global allocation functions, every form of new and delete
+ * goes through the tracker.
+ */
+
+void* operator new(std::size_t size) {
+	return crux::memory::AllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+	return crux::memory::AllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return crux::memory::AllocateOrNull(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return crux::memory::AllocateOrNull(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return crux::memory::AllocateOrThrow(size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return crux::memory::AllocateOrThrow(size, (std::size_t)alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return crux::memory::AllocateOrNull(size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return crux::memory::AllocateOrNull(size, (std::size_t)alignment);
+}
+
+void operator delete(void* ptr) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { crux::memory::TrackedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { crux::memory::TrackedFree(ptr); }
+
+#else
+
+namespace crux::memory {
+	MemoryStats Stats() {
+		return {};
+	}
+
+	void MarkFrame() {}
+
+	uint64bit ReportLeaks(std::FILE*, std::size_t) {
+		return 0;
+	}
+
+	namespace internal {
+		void RecordAllocatorAllocation(AllocatorKind, std::size_t) {}
+		void RecordAllocatorFree(AllocatorKind, std::size_t, std::size_t) {}
+	}
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "platform.h"
+#if CRUX_UNIX
+#include "platform.nix.h"
+
+#include <dlfcn.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include "memory_tracking.h"
+
+namespace crux::internal::nix {
+	std::mutex LibraryLock;
+	std::map<std::string, void*> LoadedLibraries;
+
+	namespace {
+		// strerror() is not thread safe, strerror_r() comes in a GNU flavour returning the message and a POSIX one filling buffer
+		const char* ErrorMessage(int code, char (&buffer)[256]) {
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+			return strerror_r(code, buffer, sizeof(buffer));
+#else
+			if (strerror_r(code, buffer, sizeof(buffer)) != 0)
+				std::snprintf(buffer, sizeof(buffer), "Unknown error %d", code);
+			return buffer;
+#endif
+		}
+
+		template<typename String>
+		String LastErrorString(const typename String::allocator_type& alloc) {
+			char buffer[256];
+
+			//dlerror() also clears the pending message
+			if (const char* dlMessage = dlerror())
+				return String(dlMessage, alloc);
+
+			//If no error, return empty
+			if (!errno) return String(alloc);
+
+			return String(ErrorMessage(errno, buffer), alloc);
+		}
+
+		// Loads the names not loaded yet, appending those that succeeded to loaded.
+		// LibraryLock is only taken around the map, never while the OS loads a library
+		template<typename Vector>
+		void LoadLibraries(const std::vector<std::string>& names, Vector& loaded) {
+			CRUX_MEMORY_TAG(PLATFORM);
+
+			for (const auto& name : names) {
+				{
+					std::lock_guard<std::mutex> Lock(LibraryLock);
+					if (LoadedLibraries.find(name) != LoadedLibraries.end())
+						continue;
+				}
+
+				auto proc = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+				if (proc == nullptr)
+					continue;
+
+				std::lock_guard<std::mutex> Lock(LibraryLock);
+				if (!LoadedLibraries.emplace(name, proc).second) {
+					//Loaded by another thread meanwhile, drop the extra OS reference
+					dlclose(proc);
+					continue;
+				}
+				loaded.emplace_back(name);
+			}
+		}
+	}
+
+	std::string GetLastErrorString() {
+		return LastErrorString<std::string>({});
+	}
+
+	std::pmr::string GetLastErrorString(std::pmr::memory_resource* resource) {
+		return LastErrorString<std::pmr::string>(resource);
+	}
+
+	uint32_t GetLastErrorCode() {
+		return (uint32_t)errno;
+	}
+
+	std::string GetErrorString(uint32_t code) {
+		if (!code) return {};
+
+		char buffer[256];
+		return ErrorMessage((int)code, buffer);
+	}
+
+	void* OpenLibrary(const std::string& name) {
+		return dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+	}
+
+	void CloseLibrary(void* handle) {
+		if (handle)
+			dlclose(handle);
+	}
+
+	void* FindLibrarySymbol(void* handle, const char* symbol) {
+		return dlsym(handle, symbol);
+	}
+
+	bool HasNixLibrary(const std::string& name) {
+		std::lock_guard<std::mutex> Lock(LibraryLock);
+		return LoadedLibraries.find(name) != LoadedLibraries.end();
+	}
+
+	void* LoadNixLibrary(const std::string& name) {
+		std::lock_guard<std::mutex> Lock(LibraryLock);
+		auto exists = LoadedLibraries.find(name);
+		if (exists != LoadedLibraries.end()) {
+			return exists->second;
+		}
+
+		auto proc = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (proc != nullptr) {
+			LoadedLibraries.emplace(name, proc);
+			return proc;
+		}
+
+		return nullptr;
+	}
+
+	const std::vector<std::string> LoadNixLibraries(const std::vector<std::string>& names) {
+		std::vector<std::string> loaded;
+		LoadLibraries(names, loaded);
+		return loaded;
+	}
+
+	std::pmr::vector<std::pmr::string> LoadNixLibraries(const std::vector<std::string>& names, std::pmr::memory_resource* resource) {
+		std::pmr::vector<std::pmr::string> loaded(resource);
+		LoadLibraries(names, loaded);
+		return loaded;
+	}
+
+	void* GetNixLibrary(const std::string& name) {
+		std::lock_guard<std::mutex> Lock(LibraryLock);
+		auto proc = LoadedLibraries.find(name);
+		if (proc != LoadedLibraries.end())
+			return proc->second;
+		return nullptr;
+	}
+
+	void FreeNixLibrary(const std::string& name) {
+		std::lock_guard<std::mutex> Lock(LibraryLock);
+		auto proc = LoadedLibraries.find(name);
+		if (proc != LoadedLibraries.end()) {
+			if (proc->second != nullptr)
+				dlclose(proc->second);
+			LoadedLibraries.erase(proc);
+		}
+	}
+
+	void FreeAllNixLibraries() {
+		std::lock_guard<std::mutex> Lock(LibraryLock);
+
+		for (const auto& [key, value] : LoadedLibraries) {
+			if (value != nullptr) {
+				dlclose(value);
+			}
+		}
+		LoadedLibraries.clear();
+	}
+}
+
+#endif // CRUX_UNIX
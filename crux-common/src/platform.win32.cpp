@@ -5,66 +5,151 @@
 #define WIN32_LEAN_AND_MEAN 1
 #endif
 #include <windows.h>
-#include <stringapiset.h>
 #include <map>
 #include <mutex>
 
+#include "memory_tracking.h"
+#include "utf.h"
+
 namespace crux::internal::win32 {
 	std::mutex LibraryLock;
 	std::map<std::string, void*> LoadedLibraries;
 
+	namespace {
+		// Converts straight into the result's buffer, no temporary allocation
+		template<typename WideString>
+		WideString ToWide(std::string_view input, const typename WideString::allocator_type& alloc) {
+			CRUX_MEMORY_TAG(STRING);
+
+			WideString result(alloc);
+			utf::Utf8ToWide(input, result);
+			return result;
+		}
+
+		template<typename String>
+		String FromWide(std::wstring_view input, const typename String::allocator_type& alloc) {
+			CRUX_MEMORY_TAG(STRING);
+
+			String result(alloc);
+			utf::WideToUtf8(input, result);
+			return result;
+		}
+
+		template<typename String>
+		String ErrorString(DWORD errorCode, const typename String::allocator_type& alloc) {
+			//If no error, return empty
+			if (!errorCode) return String(alloc);
+
+			//Use the Win32 API to get the error message
+			LPWSTR buffer = nullptr;
+			DWORD size = FormatMessage(
+				FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+				nullptr,
+				errorCode,
+				MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+				(LPWSTR)&buffer,
+				0,
+				nullptr
+			);
+
+			//Convert to string
+			if (size) {
+				String message = FromWide<String>(std::wstring_view(buffer, size), alloc);
+
+				//Free the buffer
+				LocalFree(buffer);
+
+				return message;
+			}
+
+			//Buffer was empty
+			return String(alloc);
+		}
+
+		template<typename String>
+		String LastErrorString(const typename String::allocator_type& alloc) {
+			return ErrorString<String>(GetLastError(), alloc);
+		}
+
+		// Loads the names not loaded yet, appending those that succeeded to loaded.
+		// LibraryLock is only taken around the map, never while the OS loads a library
+		template<typename Vector>
+		void LoadLibraries(const std::vector<std::string>& names, Vector& loaded) {
+			CRUX_MEMORY_TAG(PLATFORM);
+
+			for (const auto& name : names) {
+				{
+					std::lock_guard<std::mutex> Lock(LibraryLock);
+					if (LoadedLibraries.find(name) != LoadedLibraries.end())
+						continue;
+				}
+
+				WideBuffer path;
+				StringToWideString(name, path);
+				auto proc = LoadLibraryW(path.c_str());
+				if (proc == nullptr)
+					continue;
+
+				std::lock_guard<std::mutex> Lock(LibraryLock);
+				if (!LoadedLibraries.emplace(name, proc).second) {
+					//Loaded by another thread meanwhile, drop the extra OS reference
+					FreeLibrary(proc);
+					continue;
+				}
+				loaded.emplace_back(name);
+			}
+		}
+	}
+
 	std::wstring StringToWideString(const std::string& s) {
-		int len;
-		int slength = (int)s.length() + 1;
-		len = MultiByteToWideChar(CP_ACP, 0, s.c_str(), slength, 0, 0);
-		wchar_t* buf = new wchar_t[len];
-		MultiByteToWideChar(CP_ACP, 0, s.c_str(), slength, buf, len);
-		std::wstring r(buf);
-		delete[] buf;
-		return r;
+		return ToWide<std::wstring>(s, {});
+	}
+
+	std::pmr::wstring StringToWideString(std::string_view input, std::pmr::memory_resource* resource) {
+		return ToWide<std::pmr::wstring>(input, resource);
+	}
+
+	void StringToWideString(std::string_view input, WideBuffer& output) {
+		utf::Utf8ToWide(input, output);
 	}
 
 	std::string WideStringToString(const std::wstring& ws) {
-		std::string strTo;
-		char* szTo = new char[ws.length() + 1];
-		szTo[ws.size()] = '\0';
-		WideCharToMultiByte(CP_ACP, 0, ws.c_str(), -1, szTo, (int)ws.length(), NULL, NULL);
-		strTo = szTo;
-		delete[] szTo;
-		return strTo;
+		return FromWide<std::string>(ws, {});
+	}
+
+	std::pmr::string WideStringToString(std::wstring_view input, std::pmr::memory_resource* resource) {
+		return FromWide<std::pmr::string>(input, resource);
 	}
 
 	std::string GetLastErrorString() {
-		DWORD errorCode = GetLastError();
-
-		//If no error, return empty
-		if (!errorCode) return "";
-
-		//Use the Win32 API to get the error message
-		LPWSTR buffer = nullptr;
-		DWORD size = FormatMessage(
-			FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-			nullptr,
-			errorCode,
-			MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-			(LPWSTR)&buffer,
-			0,
-			nullptr
-		);
-
-		//Convert to string
-		if (size) {
-			//Format the message
-			std::wstring message(buffer, size);
-
-			//Free the buffer
-			LocalFree(buffer);
-
-			return WideStringToString(message);
-		}
+		return LastErrorString<std::string>({});
+	}
+
+	std::pmr::string GetLastErrorString(std::pmr::memory_resource* resource) {
+		return LastErrorString<std::pmr::string>(resource);
+	}
+
+	uint32_t GetLastErrorCode() {
+		return (uint32_t)GetLastError();
+	}
+
+	std::string GetErrorString(uint32_t code) {
+		return ErrorString<std::string>((DWORD)code, {});
+	}
+
+	void* OpenLibrary(const std::string& name) {
+		WideBuffer path;
+		StringToWideString(name, path);
+		return LoadLibraryW(path.c_str());
+	}
+
+	void CloseLibrary(void* handle) {
+		if (handle)
+			FreeLibrary((HMODULE)handle);
+	}
 
-		//Buffer was empty
-		return "";
+	void* FindLibrarySymbol(void* handle, const char* symbol) {
+		return reinterpret_cast<void*>(GetProcAddress((HMODULE)handle, symbol));
 	}
 
 	bool HasWinLibrary(const std::string& name) {
@@ -79,7 +164,9 @@ namespace crux::internal::win32 {
 			return exists->second;
 		}
 
-		auto proc = LoadLibrary(StringToWideString(name).c_str());
+		WideBuffer path;
+		StringToWideString(name, path);
+		auto proc = LoadLibraryW(path.c_str());
 		if (proc != nullptr) {
 			LoadedLibraries.emplace(name, proc);
 			return proc;
@@ -89,22 +176,14 @@ namespace crux::internal::win32 {
 	}
 
 	const std::vector<std::string> LoadWinLibraries(const std::vector<std::string>& names) {
-		std::lock_guard<std::mutex> Lock(LibraryLock);
-
 		std::vector<std::string> loaded;
+		LoadLibraries(names, loaded);
+		return loaded;
+	}
 
-		for (auto name : names) {
-			auto exists = LoadedLibraries.find(name);
-			if (exists != LoadedLibraries.end())
-				continue;
-
-			auto proc = LoadLibrary(StringToWideString(name).c_str());
-			if (proc != nullptr) {
-				LoadedLibraries.emplace(name, proc);
-				loaded.emplace_back(name);
-			}
-		}
-
+	std::pmr::vector<std::pmr::string> LoadWinLibraries(const std::vector<std::string>& names, std::pmr::memory_resource* resource) {
+		std::pmr::vector<std::pmr::string> loaded(resource);
+		LoadLibraries(names, loaded);
 		return loaded;
 	}
 
@@ -119,8 +198,11 @@ namespace crux::internal::win32 {
 	void FreeWinLibrary(const std::string& name) {
 		std::lock_guard<std::mutex> Lock(LibraryLock);
 		auto proc = LoadedLibraries.find(name);
-		if (proc != LoadedLibraries.end())
+		if (proc != LoadedLibraries.end()) {
+			if (proc->second != nullptr)
+				FreeLibrary((HMODULE)proc->second);
 			LoadedLibraries.erase(proc);
+		}
 	}
 
 	void FreeAllWinLibraries() {
@@ -0,0 +1,252 @@
+#include "profile.h"
+
+#if CRUX_PROFILE && !CRUX_PROFILE_TRACY
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "spsc_queue.h"
+
+namespace crux::profile {
+	namespace {
+		// Zones a thread buffers between two Collect() calls
+		constexpr std::size_t ThreadCapacity = 1 << 14;
+
+		// Zones the capture holds, roughly 64MB, later ones are dropped until Clear()
+		constexpr std::size_t CaptureLimit = 1 << 21;
+
+		// Track the frames are exported on, threads count from 1
+		constexpr uint32bit FrameTrack = 0;
+
+		struct BufferedZone {
+			const char* name;
+			uint64bit start;
+			uint64bit end;
+		};
+
+		struct CapturedZone {
+			const char* name;
+			uint64bit start;
+			uint64bit end;
+			uint32bit thread;
+		};
+
+		/**
+		 * @brief Zones recorded by one thread, written only by it and read under the profiler lock.
+		 * Handed to a new thread once the owner exits, under a new id.
+		*/
+		struct ThreadBuffer {
+			ThreadBuffer() : zones(ThreadCapacity) {}
+
+			spsc_queue<BufferedZone> zones;
+			uint32bit id = 0;
+		};
+
+		struct Profiler {
+			// Guards everything below, and makes the holder the single consumer of every buffer
+			std::mutex lock;
+			std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+			std::vector<ThreadBuffer*> freeBuffers;
+			std::vector<CapturedZone> capture;
+
+			// Thread names by id, kept after the thread exits so its zones still export under it
+			std::vector<string> threadNames{ "Frames" };
+
+			uint64bit lastFrame = 0;
+			std::atomic<uint64bit> dropped{ 0 };
+		};
+
+		Profiler& GetProfiler() {
+			static Profiler profiler;
+			return profiler;
+		}
+
+		// Profiler lock must be held
+		void Drain(Profiler& profiler, ThreadBuffer& buffer) {
+			BufferedZone batch[256];
+			while (std::size_t count = buffer.zones.pop_n(batch)) {
+				const std::size_t room = CaptureLimit - std::min(CaptureLimit, profiler.capture.size());
+				const std::size_t kept = std::min(room, count);
+				for (std::size_t i = 0; i < kept; ++i)
+					profiler.capture.push_back({ batch[i].name, batch[i].start, batch[i].end, buffer.id });
+				if (kept < count)
+					profiler.dropped.fetch_add(count - kept, std::memory_order_relaxed);
+			}
+		}
+
+		// Profiler lock must be held
+		void CollectAll(Profiler& profiler) {
+			for (auto& buffer : profiler.buffers)
+				Drain(profiler, *buffer);
+		}
+
+		ThreadBuffer* AcquireBuffer() {
+			Profiler& profiler = GetProfiler();
+			std::lock_guard<std::mutex> lock(profiler.lock);
+
+			ThreadBuffer* buffer;
+			if (!profiler.freeBuffers.empty()) {
+				buffer = profiler.freeBuffers.back();
+				profiler.freeBuffers.pop_back();
+			} else {
+				profiler.buffers.push_back(std::make_unique<ThreadBuffer>());
+				buffer = profiler.buffers.back().get();
+			}
+
+			buffer->id = (uint32bit)profiler.threadNames.size();
+			profiler.threadNames.push_back("Thread " + std::to_string(buffer->id));
+			return buffer;
+		}
+
+		void ReleaseBuffer(ThreadBuffer* buffer) {
+			Profiler& profiler = GetProfiler();
+			std::lock_guard<std::mutex> lock(profiler.lock);
+			Drain(profiler, *buffer);
+			profiler.freeBuffers.push_back(buffer);
+		}
+
+		// Returns the thread's buffer to the profiler when the thread exits
+		struct ThreadHandle {
+			ThreadBuffer* buffer = nullptr;
+
+			~ThreadHandle() {
+				if (buffer)
+					ReleaseBuffer(buffer);
+			}
+		};
+
+		thread_local ThreadHandle threadHandle;
+
+		ThreadBuffer& GetThreadBuffer() {
+			if (!threadHandle.buffer)
+				threadHandle.buffer = AcquireBuffer();
+			return *threadHandle.buffer;
+		}
+
+		void WriteEscaped(std::FILE* out, const char* text) {
+			for (const char* c = text; *c; ++c) {
+				if (*c == '"' || *c == '\\')
+					std::fprintf(out, "\\%c", *c);
+				else if ((unsigned char)*c < 0x20)
+					std::fprintf(out, "\\u%04x", (unsigned)*c);
+				else
+					std::fputc(*c, out);
+			}
+		}
+	}
+
+	namespace internal {
+		void RecordZone(const char* name, uint64bit start, uint64bit end) {
+			if (!GetThreadBuffer().zones.try_push({ name, start, end }))
+				GetProfiler().dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void SetThreadName(const char* name) {
+		ThreadBuffer& buffer = GetThreadBuffer();
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+		profiler.threadNames[buffer.id] = name;
+	}
+
+	void MarkFrame() {
+		const uint64bit now = clock::Now();
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+
+		if (profiler.lastFrame) {
+			if (profiler.capture.size() < CaptureLimit)
+				profiler.capture.push_back({ "Frame", profiler.lastFrame, now, FrameTrack });
+			else
+				profiler.dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+		profiler.lastFrame = now;
+		CollectAll(profiler);
+	}
+
+	void Collect() {
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+		CollectAll(profiler);
+	}
+
+	bool WriteChromeTrace(const string& path) {
+		std::FILE* out = std::fopen(path.c_str(), "wb");
+		if (!out)
+			return false;
+
+		const bool written = WriteChromeTrace(out);
+		return std::fclose(out) == 0 && written;
+	}
+
+	bool WriteChromeTrace(std::FILE* out) {
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+		CollectAll(profiler);
+
+		//Timestamps are microseconds from the first zone, keeps the numbers short
+		uint64bit origin = ~0ull;
+		for (const CapturedZone& zone : profiler.capture)
+			origin = std::min(origin, zone.start);
+		if (profiler.capture.empty())
+			origin = 0;
+
+		std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+		bool first = true;
+		for (std::size_t id = 0; id < profiler.threadNames.size(); ++id) {
+			std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"", first ? "" : ",\n", id);
+			WriteEscaped(out, profiler.threadNames[id].c_str());
+			std::fprintf(out, "\"}}");
+			first = false;
+		}
+
+		for (const CapturedZone& zone : profiler.capture) {
+			std::fprintf(out, ",\n{\"name\":\"");
+			WriteEscaped(out, zone.name);
+			std::fprintf(out, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				zone.thread, (double)(zone.start - origin) / 1000.0, (double)(zone.end - zone.start) / 1000.0);
+		}
+
+		std::fprintf(out, "\n]}\n");
+		return std::ferror(out) == 0;
+	}
+
+	void Clear() {
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+		profiler.capture.clear();
+		profiler.lastFrame = 0;
+	}
+
+	std::size_t GetZoneCount() {
+		Profiler& profiler = GetProfiler();
+		std::lock_guard<std::mutex> lock(profiler.lock);
+		return profiler.capture.size();
+	}
+
+	uint64bit GetDroppedCount() {
+		return GetProfiler().dropped.load(std::memory_order_relaxed);
+	}
+}
+
+#else
+
+namespace crux::profile {
+	namespace internal {
+		void RecordZone(const char*, uint64bit, uint64bit) {}
+	}
+
+	void SetThreadName(const char*) {}
+	void MarkFrame() {}
+	void Collect() {}
+	bool WriteChromeTrace(const string&) { return false; }
+	bool WriteChromeTrace(std::FILE*) { return false; }
+	void Clear() {}
+	std::size_t GetZoneCount() { return 0; }
+	uint64bit GetDroppedCount() { return 0; }
+}
+
+#endif
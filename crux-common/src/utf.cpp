@@ -0,0 +1,371 @@
+#include "utf.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "platform.h"
+
+#if CRUX_SIMD_AVX2
+#include <immintrin.h>
+#elif CRUX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace crux::utf {
+	namespace {
+		// Units the ASCII fast path is skipped for after it hit a non-ASCII unit, one SSE2 block
+		constexpr std::size_t BlockUnits = 16;
+
+		struct Decoded {
+			char32_t codePoint;
+
+			// Input units consumed
+			std::size_t length;
+
+			bool valid;
+		};
+
+		/*
+		 * Sources, decode one code point from the front of the input.
+		 */
+
+		struct Utf8Source {
+			// Malformed input is replaced per maximal subpart, ie. a truncated sequence counts once
+			template<typename Unit>
+			static Decoded Decode(const Unit* input, std::size_t remaining) {
+				const unsigned char lead = (unsigned char)input[0];
+				if (lead < 0x80)
+					return { lead, 1, true };
+
+				std::size_t trailing;
+				char32_t codePoint;
+				unsigned char low = 0x80;
+				unsigned char high = 0xBF;
+				if (lead >= 0xC2 && lead <= 0xDF) {
+					trailing = 1;
+					codePoint = lead & 0x1F;
+				} else if (lead >= 0xE0 && lead <= 0xEF) {
+					trailing = 2;
+					codePoint = lead & 0x0F;
+
+					//Excludes overlong forms and the surrogate range
+					if (lead == 0xE0)
+						low = 0xA0;
+					else if (lead == 0xED)
+						high = 0x9F;
+				} else if (lead >= 0xF0 && lead <= 0xF4) {
+					trailing = 3;
+					codePoint = lead & 0x07;
+
+					//Excludes overlong forms and anything past U+10FFFF
+					if (lead == 0xF0)
+						low = 0x90;
+					else if (lead == 0xF4)
+						high = 0x8F;
+				} else {
+					return { ReplacementCharacter, 1, false };
+				}
+
+				for (std::size_t i = 1; i <= trailing; ++i) {
+					if (i >= remaining)
+						return { ReplacementCharacter, i, false };
+
+					const unsigned char next = (unsigned char)input[i];
+					if (next < low || next > high)
+						return { ReplacementCharacter, i, false };
+
+					codePoint = (codePoint << 6) | (next & 0x3F);
+					low = 0x80;
+					high = 0xBF;
+				}
+				return { codePoint, trailing + 1, true };
+			}
+		};
+
+		struct Utf16Source {
+			template<typename Unit>
+			static Decoded Decode(const Unit* input, std::size_t remaining) {
+				const char32_t unit = (char16_t)input[0];
+				if (unit < 0xD800 || unit > 0xDFFF)
+					return { unit, 1, true };
+
+				if (unit <= 0xDBFF && remaining > 1) {
+					const char32_t low = (char16_t)input[1];
+					if (low >= 0xDC00 && low <= 0xDFFF)
+						return { 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), 2, true };
+				}
+				return { ReplacementCharacter, 1, false };
+			}
+		};
+
+		struct Utf32Source {
+			template<typename Unit>
+			static Decoded Decode(const Unit* input, std::size_t) {
+				const char32_t unit = (char32_t)(uint32_t)input[0];
+				if (unit >= 0x110000 || (unit >= 0xD800 && unit <= 0xDFFF))
+					return { ReplacementCharacter, 1, false };
+				return { unit, 1, true };
+			}
+		};
+
+		/*
+		 * Targets, encode one code point.
+		 */
+
+		struct Utf8Target {
+			static std::size_t Units(char32_t codePoint) {
+				return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x10000 ? 3 : 4;
+			}
+
+			template<typename Unit>
+			static void Encode(char32_t codePoint, Unit* output) {
+				if (codePoint < 0x80) {
+					output[0] = (Unit)codePoint;
+				} else if (codePoint < 0x800) {
+					output[0] = (Unit)(0xC0 | (codePoint >> 6));
+					output[1] = (Unit)(0x80 | (codePoint & 0x3F));
+				} else if (codePoint < 0x10000) {
+					output[0] = (Unit)(0xE0 | (codePoint >> 12));
+					output[1] = (Unit)(0x80 | ((codePoint >> 6) & 0x3F));
+					output[2] = (Unit)(0x80 | (codePoint & 0x3F));
+				} else {
+					output[0] = (Unit)(0xF0 | (codePoint >> 18));
+					output[1] = (Unit)(0x80 | ((codePoint >> 12) & 0x3F));
+					output[2] = (Unit)(0x80 | ((codePoint >> 6) & 0x3F));
+					output[3] = (Unit)(0x80 | (codePoint & 0x3F));
+				}
+			}
+		};
+
+		struct Utf16Target {
+			static std::size_t Units(char32_t codePoint) {
+				return codePoint < 0x10000 ? 1 : 2;
+			}
+
+			template<typename Unit>
+			static void Encode(char32_t codePoint, Unit* output) {
+				if (codePoint < 0x10000) {
+					output[0] = (Unit)codePoint;
+				} else {
+					codePoint -= 0x10000;
+					output[0] = (Unit)(0xD800 + (codePoint >> 10));
+					output[1] = (Unit)(0xDC00 + (codePoint & 0x3FF));
+				}
+			}
+		};
+
+		struct Utf32Target {
+			static std::size_t Units(char32_t) {
+				return 1;
+			}
+
+			template<typename Unit>
+			static void Encode(char32_t codePoint, Unit* output) {
+				output[0] = (Unit)codePoint;
+			}
+		};
+
+		/**
+		 * @brief Converts the run of ASCII at the start of the input a register at a time.
+		 * Only whole blocks are handled, the scalar loop picks up the rest.
+		 * @param output Destination, nullptr to only measure the run
+		 * @return Units converted, the same count on both sides
+		*/
+		template<typename In, typename Out>
+		std::size_t AsciiRun(const In* input, std::size_t size, Out* output, std::size_t capacity) {
+			const std::size_t limit = std::min(size, capacity);
+			std::size_t i = 0;
+
+#if CRUX_SIMD_SSE2
+			if constexpr (sizeof(In) == 1 && sizeof(Out) == 2) {
+#if CRUX_SIMD_AVX2
+				for (; i + 32 <= limit; i += 32) {
+					const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+					if (_mm256_movemask_epi8(bytes))
+						break;
+					if (output) {
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+					}
+				}
+#endif
+				const __m128i zero = _mm_setzero_si128();
+				for (; i + 16 <= limit; i += 16) {
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+					if (_mm_movemask_epi8(bytes))
+						break;
+					if (output) {
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_unpacklo_epi8(bytes, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8), _mm_unpackhi_epi8(bytes, zero));
+					}
+				}
+			} else if constexpr (sizeof(In) == 2 && sizeof(Out) == 1) {
+#if CRUX_SIMD_AVX2
+				const __m256i wideMask = _mm256_set1_epi16((short)0xFF80);
+				for (; i + 32 <= limit; i += 32) {
+					const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+					const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16));
+					if (!_mm256_testz_si256(_mm256_or_si256(a, b), wideMask))
+						break;
+					if (output) {
+						//packus works per 128bit lane, the permute restores the order
+						const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+					}
+				}
+#endif
+				const __m128i mask = _mm_set1_epi16((short)0xFF80);
+				const __m128i zero = _mm_setzero_si128();
+				for (; i + 16 <= limit; i += 16) {
+					const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+					const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), mask), zero)) != 0xFFFF)
+						break;
+					if (output)
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(a, b));
+				}
+			} else if constexpr (sizeof(In) == 1 && sizeof(Out) == 4) {
+				const __m128i zero = _mm_setzero_si128();
+				for (; i + 16 <= limit; i += 16) {
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+					if (_mm_movemask_epi8(bytes))
+						break;
+					if (output) {
+						const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+						const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_unpacklo_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 4), _mm_unpackhi_epi16(low, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8), _mm_unpacklo_epi16(high, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 12), _mm_unpackhi_epi16(high, zero));
+					}
+				}
+			} else if constexpr (sizeof(In) == 4 && sizeof(Out) == 1) {
+				const __m128i mask = _mm_set1_epi32((int)0xFFFFFF80);
+				const __m128i zero = _mm_setzero_si128();
+				for (; i + 16 <= limit; i += 16) {
+					const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+					const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 4));
+					const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+					const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 12));
+					const __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+					if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(any, mask), zero)) != 0xFFFF)
+						break;
+					if (output) {
+						//Values are below 0x80, so the saturating packs are exact
+						const __m128i ab = _mm_packs_epi32(a, b);
+						const __m128i cd = _mm_packs_epi32(c, d);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(ab, cd));
+					}
+				}
+			}
+#else
+			(void)input;
+			(void)output;
+			(void)limit;
+#endif
+			return i;
+		}
+
+		/**
+		 * @brief Shared conversion loop, ASCII blocks through AsciiRun and everything else a code point at a time.
+		 * @param output Destination, nullptr with capacity SIZE_MAX to only measure
+		*/
+		template<typename Source, typename Target, typename In, typename Out>
+		Result Transcode(const In* input, std::size_t size, Out* output, std::size_t capacity) {
+			Result result;
+			std::size_t nextBlock = 0;
+			while (result.read < size) {
+				if (result.read >= nextBlock) {
+					const std::size_t run = AsciiRun(input + result.read, size - result.read, output ? output + result.written : nullptr, capacity - result.written);
+					result.read += run;
+					result.written += run;
+					nextBlock = result.read + BlockUnits;
+					continue;
+				}
+
+				const Decoded decoded = Source::Decode(input + result.read, size - result.read);
+				const std::size_t units = Target::Units(decoded.codePoint);
+				if (units > capacity - result.written)
+					break;
+
+				if (output)
+					Target::Encode(decoded.codePoint, output + result.written);
+				result.read += decoded.length;
+				result.written += units;
+				result.valid = result.valid && decoded.valid;
+			}
+			return result;
+		}
+
+		template<typename Source, typename Target, typename Out, typename In>
+		std::size_t Measure(const In* input, std::size_t size) {
+			return Transcode<Source, Target>(input, size, (Out*)nullptr, SIZE_MAX).written;
+		}
+	}
+
+	bool IsAscii(std::string_view input) {
+		//Measuring the run as UTF-16 checks whole blocks at once, the tail is left to check here
+		const std::size_t run = AsciiRun(input.data(), input.size(), (char16_t*)nullptr, SIZE_MAX);
+		return std::all_of(input.begin() + run, input.end(), [](char c) { return (unsigned char)c < 0x80; });
+	}
+
+	std::size_t Utf16Length(std::string_view input) {
+		return Measure<Utf8Source, Utf16Target, char16_t>(input.data(), input.size());
+	}
+
+	std::size_t Utf32Length(std::string_view input) {
+		return Measure<Utf8Source, Utf32Target, char32_t>(input.data(), input.size());
+	}
+
+	std::size_t Utf8Length(std::u16string_view input) {
+		return Measure<Utf16Source, Utf8Target, char>(input.data(), input.size());
+	}
+
+	std::size_t Utf8Length(std::u32string_view input) {
+		return Measure<Utf32Source, Utf8Target, char>(input.data(), input.size());
+	}
+
+	std::size_t WideLength(std::string_view input) {
+		if constexpr (sizeof(wchar_t) == 2)
+			return Measure<Utf8Source, Utf16Target, wchar_t>(input.data(), input.size());
+		else
+			return Measure<Utf8Source, Utf32Target, wchar_t>(input.data(), input.size());
+	}
+
+	std::size_t Utf8Length(std::wstring_view input) {
+		if constexpr (sizeof(wchar_t) == 2)
+			return Measure<Utf16Source, Utf8Target, char>(input.data(), input.size());
+		else
+			return Measure<Utf32Source, Utf8Target, char>(input.data(), input.size());
+	}
+
+	Result Utf8ToUtf16(std::string_view input, char16_t* output, std::size_t capacity) {
+		return Transcode<Utf8Source, Utf16Target>(input.data(), input.size(), output, capacity);
+	}
+
+	Result Utf16ToUtf8(std::u16string_view input, char* output, std::size_t capacity) {
+		return Transcode<Utf16Source, Utf8Target>(input.data(), input.size(), output, capacity);
+	}
+
+	Result Utf8ToUtf32(std::string_view input, char32_t* output, std::size_t capacity) {
+		return Transcode<Utf8Source, Utf32Target>(input.data(), input.size(), output, capacity);
+	}
+
+	Result Utf32ToUtf8(std::u32string_view input, char* output, std::size_t capacity) {
+		return Transcode<Utf32Source, Utf8Target>(input.data(), input.size(), output, capacity);
+	}
+
+	Result Utf8ToWide(std::string_view input, wchar_t* output, std::size_t capacity) {
+		if constexpr (sizeof(wchar_t) == 2)
+			return Transcode<Utf8Source, Utf16Target>(input.data(), input.size(), output, capacity);
+		else
+			return Transcode<Utf8Source, Utf32Target>(input.data(), input.size(), output, capacity);
+	}
+
+	Result WideToUtf8(std::wstring_view input, char* output, std::size_t capacity) {
+		if constexpr (sizeof(wchar_t) == 2)
+			return Transcode<Utf16Source, Utf8Target>(input.data(), input.size(), output, capacity);
+		else
+			return Transcode<Utf32Source, Utf8Target>(input.data(), input.size(), output, capacity);
+	}
+}
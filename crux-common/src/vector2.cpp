@@ -0,0 +1,54 @@
+#include "vector2.h"
+
+/*
+ * Compile-time checks for vector2. Nothing in here generates code,
+ * if this translation unit builds then the constexpr operators hold.
+ */
+
+namespace crux {
+	namespace {
+		constexpr vector2<int> a{ 3, -4 };
+		constexpr vector2<int> b{ -1, 2 };
+
+		// Construction
+		static_assert(vector2<int>{}.x == 0 && vector2<int>{}.y == 0);
+		static_assert(vector2<int>(7) == vector2<int>(7, 7));
+		static_assert(a[0] == 3 && a[1] == -4);
+
+		// Arithmetic
+		static_assert(a + b == vector2<int>(2, -2));
+		static_assert(a - b == vector2<int>(4, -6));
+		static_assert(a * b == vector2<int>(-3, -8));
+		static_assert(a / b == vector2<int>(-3, -2));
+		static_assert(-a == vector2<int>(-3, 4));
+		static_assert(a * 2 == vector2<int>(6, -8) && 2 * a == a * 2);
+		static_assert(vector2<float>(3.0f, 1.5f) / 1.5f == vector2<float>(2.0f, 1.0f));
+
+		// Compound assignment
+		constexpr vector2<int> Accumulated() {
+			vector2<int> v = a;
+			v += b;
+			v *= vector2<int>(2);
+			v -= vector2<int>(1, 1);
+			v /= vector2<int>(3, 5);
+			return v;
+		}
+		static_assert(Accumulated() == vector2<int>(1, -1));
+
+		// Comparison
+		static_assert(a != b);
+		static_assert(b < a && a > b);
+		static_assert(a <= a && a >= a);
+
+		// Free functions
+		static_assert(Dot(a, b) == -11);
+		static_assert(Cross(vector2<int>(1, 0), vector2<int>(0, 1)) == 1);
+		static_assert(LengthSquared(a) == 25);
+		static_assert(Min(a, b) == vector2<int>(-1, -4));
+		static_assert(Max(a, b) == vector2<int>(3, 2));
+		static_assert(Clamp(vector2<int>(10, -10), vector2<int>(0), vector2<int>(5)) == vector2<int>(5, 0));
+		static_assert(Abs(a) == vector2<int>(3, 4));
+		static_assert(Abs(vector2<unsigned>(3u, 4u)) == vector2<unsigned>(3u, 4u));
+		static_assert(Dot(vector2<float>(0.5f, 2.0f), vector2<float>(4.0f, 0.25f)) == 2.5f);
+	}
+}
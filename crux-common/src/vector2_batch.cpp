@@ -0,0 +1,188 @@
+#include "vector2_batch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "platform.h"
+
+#if CRUX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace crux::batch {
+	namespace {
+		inline std::size_t Count(std::size_t a, std::size_t b) { return std::min(a, b); }
+		inline std::size_t Count(std::size_t a, std::size_t b, std::size_t c) { return std::min(std::min(a, b), c); }
+
+#if CRUX_SIMD_SSE2
+		// Two vec2f per register, laid out as {x0, y0, x1, y1}
+		inline __m128 Load(const vec2f* v) { return _mm_loadu_ps(&v->x); }
+		inline void Store(vec2f* v, __m128 r) { _mm_storeu_ps(&v->x, r); }
+
+		// Dot products of four vec2f pairs already multiplied together, as {d0, d1, d2, d3}
+		inline __m128 HorizontalPairs(__m128 lo, __m128 hi) {
+			__m128 xs = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 ys = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+			return _mm_add_ps(xs, ys);
+		}
+#endif
+	}
+
+	std::size_t Add(span<const vec2f> lhs, span<const vec2f> rhs, span<vec2f> out) {
+		const std::size_t n = Count(lhs.size(), rhs.size(), out.size());
+		const vec2f* a = lhs.data();
+		const vec2f* b = rhs.data();
+		vec2f* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		for (; i + 4 <= n; i += 4) {
+			__m128 r0 = _mm_add_ps(Load(a + i), Load(b + i));
+			__m128 r1 = _mm_add_ps(Load(a + i + 2), Load(b + i + 2));
+			Store(o + i, r0);
+			Store(o + i + 2, r1);
+		}
+#endif
+		for (; i < n; ++i) {
+			o[i].x = a[i].x + b[i].x;
+			o[i].y = a[i].y + b[i].y;
+		}
+		return n;
+	}
+
+	std::size_t Mul(span<const vec2f> lhs, span<const vec2f> rhs, span<vec2f> out) {
+		const std::size_t n = Count(lhs.size(), rhs.size(), out.size());
+		const vec2f* a = lhs.data();
+		const vec2f* b = rhs.data();
+		vec2f* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		for (; i + 4 <= n; i += 4) {
+			__m128 r0 = _mm_mul_ps(Load(a + i), Load(b + i));
+			__m128 r1 = _mm_mul_ps(Load(a + i + 2), Load(b + i + 2));
+			Store(o + i, r0);
+			Store(o + i + 2, r1);
+		}
+#endif
+		for (; i < n; ++i) {
+			o[i].x = a[i].x * b[i].x;
+			o[i].y = a[i].y * b[i].y;
+		}
+		return n;
+	}
+
+	std::size_t Mul(span<const vec2f> in, float scalar, span<vec2f> out) {
+		const std::size_t n = Count(in.size(), out.size());
+		const vec2f* a = in.data();
+		vec2f* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		const __m128 s = _mm_set1_ps(scalar);
+		for (; i + 4 <= n; i += 4) {
+			__m128 r0 = _mm_mul_ps(Load(a + i), s);
+			__m128 r1 = _mm_mul_ps(Load(a + i + 2), s);
+			Store(o + i, r0);
+			Store(o + i + 2, r1);
+		}
+#endif
+		for (; i < n; ++i) {
+			o[i].x = a[i].x * scalar;
+			o[i].y = a[i].y * scalar;
+		}
+		return n;
+	}
+
+	std::size_t Lerp(span<const vec2f> from, span<const vec2f> to, float t, span<vec2f> out) {
+		const std::size_t n = Count(from.size(), to.size(), out.size());
+		const vec2f* a = from.data();
+		const vec2f* b = to.data();
+		vec2f* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		const __m128 vt = _mm_set1_ps(t);
+		for (; i + 4 <= n; i += 4) {
+			__m128 a0 = Load(a + i), a1 = Load(a + i + 2);
+			__m128 r0 = _mm_add_ps(a0, _mm_mul_ps(_mm_sub_ps(Load(b + i), a0), vt));
+			__m128 r1 = _mm_add_ps(a1, _mm_mul_ps(_mm_sub_ps(Load(b + i + 2), a1), vt));
+			Store(o + i, r0);
+			Store(o + i + 2, r1);
+		}
+#endif
+		for (; i < n; ++i) {
+			o[i].x = a[i].x + (b[i].x - a[i].x) * t;
+			o[i].y = a[i].y + (b[i].y - a[i].y) * t;
+		}
+		return n;
+	}
+
+	std::size_t Dot(span<const vec2f> lhs, span<const vec2f> rhs, span<float> out) {
+		const std::size_t n = Count(lhs.size(), rhs.size(), out.size());
+		const vec2f* a = lhs.data();
+		const vec2f* b = rhs.data();
+		float* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		for (; i + 4 <= n; i += 4) {
+			__m128 m0 = _mm_mul_ps(Load(a + i), Load(b + i));
+			__m128 m1 = _mm_mul_ps(Load(a + i + 2), Load(b + i + 2));
+			_mm_storeu_ps(o + i, HorizontalPairs(m0, m1));
+		}
+#endif
+		for (; i < n; ++i)
+			o[i] = a[i].x * b[i].x + a[i].y * b[i].y;
+		return n;
+	}
+
+	std::size_t Length(span<const vec2f> in, span<float> out) {
+		const std::size_t n = Count(in.size(), out.size());
+		const vec2f* a = in.data();
+		float* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		for (; i + 4 <= n; i += 4) {
+			__m128 v0 = Load(a + i), v1 = Load(a + i + 2);
+			__m128 sq = HorizontalPairs(_mm_mul_ps(v0, v0), _mm_mul_ps(v1, v1));
+			_mm_storeu_ps(o + i, _mm_sqrt_ps(sq));
+		}
+#endif
+		for (; i < n; ++i)
+			o[i] = std::sqrt(a[i].x * a[i].x + a[i].y * a[i].y);
+		return n;
+	}
+
+	std::size_t Normalize(span<const vec2f> in, span<vec2f> out) {
+		const std::size_t n = Count(in.size(), out.size());
+		const vec2f* a = in.data();
+		vec2f* o = out.data();
+
+		std::size_t i = 0;
+#if CRUX_SIMD_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (; i + 4 <= n; i += 4) {
+			__m128 v0 = Load(a + i), v1 = Load(a + i + 2);
+			__m128 len = _mm_sqrt_ps(HorizontalPairs(_mm_mul_ps(v0, v0), _mm_mul_ps(v1, v1)));
+
+			//Zero-length vectors get a zero scale instead of 1/0
+			__m128 nonZero = _mm_cmpgt_ps(len, zero);
+			__m128 inv = _mm_and_ps(nonZero, _mm_div_ps(one, _mm_max_ps(len, _mm_set1_ps(1e-30f))));
+
+			//Expand {i0, i1, i2, i3} back into the interleaved x/y layout
+			Store(o + i, _mm_mul_ps(v0, _mm_unpacklo_ps(inv, inv)));
+			Store(o + i + 2, _mm_mul_ps(v1, _mm_unpackhi_ps(inv, inv)));
+		}
+#endif
+		for (; i < n; ++i) {
+			const float len = std::sqrt(a[i].x * a[i].x + a[i].y * a[i].y);
+			const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+			o[i].x = a[i].x * inv;
+			o[i].y = a[i].y * inv;
+		}
+		return n;
+	}
+}
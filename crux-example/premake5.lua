@@ -0,0 +1,37 @@
+project "crux-example"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+
+    staticruntime "On"
+
+    targetdir (BinDir.. "/%{prj.name}")
+    objdir (TmpDir.. "/%{prj.name}")
+
+    files {
+        "src/**.h",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "src",
+
+        "%{wks.location}/include",
+        "%{wks.location}/crux-common/include",
+        "%{wks.location}/crux-window/include"
+    }
+
+    links {
+        "crux-window",
+        "crux-common"
+    }
+
+    filter "system:linux"
+        links {
+            "X11",
+            "Xext",
+            "dl",
+            "pthread"
+        }
+
+    filter ""
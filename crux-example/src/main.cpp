@@ -1,23 +1,82 @@
 #include <cstdlib>
-#include <iostream>
 
+#include <crux-common/clock.h>
 #include <crux-common/common.h>
+#include <crux-common/log.h>
+#include <crux-common/memory_tracking.h>
+#include <crux-common/platform.h>
+#include <crux-common/profile.h>
 #include <crux-window/window.h>
 
 int main() {
+	// Log records are formatted and written on a background thread from here on
+	crux::log::Start();
+
 	// Test the common lib
 	crux::TestCommon();
 
 	// Test the window creation
-	auto optWindow = crux::Window::Create({ "Crux Example", 800, 600 });
+	crux::WindowProperties windowProps{ "Crux Example", 800, 600 };
+	auto optWindow = crux::Window::Create(windowProps);
+	if( !optWindow ) {
+		// No native backend, fallback to an offscreen window
+		windowProps.headless = true;
+		optWindow = crux::Window::Create(windowProps);
+	}
 	if( optWindow ) {
-		std::cout << "Window created successfully!" << std::endl;
+		CRUX_LOG_INFO("Window created successfully!");
+	} else {
+		CRUX_LOG_ERROR("No window backend for this platform");
+		crux::log::Stop();
+		return 1;
 	}
 	auto window = optWindow.value();
 
 	auto props = window->GetProperties();
-	printf("Window Properties: W=%d H=%d X=%d Y=%d\n", props.width, props.height, props.positionX, props.positionY);
-	
-	system("pause");
+	CRUX_LOG_INFO("Window Properties: W=%d H=%d X=%d Y=%d Headless=%d", props.width, props.height, props.positionX, props.positionY, props.headless);
+
+	// Run until the window is closed or escape is pressed, a headless window runs a single frame
+	crux::Event events[64];
+	crux::FrameTimer timer(60.0);
+	do {
+		std::size_t count = window->PollEvents(events);
+		for( std::size_t i = 0; i < count; ++i ) {
+			const crux::Event& event = events[i];
+			if( event.type == crux::EventType::KEY_DOWN && event.key.key == crux::Key::ESCAPE )
+				window->SetWantsToClose(true);
+			else if( event.type == crux::EventType::RESIZE )
+				CRUX_LOG_DEBUG("Resized to %ux%u", event.size.width, event.size.height);
+		}
+
+		// Draw a gradient into the software framebuffer, if the backend has one
+		if( auto fb = window->GetFramebuffer() ) {
+			for( uint y = 0; y < fb->GetHeight(); ++y ) {
+				uint32bit* row = fb->GetRow(y);
+				for( uint x = 0; x < fb->GetWidth(); ++x )
+					row[x] = fb->Pack((uint8bit)(x * 255 / fb->GetWidth()), (uint8bit)(y * 255 / fb->GetHeight()), 128);
+			}
+			window->Present();
+		}
+
+		// Sleeps until the next frame is due instead of spinning
+		timer.Tick();
+		crux::memory::MarkFrame();
+	} while( !window->WantsToClose() && !props.headless );
+
+	if( timer.GetFrameCount() > 1 ) {
+		auto stats = timer.GetStatistics();
+		CRUX_LOG_INFO("Frame times: p50=%.3fms p99=%.3fms max=%.3fms", crux::clock::ToMilliseconds(stats.p50), crux::clock::ToMilliseconds(stats.p99), crux::clock::ToMilliseconds(stats.max));
+	}
+
+	// Only filled in when built with --track-allocations
+	if( auto memory = crux::memory::Stats(); memory.enabled ) {
+		CRUX_LOG_INFO("Heap: %llu allocations, peak %llu bytes, last frame %llu allocations", memory.heap.allocations, memory.heap.peakBytes, memory.lastFrameAllocations);
+	}
+
+	// Only written when built with --profile, open it in chrome://tracing or ui.perfetto.dev
+	if( crux::profile::WriteChromeTrace("crux-example.trace.json") )
+		CRUX_LOG_INFO("Profile written to crux-example.trace.json");
+
+	crux::log::Stop();
 	return 0;
 }
\ No newline at end of file
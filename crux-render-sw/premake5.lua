@@ -0,0 +1,31 @@
+project "crux-render-sw"
+    kind "StaticLib"
+    language "C++"
+    cppdialect "C++20"
+
+    staticruntime "On"
+
+    targetdir (BinDir.. "/%{prj.name}")
+    objdir (TmpDir.. "/%{prj.name}")
+
+    files {
+        "include/**.h",
+        "include/**.hpp",
+        "src/**.c",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "include",
+
+        "%{wks.location}/include",
+        "%{wks.location}/crux-common/include",
+        "%{wks.location}/crux-window/include"
+    }
+
+    links {
+        "crux-window",
+        "crux-common"
+    }
+
+    filter ""
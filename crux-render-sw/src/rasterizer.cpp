@@ -0,0 +1,522 @@
+#include "rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <crux-common/platform.h>
+#include <crux-common/profile.h>
+
+#if CRUX_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace crux::render {
+	namespace internal {
+		/**
+		 * @brief A triangle after setup, ready to rasterize into any tile.
+		 * Edge k is opposite corner k, e = a * x + b * y + c evaluated at the
+		 * center of pixel (x, y), and the pixel is covered when all three are >= 0.
+		*/
+		struct Triangle {
+			int32bit a[3];
+			int32bit b[3];
+
+			// 64bit, far from the origin the constant term outgrows 32bit
+			int64bit c[3];
+
+			// Covered pixel bounds clipped to the target, max is exclusive
+			int32bit minX;
+			int32bit minY;
+			int32bit maxX;
+			int32bit maxY;
+
+			// Color in the target's format when FLAT is set, otherwise the index of its Shading in the chunk
+			uint32bit color;
+			uint32bit flags;
+		};
+
+		// Color planes of a gouraud shaded triangle, per byte of the target pixel the value at (minX, minY), and its x and y gradient
+		struct Shading {
+			float plane[4][3];
+		};
+
+		struct Chunk {
+			// Triangles per tile in submission order, copied so a tile reads its own bin front to back
+			std::vector<std::vector<Triangle>> bins;
+			std::vector<Shading> shading;
+
+			uint64bit culled = 0;
+			uint64bit binned = 0;
+		};
+	}
+
+	namespace {
+		using internal::Triangle;
+		using internal::Shading;
+		using internal::Chunk;
+
+		// All three corners share one color
+		constexpr uint32bit FLAT = 1;
+
+		// All three corners have full alpha, no blending
+		constexpr uint32bit OPAQUE = 2;
+
+		// Converts between RGBA8 and BGRA8
+		inline uint32bit SwapRedBlue(uint32bit p) {
+			return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+		}
+
+		// Rounds half away from zero, std::lrint is a libm call on gcc unless errno is disabled
+		inline int32bit RoundToInt(float value) {
+			return (int32bit)(value + (value >= 0.0f ? 0.5f : -0.5f));
+		}
+
+		// Straight alpha source-over, the alpha channel ends up a + d * (1 - a)
+		inline uint32bit BlendOver(uint32bit src, uint32bit dst) {
+			const uint32bit alpha = src >> 24;
+			const uint32bit inverse = 255 - alpha;
+			src |= 0xFF000000u;
+
+			uint32bit out = 0;
+			for (uint shift = 0; shift < 32; shift += 8) {
+				const uint32bit t = ((src >> shift) & 0xFFu) * alpha + ((dst >> shift) & 0xFFu) * inverse + 128;
+				out |= ((t + (t >> 8)) >> 8) << shift;
+			}
+			return out;
+		}
+
+		inline uint32bit Shade(const Triangle& tri, const Shading& shading, int32bit x, int32bit y) {
+			const float fx = (float)(x - tri.minX);
+			const float fy = (float)(y - tri.minY);
+
+			uint32bit out = 0;
+			for (uint k = 0; k < 4; ++k) {
+				const float value = shading.plane[k][0] + (shading.plane[k][1] * fx + shading.plane[k][2] * fy);
+				out |= (uint32bit)RoundToInt(std::clamp(value, 0.0f, 255.0f)) << (k * 8);
+			}
+			return out;
+		}
+
+		/**
+		 * @brief Sets up a triangle for rasterizing into a target of the given size.
+		 * Gouraud shaded triangles add their color planes to the chunk.
+		 * @return False if the triangle covers no pixel
+		*/
+		bool Setup(const Vertex* corners[3], int32bit width, int32bit height, PixelFormat format, Triangle& tri, Chunk& chunk) {
+			//Also rejects NaN, which fails every comparison
+			for (uint i = 0; i < 3; ++i) {
+				const vec2f& p = corners[i]->position;
+				if (!(p.x >= -Rasterizer::GuardBand && p.x <= (float)width + Rasterizer::GuardBand
+					&& p.y >= -Rasterizer::GuardBand && p.y <= (float)height + Rasterizer::GuardBand))
+					return false;
+			}
+
+			vec2i fixed[3];
+			uint32bit colors[3];
+			for (uint i = 0; i < 3; ++i) {
+				fixed[i] = vec2i(RoundToInt(corners[i]->position.x * Rasterizer::SubPixelSteps), RoundToInt(corners[i]->position.y * Rasterizer::SubPixelSteps));
+				colors[i] = format == PixelFormat::BGRA8 ? SwapRedBlue(corners[i]->color) : corners[i]->color;
+			}
+
+			if ((colors[0] | colors[1] | colors[2]) >> 24 == 0)
+				return false; //Fully transparent, draws nothing
+
+			int64bit area = (int64bit)(fixed[1].x - fixed[0].x) * (fixed[2].y - fixed[0].y) - (int64bit)(fixed[1].y - fixed[0].y) * (fixed[2].x - fixed[0].x);
+			if (area == 0)
+				return false;
+			if (area < 0) {
+				//Flip to the winding the edge functions expect
+				std::swap(fixed[1], fixed[2]);
+				std::swap(colors[1], colors[2]);
+				area = -area;
+			}
+
+			//Pixels whose center lies within the bounds of the snapped corners, the shifts round toward negative infinity
+			constexpr int32bit half = Rasterizer::SubPixelSteps / 2;
+			const int32bit loX = std::min(fixed[0].x, std::min(fixed[1].x, fixed[2].x));
+			const int32bit hiX = std::max(fixed[0].x, std::max(fixed[1].x, fixed[2].x));
+			const int32bit loY = std::min(fixed[0].y, std::min(fixed[1].y, fixed[2].y));
+			const int32bit hiY = std::max(fixed[0].y, std::max(fixed[1].y, fixed[2].y));
+			tri.minX = std::max(0, (loX - half + Rasterizer::SubPixelSteps - 1) >> Rasterizer::SubPixelBits);
+			tri.minY = std::max(0, (loY - half + Rasterizer::SubPixelSteps - 1) >> Rasterizer::SubPixelBits);
+			tri.maxX = std::min(width, ((hiX - half) >> Rasterizer::SubPixelBits) + 1);
+			tri.maxY = std::min(height, ((hiY - half) >> Rasterizer::SubPixelBits) + 1);
+			if (tri.minX >= tri.maxX || tri.minY >= tri.maxY)
+				return false;
+
+			int64bit unbiased[3];
+			for (uint k = 0; k < 3; ++k) {
+				const vec2i& from = fixed[(k + 1) % 3];
+				const vec2i& to = fixed[(k + 2) % 3];
+				const int64bit a = from.y - to.y;
+				const int64bit b = to.x - from.x;
+				const int64bit c = (int64bit)from.x * to.y - (int64bit)to.x * from.y;
+
+				//Top-left fill rule, pixels exactly on a right or bottom edge belong to the neighbour
+				const bool topLeft = a > 0 || (a == 0 && b > 0);
+
+				tri.a[k] = (int32bit)(a * Rasterizer::SubPixelSteps);
+				tri.b[k] = (int32bit)(b * Rasterizer::SubPixelSteps);
+				unbiased[k] = (a + b) * half + c;
+				tri.c[k] = unbiased[k] - (topLeft ? 0 : 1);
+			}
+
+			tri.flags = 0;
+			if (colors[0] == colors[1] && colors[1] == colors[2])
+				tri.flags |= FLAT;
+			if ((colors[0] & colors[1] & colors[2]) >> 24 == 0xFF)
+				tri.flags |= OPAQUE;
+			tri.color = colors[0];
+
+			if (!(tri.flags & FLAT)) {
+				//Each corner weighted by its opposite edge over the area, relative to (minX, minY)
+				tri.color = (uint32bit)chunk.shading.size();
+				Shading& shading = chunk.shading.emplace_back();
+				const double inverseArea = 1.0 / (double)area;
+				for (uint channel = 0; channel < 4; ++channel) {
+					double value = 0.0, dx = 0.0, dy = 0.0;
+					for (uint k = 0; k < 3; ++k) {
+						const double c = (double)((colors[k] >> (channel * 8)) & 0xFFu);
+						value += c * (double)(unbiased[k] + (int64bit)tri.a[k] * tri.minX + (int64bit)tri.b[k] * tri.minY);
+						dx += c * (double)tri.a[k];
+						dy += c * (double)tri.b[k];
+					}
+					shading.plane[channel][0] = (float)(value * inverseArea);
+					shading.plane[channel][1] = (float)(dx * inverseArea);
+					shading.plane[channel][2] = (float)(dy * inverseArea);
+				}
+			}
+			return true;
+		}
+
+		struct Rect {
+			int32bit x0;
+			int32bit y0;
+			int32bit x1;
+			int32bit y1;
+		};
+
+		/**
+		 * @brief Walks the rect in blocks of 4 pixels starting at an x multiple of 4.
+		 * Edges a, b and e (the value at (x0 & ~3, y0)) are zero for edges the rect is fully inside of.
+		*/
+		template<bool Flat, bool Opaque>
+		void Fill(const Triangle& tri, const Shading* shading, Framebuffer& target, const Rect& rect, const int32bit a[3], const int32bit b[3], const int32bit e[3]) {
+			const int32bit startX = rect.x0 & ~3;
+
+#if CRUX_SIMD_SSE2
+			const int32bit stride = (int32bit)target.GetStride();
+			const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+			const __m128i firstX = _mm_set1_epi32(rect.x0 - 1);
+			const __m128i lastX = _mm_set1_epi32(rect.x1);
+
+			__m128i step[3], row[3];
+			for (uint k = 0; k < 3; ++k) {
+				step[k] = _mm_set1_epi32(a[k] * 4);
+				row[k] = _mm_setr_epi32(e[k], e[k] + a[k], e[k] + a[k] * 2, e[k] + a[k] * 3);
+			}
+
+			const __m128i flat = _mm_set1_epi32((int)tri.color);
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i keepColor = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+			const __m128i fullAlpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+			const __m128i alphaMax = _mm_set1_epi16(255);
+			const __m128i round = _mm_set1_epi16(128);
+			const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+			const __m128 half = _mm_set1_ps(0.5f);
+
+			for (int32bit y = rect.y0; y < rect.y1; ++y) {
+				uint32bit* pixels = target.GetRow((uint)y);
+				__m128i e0 = row[0], e1 = row[1], e2 = row[2];
+
+				for (int32bit x = startX; x < rect.x1; x += 4) {
+					const __m128i xs = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+					__m128i mask = _mm_and_si128(_mm_cmpgt_epi32(xs, firstX), _mm_cmplt_epi32(xs, lastX));
+					mask = _mm_andnot_si128(_mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31), mask);
+					e0 = _mm_add_epi32(e0, step[0]);
+					e1 = _mm_add_epi32(e1, step[1]);
+					e2 = _mm_add_epi32(e2, step[2]);
+
+					const int covered = _mm_movemask_ps(_mm_castsi128_ps(mask));
+					if (covered == 0)
+						continue;
+
+					__m128i src = flat;
+					if constexpr (!Flat) {
+						const __m128 fx = _mm_add_ps(_mm_set1_ps((float)(x - tri.minX)), laneOffsets);
+						const __m128 fy = _mm_set1_ps((float)(y - tri.minY));
+						src = zero;
+						for (int k = 0; k < 4; ++k) {
+							__m128 value = _mm_add_ps(_mm_set1_ps(shading->plane[k][0]), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(shading->plane[k][1]), fx), _mm_mul_ps(_mm_set1_ps(shading->plane[k][2]), fy)));
+							value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+							src = _mm_or_si128(src, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(value, half)), k * 8));
+						}
+					}
+
+					if (x + 4 > stride) {
+						//Attached memory without row padding, finish the last block one pixel at a time
+						alignas(16) uint32bit colors[4];
+						_mm_store_si128((__m128i*)colors, src);
+						for (int i = 0; i < 4; ++i) {
+							if (covered & (1 << i))
+								pixels[x + i] = Opaque ? colors[i] : BlendOver(colors[i], pixels[x + i]);
+						}
+						continue;
+					}
+
+					__m128i* block = (__m128i*)(pixels + x);
+					if (Opaque && covered == 0xF) {
+						_mm_storeu_si128(block, src);
+						continue;
+					}
+
+					const __m128i dst = _mm_loadu_si128(block);
+					if constexpr (!Opaque) {
+						//Two pixels per register as 16bit channels, (s * a + d * (255 - a) + 128) / 255
+						__m128i srcLo = _mm_unpacklo_epi8(src, zero);
+						__m128i srcHi = _mm_unpackhi_epi8(src, zero);
+						const __m128i dstLo = _mm_unpacklo_epi8(dst, zero);
+						const __m128i dstHi = _mm_unpackhi_epi8(dst, zero);
+
+						const __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+						const __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+						srcLo = _mm_or_si128(_mm_and_si128(srcLo, keepColor), fullAlpha);
+						srcHi = _mm_or_si128(_mm_and_si128(srcHi, keepColor), fullAlpha);
+
+						__m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(srcLo, alphaLo), _mm_mullo_epi16(dstLo, _mm_sub_epi16(alphaMax, alphaLo))), round);
+						__m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(srcHi, alphaHi), _mm_mullo_epi16(dstHi, _mm_sub_epi16(alphaMax, alphaHi))), round);
+						lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+						hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+						src = _mm_packus_epi16(lo, hi);
+					}
+					_mm_storeu_si128(block, _mm_or_si128(_mm_and_si128(mask, src), _mm_andnot_si128(mask, dst)));
+				}
+
+				row[0] = _mm_add_epi32(row[0], _mm_set1_epi32(b[0]));
+				row[1] = _mm_add_epi32(row[1], _mm_set1_epi32(b[1]));
+				row[2] = _mm_add_epi32(row[2], _mm_set1_epi32(b[2]));
+			}
+#else
+			int32bit row[3] = { e[0], e[1], e[2] };
+			for (int32bit y = rect.y0; y < rect.y1; ++y) {
+				uint32bit* pixels = target.GetRow((uint)y);
+				int32bit e0 = row[0], e1 = row[1], e2 = row[2];
+
+				for (int32bit x = startX; x < rect.x1; ++x, e0 += a[0], e1 += a[1], e2 += a[2]) {
+					if (x < rect.x0 || (e0 | e1 | e2) < 0)
+						continue;
+
+					const uint32bit src = Flat ? tri.color : Shade(tri, *shading, x, y);
+					pixels[x] = Opaque ? src : BlendOver(src, pixels[x]);
+				}
+
+				row[0] += b[0];
+				row[1] += b[1];
+				row[2] += b[2];
+			}
+#endif
+		}
+
+		void RasterizeTriangle(const Triangle& tri, const Chunk& chunk, Framebuffer& target, const Rect& tile) {
+			const Rect rect = {
+				std::max(tile.x0, tri.minX),
+				std::max(tile.y0, tri.minY),
+				std::min(tile.x1, tri.maxX),
+				std::min(tile.y1, tri.maxY)
+			};
+			if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1)
+				return;
+
+			//Classify each edge against the rect in 64bit, a pixel anywhere in the rect is then within
+			//a tile's reach of an edge crossing it, and fits 32bit while stepping
+			const int32bit startX = rect.x0 & ~3;
+			int32bit a[3], b[3], e[3];
+			bool partial = false;
+			for (uint k = 0; k < 3; ++k) {
+				const int64bit corner = (int64bit)tri.a[k] * rect.x0 + (int64bit)tri.b[k] * rect.y0 + tri.c[k];
+				const int64bit dx = (int64bit)tri.a[k] * (rect.x1 - 1 - rect.x0);
+				const int64bit dy = (int64bit)tri.b[k] * (rect.y1 - 1 - rect.y0);
+				if (corner + std::max<int64bit>(dx, 0) + std::max<int64bit>(dy, 0) < 0)
+					return; //Whole rect outside this edge
+
+				if (corner + std::min<int64bit>(dx, 0) + std::min<int64bit>(dy, 0) >= 0) {
+					a[k] = b[k] = e[k] = 0;
+					continue;
+				}
+
+				a[k] = tri.a[k];
+				b[k] = tri.b[k];
+				e[k] = (int32bit)(corner - (int64bit)tri.a[k] * (rect.x0 - startX));
+				partial = true;
+			}
+
+			const bool flat = (tri.flags & FLAT) != 0;
+			const bool opaque = (tri.flags & OPAQUE) != 0;
+			if (!partial && flat && opaque) {
+				for (int32bit y = rect.y0; y < rect.y1; ++y)
+					std::fill_n(target.GetRow((uint)y) + rect.x0, rect.x1 - rect.x0, tri.color);
+				return;
+			}
+
+			if (flat) {
+				opaque ? Fill<true, true>(tri, nullptr, target, rect, a, b, e) : Fill<true, false>(tri, nullptr, target, rect, a, b, e);
+			} else {
+				const Shading* shading = &chunk.shading[tri.color];
+				opaque ? Fill<false, true>(tri, shading, target, rect, a, b, e) : Fill<false, false>(tri, shading, target, rect, a, b, e);
+			}
+		}
+	}
+
+	Rasterizer::Rasterizer(JobSystem* jobs) : jobs(jobs) {}
+
+	Rasterizer::~Rasterizer() = default;
+
+	void Rasterizer::Begin(Framebuffer& newTarget) {
+		target = &newTarget;
+		tileCount = vec2u((newTarget.GetWidth() + TileSize - 1) / TileSize, (newTarget.GetHeight() + TileSize - 1) / TileSize);
+		usedChunks = 0;
+		clear = false;
+		stats = RasterizerStats();
+	}
+
+	void Rasterizer::Clear(uint32bit color) {
+		if (!target)
+			return;
+
+		usedChunks = 0;
+		clear = true;
+		clearColor = target->GetFormat() == PixelFormat::BGRA8 ? SwapRedBlue(color) : color;
+	}
+
+	void Rasterizer::DrawTriangles(span<const Vertex> vertices) {
+		Draw(vertices.size() / 3, [&](std::size_t i, const Vertex* corners[3]) {
+			corners[0] = &vertices[i * 3];
+			corners[1] = &vertices[i * 3 + 1];
+			corners[2] = &vertices[i * 3 + 2];
+			return true;
+		});
+	}
+
+	void Rasterizer::DrawIndexed(span<const Vertex> vertices, span<const uint32bit> indices) {
+		Draw(indices.size() / 3, [&](std::size_t i, const Vertex* corners[3]) {
+			for (uint k = 0; k < 3; ++k) {
+				const uint32bit index = indices[i * 3 + k];
+				if (index >= vertices.size())
+					return false;
+				corners[k] = &vertices[index];
+			}
+			return true;
+		});
+	}
+
+	template<typename Fetch>
+	void Rasterizer::Draw(std::size_t count, const Fetch& fetch) {
+		if (!target || count == 0)
+			return;
+
+		CRUX_PROFILE_SCOPE("Rasterizer::Draw");
+		stats.triangles += count;
+
+		const std::size_t chunkCount = (count + ChunkTriangles - 1) / ChunkTriangles;
+		std::vector<Chunk*> batch(chunkCount);
+		for (Chunk*& chunk : batch)
+			chunk = &AcquireChunk();
+
+		const int32bit width = (int32bit)target->GetWidth();
+		const int32bit height = (int32bit)target->GetHeight();
+		const PixelFormat format = target->GetFormat();
+
+		auto bin = [&](std::size_t c) {
+			Chunk& chunk = *batch[c];
+			const std::size_t end = std::min(count, (c + 1) * ChunkTriangles);
+			for (std::size_t i = c * ChunkTriangles; i < end; ++i) {
+				const Vertex* corners[3];
+				Triangle tri;
+				if (!fetch(i, corners) || !Setup(corners, width, height, format, tri, chunk)) {
+					++chunk.culled;
+					continue;
+				}
+
+				const uint tileX0 = (uint)tri.minX / TileSize, tileX1 = (uint)(tri.maxX - 1) / TileSize;
+				const uint tileY0 = (uint)tri.minY / TileSize, tileY1 = (uint)(tri.maxY - 1) / TileSize;
+				for (uint ty = tileY0; ty <= tileY1; ++ty) {
+					for (uint tx = tileX0; tx <= tileX1; ++tx)
+						chunk.bins[ty * tileCount.x + tx].push_back(tri);
+				}
+				chunk.binned += (uint64bit)(tileX1 - tileX0 + 1) * (tileY1 - tileY0 + 1);
+			}
+		};
+
+		if (jobs && chunkCount > 1) {
+			jobs->ParallelFor(0, chunkCount, 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t c = begin; c < end; ++c)
+					bin(c);
+			});
+		} else {
+			for (std::size_t c = 0; c < chunkCount; ++c)
+				bin(c);
+		}
+
+		for (Chunk* chunk : batch) {
+			stats.culled += chunk->culled;
+			stats.binned += chunk->binned;
+		}
+	}
+
+	Chunk& Rasterizer::AcquireChunk() {
+		if (usedChunks == chunks.size())
+			chunks.push_back(std::make_unique<Chunk>());
+
+		Chunk& chunk = *chunks[usedChunks++];
+		chunk.bins.resize((std::size_t)tileCount.x * tileCount.y);
+		for (auto& bin : chunk.bins)
+			bin.clear();
+		chunk.shading.clear();
+		chunk.culled = 0;
+		chunk.binned = 0;
+		return chunk;
+	}
+
+	void Rasterizer::RasterizeTile(uint tile) {
+		const uint tx = tile % tileCount.x;
+		const uint ty = tile / tileCount.x;
+		const Rect rect = {
+			(int32bit)(tx * TileSize),
+			(int32bit)(ty * TileSize),
+			(int32bit)std::min((tx + 1) * TileSize, target->GetWidth()),
+			(int32bit)std::min((ty + 1) * TileSize, target->GetHeight())
+		};
+
+		if (clear) {
+			for (int32bit y = rect.y0; y < rect.y1; ++y)
+				std::fill_n(target->GetRow((uint)y) + rect.x0, rect.x1 - rect.x0, clearColor);
+		}
+
+		for (std::size_t c = 0; c < usedChunks; ++c) {
+			const Chunk& chunk = *chunks[c];
+			for (const Triangle& tri : chunk.bins[tile])
+				RasterizeTriangle(tri, chunk, *target, rect);
+		}
+	}
+
+	void Rasterizer::End() {
+		if (!target)
+			return;
+
+		CRUX_PROFILE_SCOPE("Rasterizer::End");
+		const uint tiles = tileCount.x * tileCount.y;
+		if (jobs) {
+			jobs->ParallelFor(0, tiles, 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t tile = begin; tile < end; ++tile)
+					RasterizeTile((uint)tile);
+			});
+		} else {
+			for (uint tile = 0; tile < tiles; ++tile)
+				RasterizeTile(tile);
+		}
+
+		target = nullptr;
+		usedChunks = 0;
+		clear = false;
+	}
+}
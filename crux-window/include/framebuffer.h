@@ -0,0 +1,164 @@
+#pragma once
+
+/*
+ * CPU-side pixel storage for software rendered windows.
+ * Pixels are 32bit words, one per pixel, with the byte order described
+ * by the PixelFormat (assuming a little-endian host).
+ */
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+
+#include <crux-common/types.h>
+#include <crux-common/span.h>
+
+#include "dirty_region.h"
+
+namespace crux {
+	/**
+	 * @brief Byte order of a single 32bit pixel in memory.
+	*/
+	enum class PixelFormat {
+		// Bytes R, G, B, A. The native layout for images and the headless backend
+		RGBA8 = 0,
+
+		// Bytes B, G, R, A. The native layout of X11 and Win32 DIB surfaces
+		BGRA8,
+	};
+
+	/**
+	 * @brief A 2D array of 32bit pixels, either owned or attached to external memory.
+	 *
+	 * Owned storage is aligned to Framebuffer::Alignment bytes and each row
+	 * is padded to a multiple of Framebuffer::RowAlignment pixels so rows can
+	 * be processed with aligned vector loads.
+	*/
+	class Framebuffer {
+	public:
+		// Byte alignment of owned pixel storage
+		static constexpr std::size_t Alignment = 64;
+
+		// Rows of owned storage are padded to a multiple of this many pixels
+		static constexpr uint RowAlignment = 16;
+
+		Framebuffer(PixelFormat format = PixelFormat::RGBA8) : format(format) {}
+
+		/**
+		 * @brief Construct a framebuffer owning storage for the given size.
+		 * @param size Width and height in pixels
+		 * @param format Byte order of the pixels
+		*/
+		Framebuffer(const vec2u& size, PixelFormat format = PixelFormat::RGBA8);
+
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+
+		Framebuffer(Framebuffer&& other) noexcept { Swap(other); }
+		Framebuffer& operator=(Framebuffer&& other) noexcept { Swap(other); return *this; }
+
+		/**
+		 * @brief Resizes owned storage, the pixel contents are undefined afterwards.
+		 * Storage is only reallocated when growing past the current capacity.
+		 * Detaches from any external memory.
+		 * @param size New width and height in pixels
+		*/
+		void Resize(const vec2u& size);
+
+		/**
+		 * @brief Uses external memory for the pixels, ie. a shared memory segment.
+		 * The memory is not owned and must outlive the framebuffer, or the next
+		 * call to Resize/Attach.
+		 * @param pixels First pixel of the top row
+		 * @param size Width and height in pixels
+		 * @param stride Pixels between the start of two rows, at least size.x
+		*/
+		void Attach(uint32bit* pixels, const vec2u& size, uint stride);
+
+		// Swaps the storage, size and format of two framebuffers without copying pixels
+		void Swap(Framebuffer& other) noexcept;
+
+		// @return Pointer to the first pixel of the top row
+		inline uint32bit* GetPixels() { return pixels; }
+		inline const uint32bit* GetPixels() const { return pixels; }
+
+		// @return Pointer to the first pixel of row y
+		inline uint32bit* GetRow(uint y) { return pixels + (std::size_t)y * stride; }
+		inline const uint32bit* GetRow(uint y) const { return pixels + (std::size_t)y * stride; }
+
+		// @return Span over the pixels of row y, without the padding
+		inline span<uint32bit> GetRowSpan(uint y) { return span<uint32bit>(GetRow(y), size.x); }
+		inline span<const uint32bit> GetRowSpan(uint y) const { return span<const uint32bit>(GetRow(y), size.x); }
+
+		// @return Width and height in pixels
+		inline vec2u GetSize() const { return size; }
+
+		// @return Width in pixels
+		inline uint GetWidth() const { return size.x; }
+
+		// @return Height in pixels
+		inline uint GetHeight() const { return size.y; }
+
+		// @return Pixels between the start of two rows
+		inline uint GetStride() const { return stride; }
+
+		// @return Byte order of the pixels
+		inline PixelFormat GetFormat() const { return format; }
+
+		// @return True if there are no pixels
+		inline bool IsEmpty() const { return size.x == 0 || size.y == 0; }
+
+		/**
+		 * @brief Packs 8bit channels into a pixel of the given format.
+		 * @return The 32bit pixel value
+		*/
+		static constexpr uint32bit Pack(PixelFormat format, uint8bit r, uint8bit g, uint8bit b, uint8bit a = 255) {
+			return format == PixelFormat::RGBA8
+				? (uint32bit)r | ((uint32bit)g << 8) | ((uint32bit)b << 16) | ((uint32bit)a << 24)
+				: (uint32bit)b | ((uint32bit)g << 8) | ((uint32bit)r << 16) | ((uint32bit)a << 24);
+		}
+
+		// @return The pixel value for the given channels in this framebuffer's format
+		inline uint32bit Pack(uint8bit r, uint8bit g, uint8bit b, uint8bit a = 255) const { return Pack(format, r, g, b, a); }
+
+		// Fills every pixel with the given packed value
+		void Clear(uint32bit pixel);
+
+		/**
+		 * @brief Copies the pixels of another framebuffer of the same size,
+		 * converting the byte order if the formats differ.
+		 * @return False if the sizes differ
+		*/
+		bool CopyFrom(const Framebuffer& other);
+
+		/**
+		 * @brief Copies one rectangle of pixels from another framebuffer of the same size,
+		 * converting the byte order if the formats differ.
+		 * @param other Framebuffer to copy from
+		 * @param rect Pixels to copy, clipped to the framebuffer
+		 * @return False if the sizes differ
+		*/
+		bool CopyRect(const Framebuffer& other, const PixelRect& rect);
+
+		/**
+		 * @brief Writes the pixels to a binary PPM (P6) image, dropping alpha.
+		 * @param path File path to write to
+		 * @return True if the file was written
+		*/
+		bool WritePPM(const std::string& path) const;
+
+	private:
+		struct AlignedDelete {
+			void operator()(uint32bit* p) const { ::operator delete(p, std::align_val_t(Alignment)); }
+		};
+
+		std::unique_ptr<uint32bit, AlignedDelete> storage;
+		std::size_t capacity = 0;
+
+		uint32bit* pixels = nullptr;
+		vec2u size{ 0u, 0u };
+		uint stride = 0;
+		PixelFormat format = PixelFormat::RGBA8;
+	};
+}
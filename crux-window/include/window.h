@@ -1,9 +1,19 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
 #include <crux-common/types.h>
 #include <crux-common/optional.h>
+#include <crux-common/span.h>
+#include <crux-common/spsc_queue.h>
+#include <crux-common/task.h>
+
+#include "event.h"
+#include "framebuffer.h"
 
 namespace crux {
 	/**
@@ -14,6 +24,7 @@ namespace crux {
 	 * underlying implementation if absolutely needed.
 	*/
 	class Window;
+	class WindowManager;
 
 	/**
 	 * @brief Smart-pointer for a window.
@@ -35,10 +46,10 @@ namespace crux {
 		 * if the WindowProperties::positionCentered flag is true.
 		 * If that flag is false, then the OS will decide.
 		*/
-		static const int POSITION_UNDEFINED = -1;
+		static constexpr int POSITION_UNDEFINED = -1;
 
 		// Vector 2D of integers, both of which are POSITION_UNDEFINED
-		static const vec2i POSITION_UNDEFINED_VEC;
+		static constexpr vec2i POSITION_UNDEFINED_VEC{ POSITION_UNDEFINED, POSITION_UNDEFINED };
 
 		// Given std::string title for the window, shown in the platform UI.
 		std::string title = "Unknown";
@@ -65,6 +76,16 @@ namespace crux {
 		// properties is negative, to indicate automatic centering on the screen.
 		bool positionCentered = true;
 
+		// When true, Window::Create makes an offscreen WindowHeadless with
+		// no display-server dependency instead of a native window.
+		bool headless = false;
+
+		// When true, the OS message pump runs on its own thread so window
+		// drags and resizes never stall the thread calling PollEvents.
+		// Setters are then applied asynchronously by that thread.
+		// Ignored by headless windows, which have no OS messages.
+		bool threadedMessagePump = false;
+
 		WindowProperties() = default;
 
 		/**
@@ -104,6 +125,8 @@ namespace crux {
 	 * underlying implementation if absolutely needed.
 	*/
 	class Window {
+		//Pumps and drains many windows at once
+		friend class WindowManager;
 	public:
 		/**
 		 * @brief Factory function to create a new Window
@@ -117,6 +140,26 @@ namespace crux {
 		 * @return A crux::optional object resulting in a WinPtr object if successfully created
 		*/
 		static crux::optional<WinPtr> Create(const WindowProperties& props);
+
+		/**
+		 * @brief Coroutine version of Create, creating the window on a job system worker.
+		 *
+		 * Opening the display connection and creating the native window can take
+		 * several milliseconds, awaiting this lets the caller overlap it with other
+		 * startup work. The awaiting coroutine resumes on the worker that created
+		 * the window.
+		 *
+		 * On Win32 the message queue belongs to the creating thread, so native
+		 * windows created this way always use WindowProperties::threadedMessagePump.
+		 * 
+		 * @param[in] props The properties of the window to set for creation, copied into the coroutine
+		 * @param[in] jobs Job system to create the window on
+		 * @return Task resolving to the same result as Create
+		*/
+		static task<crux::optional<WinPtr>> CreateAsync(WindowProperties props, JobSystem& jobs);
+
+		// Number of events that can be pending before new events are dropped
+		static constexpr std::size_t EVENT_QUEUE_CAPACITY = 1024;
 	
 		Window(const Window&) = delete; //copy ctor
 		Window& operator=(const Window&) = delete; //assignment
@@ -150,21 +193,21 @@ namespace crux {
 		 * of the Window.
 		 * @return Vector 2D (signed) of the screen position
 		*/
-		inline const vec2i& GetPosition() const { return position; }
+		inline vec2i GetPosition() const { return position.load(std::memory_order_acquire); }
 
 		/**
 		 * @brief Returns the current horizontal (X axis) position 
 		 * in pixels, on-screen, of the Window.
 		 * @return Integer of the horizontal screen position
 		*/
-		inline int GetPositionX() const { return position.x; }
+		inline int GetPositionX() const { return GetPosition().x; }
 
 		/**
 		 * @brief Returns the current vertical (Y axis) position
 		 * in pixels, on-screen, of the Window.
 		 * @return Integer of the vertical screen position
 		*/
-		inline int GetPositionY() const { return position.y; }
+		inline int GetPositionY() const { return GetPosition().y; }
 
 		// Set the window position, using a vector-2D of integers
 		virtual void SetPosition(const vec2i& pos) = 0;
@@ -179,34 +222,34 @@ namespace crux {
 		virtual void SetPosition(uint x, uint y) { SetPosition(vec2i(x, y)); }
 
 		// Set the window horizontal (X-axis) position, using an integer
-		virtual void SetPositionX(int x) { SetPosition(vec2i(x, position.y)); }
+		virtual void SetPositionX(int x) { SetPosition(vec2i(x, GetPositionY())); }
 
 		// Set the window horizontal (X-axis) position, using an unsigned-integer
-		virtual void SetPositionX(uint x) { SetPosition(vec2i(x, position.y)); }
+		virtual void SetPositionX(uint x) { SetPosition(vec2i(x, GetPositionY())); }
 
 		// Set the window vertical (Y-axis) position, using an integer
-		virtual void SetPositionY(int y) { SetPosition(vec2i(position.x, y)); }
+		virtual void SetPositionY(int y) { SetPosition(vec2i(GetPositionX(), y)); }
 
 		// Set the window vertical (Y-axis) position, using an unsigned-integer
-		virtual void SetPositionY(uint y) { SetPosition(vec2i(position.x, y)); }
+		virtual void SetPositionY(uint y) { SetPosition(vec2i(GetPositionX(), y)); }
 
 		/**
 		 * @brief Returns the size of the Window, in screen pixels.
 		 * @return Vector 2D of unsigned-integers
 		*/
-		inline const vec2u& GetSize() const { return size; }
+		inline vec2u GetSize() const { return size.load(std::memory_order_acquire); }
 
 		/**
 		 * @brief Returns the horizontal (X axis) size of the Window, in screen pixels.
 		 * @return Unsigned-integer of the width
 		*/
-		inline uint GetWidth() const { return size.x; }
+		inline uint GetWidth() const { return GetSize().x; }
 
 		/**
 		 * @brief Returns the vertical (Y axis) size of the Window, in screen pixels.
 		 * @return Unsigned-integer of the height
 		*/
-		inline uint GetHeight() const { return size.y; }
+		inline uint GetHeight() const { return GetSize().y; }
 
 		// Set the window size, using a vector-2D of unsigned-integers
 		virtual void SetSize(const vec2u& pos) = 0;
@@ -218,16 +261,16 @@ namespace crux {
 		virtual void SetSize(uint x, uint y) { SetSize(vec2u(x, y)); }
 		
 		// Set the window width (X-axis), using an integer
-		virtual void SetWidth(int x) { SetSize(vec2u(x, size.y)); }
+		virtual void SetWidth(int x) { SetSize(vec2u(x, GetHeight())); }
 
 		// Set the window width (X-axis), using an unsigned-integer
-		virtual void SetWidth(uint x) { SetSize(vec2u(x, size.y)); }
+		virtual void SetWidth(uint x) { SetSize(vec2u(x, GetHeight())); }
 
 		// Set the window height (Y-axis), using an integer
-		virtual void SetHeight(int y) { SetSize(vec2u(size.x, y)); }
+		virtual void SetHeight(int y) { SetSize(vec2u(GetWidth(), y)); }
 
 		// Set the window height (Y-axis), using an unsigned-integer
-		virtual void SetHeight(uint y) { SetSize(vec2u(size.x, y)); }
+		virtual void SetHeight(uint y) { SetSize(vec2u(GetWidth(), y)); }
 
 		/**
 		 * @brief Gets the windows properties and fills a WindowProperties object 
@@ -236,6 +279,36 @@ namespace crux {
 		*/
 		virtual WindowProperties GetProperties();
 
+		/**
+		 * @brief Starts a batch of property changes.
+		 * Until the matching EndUpdate, SetTitle/SetPosition/SetSize (and their
+		 * overloads) only record the new values, which the getters already
+		 * return. Calls nest, only the outermost EndUpdate applies the batch.
+		 * Must be called from the thread owning the window, like the setters.
+		*/
+		void BeginUpdate();
+
+		/**
+		 * @brief Ends a batch of property changes started by BeginUpdate.
+		 * The net change is applied with at most one title change and one
+		 * native move/resize, ie. SetWidth followed by SetHeight is a single
+		 * resize. Properties ending where they started are not applied at all.
+		*/
+		void EndUpdate();
+
+		// @return True between BeginUpdate and the outermost EndUpdate
+		inline bool IsUpdating() const { return updateDepth > 0; }
+
+		/**
+		 * @brief Changes the title, position and size in one batch, see BeginUpdate.
+		 * A position axis of POSITION_UNDEFINED, or a zero width or height, keeps
+		 * the current value, other negative positions reach monitors left of or above
+		 * the primary one. WindowProperties::positionCentered,
+		 * headless and threadedMessagePump only apply at creation and are ignored.
+		 * @param props The properties to apply
+		*/
+		void ApplyProperties(const WindowProperties& props);
+
 		/**
 		 * @brief Checks if the OS window wants to close the Window.
 		 * For most application, this marks the end of the application lifecycle
@@ -262,22 +335,194 @@ namespace crux {
 		 * @return An optional resulting in a void-pointer if a platform handle exists
 		*/
 		virtual crux::optional<void*> GetPlatformHandle() { return {}; }
+
+		/**
+		 * @brief Returns the CPU-side framebuffer software rendering should draw into.
+		 * The framebuffer is resized along with the window, so the pointer should
+		 * be fetched again after a size change.
+		 * @return Pointer to the framebuffer, or nullptr if the backend has none
+		*/
+		virtual Framebuffer* GetFramebuffer() { return nullptr; }
+
+		/**
+		 * @brief Presents the current framebuffer contents.
+		 * Without a MarkDirty call since the last Present, the whole framebuffer
+		 * is presented and its contents are undefined afterwards, the next frame
+		 * should be drawn in full.
+		 * Otherwise only the dirty rectangles are presented, and the framebuffer
+		 * keeps the presented image so the next frame only redraws what changes.
+		 * The first partial frame after a full one, or after a resize, must mark
+		 * the whole window. Clears the dirty region.
+		 * @return True if a frame was presented
+		*/
+		virtual bool Present() { return false; }
+
+		/**
+		 * @brief Marks part of the framebuffer as changed since the last Present.
+		 * Must be called from the thread drawing and presenting.
+		 * @param rect Changed pixels, clipped to the window size
+		*/
+		void MarkDirty(const PixelRect& rect);
+
+		// Marks the whole framebuffer as changed since the last Present
+		void MarkDirty();
+
+		// @return The rectangles Present will send, merged and clipped to the window
+		inline const DirtyRegion& GetDirtyRegion() const { return dirtyRegion; }
+
+		/**
+		 * @brief Processes pending OS messages, then moves as many queued events
+		 * as fit into the given span, oldest first.
+		 * With a threaded message pump the OS messages are already being
+		 * processed elsewhere, and only the queue is drained.
+		 * Events that do not fit stay queued for the next call. Never locks
+		 * or allocates, and must only be called from one thread at a time.
+		 * @param events Destination for the events
+		 * @return Number of events written
+		*/
+		std::size_t PollEvents(span<Event> events);
+
+		/**
+		 * @brief Returns how many events were dropped because the queue was full.
+		 * A non-zero value means PollEvents is not called often enough, or with
+		 * too small a span.
+		 * @return Dropped event count since creation
+		*/
+		inline uint64 GetDroppedEventCount() const { return droppedEvents.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief Checks if the OS message pump runs on its own thread,
+		 * see WindowProperties::threadedMessagePump.
+		 * @return True if a message thread is running for this window
+		*/
+		inline bool IsMessageThreaded() const { return messageThreaded; }
 		
 	protected:
 		Window(const WindowProperties& props);
 		virtual ~Window() = default;
 
-	private:
-		// Current title of the window
+		/**
+		 * @brief Runs the platform message loop until no messages are pending,
+		 * translating them into events with PushEvent.
+		 * Called by PollEvents. Implemented by the platform-specific classes.
+		*/
+		virtual void PumpMessages() {}
+
+		/**
+		 * @brief Queues an event for PollEvents. Only the thread running the
+		 * message loop may push.
+		 * @return False if the queue was full and the event was dropped
+		*/
+		bool PushEvent(const Event& event);
+
+		// Events waiting for PollEvents, produced by the message loop
+		spsc_queue<Event> events{ EVENT_QUEUE_CAPACITY };
+
+		// Events that did not fit in the queue
+		std::atomic<uint64> droppedEvents{ 0 };
+
+		/**
+		 * @brief A property change marshalled to the message thread.
+		*/
+		enum class WindowCommandType : uint8bit {
+			SET_TITLE,
+			SET_POSITION,
+			SET_SIZE,
+
+			// Moves and resizes in one native call, from a batch (see EndUpdate)
+			SET_BOUNDS,
+		};
+
+		struct WindowCommand {
+			WindowCommandType type;
+
+			// Position or size, depending on the type. Unused by SET_TITLE
+			int x;
+			int y;
+
+			// Size for SET_BOUNDS, where x and y hold the position
+			int width = 0;
+			int height = 0;
+		};
+
+		/**
+		 * @brief Applies a command straight away, or queues it for the message
+		 * thread when there is one. Only the owning thread may submit.
+		 * @param command Command to apply
+		 * @param newTitle Title to apply for WindowCommandType::SET_TITLE
+		*/
+		void SubmitCommand(const WindowCommand& command, const string& newTitle);
+
+		/**
+		 * @brief Queues a command for the message thread and wakes it.
+		 * Only the thread owning the window (calling the setters) may queue.
+		 * Spins if the queue is full, which takes a burst of setters
+		 * faster than the message thread applies them.
+		 * @param command Command to apply on the message thread
+		*/
+		void QueueCommand(const WindowCommand& command);
+
+		/**
+		 * @brief Queues a WindowCommandType::SET_TITLE command with the given title.
+		 * @param newTitle Title for the message thread to apply
+		*/
+		void QueueTitleCommand(const string& newTitle);
+
+		/**
+		 * @brief Applies every queued command through ApplyCommand.
+		 * Called by the message thread after being woken.
+		*/
+		void ApplyCommands();
+
+		/**
+		 * @brief Performs a queued property change on the message thread.
+		 * Implemented by the platform-specific classes using a message thread,
+		 * which receive the command and the title to apply for WindowCommandType::SET_TITLE.
+		*/
+		virtual void ApplyCommand(const WindowCommand&, const string&) {}
+
+		/**
+		 * @brief Interrupts the message thread's wait for OS messages so
+		 * queued commands are applied promptly.
+		*/
+		virtual void WakeMessageThread() {}
+
+		// Commands from the owning thread, consumed by the message thread
+		spsc_queue<WindowCommand> commands{ 64 };
+
+		// Latest title passed to SetTitle, handed to the message thread
+		std::string pendingTitle;
+		std::mutex pendingTitleLock;
+
+		// Set by backends once their message thread is running
+		bool messageThreaded = false;
+
+		// The message thread, when WindowProperties::threadedMessagePump is used
+		std::thread messageThread;
+
+		// Current title of the window, only touched by the owning thread
 		std::string title;
 
-		// The position of the window, on screen.
-		vec2i position;
+		// The position of the window, on screen. Published by the message thread
+		std::atomic<vec2i> position;
 
-		// The size of the window, in screen pixels.
-		vec2u size;
+		// The size of the window, in screen pixels. Published by the message thread
+		std::atomic<vec2u> size;
 
 		// Does the window want to close?
 		std::atomic_bool wantsToClose;
+
+		// Changed pixels since the last Present, only touched by the owning thread
+		DirtyRegion dirtyRegion;
+
+		// BeginUpdate calls without their EndUpdate yet, only touched by the owning thread
+		uint updateDepth = 0;
+
+		// Properties as they were at the outermost BeginUpdate, compared against by EndUpdate
+		struct {
+			std::string title;
+			vec2i position{ 0, 0 };
+			vec2u size{ 0u, 0u };
+		} updateStart;
 	};
 }
\ No newline at end of file
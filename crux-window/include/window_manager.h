@@ -0,0 +1,212 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <crux-common/types.h>
+#include <crux-common/optional.h>
+#include <crux-common/span.h>
+
+#include "event.h"
+#include "window.h"
+
+namespace crux {
+	/**
+	 * @brief A display attached to the desktop, as reported by the OS.
+	*/
+	struct MonitorInfo {
+		// Dots per inch that 100% scaling is rendered at
+		static constexpr uint DefaultDpi = 96;
+
+		// OS name of the output, ie. "DP-1" or "\\.\DISPLAY1"
+		std::string name;
+
+		// Top-left corner on the virtual desktop, in screen pixels
+		vec2i position{ 0, 0 };
+
+		// Resolution in pixels
+		vec2u size{ 0u, 0u };
+
+		// Physical size in millimetres, 0 when unknown. Often only approximate, as reported by the display
+		vec2u physicalSize{ 0u, 0u };
+
+		// Dots per inch content should be drawn at, the user's scaling rather than the physical density.
+		// DefaultDpi when the OS does not say
+		uint dpi = DefaultDpi;
+
+		// Refresh rate in hertz, 0 when unknown
+		double refreshRate = 0.0;
+
+		// True for the monitor the OS considers primary
+		bool primary = false;
+
+		// @return Content scale, ie. 1.5 at 144 DPI
+		inline float GetScale() const { return (float)dpi / (float)DefaultDpi; }
+
+		// @return The monitor's area on the virtual desktop
+		inline PixelRect GetBounds() const { return PixelRect::FromSize(position.x, position.y, size.x, size.y); }
+	};
+
+	/**
+	 * @brief Identifies a window owned by a WindowManager.
+	 * Stays safe to use after the window is destroyed, the manager then
+	 * no longer resolves it, even if the slot was reused.
+	*/
+	struct WindowId {
+		static constexpr uint32bit InvalidIndex = ~(uint32bit)0;
+
+		uint32bit index = InvalidIndex;
+		uint32bit generation = 0;
+
+		// @return True if the id was ever handed out, not that the window is still alive
+		inline constexpr bool IsValid() const { return index != InvalidIndex; }
+
+		friend constexpr bool operator==(const WindowId&, const WindowId&) = default;
+	};
+
+	// An event along with the window it came from
+	struct WindowEvent {
+		WindowId window;
+		Event event;
+	};
+
+	/**
+	 * @brief Owns a set of windows and pumps them together.
+	 *
+	 * Windows are kept in flat arrays, ordered by nothing in particular,
+	 * and ids resolve through a generation-checked slot table, so creating,
+	 * destroying and iterating never walks a node based container. Slots
+	 * and array storage are reused, after warm-up tracking a window does
+	 * not allocate.
+	 *
+	 * PollEvents pumps the OS messages of every window in one pass instead
+	 * of one pass per window: on X11 a single poll() covers every display
+	 * connection and only the ones with input are read, on Win32 one
+	 * message loop serves all the windows of the thread.
+	 *
+	 * Not thread-safe, must be used from the thread owning the windows.
+	*/
+	class WindowManager {
+	public:
+		WindowManager() = default;
+		~WindowManager();
+
+		WindowManager(const WindowManager&) = delete;
+		WindowManager& operator=(const WindowManager&) = delete;
+
+		/**
+		 * @brief Creates a window with Window::Create and takes ownership of it.
+		 * @param[in] props The properties of the window to set for creation
+		 * @return Id of the window, empty if it could not be created
+		*/
+		optional<WindowId> Create(const WindowProperties& props);
+
+		/**
+		 * @brief Takes ownership of a window created elsewhere, ie. with Window::CreateAsync.
+		 * A window added twice gets two ids, and is pumped twice.
+		 * @param window The window to track
+		 * @return Id of the window, invalid if window is null
+		*/
+		WindowId Add(WinPtr window);
+
+		/**
+		 * @brief Stops tracking a window, destroying it unless a WinPtr to it is held elsewhere.
+		 * Events still queued for it are dropped.
+		 * @return False if the id does not resolve
+		*/
+		bool Destroy(WindowId id);
+
+		/**
+		 * @brief Destroys every window that wants to close, see Window::WantsToClose.
+		 * @return Number of windows destroyed
+		*/
+		std::size_t DestroyClosed();
+
+		// Destroys every window
+		void Clear();
+
+		// @return The window, or nullptr if the id does not resolve
+		Window* Get(WindowId id) const;
+
+		// @return Shared ownership of the window, empty if the id does not resolve
+		WinPtr GetShared(WindowId id) const;
+
+		// @return True if the id resolves to a live window
+		inline bool Contains(WindowId id) const { return Get(id) != nullptr; }
+
+		// @return Number of windows
+		inline std::size_t GetCount() const { return windows.size(); }
+
+		// @return Every window, in the same order as GetIds()
+		inline span<Window* const> GetWindows() const { return span<Window* const>(windows.data(), windows.size()); }
+
+		// @return The id of every window, in the same order as GetWindows()
+		inline span<const WindowId> GetIds() const { return span<const WindowId>(ids.data(), ids.size()); }
+
+		/**
+		 * @brief Processes pending OS messages of every window in one pass, then
+		 * moves as many queued events as fit into the given span.
+		 * Windows are drained in turn, starting one further each call, so a
+		 * window flooding events cannot starve the others. Events that do not
+		 * fit stay queued for the next call.
+		 * @param events Destination for the events
+		 * @return Number of events written
+		*/
+		std::size_t PollEvents(span<WindowEvent> events);
+
+		/**
+		 * @brief Returns the monitors of the desktop, enumerated on the first call.
+		 * Empty without a display server, ie. on a headless machine.
+		 * @return The monitors, the primary one first
+		*/
+		span<const MonitorInfo> GetMonitors();
+
+		/**
+		 * @brief Enumerates the monitors again, ie. after a monitor was plugged in
+		 * or its settings changed.
+		*/
+		void RefreshMonitors();
+
+		/**
+		 * @brief Finds the monitor a window is mostly on, by the center of the window.
+		 * @return The monitor, or nullptr if the id does not resolve or no monitor holds the center
+		*/
+		const MonitorInfo* GetMonitorFor(WindowId id);
+
+		/**
+		 * @brief Enumerates the monitors of the desktop through the OS.
+		 * @return The monitors, the primary one first, empty without a display server
+		*/
+		static std::vector<MonitorInfo> EnumerateMonitors();
+
+	private:
+		// Slot table entry, indexed by WindowId::index
+		struct Slot {
+			// Position in the dense arrays, while alive
+			uint32bit dense = 0;
+
+			// Bumped on destroy, so stale ids stop resolving
+			uint32bit generation = 0;
+		};
+
+		// Removes the window at a dense position, swapping the last one into its place
+		void RemoveAt(std::size_t dense);
+
+		// Dense arrays, one entry per window in the same order
+		std::vector<Window*> windows;
+		std::vector<WindowId> ids;
+		std::vector<WinPtr> owners;
+
+		// Backend windows without a message thread, the ones PollEvents pumps
+		std::vector<Window*> pumped;
+
+		std::vector<Slot> slots;
+		std::vector<uint32bit> freeSlots;
+
+		// Window PollEvents starts draining at, rotated every call
+		std::size_t nextDrain = 0;
+
+		std::vector<MonitorInfo> monitors;
+		bool monitorsEnumerated = false;
+	};
+}
@@ -1,7 +1,7 @@
 project "crux-window"
     kind "StaticLib"
     language "C++"
-    cppdialect "C++17"
+    cppdialect "C++20"
 
     staticruntime "On"
 
@@ -20,6 +20,7 @@ project "crux-window"
     includedirs {
         "include",
 
+        "%{wks.location}/include",
         "%{wks.location}/crux-common/include"
     }
 
@@ -29,9 +30,17 @@ project "crux-window"
 
     filter "system:windows"
         removefiles {
-            "**.nix.h"
-            "**.nix.cpp"
-            "**.mac.h"
+            "**.nix.h",
+            "**.nix.cpp",
+            "**.mac.h",
+            "**.mac.cpp"
+        }
+
+    filter "system:linux"
+        removefiles {
+            "**.win32.h",
+            "**.win32.cpp",
+            "**.mac.h",
             "**.mac.cpp"
         }
 
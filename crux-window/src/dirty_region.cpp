@@ -0,0 +1,69 @@
+#include "dirty_region.h"
+
+namespace crux {
+	void DirtyRegion::Add(const PixelRect& rect) {
+		if (rect.IsEmpty())
+			return;
+
+		PixelRect merged = rect;
+		for (std::size_t i = 0; i < count;) {
+			const PixelRect& held = rects[i];
+			if (held.Contains(merged))
+				return;
+
+			//Merging never presents a pixel twice, and is free when the union is no bigger than both apart
+			const PixelRect joined = held.Union(merged);
+			if (held.Overlaps(merged) || joined.GetArea() <= held.GetArea() + merged.GetArea()) {
+				merged = joined;
+				Remove(i);
+				i = 0; //The union may now reach rectangles already passed
+				continue;
+			}
+			++i;
+		}
+
+		rects[count++] = merged;
+		if (count <= MaxRects)
+			return;
+
+		//One over, merge the pair whose union adds the fewest pixels, then merge again from the top
+		std::size_t first = 0, second = 1;
+		uint64bit bestGrowth = ~(uint64bit)0;
+		for (std::size_t i = 0; i < count; ++i) {
+			for (std::size_t j = i + 1; j < count; ++j) {
+				const uint64bit growth = rects[i].Union(rects[j]).GetArea() - rects[i].GetArea() - rects[j].GetArea();
+				if (growth < bestGrowth) {
+					bestGrowth = growth;
+					first = i;
+					second = j;
+				}
+			}
+		}
+
+		const PixelRect joined = rects[first].Union(rects[second]);
+		Remove(second);
+		Remove(first);
+		Add(joined);
+	}
+
+	uint64bit DirtyRegion::GetArea() const {
+		uint64bit area = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			area += rects[i].GetArea();
+		return area;
+	}
+
+	PixelRect DirtyRegion::GetBounds() const {
+		if (count == 0)
+			return PixelRect();
+
+		PixelRect bounds = rects[0];
+		for (std::size_t i = 1; i < count; ++i)
+			bounds = bounds.Union(rects[i]);
+		return bounds;
+	}
+
+	void DirtyRegion::Remove(std::size_t index) {
+		rects[index] = rects[--count];
+	}
+}
@@ -0,0 +1,117 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace crux {
+	namespace {
+		// Swaps the R and B channels, converting between RGBA8 and BGRA8
+		inline uint32bit SwapRedBlue(uint32bit p) {
+			return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+		}
+	}
+
+	Framebuffer::Framebuffer(const vec2u& size, PixelFormat format) : format(format) {
+		Resize(size);
+	}
+
+	void Framebuffer::Resize(const vec2u& newSize) {
+		const uint newStride = (newSize.x + RowAlignment - 1) / RowAlignment * RowAlignment;
+		const std::size_t required = (std::size_t)newStride * newSize.y;
+
+		if (required > capacity || !storage) {
+			storage.reset(required
+				? static_cast<uint32bit*>(::operator new(required * sizeof(uint32bit), std::align_val_t(Alignment)))
+				: nullptr);
+			capacity = required;
+		}
+
+		pixels = storage.get();
+		size = newSize;
+		stride = newStride;
+	}
+
+	void Framebuffer::Attach(uint32bit* external, const vec2u& newSize, uint newStride) {
+		storage.reset();
+		capacity = 0;
+
+		pixels = external;
+		size = newSize;
+		stride = std::max(newStride, newSize.x);
+	}
+
+	void Framebuffer::Swap(Framebuffer& other) noexcept {
+		std::swap(storage, other.storage);
+		std::swap(capacity, other.capacity);
+		std::swap(pixels, other.pixels);
+		std::swap(size, other.size);
+		std::swap(stride, other.stride);
+		std::swap(format, other.format);
+	}
+
+	void Framebuffer::Clear(uint32bit pixel) {
+		for (uint y = 0; y < size.y; ++y)
+			std::fill_n(GetRow(y), size.x, pixel);
+	}
+
+	bool Framebuffer::CopyFrom(const Framebuffer& other) {
+		return CopyRect(other, PixelRect::FromSize(0, 0, size.x, size.y));
+	}
+
+	bool Framebuffer::CopyRect(const Framebuffer& other, const PixelRect& rect) {
+		if (other.size != size)
+			return false;
+
+		const PixelRect clipped = rect.Intersect(PixelRect::FromSize(0, 0, size.x, size.y));
+		if (clipped.IsEmpty())
+			return true;
+
+		const uint width = (uint)clipped.GetWidth();
+		if (other.format == format && other.stride == stride && width == size.x) {
+			//Whole rows with the same padding are one contiguous block
+			const std::size_t count = (std::size_t)(clipped.GetHeight() - 1) * stride + width;
+			std::memcpy(GetRow((uint)clipped.min.y), other.GetRow((uint)clipped.min.y), count * sizeof(uint32bit));
+			return true;
+		}
+
+		for (int y = clipped.min.y; y < clipped.max.y; ++y) {
+			const uint32bit* src = other.GetRow((uint)y) + clipped.min.x;
+			uint32bit* dst = GetRow((uint)y) + clipped.min.x;
+			if (other.format == format) {
+				std::memcpy(dst, src, (std::size_t)width * sizeof(uint32bit));
+			} else {
+				for (uint x = 0; x < width; ++x)
+					dst[x] = SwapRedBlue(src[x]);
+			}
+		}
+		return true;
+	}
+
+	bool Framebuffer::WritePPM(const std::string& path) const {
+		std::FILE* file = std::fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		std::fprintf(file, "P6\n%u %u\n255\n", size.x, size.y);
+
+		//Channel byte offsets within a pixel word for this format
+		const int r = format == PixelFormat::RGBA8 ? 0 : 16;
+		const int b = format == PixelFormat::RGBA8 ? 16 : 0;
+
+		std::vector<uint8bit> row((std::size_t)size.x * 3);
+		bool ok = true;
+		for (uint y = 0; y < size.y && ok; ++y) {
+			const uint32bit* src = GetRow(y);
+			for (uint x = 0; x < size.x; ++x) {
+				row[x * 3 + 0] = (uint8bit)(src[x] >> r);
+				row[x * 3 + 1] = (uint8bit)(src[x] >> 8);
+				row[x * 3 + 2] = (uint8bit)(src[x] >> b);
+			}
+			ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+		}
+
+		return std::fclose(file) == 0 && ok;
+	}
+}
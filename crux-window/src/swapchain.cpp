@@ -0,0 +1,207 @@
+#include "swapchain.h"
+
+#include <algorithm>
+
+#include <crux-common/clock.h>
+#include <crux-common/log.h>
+#include <crux-common/memory_tracking.h>
+#include <crux-common/profile.h>
+
+#include "window.headless.h"
+
+namespace crux {
+	optional<SwapchainPtr> Swapchain::Create(WinPtr window, const SwapchainProperties& props) {
+		CRUX_PROFILE_SCOPE("Swapchain::Create");
+		CRUX_MEMORY_TAG(WINDOW);
+
+		if (!window)
+			return {};
+
+		Framebuffer* target = window->GetFramebuffer();
+		if (!target) {
+			CRUX_LOG_ERROR("Swapchain needs a window with a framebuffer");
+			return {};
+		}
+
+		//Presenting from another thread races the owning thread's message pump on X11 and Win32
+		const bool threaded = props.presentThread && props.mode != PresentMode::IMMEDIATE;
+		if (threaded && !window->IsMessageThreaded() && !dynamic_cast<WindowHeadless*>(window.get())) {
+			CRUX_LOG_ERROR("Swapchain present thread needs a window with threadedMessagePump");
+			return {};
+		}
+
+		SwapchainPtr swapchain(new Swapchain(window, props, target->GetFormat()));
+		if (threaded)
+			swapchain->presentThread = std::thread(&Swapchain::PresentLoop, swapchain.get(), props.refreshRate);
+		return { std::move(swapchain) };
+	}
+
+	Swapchain::Swapchain(WinPtr window, const SwapchainProperties& props, PixelFormat format)
+		: window(std::move(window)), mode(props.mode), bufferCount(std::clamp(props.bufferCount, 2u, MaxBuffers)) {
+		const vec2u size = this->window->GetSize();
+		for (uint i = 0; i < bufferCount; ++i) {
+			buffers[i] = Framebuffer(size, format);
+			freeList[freeCount++] = i;
+		}
+	}
+
+	Swapchain::~Swapchain() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		frameQueued.notify_all();
+
+		if (presentThread.joinable())
+			presentThread.join();
+	}
+
+	Framebuffer* Swapchain::Acquire() {
+		if (acquired >= 0)
+			return &buffers[acquired];
+
+		uint index;
+		{
+			CRUX_PROFILE_SCOPE("Swapchain::Acquire");
+			std::unique_lock<std::mutex> guard(lock);
+			bufferFreed.wait(guard, [this] { return freeCount > 0; });
+			index = freeList[--freeCount];
+		}
+		return TakeBuffer(index);
+	}
+
+	Framebuffer* Swapchain::TryAcquire() {
+		if (acquired >= 0)
+			return &buffers[acquired];
+
+		uint index;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (freeCount == 0)
+				return nullptr;
+			index = freeList[--freeCount];
+		}
+		return TakeBuffer(index);
+	}
+
+	Framebuffer* Swapchain::TakeBuffer(uint index) {
+		acquired = (int)index;
+
+		//Follow a resize here, on the render thread, rather than while presenting
+		Framebuffer& buffer = buffers[index];
+		const vec2u size = window->GetSize();
+		if (buffer.GetSize() != size)
+			buffer.Resize(size);
+		return &buffer;
+	}
+
+	bool Swapchain::Present() {
+		if (acquired < 0)
+			return false;
+
+		const uint index = (uint)acquired;
+		acquired = -1;
+
+		if (mode == PresentMode::IMMEDIATE)
+			return PresentBuffer(index);
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (mode == PresentMode::MAILBOX && queueCount > 0) {
+				//The waiting frame was never shown, the new one takes its place
+				Release(queue[--queueCount]);
+				dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			queue[queueCount++] = index;
+		}
+		frameQueued.notify_one();
+		return true;
+	}
+
+	bool Swapchain::PresentQueued() {
+		uint index;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (queueCount == 0)
+				return false;
+
+			index = PopQueued();
+		}
+		return PresentBuffer(index);
+	}
+
+	SwapchainStats Swapchain::GetStats() const {
+		SwapchainStats stats;
+		stats.presented = presented.load(std::memory_order_relaxed);
+		stats.dropped = dropped.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	bool Swapchain::PresentBuffer(uint index) {
+		CRUX_PROFILE_SCOPE("Swapchain::Present");
+
+		//Fetched per frame, the window's framebuffer follows its size
+		Framebuffer* target = window->GetFramebuffer();
+		const bool copied = target && target->CopyFrom(buffers[index]);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			Release(index);
+		}
+
+		//Drawn before a resize, the render thread draws the next one at the new size
+		if (!copied) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		if (!window->Present())
+			return false;
+
+		presented.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	void Swapchain::Release(uint index) {
+		freeList[freeCount++] = index;
+		bufferFreed.notify_one();
+	}
+
+	uint Swapchain::PopQueued() {
+		const uint index = queue[0];
+		std::copy(queue + 1, queue + queueCount, queue);
+		--queueCount;
+		return index;
+	}
+
+	void Swapchain::PresentLoop(double refreshRate) {
+		CRUX_PROFILE_THREAD("Swapchain Present");
+
+		//Paced here rather than with a FrameTimer, whose Tick marks profiler frames that belong to the render loop
+		const uint64bit period = clock::FromHertz(refreshRate);
+		uint64bit deadline = 0;
+		for (;;) {
+			uint index;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				frameQueued.wait(guard, [this] { return stopping || queueCount > 0; });
+				if (stopping)
+					return;
+
+				index = PopQueued();
+			}
+
+			PresentBuffer(index);
+			if (period == 0)
+				continue;
+
+			//Waits after each present, frames queued meanwhile are shown in the next slot.
+			//After idling or running late by more than a period the slots restart from now
+			const uint64bit now = clock::Now();
+			const uint64bit next = deadline + period;
+			deadline = (deadline == 0 || now >= next) ? now + period : next;
+
+			CRUX_PROFILE_SCOPE("Swapchain::Wait");
+			clock::WaitUntil(deadline);
+		}
+	}
+}
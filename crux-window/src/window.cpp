@@ -1,39 +1,175 @@
 #include "window.h"
 
+#include <crux-common/memory_tracking.h>
 #include <crux-common/platform.h>
+#include <crux-common/profile.h>
+
+#include "window.headless.h"
 
 #if CRUX_WIN32
 #include "window.win32.h"
+#elif CRUX_UNIX
+#include "window.nix.h"
 #endif
 
 namespace crux {
-	const vec2i WindowProperties::POSITION_UNDEFINED_VEC = vec2i{
-		WindowProperties::POSITION_UNDEFINED, 
-		WindowProperties::POSITION_UNDEFINED 
-	};
-
 	optional<WinPtr> Window::Create(const WindowProperties& props) {
+		CRUX_PROFILE_SCOPE("Window::Create");
+		CRUX_MEMORY_TAG(WINDOW);
+
+		if (props.headless) {
+			return {
+				std::make_shared<WindowHeadless>(props)
+			};
+		}
+
 #if CRUX_WIN32
 		return {
 			std::make_shared<internal::win32::WindowWin32>(props)
 		};
+#elif CRUX_UNIX
+		//No display server reachable (ie. $DISPLAY unset), no window
+		auto window = std::make_shared<internal::nix::WindowX11>(props);
+		if (!window->GetPlatformHandle())
+			return {};
+		return { window };
 #endif
 		
 		return {};
 	}
 
+	task<optional<WinPtr>> Window::CreateAsync(WindowProperties props, JobSystem& jobs) {
+#if CRUX_WIN32
+		//Only the dedicated message thread can pump a window created on a worker
+		if (!props.headless)
+			props.threadedMessagePump = true;
+#endif
+
+		co_await Schedule(jobs);
+		co_return Create(props);
+	}
+
 	Window::Window(const WindowProperties& props) {
 		title = props.title;
 		size = vec2u(props.width, props.height);
 		position = vec2i(props.positionX, props.positionY);
+		wantsToClose = false;
+	}
+
+	std::size_t Window::PollEvents(span<Event> out) {
+		CRUX_PROFILE_SCOPE("Window::PollEvents");
+		if (!messageThreaded)
+			PumpMessages();
+		return events.pop_n(out);
+	}
+
+	void Window::BeginUpdate() {
+		if (updateDepth++ > 0)
+			return;
+
+		updateStart.title = title;
+		updateStart.position = GetPosition();
+		updateStart.size = GetSize();
+	}
+
+	void Window::EndUpdate() {
+		if (updateDepth == 0 || --updateDepth > 0)
+			return;
+
+		CRUX_PROFILE_SCOPE("Window::EndUpdate");
+		if (title != updateStart.title)
+			SubmitCommand({ WindowCommandType::SET_TITLE, 0, 0 }, title);
+
+		const vec2i newPos = GetPosition();
+		const vec2u newSize = GetSize();
+		const bool move = newPos != updateStart.position;
+		const bool resize = newSize != updateStart.size;
+		if (move && resize)
+			SubmitCommand({ WindowCommandType::SET_BOUNDS, newPos.x, newPos.y, (int)newSize.x, (int)newSize.y }, title);
+		else if (move)
+			SubmitCommand({ WindowCommandType::SET_POSITION, newPos.x, newPos.y }, title);
+		else if (resize)
+			SubmitCommand({ WindowCommandType::SET_SIZE, (int)newSize.x, (int)newSize.y }, title);
+	}
+
+	void Window::ApplyProperties(const WindowProperties& props) {
+		CRUX_PROFILE_SCOPE("Window::ApplyProperties");
+		const vec2i curPos = GetPosition();
+		const vec2u curSize = GetSize();
+
+		BeginUpdate();
+		SetTitle(props.title);
+		SetPosition(vec2i(
+			props.positionX == WindowProperties::POSITION_UNDEFINED ? curPos.x : props.positionX,
+			props.positionY == WindowProperties::POSITION_UNDEFINED ? curPos.y : props.positionY));
+		SetSize(vec2u(
+			props.width == 0 ? curSize.x : props.width,
+			props.height == 0 ? curSize.y : props.height));
+		EndUpdate();
+	}
+
+	void Window::MarkDirty(const PixelRect& rect) {
+		const vec2u bounds = GetSize();
+		dirtyRegion.Add(rect.Intersect(PixelRect::FromSize(0, 0, bounds.x, bounds.y)));
+	}
+
+	void Window::MarkDirty() {
+		const vec2u bounds = GetSize();
+		dirtyRegion.Add(PixelRect::FromSize(0, 0, bounds.x, bounds.y));
+	}
+
+	bool Window::PushEvent(const Event& event) {
+		if (events.try_push(event))
+			return true;
+
+		droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	void Window::QueueCommand(const WindowCommand& command) {
+		while (!commands.try_push(command)) {
+			WakeMessageThread();
+			std::this_thread::yield();
+		}
+		WakeMessageThread();
+	}
+
+	void Window::SubmitCommand(const WindowCommand& command, const string& newTitle) {
+		if (!messageThreaded)
+			ApplyCommand(command, newTitle);
+		else if (command.type == WindowCommandType::SET_TITLE)
+			QueueTitleCommand(newTitle);
+		else
+			QueueCommand(command);
+	}
+
+	void Window::QueueTitleCommand(const string& newTitle) {
+		{
+			std::lock_guard<std::mutex> lock(pendingTitleLock);
+			pendingTitle = newTitle;
+		}
+		QueueCommand({ WindowCommandType::SET_TITLE, 0, 0 });
+	}
+
+	void Window::ApplyCommands() {
+		WindowCommand command;
+		while (commands.try_pop(command)) {
+			std::string newTitle;
+			if (command.type == WindowCommandType::SET_TITLE) {
+				std::lock_guard<std::mutex> lock(pendingTitleLock);
+				newTitle = pendingTitle;
+			}
+			ApplyCommand(command, newTitle);
+		}
 	}
 
 	WindowProperties Window::GetProperties() {
 		WindowProperties props{
 			title,
-			size,
-			position,
+			GetSize(),
+			GetPosition(),
 		};
+		props.threadedMessagePump = messageThreaded;
 
 		return props;
 	}
@@ -0,0 +1,101 @@
+#include "window.headless.h"
+
+#include <cstdio>
+#include <vector>
+
+#include <crux-common/profile.h>
+
+namespace crux {
+	WindowHeadless::WindowHeadless(const WindowProperties& props) : Window(props) {
+		backBuffer.Resize(size);
+	}
+
+	void WindowHeadless::SetTitle(const string& newTitle) {
+		CRUX_PROFILE_SCOPE("Window::SetTitle");
+		title = newTitle;
+	}
+
+	void WindowHeadless::SetPosition(const vec2i& newPos) {
+		CRUX_PROFILE_SCOPE("Window::SetPosition");
+		position = newPos;
+		if (!IsUpdating())
+			ApplyCommand({ WindowCommandType::SET_POSITION, newPos.x, newPos.y }, title);
+	}
+
+	void WindowHeadless::SetSize(const vec2u& newSize) {
+		CRUX_PROFILE_SCOPE("Window::SetSize");
+		size = newSize;
+		if (!IsUpdating())
+			ApplyCommand({ WindowCommandType::SET_SIZE, (int)newSize.x, (int)newSize.y }, title);
+	}
+
+	void WindowHeadless::ApplyCommand(const WindowCommand& command, const string& newTitle) {
+		//No OS window, only the events a native backend would report back
+		Event event;
+		switch (command.type) {
+		case WindowCommandType::SET_TITLE:
+			return;
+
+		case WindowCommandType::SET_POSITION:
+			event.type = EventType::MOVE;
+			event.position = { command.x, command.y };
+			PushEvent(event);
+			return;
+
+		case WindowCommandType::SET_SIZE:
+			backBuffer.Resize(vec2u(command.x, command.y));
+			event.type = EventType::RESIZE;
+			event.size = { (uint)command.x, (uint)command.y };
+			PushEvent(event);
+			return;
+
+		case WindowCommandType::SET_BOUNDS:
+			ApplyCommand({ WindowCommandType::SET_POSITION, command.x, command.y }, newTitle);
+			ApplyCommand({ WindowCommandType::SET_SIZE, command.width, command.height }, newTitle);
+			return;
+		}
+	}
+
+	bool WindowHeadless::InjectEvent(const Event& event) {
+		if (event.type == EventType::CLOSE)
+			wantsToClose = true;
+		return PushEvent(event);
+	}
+
+	WindowProperties WindowHeadless::GetProperties() {
+		WindowProperties props = Window::GetProperties();
+		props.headless = true;
+		return props;
+	}
+
+	bool WindowHeadless::Present() {
+		CRUX_PROFILE_SCOPE("Window::Present");
+		if (dirtyRegion.IsEmpty()) {
+			//The previous front buffer becomes the next back buffer, no pixels are copied
+			frontBuffer.Swap(backBuffer);
+			if (backBuffer.GetSize() != GetSize())
+				backBuffer.Resize(size);
+		} else if (frontBuffer.GetSize() != backBuffer.GetSize()) {
+			//First frame, or the first since a resize
+			frontBuffer.Resize(backBuffer.GetSize());
+			frontBuffer.CopyFrom(backBuffer);
+		} else if (dirtyRegion.GetArea() * 4 >= (uint64bit)backBuffer.GetWidth() * backBuffer.GetHeight() * 3) {
+			//Most of the surface changed, one straight copy beats walking the rectangles row by row
+			frontBuffer.CopyFrom(backBuffer);
+		} else {
+			//Only the changed pixels, the back buffer keeps the frame for the next one to build on
+			for (const PixelRect& rect : dirtyRegion.GetRects())
+				frontBuffer.CopyRect(backBuffer, rect);
+		}
+		dirtyRegion.Clear();
+
+		if (!dumpPattern.empty()) {
+			std::vector<char> path(dumpPattern.size() + 32);
+			std::snprintf(path.data(), path.size(), dumpPattern.c_str(), (unsigned long long)presentCount);
+			frontBuffer.WritePPM(path.data());
+		}
+
+		++presentCount;
+		return true;
+	}
+}
@@ -0,0 +1,1011 @@
+#include <crux-common/platform.h>
+#if CRUX_UNIX
+#include "window.nix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+
+#include <crux-common/dynamic_library.h>
+#include <crux-common/log.h>
+#include <crux-common/memory_tracking.h>
+#include <crux-common/profile.h>
+
+namespace crux::internal::nix {
+	namespace {
+		// Presentation double-buffers, one being drawn while the other is read by the server
+		constexpr int SurfaceCount = 2;
+
+		// Set by the error handler while attaching a shared segment
+		bool ShmAttachFailed = false;
+
+		int ShmAttachErrorHandler(Display*, XErrorEvent*) {
+			ShmAttachFailed = true;
+			return 0;
+		}
+
+		// XOpenDisplay with Xlib's thread support enabled first, which has to happen before any
+		// other Xlib call in the process and applies to every connection opened afterwards
+		Display* OpenDisplay() {
+			static std::once_flag threadsInitialized;
+			std::call_once(threadsInitialized, [] { XInitThreads(); });
+			return XOpenDisplay(nullptr);
+		}
+
+		/*
+		 * An X connection and the windows created on it. Events are read by
+		 * whichever window of the connection is pumped and routed to their
+		 * window by XID, so every window of a thread can share one socket.
+		 */
+		struct Connection {
+			Display* display = nullptr;
+
+			// Windows on the connection by XID
+			std::vector<std::pair<unsigned long, WindowX11*>> windows;
+
+			explicit Connection(Display* display) : display(display) {}
+			~Connection() { XCloseDisplay(display); }
+
+			Connection(const Connection&) = delete;
+			Connection& operator=(const Connection&) = delete;
+
+			// @return The window an event is for, or nullptr if it is already destroyed
+			WindowX11* Find(unsigned long xid) const {
+				for (const auto& entry : windows) {
+					if (entry.first == xid)
+						return entry.second;
+				}
+				return nullptr;
+			}
+
+			void Remove(WindowX11* window) {
+				auto found = std::find_if(windows.begin(), windows.end(), [window](const auto& entry) { return entry.second == window; });
+				if (found != windows.end()) {
+					*found = windows.back();
+					windows.pop_back();
+				}
+			}
+		};
+
+		/**
+		 * @brief Opens the connection for a window.
+		 * Windows pumped by the thread creating them share that thread's connection,
+		 * which closes with the last of them. A message thread reads its connection
+		 * without coordinating with anyone, so threaded windows get their own.
+		 * @return The connection, empty if the display cannot be opened
+		*/
+		std::shared_ptr<Connection> OpenConnection(bool threaded) {
+			thread_local std::weak_ptr<Connection> shared;
+			if (!threaded) {
+				if (auto existing = shared.lock())
+					return existing;
+			}
+
+			Display* display = OpenDisplay();
+			if (!display)
+				return {};
+
+			auto connection = std::make_shared<Connection>(display);
+			if (!threaded)
+				shared = connection;
+			return connection;
+		}
+
+		/*
+		 * The parts of XRandR 1.3 used for monitor enumeration, declared here as
+		 * libXrandr is loaded at runtime, so building needs no Xrandr headers
+		 * and running does not need the library.
+		 */
+		typedef XID RROutput;
+		typedef XID RRCrtc;
+		typedef XID RRMode;
+
+		// Output connection state, RR_Connected
+		constexpr unsigned short RRConnected = 0;
+
+		// Mode flags changing the lines per frame, RR_Interlace and RR_DoubleScan
+		constexpr unsigned long RRInterlace = 0x10;
+		constexpr unsigned long RRDoubleScan = 0x20;
+
+		struct XRRModeInfo {
+			RRMode id;
+			unsigned int width;
+			unsigned int height;
+			unsigned long dotClock;
+			unsigned int hSyncStart;
+			unsigned int hSyncEnd;
+			unsigned int hTotal;
+			unsigned int hSkew;
+			unsigned int vSyncStart;
+			unsigned int vSyncEnd;
+			unsigned int vTotal;
+			char* name;
+			unsigned int nameLength;
+			unsigned long modeFlags;
+		};
+
+		struct XRRScreenResources {
+			Time timestamp;
+			Time configTimestamp;
+			int ncrtc;
+			RRCrtc* crtcs;
+			int noutput;
+			RROutput* outputs;
+			int nmode;
+			XRRModeInfo* modes;
+		};
+
+		struct XRROutputInfo {
+			Time timestamp;
+			RRCrtc crtc;
+			char* name;
+			int nameLen;
+			unsigned long mm_width;
+			unsigned long mm_height;
+			unsigned short connection;
+			unsigned short subpixel_order;
+			int ncrtc;
+			RRCrtc* crtcs;
+			int nclone;
+			RROutput* clones;
+			int nmode;
+			int npreferred;
+			RRMode* modes;
+		};
+
+		struct XRRCrtcInfo {
+			Time timestamp;
+			int x;
+			int y;
+			unsigned int width;
+			unsigned int height;
+			RRMode mode;
+			unsigned short rotation;
+			int noutput;
+			RROutput* outputs;
+			unsigned short rotations;
+			int npossible;
+			RROutput* possible;
+		};
+
+		LazyLibrary Xrandr("libXrandr.so.2");
+
+		// Entry points of libXrandr, all null unless every one resolved
+		struct XrandrFunctions {
+			Status (*QueryVersion)(Display*, int*, int*) = nullptr;
+			XRRScreenResources* (*GetScreenResourcesCurrent)(Display*, ::Window) = nullptr;
+			void (*FreeScreenResources)(XRRScreenResources*) = nullptr;
+			XRROutputInfo* (*GetOutputInfo)(Display*, XRRScreenResources*, RROutput) = nullptr;
+			void (*FreeOutputInfo)(XRROutputInfo*) = nullptr;
+			XRRCrtcInfo* (*GetCrtcInfo)(Display*, XRRScreenResources*, RRCrtc) = nullptr;
+			void (*FreeCrtcInfo)(XRRCrtcInfo*) = nullptr;
+			RROutput (*GetOutputPrimary)(Display*, ::Window) = nullptr;
+
+			bool Load() {
+				const std::string_view names[] = {
+					"XRRQueryVersion",
+					"XRRGetScreenResourcesCurrent",
+					"XRRFreeScreenResources",
+					"XRRGetOutputInfo",
+					"XRRFreeOutputInfo",
+					"XRRGetCrtcInfo",
+					"XRRFreeCrtcInfo",
+					"XRRGetOutputPrimary",
+				};
+				void* symbols[8] = {};
+				if (Xrandr.GetSymbols(names, symbols) != 8)
+					return false;
+
+				QueryVersion = reinterpret_cast<decltype(QueryVersion)>(symbols[0]);
+				GetScreenResourcesCurrent = reinterpret_cast<decltype(GetScreenResourcesCurrent)>(symbols[1]);
+				FreeScreenResources = reinterpret_cast<decltype(FreeScreenResources)>(symbols[2]);
+				GetOutputInfo = reinterpret_cast<decltype(GetOutputInfo)>(symbols[3]);
+				FreeOutputInfo = reinterpret_cast<decltype(FreeOutputInfo)>(symbols[4]);
+				GetCrtcInfo = reinterpret_cast<decltype(GetCrtcInfo)>(symbols[5]);
+				FreeCrtcInfo = reinterpret_cast<decltype(FreeCrtcInfo)>(symbols[6]);
+				GetOutputPrimary = reinterpret_cast<decltype(GetOutputPrimary)>(symbols[7]);
+				return true;
+			}
+		};
+
+		// Frames per second of a mode, 0 if its timings are missing
+		double ModeRefreshRate(const XRRModeInfo& mode) {
+			double lines = (double)mode.vTotal;
+			if (mode.modeFlags & RRDoubleScan)
+				lines *= 2.0;
+			if (mode.modeFlags & RRInterlace)
+				lines /= 2.0;
+			if (mode.hTotal == 0 || lines <= 0.0)
+				return 0.0;
+			return (double)mode.dotClock / ((double)mode.hTotal * lines);
+		}
+
+		// Monitors through XRandR 1.3, one per active CRTC. Empty if the extension or library is missing
+		std::vector<MonitorInfo> EnumerateRandrMonitors(Display* display) {
+			std::vector<MonitorInfo> monitors;
+
+			int opcode, eventBase, errorBase;
+			if (!XQueryExtension(display, "RANDR", &opcode, &eventBase, &errorBase))
+				return monitors;
+
+			XrandrFunctions rr;
+			int major = 0, minor = 0;
+			if (!rr.Load() || !rr.QueryVersion(display, &major, &minor) || major < 1 || (major == 1 && minor < 3))
+				return monitors;
+
+			const ::Window root = DefaultRootWindow(display);
+			XRRScreenResources* resources = rr.GetScreenResourcesCurrent(display, root);
+			if (!resources)
+				return monitors;
+
+			const RROutput primary = rr.GetOutputPrimary(display, root);
+			std::vector<RRCrtc> seen;
+			for (int o = 0; o < resources->noutput; ++o) {
+				XRROutputInfo* output = rr.GetOutputInfo(display, resources, resources->outputs[o]);
+				if (!output)
+					continue;
+
+				//Mirrored outputs share a CRTC, report the picture once
+				if (output->connection == RRConnected && output->crtc && std::find(seen.begin(), seen.end(), output->crtc) == seen.end()) {
+					XRRCrtcInfo* crtc = rr.GetCrtcInfo(display, resources, output->crtc);
+					if (crtc && crtc->mode) {
+						seen.push_back(output->crtc);
+
+						MonitorInfo& monitor = monitors.emplace_back();
+						monitor.name.assign(output->name, (std::size_t)output->nameLen);
+						monitor.position = vec2i(crtc->x, crtc->y);
+						monitor.size = vec2u(crtc->width, crtc->height);
+						monitor.physicalSize = vec2u((uint)output->mm_width, (uint)output->mm_height);
+						monitor.primary = resources->outputs[o] == primary;
+						for (int m = 0; m < resources->nmode; ++m) {
+							if (resources->modes[m].id == crtc->mode) {
+								monitor.refreshRate = ModeRefreshRate(resources->modes[m]);
+								break;
+							}
+						}
+					}
+					if (crtc)
+						rr.FreeCrtcInfo(crtc);
+				}
+				rr.FreeOutputInfo(output);
+			}
+			rr.FreeScreenResources(resources);
+			return monitors;
+		}
+
+		Key TranslateKeySym(KeySym sym) {
+			if (sym >= XK_a && sym <= XK_z)
+				return (Key)((int)Key::A + (int)(sym - XK_a));
+			if (sym >= XK_A && sym <= XK_Z)
+				return (Key)((int)Key::A + (int)(sym - XK_A));
+			if (sym >= XK_0 && sym <= XK_9)
+				return (Key)((int)Key::NUM_0 + (int)(sym - XK_0));
+			if (sym >= XK_F1 && sym <= XK_F12)
+				return (Key)((int)Key::F1 + (int)(sym - XK_F1));
+
+			switch (sym) {
+			case XK_Escape: return Key::ESCAPE;
+			case XK_Return: return Key::ENTER;
+			case XK_KP_Enter: return Key::ENTER;
+			case XK_Tab: return Key::TAB;
+			case XK_BackSpace: return Key::BACKSPACE;
+			case XK_space: return Key::SPACE;
+			case XK_Insert: return Key::INSERT;
+			case XK_Delete: return Key::DEL;
+			case XK_Home: return Key::HOME;
+			case XK_End: return Key::END;
+			case XK_Page_Up: return Key::PAGE_UP;
+			case XK_Page_Down: return Key::PAGE_DOWN;
+			case XK_Left: return Key::LEFT;
+			case XK_Right: return Key::RIGHT;
+			case XK_Up: return Key::UP;
+			case XK_Down: return Key::DOWN;
+			case XK_Shift_L: return Key::LEFT_SHIFT;
+			case XK_Shift_R: return Key::RIGHT_SHIFT;
+			case XK_Control_L: return Key::LEFT_CONTROL;
+			case XK_Control_R: return Key::RIGHT_CONTROL;
+			case XK_Alt_L: return Key::LEFT_ALT;
+			case XK_Alt_R: return Key::RIGHT_ALT;
+			default: return Key::UNKNOWN;
+			}
+		}
+
+		uint8bit TranslateModifiers(unsigned int state) {
+			uint8bit mods = 0;
+			if (state & ShiftMask) mods |= KEYMOD_SHIFT;
+			if (state & ControlMask) mods |= KEYMOD_CONTROL;
+			if (state & Mod1Mask) mods |= KEYMOD_ALT;
+			if (state & Mod4Mask) mods |= KEYMOD_SUPER;
+			return mods;
+		}
+	}
+
+	struct WindowX11::State {
+		struct Surface {
+			XImage* image = nullptr;
+			XShmSegmentInfo shm{};
+
+			// A put of this surface is in flight and the server may still be reading it.
+			// Cleared by whichever thread sees the completion event
+			std::atomic<bool> pending{ false };
+
+			// Copy of shm.shmseg while the segment is attached, 0 otherwise. Published by the
+			// thread drawing the window for the message thread, which must not read image or shm
+			std::atomic<ShmSeg> segment{ 0 };
+		};
+
+		// Shared with the other windows of the creating thread unless the window has a message thread
+		std::shared_ptr<Connection> connection;
+
+		Display* display = nullptr;
+		GC gc = nullptr;
+		Visual* visual = nullptr;
+		int depth = 0;
+		Atom wmDeleteWindow = 0;
+
+		// MIT-SHM is available and used for presenting
+		bool useShm = false;
+
+		// Event type of XShmCompletionEvent, offset by the extension base
+		int shmCompletionType = 0;
+
+		// Pixels are 0x00RRGGBB words, so the framebuffer can be handed out directly
+		bool bgraVisual = false;
+
+		Surface surfaces[SurfaceCount];
+		int current = 0;
+
+		// Size the surfaces were created for, they are rebuilt lazily when the window size differs
+		vec2u surfaceSize{ 0u, 0u };
+
+		// eventfd used to wake the message thread out of poll()
+		int wakeFd = -1;
+
+		// Cleared to stop the message thread
+		std::atomic<bool> running{ false };
+	};
+
+	WindowX11::WindowX11(const WindowProperties& props) : Window(props), state(std::make_unique<State>()) {
+		state->connection = OpenConnection(props.threadedMessagePump);
+		if (!state->connection) {
+			CRUX_LOG_WARN("Cannot open X display \"%s\"", std::getenv("DISPLAY"));
+			return;
+		}
+
+		Display* display = state->connection->display;
+		state->display = display;
+		const int screen = DefaultScreen(display);
+		state->visual = DefaultVisual(display, screen);
+		state->depth = DefaultDepth(display, screen);
+		state->bgraVisual = (state->depth == 24 || state->depth == 32)
+			&& state->visual->red_mask == 0xFF0000 && state->visual->green_mask == 0x00FF00 && state->visual->blue_mask == 0x0000FF;
+
+		//Negative positions are centered on screen, or left to the window manager
+		const vec2u clientSize = GetSize();
+		vec2i pos = GetPosition();
+		if (props.positionCentered) {
+			if (pos.x < 0) pos.x = (DisplayWidth(display, screen) - (int)clientSize.x) / 2;
+			if (pos.y < 0) pos.y = (DisplayHeight(display, screen) - (int)clientSize.y) / 2;
+		}
+
+		handle = XCreateSimpleWindow(
+			display,
+			RootWindow(display, screen),
+			pos.x < 0 ? 0 : pos.x,
+			pos.y < 0 ? 0 : pos.y,
+			clientSize.x ? clientSize.x : 1,
+			clientSize.y ? clientSize.y : 1,
+			0,
+			BlackPixel(display, screen),
+			BlackPixel(display, screen)
+		);
+		if (!handle) {
+			state->connection.reset();
+			state->display = nullptr;
+			return;
+		}
+		state->connection->windows.emplace_back(handle, this);
+
+		XSelectInput(display, handle, ExposureMask | StructureNotifyMask | FocusChangeMask
+			| KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask);
+
+		//Ask the window manager for a ClientMessage instead of killing the connection on close
+		state->wmDeleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+		XSetWMProtocols(display, handle, &state->wmDeleteWindow, 1);
+
+		XStoreName(display, handle, title.c_str());
+
+		//Without USPosition the window manager is free to ignore the requested position
+		if (pos.x >= 0 || pos.y >= 0) {
+			XSizeHints hints{};
+			hints.flags = USPosition;
+			hints.x = pos.x;
+			hints.y = pos.y;
+			XSetWMNormalHints(display, handle, &hints);
+		}
+
+		state->gc = XCreateGC(display, handle, 0, nullptr);
+
+		int major = 0, minor = 0;
+		Bool pixmaps = False;
+		state->useShm = XShmQueryVersion(display, &major, &minor, &pixmaps) == True;
+		if (state->useShm)
+			state->shmCompletionType = XShmGetEventBase(display) + ShmCompletion;
+
+		CreateSurfaces(clientSize);
+
+		XMapWindow(display, handle);
+		XFlush(display);
+
+		if (props.threadedMessagePump) {
+			state->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (state->wakeFd >= 0) {
+				state->running = true;
+				messageThreaded = true;
+				messageThread = std::thread(&WindowX11::MessageLoop, this);
+			}
+		}
+	}
+
+	WindowX11::~WindowX11() {
+		if (messageThreaded) {
+			state->running = false;
+			WakeMessageThread();
+			messageThread.join();
+			close(state->wakeFd);
+			state->wakeFd = -1;
+
+			//Nobody reads events anymore, so outstanding completions have to be waited for synchronously
+			messageThreaded = false;
+		}
+
+		if (!state->display)
+			return;
+
+		DestroySurfaces();
+		if (state->gc)
+			XFreeGC(state->display, state->gc);
+		if (handle) {
+			XDestroyWindow(state->display, handle);
+			state->connection->Remove(this);
+		}
+
+		//Closes the display once the thread's other windows are gone too
+		if (state->connection.use_count() > 1)
+			XFlush(state->display);
+		state->connection.reset();
+	}
+
+	void WindowX11::CreateSurfaces(const vec2u& clientSize) {
+		Display* display = state->display;
+		state->surfaceSize = clientSize;
+		if (!display || !state->bgraVisual || clientSize.x == 0 || clientSize.y == 0) {
+			framebuffer.Resize(vec2u(0u, 0u));
+			return;
+		}
+
+		for (auto& surface : state->surfaces) {
+			if (state->useShm) {
+				surface.image = XShmCreateImage(display, state->visual, state->depth, ZPixmap, nullptr, &surface.shm, clientSize.x, clientSize.y);
+				if (surface.image) {
+					surface.shm.shmid = shmget(IPC_PRIVATE, (size_t)surface.image->bytes_per_line * surface.image->height, IPC_CREAT | 0600);
+					surface.shm.shmaddr = surface.shm.shmid >= 0 ? (char*)shmat(surface.shm.shmid, nullptr, 0) : (char*)-1;
+					surface.shm.readOnly = False;
+
+					bool attached = false;
+					if (surface.shm.shmaddr != (char*)-1) {
+						surface.image->data = surface.shm.shmaddr;
+
+						//Attaching fails with BadAccess on remote displays, trap it instead of exiting
+						ShmAttachFailed = false;
+						auto previousHandler = XSetErrorHandler(ShmAttachErrorHandler);
+						XShmAttach(display, &surface.shm);
+						XSync(display, False);
+						XSetErrorHandler(previousHandler);
+						attached = !ShmAttachFailed;
+					}
+
+					//Marked for removal now, the segment is freed once both sides detach
+					if (surface.shm.shmid >= 0)
+						shmctl(surface.shm.shmid, IPC_RMID, nullptr);
+
+					if (attached) {
+						surface.segment.store(surface.shm.shmseg, std::memory_order_release);
+						continue;
+					}
+
+					if (surface.shm.shmaddr != (char*)-1)
+						shmdt(surface.shm.shmaddr);
+					surface.image->data = nullptr;
+					XDestroyImage(surface.image);
+					surface.image = nullptr;
+					surface.shm = {};
+				}
+
+				//Shared memory unusable, switch every surface to the XPutImage path
+				DestroySurfaces();
+				state->useShm = false;
+				CreateSurfaces(clientSize);
+				return;
+			}
+
+			//XDestroyImage releases the data with free(), so it must come from malloc
+			const int bytesPerLine = (int)clientSize.x * 4;
+			char* data = (char*)std::malloc((size_t)bytesPerLine * clientSize.y);
+			surface.image = XCreateImage(display, state->visual, state->depth, ZPixmap, 0, data, clientSize.x, clientSize.y, 32, bytesPerLine);
+			if (!surface.image)
+				std::free(data);
+		}
+
+		state->current = 0;
+		XImage* image = state->surfaces[0].image;
+		if (image)
+			framebuffer.Attach(reinterpret_cast<uint32bit*>(image->data), clientSize, (uint)(image->bytes_per_line / 4));
+		else
+			framebuffer.Resize(vec2u(0u, 0u));
+
+		//XSync may have pulled events into the queue without the socket becoming readable again
+		WakeMessageThread();
+	}
+
+	void WindowX11::DestroySurfaces() {
+		Display* display = state->display;
+		for (int i = 0; i < SurfaceCount; ++i) {
+			WaitForSurface(i);
+
+			auto& surface = state->surfaces[i];
+			if (!surface.image)
+				continue;
+
+			if (surface.shm.shmaddr) {
+				surface.segment.store(0, std::memory_order_release);
+				XShmDetach(display, &surface.shm);
+				shmdt(surface.shm.shmaddr);
+				surface.image->data = nullptr;
+			}
+			XDestroyImage(surface.image);
+			surface.image = nullptr;
+			surface.shm = {};
+		}
+		XSync(display, False);
+		framebuffer.Resize(vec2u(0u, 0u));
+		state->surfaceSize = vec2u(0u, 0u);
+	}
+
+	void WindowX11::EnsureSurfaces() {
+		const vec2u wanted = GetSize();
+		if (!state->display || wanted == state->surfaceSize)
+			return;
+
+		DestroySurfaces();
+		CreateSurfaces(wanted);
+	}
+
+	void WindowX11::WaitForSurface(int index) {
+		auto& surface = state->surfaces[index];
+		if (!surface.pending.load(std::memory_order_acquire))
+			return;
+
+		//The message thread owns event reading and clears the flag when the completion arrives
+		if (messageThreaded) {
+			while (surface.pending.load(std::memory_order_acquire))
+				std::this_thread::yield();
+			return;
+		}
+
+		struct Match {
+			int type;
+			ShmSeg segment;
+		} match{ state->shmCompletionType, surface.shm.shmseg };
+
+		//Blocks until the server has finished reading this segment, other events stay queued
+		XEvent event;
+		XIfEvent(state->display, &event, [](Display*, XEvent* e, XPointer arg) -> Bool {
+			const Match* m = reinterpret_cast<const Match*>(arg);
+			return e->type == m->type && reinterpret_cast<XShmCompletionEvent*>(e)->shmseg == m->segment;
+		}, reinterpret_cast<XPointer>(&match));
+
+		surface.pending = false;
+	}
+
+	void WindowX11::SetTitle(const string& newTitle) {
+		CRUX_PROFILE_SCOPE("Window::SetTitle");
+		title = newTitle;
+		if (!handle || IsUpdating())
+			return;
+
+		SubmitCommand({ WindowCommandType::SET_TITLE, 0, 0 }, newTitle);
+	}
+
+	void WindowX11::SetPosition(const vec2i& newPos) {
+		CRUX_PROFILE_SCOPE("Window::SetPosition");
+		position = newPos;
+		if (!handle || IsUpdating())
+			return;
+
+		SubmitCommand({ WindowCommandType::SET_POSITION, newPos.x, newPos.y }, title);
+	}
+
+	void WindowX11::SetSize(const vec2u& newSize) {
+		CRUX_PROFILE_SCOPE("Window::SetSize");
+		//The surfaces follow on the next GetFramebuffer or Present
+		size = newSize;
+		if (!handle || IsUpdating())
+			return;
+
+		SubmitCommand({ WindowCommandType::SET_SIZE, (int)newSize.x, (int)newSize.y }, title);
+	}
+
+	void WindowX11::ApplyCommand(const WindowCommand& command, const string& newTitle) {
+		if (!handle)
+			return;
+
+		switch (command.type) {
+		case WindowCommandType::SET_TITLE:
+			XStoreName(state->display, handle, newTitle.c_str());
+			break;
+		case WindowCommandType::SET_POSITION:
+			XMoveWindow(state->display, handle, command.x, command.y);
+			break;
+		case WindowCommandType::SET_SIZE:
+			XResizeWindow(state->display, handle, command.x > 0 ? command.x : 1, command.y > 0 ? command.y : 1);
+			break;
+		case WindowCommandType::SET_BOUNDS:
+			XMoveResizeWindow(state->display, handle, command.x, command.y,
+				command.width > 0 ? command.width : 1, command.height > 0 ? command.height : 1);
+			break;
+		}
+		XFlush(state->display);
+	}
+
+	void WindowX11::WakeMessageThread() {
+		if (state->wakeFd < 0)
+			return;
+
+		const uint64_t one = 1;
+		ssize_t written = write(state->wakeFd, &one, sizeof(one));
+		(void)written;
+	}
+
+	void WindowX11::MessageLoop() {
+		CRUX_MEMORY_TAG(EVENTS);
+
+		pollfd fds[2] = {
+			{ ConnectionNumber(state->display), POLLIN, 0 },
+			{ state->wakeFd, POLLIN, 0 },
+		};
+
+		while (state->running.load(std::memory_order_acquire)) {
+			ApplyCommands();
+			PumpMessages();
+
+			//The timeout only guards against events queued by another thread's Xlib calls without a wake
+			poll(fds, 2, 100);
+			if (fds[1].revents & POLLIN) {
+				uint64_t value;
+				ssize_t read = ::read(state->wakeFd, &value, sizeof(value));
+				(void)read;
+			}
+		}
+	}
+
+	void WindowX11::SetWantsToClose(bool close) {
+		Window::SetWantsToClose(close);
+	}
+
+	optional<void*> WindowX11::GetPlatformHandle() {
+		if (!handle)
+			return {};
+		return { &handle };
+	}
+
+	Framebuffer* WindowX11::GetFramebuffer() {
+		EnsureSurfaces();
+		return framebuffer.IsEmpty() ? nullptr : &framebuffer;
+	}
+
+	bool WindowX11::Present() {
+		CRUX_PROFILE_SCOPE("Window::Present");
+		if (!handle) {
+			dirtyRegion.Clear();
+			return false;
+		}
+
+		//A resize since the last frame drops it, the caller draws into the new framebuffer next
+		const vec2u clientSize = state->surfaceSize;
+		EnsureSurfaces();
+		auto& surface = state->surfaces[state->current];
+		if (!surface.image || clientSize != state->surfaceSize) {
+			dirtyRegion.Clear();
+			return false;
+		}
+
+		//Without a dirty region the whole surface goes out as one rectangle
+		const PixelRect whole = PixelRect::FromSize(0, 0, clientSize.x, clientSize.y);
+		PixelRect rects[DirtyRegion::MaxRects];
+		std::size_t rectCount = 0;
+		const bool partial = !dirtyRegion.IsEmpty();
+		if (partial) {
+			for (const PixelRect& rect : dirtyRegion.GetRects()) {
+				const PixelRect clipped = rect.Intersect(whole);
+				if (!clipped.IsEmpty())
+					rects[rectCount++] = clipped;
+			}
+		} else {
+			rects[rectCount++] = whole;
+		}
+		dirtyRegion.Clear();
+
+		if (state->useShm) {
+			//Completion is requested on the last put only, the server handles them in order
+			//so it also covers the earlier ones. The segment is not drawn into while being read
+			if (rectCount)
+				surface.pending.store(true, std::memory_order_release);
+			for (std::size_t i = 0; i < rectCount; ++i) {
+				const PixelRect& rect = rects[i];
+				XShmPutImage(state->display, handle, state->gc, surface.image, rect.min.x, rect.min.y, rect.min.x, rect.min.y,
+					(unsigned int)rect.GetWidth(), (unsigned int)rect.GetHeight(), i + 1 == rectCount ? True : False);
+			}
+		} else {
+			for (std::size_t i = 0; i < rectCount; ++i) {
+				const PixelRect& rect = rects[i];
+				XPutImage(state->display, handle, state->gc, surface.image, rect.min.x, rect.min.y, rect.min.x, rect.min.y,
+					(unsigned int)rect.GetWidth(), (unsigned int)rect.GetHeight());
+			}
+		}
+		XFlush(state->display);
+
+		//Hand out the other surface, waiting only if its previous put is still in flight
+		XImage* presented = surface.image;
+		state->current = (state->current + 1) % SurfaceCount;
+		WaitForSurface(state->current);
+
+		XImage* next = state->surfaces[state->current].image;
+		framebuffer.Attach(reinterpret_cast<uint32bit*>(next->data), clientSize, (uint)(next->bytes_per_line / 4));
+
+		if (partial) {
+			//The next surface still holds the frame before this one, bring it up to date by copying
+			//only what changed, both sides are read so the put in flight is unaffected
+			Framebuffer source{ PixelFormat::BGRA8 };
+			source.Attach(reinterpret_cast<uint32bit*>(presented->data), clientSize, (uint)(presented->bytes_per_line / 4));
+			for (std::size_t i = 0; i < rectCount; ++i)
+				framebuffer.CopyRect(source, rects[i]);
+		}
+		return true;
+	}
+
+	void WindowX11::PumpAll(span<Window* const> windows) {
+		CRUX_PROFILE_SCOPE("Window::PumpAll");
+
+		//Polled in fixed batches, so no window count ever allocates
+		constexpr std::size_t Batch = 64;
+		pollfd fds[Batch];
+		WindowX11* polled[Batch];
+		Display* visited[Batch];
+
+		for (std::size_t first = 0; first < windows.size(); first += Batch) {
+			const std::size_t count = std::min(Batch, windows.size() - first);
+			nfds_t waiting = 0;
+			std::size_t visitedCount = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				WindowX11* window = static_cast<WindowX11*>(windows[first + i]);
+				if (!window->handle)
+					continue;
+
+				//Pumping any window of a connection reads the events of all of them
+				Display* display = window->state->display;
+				if (std::find(visited, visited + visitedCount, display) != visited + visitedCount)
+					continue;
+				visited[visitedCount++] = display;
+
+				//Events Xlib already read off the socket would not wake poll()
+				if (XEventsQueued(display, QueuedAlready) > 0) {
+					window->PumpMessages();
+					continue;
+				}
+
+				fds[waiting] = { ConnectionNumber(display), POLLIN, 0 };
+				polled[waiting] = window;
+				++waiting;
+			}
+
+			if (waiting == 0 || poll(fds, waiting, 0) <= 0)
+				continue;
+
+			for (nfds_t i = 0; i < waiting; ++i) {
+				if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+					polled[i]->PumpMessages();
+			}
+		}
+	}
+
+	std::vector<MonitorInfo> WindowX11::EnumerateMonitors() {
+		Display* display = OpenDisplay();
+		if (!display)
+			return {};
+
+		std::vector<MonitorInfo> monitors = EnumerateRandrMonitors(display);
+		if (monitors.empty()) {
+			//No RandR, the X screens are the closest thing to monitors
+			for (int screen = 0; screen < ScreenCount(display); ++screen) {
+				MonitorInfo& monitor = monitors.emplace_back();
+				monitor.name = "screen " + std::to_string(screen);
+				monitor.size = vec2u((uint)DisplayWidth(display, screen), (uint)DisplayHeight(display, screen));
+				monitor.physicalSize = vec2u((uint)DisplayWidthMM(display, screen), (uint)DisplayHeightMM(display, screen));
+				monitor.primary = screen == DefaultScreen(display);
+			}
+		}
+
+		//X has no per-monitor scaling, desktops publish one DPI for every screen as Xft.dpi
+		const char* xftDpi = XGetDefault(display, "Xft", "dpi");
+		const double dpi = xftDpi ? std::atof(xftDpi) : 0.0;
+		if (dpi > 0.0) {
+			for (MonitorInfo& monitor : monitors)
+				monitor.dpi = (uint)std::lround(dpi);
+		}
+
+		XCloseDisplay(display);
+		std::stable_partition(monitors.begin(), monitors.end(), [](const MonitorInfo& monitor) { return monitor.primary; });
+		return monitors;
+	}
+
+	void WindowX11::PumpMessages() {
+		CRUX_MEMORY_TAG(EVENTS);
+
+		Display* display = state->display;
+		if (!handle)
+			return;
+
+		//Reads the events of every window on the connection, each goes to its own window
+		const Connection& connection = *state->connection;
+		while (XPending(display)) {
+			XEvent event;
+			XNextEvent(display, &event);
+			if (WindowX11* target = connection.Find(event.xany.window))
+				target->HandleEvent(&event);
+		}
+	}
+
+	void WindowX11::HandleEvent(const void* xevent) {
+		const XEvent& xe = *static_cast<const XEvent*>(xevent);
+		Display* display = state->display;
+
+		//Completions drained here would otherwise be waited on forever in WaitForSurface
+		//Matched by the published segment ids, the drawing thread may be rebuilding the surfaces meanwhile
+		if (state->shmCompletionType != 0 && xe.type == state->shmCompletionType) {
+			const auto& completion = reinterpret_cast<const XShmCompletionEvent&>(xe);
+			for (auto& surface : state->surfaces) {
+				if (surface.segment.load(std::memory_order_acquire) == completion.shmseg)
+					surface.pending.store(false, std::memory_order_release);
+			}
+			return;
+		}
+
+		Event event;
+		switch (xe.type) {
+		case ClientMessage:
+			if ((Atom)xe.xclient.data.l[0] != state->wmDeleteWindow)
+				return;
+			wantsToClose = true;
+			event.type = EventType::CLOSE;
+			break;
+
+		case ConfigureNotify: {
+			//Only the size is published, the surfaces are rebuilt by the thread drawing into them
+			const vec2u newSize((uint)xe.xconfigure.width, (uint)xe.xconfigure.height);
+			if (newSize != GetSize()) {
+				size = newSize;
+
+				event.type = EventType::RESIZE;
+				event.size = { newSize.x, newSize.y };
+				PushEvent(event);
+			}
+
+			//Real configure events are relative to the window manager frame, synthetic ones to the root
+			vec2i newPos(xe.xconfigure.x, xe.xconfigure.y);
+			if (!xe.xconfigure.send_event) {
+				::Window child;
+				XTranslateCoordinates(display, handle, DefaultRootWindow(display), 0, 0, &newPos.x, &newPos.y, &child);
+			}
+			if (newPos == GetPosition())
+				return;
+			position = newPos;
+			event.type = EventType::MOVE;
+			event.position = { newPos.x, newPos.y };
+			break;
+		}
+
+		case FocusIn:
+			event.type = EventType::FOCUS_GAINED;
+			break;
+
+		case FocusOut:
+			event.type = EventType::FOCUS_LOST;
+			break;
+
+		case KeyPress:
+		case KeyRelease: {
+			XKeyEvent keyEvent = xe.xkey;
+
+			//Auto-repeat arrives as a release immediately followed by a press with the same time
+			if (xe.type == KeyRelease && XEventsQueued(display, QueuedAfterReading)) {
+				XEvent next;
+				XPeekEvent(display, &next);
+				if (next.type == KeyPress && next.xkey.time == keyEvent.time && next.xkey.keycode == keyEvent.keycode) {
+					XNextEvent(display, &next);
+					event.type = EventType::KEY_DOWN;
+					event.key = { TranslateKeySym(XLookupKeysym(&keyEvent, 0)), keyEvent.keycode, TranslateModifiers(keyEvent.state), true };
+					break;
+				}
+			}
+
+			event.type = xe.type == KeyPress ? EventType::KEY_DOWN : EventType::KEY_UP;
+			event.key = { TranslateKeySym(XLookupKeysym(&keyEvent, 0)), keyEvent.keycode, TranslateModifiers(keyEvent.state), false };
+			break;
+		}
+
+		case ButtonPress:
+		case ButtonRelease: {
+			const unsigned int button = xe.xbutton.button;
+
+			//Buttons 4-7 are the wheel, reported once per notch on press
+			if (button >= Button4 && button <= 7) {
+				if (xe.type == ButtonRelease)
+					return;
+				event.type = EventType::MOUSE_WHEEL;
+				event.mouseWheel = {
+					button == 6 ? -1.0f : (button == 7 ? 1.0f : 0.0f),
+					button == Button4 ? 1.0f : (button == Button5 ? -1.0f : 0.0f)
+				};
+				break;
+			}
+
+			MouseButton mapped;
+			switch (button) {
+			case Button1: mapped = MouseButton::LEFT; break;
+			case Button2: mapped = MouseButton::MIDDLE; break;
+			case Button3: mapped = MouseButton::RIGHT; break;
+			case 8: mapped = MouseButton::X1; break;
+			case 9: mapped = MouseButton::X2; break;
+			default: return;
+			}
+
+			event.type = xe.type == ButtonPress ? EventType::MOUSE_DOWN : EventType::MOUSE_UP;
+			event.mouseButton = { mapped, TranslateModifiers(xe.xbutton.state), xe.xbutton.x, xe.xbutton.y };
+			break;
+		}
+
+		case MotionNotify:
+			event.type = EventType::MOUSE_MOVE;
+			event.mouseMove = { xe.xmotion.x, xe.xmotion.y };
+			break;
+
+		default:
+			return;
+		}
+
+		PushEvent(event);
+	}
+
+	void* WindowX11::GetDisplay() const {
+		return state->display;
+	}
+
+	bool WindowX11::IsSharedMemory() const {
+		return state->useShm;
+	}
+}
+
+#endif //CRUX_UNIX
@@ -1,30 +1,540 @@
 #if CRUX_WIN32
 #include "window.win32.h"
 
+#include <windowsx.h>
+
+#include <algorithm>
+#include <functional>
+
+#include <crux-common/dynamic_library.h>
+#include <crux-common/log.h>
+#include <crux-common/memory_tracking.h>
 #include <crux-common/platform.win32.h>
+#include <crux-common/profile.h>
 
 namespace crux::internal::win32 {
+	namespace {
+		const wchar_t* WindowClassName = L"crux-window";
+
+		// Posted to the message thread when commands are queued
+		constexpr UINT WM_CRUX_COMMAND = WM_APP + 1;
+
+		// Posted to the message thread to destroy the window and leave the loop
+		constexpr UINT WM_CRUX_QUIT = WM_APP + 2;
+
+		// GetDpiForMonitor, loaded at runtime as shcore.dll only exists from Windows 8.1
+		typedef HRESULT WINAPI GetDpiForMonitorFn(HMONITOR monitor, int dpiType, UINT* dpiX, UINT* dpiY);
+		LazyLibrary Shcore("shcore.dll");
+
+		// MDT_EFFECTIVE_DPI, the DPI with the user's scale factor applied
+		constexpr int EffectiveDpi = 0;
+
+		// EnumDisplayMonitors callback, appends one MonitorInfo to the vector in param
+		BOOL CALLBACK AddMonitor(HMONITOR monitor, HDC, LPRECT, LPARAM param) {
+			MONITORINFOEXW info{};
+			info.cbSize = sizeof(info);
+			if (!GetMonitorInfoW(monitor, &info))
+				return TRUE;
+
+			MonitorInfo& out = reinterpret_cast<std::vector<MonitorInfo>*>(param)->emplace_back();
+			out.name = WideStringToString(std::wstring(info.szDevice));
+			out.position = vec2i(info.rcMonitor.left, info.rcMonitor.top);
+			out.size = vec2u((uint)(info.rcMonitor.right - info.rcMonitor.left), (uint)(info.rcMonitor.bottom - info.rcMonitor.top));
+			out.primary = (info.dwFlags & MONITORINFOF_PRIMARY) != 0;
+
+			//0 and 1 both stand for the hardware default rate
+			DEVMODEW mode{};
+			mode.dmSize = sizeof(mode);
+			if (EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1)
+				out.refreshRate = (double)mode.dmDisplayFrequency;
+
+			HDC dc = CreateDCW(L"DISPLAY", info.szDevice, nullptr, nullptr);
+			if (dc) {
+				out.physicalSize = vec2u((uint)GetDeviceCaps(dc, HORZSIZE), (uint)GetDeviceCaps(dc, VERTSIZE));
+				out.dpi = (uint)GetDeviceCaps(dc, LOGPIXELSX);
+				DeleteDC(dc);
+			}
+
+			UINT dpiX = 0, dpiY = 0;
+			auto getDpiForMonitor = Shcore.GetFunction<GetDpiForMonitorFn>("GetDpiForMonitor");
+			if (getDpiForMonitor && SUCCEEDED(getDpiForMonitor(monitor, EffectiveDpi, &dpiX, &dpiY)) && dpiX > 0)
+				out.dpi = dpiX;
+			return TRUE;
+		}
+
+		// Registers the shared window class once per process
+		bool RegisterWindowClass(WNDPROC proc) {
+			static const bool registered = [proc]() {
+				WNDCLASSEXW wc{};
+				wc.cbSize = sizeof(wc);
+				wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+				wc.lpfnWndProc = proc;
+				wc.hInstance = GetModuleHandleW(nullptr);
+				wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+				wc.lpszClassName = WindowClassName;
+				return RegisterClassExW(&wc) != 0;
+			}();
+			return registered;
+		}
+
+		Key TranslateVirtualKey(WPARAM vk, LPARAM lparam) {
+			if (vk >= 'A' && vk <= 'Z')
+				return (Key)((int)Key::A + (int)(vk - 'A'));
+			if (vk >= '0' && vk <= '9')
+				return (Key)((int)Key::NUM_0 + (int)(vk - '0'));
+			if (vk >= VK_F1 && vk <= VK_F12)
+				return (Key)((int)Key::F1 + (int)(vk - VK_F1));
+
+			//Bit 24 of lparam marks the right-hand variant of ctrl/alt
+			const bool extended = (lparam & (1 << 24)) != 0;
+			switch (vk) {
+			case VK_ESCAPE: return Key::ESCAPE;
+			case VK_RETURN: return Key::ENTER;
+			case VK_TAB: return Key::TAB;
+			case VK_BACK: return Key::BACKSPACE;
+			case VK_SPACE: return Key::SPACE;
+			case VK_INSERT: return Key::INSERT;
+			case VK_DELETE: return Key::DEL;
+			case VK_HOME: return Key::HOME;
+			case VK_END: return Key::END;
+			case VK_PRIOR: return Key::PAGE_UP;
+			case VK_NEXT: return Key::PAGE_DOWN;
+			case VK_LEFT: return Key::LEFT;
+			case VK_RIGHT: return Key::RIGHT;
+			case VK_UP: return Key::UP;
+			case VK_DOWN: return Key::DOWN;
+			case VK_SHIFT:
+				return MapVirtualKeyW((UINT)((lparam >> 16) & 0xFF), MAPVK_VSC_TO_VK_EX) == VK_RSHIFT ? Key::RIGHT_SHIFT : Key::LEFT_SHIFT;
+			case VK_CONTROL: return extended ? Key::RIGHT_CONTROL : Key::LEFT_CONTROL;
+			case VK_MENU: return extended ? Key::RIGHT_ALT : Key::LEFT_ALT;
+			default: return Key::UNKNOWN;
+			}
+		}
+
+		uint8bit CurrentModifiers() {
+			uint8bit mods = 0;
+			if (GetKeyState(VK_SHIFT) & 0x8000) mods |= KEYMOD_SHIFT;
+			if (GetKeyState(VK_CONTROL) & 0x8000) mods |= KEYMOD_CONTROL;
+			if (GetKeyState(VK_MENU) & 0x8000) mods |= KEYMOD_ALT;
+			if ((GetKeyState(VK_LWIN) | GetKeyState(VK_RWIN)) & 0x8000) mods |= KEYMOD_SUPER;
+			return mods;
+		}
+	}
+
 	WindowWin32::WindowWin32(const WindowProperties& props) : Window(props) {
 		handle = nullptr;
+		if (!RegisterWindowClass(&WindowWin32::WindowProc))
+			return;
+
+		if (!props.threadedMessagePump) {
+			CreateNativeWindow(props);
+			return;
+		}
+
+		//Messages go to the thread that created the window, so creation happens on the message thread
+		std::promise<bool> created;
+		std::future<bool> result = created.get_future();
+		messageThread = std::thread(&WindowWin32::MessageLoop, this, props, std::ref(created));
+		if (result.get()) {
+			messageThreaded = true;
+		} else {
+			messageThread.join();
+		}
+	}
+
+	bool WindowWin32::CreateNativeWindow(const WindowProperties& props) {
+		//The requested size is the client area, grow the rect to include the borders
+		const DWORD style = WS_OVERLAPPEDWINDOW;
+		const vec2u clientSize = GetSize();
+		const vec2i startPos = GetPosition();
+		RECT rect{ 0, 0, (LONG)clientSize.x, (LONG)clientSize.y };
+		AdjustWindowRect(&rect, style, FALSE);
+		const int outerWidth = rect.right - rect.left;
+		const int outerHeight = rect.bottom - rect.top;
+
+		//Negative positions are centered on screen, or left to the OS
+		int x = startPos.x;
+		int y = startPos.y;
+		if (x < 0) x = props.positionCentered ? (GetSystemMetrics(SM_CXSCREEN) - outerWidth) / 2 : CW_USEDEFAULT;
+		if (y < 0) y = props.positionCentered ? (GetSystemMetrics(SM_CYSCREEN) - outerHeight) / 2 : CW_USEDEFAULT;
+
+		WideBuffer wideTitle;
+		StringToWideString(title, wideTitle);
+
+		//The instance pointer is handed to WindowProc through WM_NCCREATE
+		handle = CreateWindowExW(
+			0,
+			WindowClassName,
+			wideTitle.c_str(),
+			style,
+			x, y,
+			outerWidth, outerHeight,
+			nullptr,
+			nullptr,
+			GetModuleHandleW(nullptr),
+			this
+		);
+		if (!handle) {
+			CRUX_LOG_ERROR("CreateWindowExW failed: %s", log::LastError());
+			return false;
+		}
+
+		ShowWindow(handle, SW_SHOW);
+		return true;
+	}
+
+	void WindowWin32::MessageLoop(const WindowProperties& props, std::promise<bool>& created) {
+		CRUX_MEMORY_TAG(EVENTS);
+
+		const bool ok = CreateNativeWindow(props);
+		created.set_value(ok);
+		if (!ok)
+			return;
+
+		//Blocks while idle, drags and resizes run their modal loops here instead of on the render thread
+		MSG msg;
+		while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+			TranslateMessage(&msg);
+			DispatchMessageW(&msg);
+		}
+	}
+
+	WindowWin32::~WindowWin32() {
+		if (messageThreaded) {
+			//The window has to be destroyed by the thread that created it
+			PostMessageW(handle, WM_CRUX_QUIT, 0, 0);
+			messageThread.join();
+			return;
+		}
+
+		if (handle) {
+			SetWindowLongPtrW(handle, GWLP_USERDATA, 0);
+			DestroyWindow(handle);
+		}
+	}
+
+	LRESULT CALLBACK WindowWin32::WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+		if (message == WM_NCCREATE) {
+			auto create = reinterpret_cast<CREATESTRUCTW*>(lparam);
+			SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+		}
+
+		auto window = reinterpret_cast<WindowWin32*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+		if (window)
+			return window->MessageHandler(hwnd, message, wparam, lparam);
+		return DefWindowProcW(hwnd, message, wparam, lparam);
+	}
+
+	LRESULT CALLBACK WindowWin32::MessageHandler(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+		Event event;
+
+		switch (message) {
+		case WM_CLOSE:
+			//Closing is left to the application, which sees WantsToClose and the event
+			wantsToClose = true;
+			event.type = EventType::CLOSE;
+			PushEvent(event);
+			return 0;
+
+		case WM_CRUX_COMMAND:
+			ApplyCommands();
+			return 0;
+
+		case WM_CRUX_QUIT:
+			ApplyCommands();
+			SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+			DestroyWindow(hwnd);
+			PostQuitMessage(0);
+			return 0;
+
+		case WM_SIZE: {
+			if (wparam == SIZE_MINIMIZED)
+				return 0;
+
+			//Only the size is published, the framebuffer is resized by the thread drawing into it
+			const vec2u newSize((uint)LOWORD(lparam), (uint)HIWORD(lparam));
+			if (newSize == GetSize())
+				return 0;
+			size = newSize;
+			event.type = EventType::RESIZE;
+			event.size = { newSize.x, newSize.y };
+			PushEvent(event);
+			return 0;
+		}
+
+		case WM_MOVE: {
+			//lparam holds the client origin, report the outer window origin that SetPosition takes
+			RECT rect;
+			GetWindowRect(hwnd, &rect);
+			const vec2i newPos((int)rect.left, (int)rect.top);
+			position = newPos;
+			event.type = EventType::MOVE;
+			event.position = { newPos.x, newPos.y };
+			PushEvent(event);
+			return 0;
+		}
+
+		case WM_SETFOCUS:
+			event.type = EventType::FOCUS_GAINED;
+			PushEvent(event);
+			return 0;
+
+		case WM_KILLFOCUS:
+			event.type = EventType::FOCUS_LOST;
+			PushEvent(event);
+			return 0;
+
+		case WM_KEYDOWN:
+		case WM_SYSKEYDOWN:
+			PushKeyEvent(EventType::KEY_DOWN, wparam, lparam);
+			//Let alt+F4 and friends through
+			return message == WM_SYSKEYDOWN ? DefWindowProcW(hwnd, message, wparam, lparam) : 0;
+
+		case WM_KEYUP:
+		case WM_SYSKEYUP:
+			PushKeyEvent(EventType::KEY_UP, wparam, lparam);
+			return message == WM_SYSKEYUP ? DefWindowProcW(hwnd, message, wparam, lparam) : 0;
+
+		case WM_MOUSEMOVE:
+			event.type = EventType::MOUSE_MOVE;
+			event.mouseMove = { GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam) };
+			PushEvent(event);
+			return 0;
+
+		case WM_LBUTTONDOWN: PushMouseButtonEvent(EventType::MOUSE_DOWN, MouseButton::LEFT, lparam); return 0;
+		case WM_LBUTTONUP: PushMouseButtonEvent(EventType::MOUSE_UP, MouseButton::LEFT, lparam); return 0;
+		case WM_RBUTTONDOWN: PushMouseButtonEvent(EventType::MOUSE_DOWN, MouseButton::RIGHT, lparam); return 0;
+		case WM_RBUTTONUP: PushMouseButtonEvent(EventType::MOUSE_UP, MouseButton::RIGHT, lparam); return 0;
+		case WM_MBUTTONDOWN: PushMouseButtonEvent(EventType::MOUSE_DOWN, MouseButton::MIDDLE, lparam); return 0;
+		case WM_MBUTTONUP: PushMouseButtonEvent(EventType::MOUSE_UP, MouseButton::MIDDLE, lparam); return 0;
+
+		case WM_XBUTTONDOWN:
+		case WM_XBUTTONUP:
+			PushMouseButtonEvent(
+				message == WM_XBUTTONDOWN ? EventType::MOUSE_DOWN : EventType::MOUSE_UP,
+				GET_XBUTTON_WPARAM(wparam) == XBUTTON1 ? MouseButton::X1 : MouseButton::X2,
+				lparam);
+			return TRUE;
+
+		case WM_MOUSEWHEEL:
+		case WM_MOUSEHWHEEL: {
+			const float notches = (float)GET_WHEEL_DELTA_WPARAM(wparam) / (float)WHEEL_DELTA;
+			event.type = EventType::MOUSE_WHEEL;
+			event.mouseWheel = { message == WM_MOUSEHWHEEL ? notches : 0.0f, message == WM_MOUSEWHEEL ? notches : 0.0f };
+			PushEvent(event);
+			return 0;
+		}
+
+		case WM_PAINT:
+			WindowPaint(hwnd);
+			return 0;
+
+		case WM_ERASEBKGND:
+			//The framebuffer covers the whole client area, erasing would only flicker
+			return 1;
+
+		default:
+			return DefWindowProcW(hwnd, message, wparam, lparam);
+		}
+	}
+
+	void WindowWin32::PushKeyEvent(EventType type, WPARAM wparam, LPARAM lparam) {
+		Event event;
+		event.type = type;
+		event.key = {
+			TranslateVirtualKey(wparam, lparam),
+			(uint32bit)wparam,
+			CurrentModifiers(),
+			//Bit 30 is the previous key state, set when auto-repeating
+			type == EventType::KEY_DOWN && (lparam & (1 << 30)) != 0
+		};
+		PushEvent(event);
+	}
+
+	void WindowWin32::PushMouseButtonEvent(EventType type, MouseButton button, LPARAM lparam) {
+		Event event;
+		event.type = type;
+		event.mouseButton = { button, CurrentModifiers(), GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam) };
+		PushEvent(event);
+	}
+
+	void WindowWin32::Blit(HDC dc, const PixelRect& rect) {
+		const PixelRect clipped = rect.Intersect(PixelRect::FromSize(0, 0, framebuffer.GetWidth(), framebuffer.GetHeight()));
+		if (clipped.IsEmpty())
+			return;
+
+		//Top-down 32bit DIB, matching the BGRA8 framebuffer rows, starting at the rect's first row
+		BITMAPINFO info{};
+		info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		info.bmiHeader.biWidth = (LONG)framebuffer.GetStride();
+		info.bmiHeader.biHeight = -(LONG)clipped.GetHeight();
+		info.bmiHeader.biPlanes = 1;
+		info.bmiHeader.biBitCount = 32;
+		info.bmiHeader.biCompression = BI_RGB;
+
+		SetDIBitsToDevice(dc, clipped.min.x, clipped.min.y, (DWORD)clipped.GetWidth(), (DWORD)clipped.GetHeight(),
+			clipped.min.x, 0, 0, (UINT)clipped.GetHeight(), framebuffer.GetRow((uint)clipped.min.y), &info, DIB_RGB_COLORS);
+	}
+
+	void WindowWin32::WindowPaint(HWND hwnd) {
+		PAINTSTRUCT paint;
+		HDC dc = BeginPaint(hwnd, &paint);
+
+		//With a message thread the framebuffer belongs to the render thread, the next Present repaints
+		if (!messageThreaded && !framebuffer.IsEmpty())
+			Blit(dc, PixelRect(vec2i(paint.rcPaint.left, paint.rcPaint.top), vec2i(paint.rcPaint.right, paint.rcPaint.bottom)));
+		EndPaint(hwnd, &paint);
+	}
+
+	void WindowWin32::PumpMessages() {
+		CRUX_MEMORY_TAG(EVENTS);
+
+		MSG msg;
+		while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+			TranslateMessage(&msg);
+			DispatchMessageW(&msg);
+		}
+	}
+
+	void WindowWin32::PumpAll(span<Window* const> windows) {
+		CRUX_PROFILE_SCOPE("Window::PumpAll");
+		//PeekMessage without a window reads every message of the thread, whichever window it is for
+		if (!windows.empty())
+			static_cast<WindowWin32*>(windows[0])->PumpMessages();
+	}
+
+	std::vector<MonitorInfo> WindowWin32::EnumerateMonitors() {
+		std::vector<MonitorInfo> monitors;
+		EnumDisplayMonitors(nullptr, nullptr, AddMonitor, reinterpret_cast<LPARAM>(&monitors));
+
+		std::stable_partition(monitors.begin(), monitors.end(), [](const MonitorInfo& monitor) { return monitor.primary; });
+		return monitors;
 	}
 
 	void WindowWin32::SetTitle(const string& newTitle) {
+		CRUX_PROFILE_SCOPE("Window::SetTitle");
+		title = newTitle;
+		if (!handle || IsUpdating())
+			return;
 
+		SubmitCommand({ WindowCommandType::SET_TITLE, 0, 0 }, newTitle);
 	}
 
 	void WindowWin32::SetPosition(const vec2i& newPos) {
+		CRUX_PROFILE_SCOPE("Window::SetPosition");
+		position = newPos;
+		if (!handle || IsUpdating())
+			return;
 
+		SubmitCommand({ WindowCommandType::SET_POSITION, newPos.x, newPos.y }, title);
 	}
 
 	void WindowWin32::SetSize(const vec2u& newSize) {
+		CRUX_PROFILE_SCOPE("Window::SetSize");
+		//The framebuffer follows on the next GetFramebuffer or Present
+		size = newSize;
+		if (!handle || IsUpdating())
+			return;
+
+		SubmitCommand({ WindowCommandType::SET_SIZE, (int)newSize.x, (int)newSize.y }, title);
+	}
+
+	void WindowWin32::ApplyCommand(const WindowCommand& command, const string& newTitle) {
+		if (!handle)
+			return;
+
+		switch (command.type) {
+		case WindowCommandType::SET_TITLE: {
+			WideBuffer wideTitle;
+			StringToWideString(newTitle, wideTitle);
+			SetWindowTextW(handle, wideTitle.c_str());
+			break;
+		}
 
+		case WindowCommandType::SET_POSITION:
+			SetWindowPos(handle, nullptr, command.x, command.y, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+			break;
+
+		case WindowCommandType::SET_SIZE: {
+			//The requested size is the client area
+			RECT rect{ 0, 0, (LONG)command.x, (LONG)command.y };
+			AdjustWindowRect(&rect, (DWORD)GetWindowLongPtrW(handle, GWL_STYLE), FALSE);
+			SetWindowPos(handle, nullptr, 0, 0, rect.right - rect.left, rect.bottom - rect.top, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+			break;
+		}
+
+		case WindowCommandType::SET_BOUNDS: {
+			//Position of the outer window, size of the client area, as the separate commands take them
+			RECT rect{ 0, 0, (LONG)command.width, (LONG)command.height };
+			AdjustWindowRect(&rect, (DWORD)GetWindowLongPtrW(handle, GWL_STYLE), FALSE);
+			SetWindowPos(handle, nullptr, command.x, command.y, rect.right - rect.left, rect.bottom - rect.top, SWP_NOZORDER | SWP_NOACTIVATE);
+			break;
+		}
+		}
+	}
+
+	void WindowWin32::WakeMessageThread() {
+		if (handle)
+			PostMessageW(handle, WM_CRUX_COMMAND, 0, 0);
 	}
 
 	void WindowWin32::SetWantsToClose(bool close) {
+		Window::SetWantsToClose(close);
+	}
 
+	optional<void*> WindowWin32::GetPlatformHandle() {
+		if (!handle)
+			return {};
+		return { &handle };
 	}
 
+	Framebuffer* WindowWin32::GetFramebuffer() {
+		if (!handle)
+			return nullptr;
 
+		const vec2u clientSize = GetSize();
+		if (framebuffer.GetSize() != clientSize)
+			framebuffer.Resize(clientSize);
+		return framebuffer.IsEmpty() ? nullptr : &framebuffer;
+	}
+
+	bool WindowWin32::Present() {
+		CRUX_PROFILE_SCOPE("Window::Present");
+		if (!handle || framebuffer.IsEmpty()) {
+			dirtyRegion.Clear();
+			return false;
+		}
+
+		//A resize since the last frame drops it, the caller draws into the new framebuffer next
+		const vec2u clientSize = GetSize();
+		if (framebuffer.GetSize() != clientSize) {
+			framebuffer.Resize(clientSize);
+			dirtyRegion.Clear();
+			return false;
+		}
+
+		//Blit straight away instead of waiting for the next WM_PAINT, only the dirty rects when marked.
+		//The framebuffer is not double buffered, it keeps the presented image as is
+		HDC dc = GetDC(handle);
+		if (dirtyRegion.IsEmpty()) {
+			Blit(dc, PixelRect::FromSize(0, 0, clientSize.x, clientSize.y));
+			if (!messageThreaded)
+				ValidateRect(handle, nullptr);
+		} else {
+			for (const PixelRect& rect : dirtyRegion.GetRects()) {
+				Blit(dc, rect);
+
+				//Anything else invalid still gets its WM_PAINT
+				if (!messageThreaded) {
+					const RECT validated{ rect.min.x, rect.min.y, rect.max.x, rect.max.y };
+					ValidateRect(handle, &validated);
+				}
+			}
+		}
+		ReleaseDC(handle, dc);
+		dirtyRegion.Clear();
+		return true;
+	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,216 @@
+#include "window_manager.h"
+
+#include <algorithm>
+
+#include <crux-common/memory_tracking.h>
+#include <crux-common/platform.h>
+#include <crux-common/profile.h>
+
+#if CRUX_WIN32
+#include "window.win32.h"
+#elif CRUX_UNIX
+#include "window.nix.h"
+#endif
+
+namespace crux {
+	namespace {
+		// @return True for windows of the platform backend without a message thread, the ones PollEvents pumps.
+		// Headless windows have no OS messages and other Window subclasses are unknown to the backend
+		bool NeedsPump(Window* window) {
+			if (window->IsMessageThreaded())
+				return false;
+#if CRUX_WIN32
+			return dynamic_cast<internal::win32::WindowWin32*>(window) != nullptr;
+#elif CRUX_UNIX
+			return dynamic_cast<internal::nix::WindowX11*>(window) != nullptr;
+#else
+			return false;
+#endif
+		}
+	}
+
+	WindowManager::~WindowManager() {
+		Clear();
+	}
+
+	optional<WindowId> WindowManager::Create(const WindowProperties& props) {
+		CRUX_PROFILE_SCOPE("WindowManager::Create");
+		auto created = Window::Create(props);
+		if (!created)
+			return {};
+		return { Add(std::move(*created)) };
+	}
+
+	WindowId WindowManager::Add(WinPtr window) {
+		if (!window)
+			return WindowId();
+
+		CRUX_MEMORY_TAG(WINDOW);
+
+		uint32bit index;
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		} else {
+			index = (uint32bit)slots.size();
+			slots.emplace_back();
+		}
+
+		Slot& slot = slots[index];
+		slot.dense = (uint32bit)windows.size();
+		const WindowId id{ index, slot.generation };
+
+		if (NeedsPump(window.get()))
+			pumped.push_back(window.get());
+
+		windows.push_back(window.get());
+		ids.push_back(id);
+		owners.push_back(std::move(window));
+		return id;
+	}
+
+	bool WindowManager::Destroy(WindowId id) {
+		if (!Get(id))
+			return false;
+
+		RemoveAt(slots[id.index].dense);
+		return true;
+	}
+
+	std::size_t WindowManager::DestroyClosed() {
+		std::size_t destroyed = 0;
+		for (std::size_t i = 0; i < windows.size();) {
+			if (windows[i]->WantsToClose()) {
+				//The last window moves into i, look at it next
+				RemoveAt(i);
+				++destroyed;
+			} else {
+				++i;
+			}
+		}
+		return destroyed;
+	}
+
+	void WindowManager::Clear() {
+		while (!windows.empty())
+			RemoveAt(windows.size() - 1);
+	}
+
+	Window* WindowManager::Get(WindowId id) const {
+		if (id.index >= slots.size())
+			return nullptr;
+
+		const Slot& slot = slots[id.index];
+		if (slot.generation != id.generation || slot.dense >= windows.size() || ids[slot.dense] != id)
+			return nullptr;
+		return windows[slot.dense];
+	}
+
+	WinPtr WindowManager::GetShared(WindowId id) const {
+		if (!Get(id))
+			return {};
+		return owners[slots[id.index].dense];
+	}
+
+	void WindowManager::RemoveAt(std::size_t dense) {
+		Window* window = windows[dense];
+		const WindowId id = ids[dense];
+
+		auto found = std::find(pumped.begin(), pumped.end(), window);
+		if (found != pumped.end()) {
+			*found = pumped.back();
+			pumped.pop_back();
+		}
+
+		//Released after the arrays are consistent again, the window's destructor may take a while
+		WinPtr owner = std::move(owners[dense]);
+
+		const std::size_t last = windows.size() - 1;
+		if (dense != last) {
+			windows[dense] = windows[last];
+			ids[dense] = ids[last];
+			owners[dense] = std::move(owners[last]);
+			slots[ids[dense].index].dense = (uint32bit)dense;
+		}
+
+		windows.pop_back();
+		ids.pop_back();
+		owners.pop_back();
+
+		++slots[id.index].generation;
+		freeSlots.push_back(id.index);
+		if (nextDrain >= windows.size())
+			nextDrain = 0;
+	}
+
+	std::size_t WindowManager::PollEvents(span<WindowEvent> out) {
+		CRUX_PROFILE_SCOPE("WindowManager::PollEvents");
+		if (!pumped.empty()) {
+#if CRUX_WIN32
+			internal::win32::WindowWin32::PumpAll(pumped);
+#elif CRUX_UNIX
+			internal::nix::WindowX11::PumpAll(pumped);
+#endif
+		}
+
+		const std::size_t count = windows.size();
+		if (count == 0)
+			return 0;
+
+		std::size_t written = 0;
+		std::size_t i = nextDrain;
+		nextDrain = (nextDrain + 1 == count) ? 0 : nextDrain + 1;
+
+		//Events are tagged straight into the output, without a copy through a local batch
+		for (std::size_t n = 0; n < count && written < out.size(); ++n) {
+			const WindowId id = ids[i];
+			written += windows[i]->events.consume_n(out.size() - written, [&out, id, at = written](const Event& event) mutable {
+				out[at].window = id;
+				out[at].event = event;
+				++at;
+			});
+			if (++i == count)
+				i = 0;
+		}
+		return written;
+	}
+
+	span<const MonitorInfo> WindowManager::GetMonitors() {
+		if (!monitorsEnumerated)
+			RefreshMonitors();
+		return span<const MonitorInfo>(monitors.data(), monitors.size());
+	}
+
+	void WindowManager::RefreshMonitors() {
+		monitors = EnumerateMonitors();
+		monitorsEnumerated = true;
+	}
+
+	const MonitorInfo* WindowManager::GetMonitorFor(WindowId id) {
+		const Window* window = Get(id);
+		if (!window)
+			return nullptr;
+
+		const vec2i position = window->GetPosition();
+		const vec2u size = window->GetSize();
+		const vec2i center(position.x + (int)(size.x / 2), position.y + (int)(size.y / 2));
+		const PixelRect probe = PixelRect::FromSize(center.x, center.y, 1, 1);
+
+		for (const MonitorInfo& monitor : GetMonitors()) {
+			if (monitor.GetBounds().Contains(probe))
+				return &monitor;
+		}
+		return nullptr;
+	}
+
+	std::vector<MonitorInfo> WindowManager::EnumerateMonitors() {
+		CRUX_PROFILE_SCOPE("WindowManager::EnumerateMonitors");
+#if CRUX_WIN32
+		return internal::win32::WindowWin32::EnumerateMonitors();
+#elif CRUX_UNIX
+		return internal::nix::WindowX11::EnumerateMonitors();
+#else
+		return {};
+#endif
+	}
+}
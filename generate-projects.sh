@@ -0,0 +1,11 @@
+#!/bin/sh
+# Generates GNU makefiles, build with: make config=release -j$(nproc)
+
+cd "$(dirname "$0")"
+
+PREMAKE=./vendor/premake5/premake5
+if [ ! -x "$PREMAKE" ]; then
+	PREMAKE=premake5
+fi
+
+$PREMAKE gmake2 "$@"
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+
+#include "matrix3x3.h"
+#include "optional.h"
+#include "platform.h"
+#include "quaternion.h"
+#include "vector4.h"
+
+namespace crux::internal::simd {
+	/*
+	 * Out-of-line kernels backing matrix4x4<float> at runtime.
+	 * Both take and return 16 column-major floats, and use SSE/AVX when available.
+	 */
+
+	// out = lhs * rhs, out may alias either input
+	void Multiply4x4(const float* lhs, const float* rhs, float* out);
+
+	// Writes the inverse into out and returns true, or returns false if singular
+	bool Inverse4x4(const float* in, float* out);
+}
+
+namespace crux {
+	/**
+	 * @brief 4x4 matrix, stored column-major and multiplied against column vectors.
+	 *
+	 * Indexing is m[column][row], so m[3] holds the translation.
+	 * Projection helpers are right-handed with a [0, 1] clip-space depth range.
+	 * Default constructs to the identity matrix.
+	*/
+	template<typename T>
+	struct matrix4x4 {
+		using value_type = T;
+		using column_type = vector4<T>;
+
+		vector4<T> columns[4];
+
+		constexpr matrix4x4() : columns{
+			{ T{ 1 }, T{}, T{}, T{} },
+			{ T{}, T{ 1 }, T{}, T{} },
+			{ T{}, T{}, T{ 1 }, T{} },
+			{ T{}, T{}, T{}, T{ 1 } } } {}
+		constexpr explicit matrix4x4(const T& diagonal) : columns{
+			{ diagonal, T{}, T{}, T{} },
+			{ T{}, diagonal, T{}, T{} },
+			{ T{}, T{}, diagonal, T{} },
+			{ T{}, T{}, T{}, diagonal } } {}
+		constexpr matrix4x4(const vector4<T>& c0, const vector4<T>& c1, const vector4<T>& c2, const vector4<T>& c3) : columns{ c0, c1, c2, c3 } {}
+
+		// Expands a 3x3 rotation/scale, with no translation
+		constexpr explicit matrix4x4(const matrix3x3<T>& obj) : columns{
+			{ obj[0], T{} },
+			{ obj[1], T{} },
+			{ obj[2], T{} },
+			{ T{}, T{}, T{}, T{ 1 } } } {}
+
+		constexpr matrix4x4(const matrix4x4<T>&) = default;
+		constexpr matrix4x4(matrix4x4<T>&&) = default;
+		constexpr matrix4x4<T>& operator=(const matrix4x4<T>&) = default;
+		constexpr matrix4x4<T>& operator=(matrix4x4<T>&&) = default;
+
+		constexpr matrix4x4<T>& operator*=(const matrix4x4<T>& obj) { return *this = *this * obj; }
+
+		constexpr vector4<T>& operator[](std::size_t col) { return columns[col]; }
+		constexpr const vector4<T>& operator[](std::size_t col) const { return columns[col]; }
+
+		// @return Pointer to the 16 column-major components
+		T* data() { return &columns[0].x; }
+		const T* data() const { return &columns[0].x; }
+
+		// @return The identity matrix
+		static constexpr matrix4x4<T> Identity() { return matrix4x4<T>(); }
+
+		// @return A translation matrix
+		static constexpr matrix4x4<T> Translation(const vector3<T>& offset) {
+			matrix4x4<T> out;
+			out[3] = vector4<T>(offset, T{ 1 });
+			return out;
+		}
+
+		// @return A scaling matrix
+		static constexpr matrix4x4<T> Scale(const vector3<T>& scale) { return matrix4x4<T>(matrix3x3<T>::Scale(scale)); }
+
+		// @return The rotation matrix equivalent of a unit quaternion
+		static constexpr matrix4x4<T> Rotation(const quaternion<T>& q) { return matrix4x4<T>(matrix3x3<T>::Rotation(q)); }
+
+		// @return Translation * Rotation * Scale, the usual object-to-world transform
+		static constexpr matrix4x4<T> TRS(const vector3<T>& translation, const quaternion<T>& rotation, const vector3<T>& scale) {
+			const matrix3x3<T> rs = matrix3x3<T>::Rotation(rotation);
+			return matrix4x4<T>(
+				{ rs[0] * scale.x, T{} },
+				{ rs[1] * scale.y, T{} },
+				{ rs[2] * scale.z, T{} },
+				{ translation, T{ 1 } }
+			);
+		}
+
+		/**
+		 * @brief Builds a perspective projection.
+		 * @param fovY Vertical field of view, in radians
+		 * @param aspect Width over height of the viewport
+		 * @param zNear Distance to the near plane, mapped to depth 0
+		 * @param zFar Distance to the far plane, mapped to depth 1
+		*/
+		static matrix4x4<T> Perspective(T fovY, T aspect, T zNear, T zFar) {
+			const T tanHalf = (T)std::tan(fovY / T{ 2 });
+			matrix4x4<T> out(T{});
+			out[0].x = T{ 1 } / (aspect * tanHalf);
+			out[1].y = T{ 1 } / tanHalf;
+			out[2].z = zFar / (zNear - zFar);
+			out[2].w = -T{ 1 };
+			out[3].z = -(zFar * zNear) / (zFar - zNear);
+			return out;
+		}
+
+		// @return An orthographic projection of the given view volume
+		static constexpr matrix4x4<T> Orthographic(T left, T right, T bottom, T top, T zNear, T zFar) {
+			matrix4x4<T> out;
+			out[0].x = T{ 2 } / (right - left);
+			out[1].y = T{ 2 } / (top - bottom);
+			out[2].z = -T{ 1 } / (zFar - zNear);
+			out[3].x = -(right + left) / (right - left);
+			out[3].y = -(top + bottom) / (top - bottom);
+			out[3].z = -zNear / (zFar - zNear);
+			return out;
+		}
+
+		// @return A view matrix at eye, looking towards target
+		static matrix4x4<T> LookAt(const vector3<T>& eye, const vector3<T>& target, const vector3<T>& up) {
+			const vector3<T> f = Normalize(target - eye);
+			const vector3<T> s = Normalize(Cross(f, up));
+			const vector3<T> u = Cross(s, f);
+			return matrix4x4<T>(
+				{ s.x, u.x, -f.x, T{} },
+				{ s.y, u.y, -f.y, T{} },
+				{ s.z, u.z, -f.z, T{} },
+				{ -Dot(s, eye), -Dot(u, eye), Dot(f, eye), T{ 1 } }
+			);
+		}
+	};
+
+	template<typename T>
+	constexpr bool operator==(const matrix4x4<T>& lhs, const matrix4x4<T>& rhs) { return lhs[0] == rhs[0] && lhs[1] == rhs[1] && lhs[2] == rhs[2] && lhs[3] == rhs[3]; }
+
+	template<typename T>
+	constexpr bool operator!=(const matrix4x4<T>& lhs, const matrix4x4<T>& rhs) { return !(lhs == rhs); }
+
+	template<typename T>
+	constexpr vector4<T> operator*(const matrix4x4<T>& lhs, const vector4<T>& rhs) {
+		return lhs[0] * rhs.x + lhs[1] * rhs.y + lhs[2] * rhs.z + lhs[3] * rhs.w;
+	}
+
+	template<typename T>
+	constexpr matrix4x4<T> operator*(const matrix4x4<T>& lhs, const matrix4x4<T>& rhs) {
+		if constexpr (std::is_same_v<T, float>) {
+			if (!CRUX_IS_CONSTANT_EVALUATED()) {
+				matrix4x4<float> out(0.0f);
+				internal::simd::Multiply4x4(lhs.data(), rhs.data(), out.data());
+				return out;
+			}
+		}
+		return matrix4x4<T>(lhs * rhs[0], lhs * rhs[1], lhs * rhs[2], lhs * rhs[3]);
+	}
+
+	template<typename T>
+	constexpr matrix4x4<T> operator*(const matrix4x4<T>& lhs, const typename matrix4x4<T>::value_type& rhs) {
+		return matrix4x4<T>(lhs[0] * rhs, lhs[1] * rhs, lhs[2] * rhs, lhs[3] * rhs);
+	}
+
+	// @return The point transformed with an implied w of 1, without a perspective divide
+	template<typename T>
+	constexpr vector3<T> TransformPoint(const matrix4x4<T>& m, const vector3<T>& point) {
+		return (m[0] * point.x + m[1] * point.y + m[2] * point.z + m[3]).xyz();
+	}
+
+	// @return The direction transformed with an implied w of 0, ignoring translation
+	template<typename T>
+	constexpr vector3<T> TransformDirection(const matrix4x4<T>& m, const vector3<T>& direction) {
+		return (m[0] * direction.x + m[1] * direction.y + m[2] * direction.z).xyz();
+	}
+
+	template<typename T>
+	constexpr matrix4x4<T> Transpose(const matrix4x4<T>& obj) {
+		return matrix4x4<T>(
+			{ obj[0].x, obj[1].x, obj[2].x, obj[3].x },
+			{ obj[0].y, obj[1].y, obj[2].y, obj[3].y },
+			{ obj[0].z, obj[1].z, obj[2].z, obj[3].z },
+			{ obj[0].w, obj[1].w, obj[2].w, obj[3].w }
+		);
+	}
+
+	namespace internal {
+		// The twelve 2x2 sub-determinants shared by Determinant and Inverse
+		template<typename T>
+		struct minors4x4 {
+			T s0, s1, s2, s3, s4, s5;
+			T c0, c1, c2, c3, c4, c5;
+
+			constexpr explicit minors4x4(const matrix4x4<T>& a)
+				: s0(a[0].x * a[1].y - a[1].x * a[0].y)
+				, s1(a[0].x * a[1].z - a[1].x * a[0].z)
+				, s2(a[0].x * a[1].w - a[1].x * a[0].w)
+				, s3(a[0].y * a[1].z - a[1].y * a[0].z)
+				, s4(a[0].y * a[1].w - a[1].y * a[0].w)
+				, s5(a[0].z * a[1].w - a[1].z * a[0].w)
+				, c0(a[2].x * a[3].y - a[3].x * a[2].y)
+				, c1(a[2].x * a[3].z - a[3].x * a[2].z)
+				, c2(a[2].x * a[3].w - a[3].x * a[2].w)
+				, c3(a[2].y * a[3].z - a[3].y * a[2].z)
+				, c4(a[2].y * a[3].w - a[3].y * a[2].w)
+				, c5(a[2].z * a[3].w - a[3].z * a[2].w) {}
+
+			constexpr T Determinant() const { return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0; }
+		};
+
+		// Scalar cofactor inverse, shared by crux::Inverse and the non-SIMD kernel
+		template<typename T>
+		constexpr bool InverseScalar(const matrix4x4<T>& a, matrix4x4<T>& out) {
+			const minors4x4<T> m(a);
+			const T det = m.Determinant();
+			if (det == T{})
+				return false;
+			const T inv = T{ 1 } / det;
+
+			out = matrix4x4<T>(
+				{
+					( a[1].y * m.c5 - a[1].z * m.c4 + a[1].w * m.c3) * inv,
+					(-a[0].y * m.c5 + a[0].z * m.c4 - a[0].w * m.c3) * inv,
+					( a[3].y * m.s5 - a[3].z * m.s4 + a[3].w * m.s3) * inv,
+					(-a[2].y * m.s5 + a[2].z * m.s4 - a[2].w * m.s3) * inv
+				},
+				{
+					(-a[1].x * m.c5 + a[1].z * m.c2 - a[1].w * m.c1) * inv,
+					( a[0].x * m.c5 - a[0].z * m.c2 + a[0].w * m.c1) * inv,
+					(-a[3].x * m.s5 + a[3].z * m.s2 - a[3].w * m.s1) * inv,
+					( a[2].x * m.s5 - a[2].z * m.s2 + a[2].w * m.s1) * inv
+				},
+				{
+					( a[1].x * m.c4 - a[1].y * m.c2 + a[1].w * m.c0) * inv,
+					(-a[0].x * m.c4 + a[0].y * m.c2 - a[0].w * m.c0) * inv,
+					( a[3].x * m.s4 - a[3].y * m.s2 + a[3].w * m.s0) * inv,
+					(-a[2].x * m.s4 + a[2].y * m.s2 - a[2].w * m.s0) * inv
+				},
+				{
+					(-a[1].x * m.c3 + a[1].y * m.c1 - a[1].z * m.c0) * inv,
+					( a[0].x * m.c3 - a[0].y * m.c1 + a[0].z * m.c0) * inv,
+					(-a[3].x * m.s3 + a[3].y * m.s1 - a[3].z * m.s0) * inv,
+					( a[2].x * m.s3 - a[2].y * m.s1 + a[2].z * m.s0) * inv
+				}
+			);
+			return true;
+		}
+	}
+
+	template<typename T>
+	constexpr T Determinant(const matrix4x4<T>& obj) { return internal::minors4x4<T>(obj).Determinant(); }
+
+	/**
+	 * @brief Inverts a general 4x4 matrix.
+	 * @return The inverse, or nullopt if the matrix is singular
+	*/
+	template<typename T>
+	constexpr optional<matrix4x4<T>> Inverse(const matrix4x4<T>& a) {
+		matrix4x4<T> out(T{});
+		if constexpr (std::is_same_v<T, float>) {
+			if (!CRUX_IS_CONSTANT_EVALUATED()) {
+				if (!internal::simd::Inverse4x4(a.data(), out.data()))
+					return nullopt;
+				return out;
+			}
+		}
+
+		if (!internal::InverseScalar(a, out))
+			return nullopt;
+		return out;
+	}
+
+	template<typename T>
+	std::ostream& operator<<(std::ostream& out, const matrix4x4<T>& obj) {
+		out << "matrix4x4{" << obj[0] << ", " << obj[1] << ", " << obj[2] << ", " << obj[3] << "}";
+		return out;
+	}
+
+	static_assert(std::is_trivially_copyable_v<matrix4x4<float>>, "matrix4x4 must be trivially copyable");
+	static_assert(sizeof(matrix4x4<float>) == 16 * sizeof(float), "matrix4x4 must be 16 contiguous components");
+}
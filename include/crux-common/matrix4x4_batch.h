@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ * Batch kernels applying a matrix4x4<float> to spans of vectors or matrices.
+ * vector4 and matrix inputs use SSE registers (two vectors at a time with AVX),
+ * vector3 inputs four at a time, straight in their packed layout.
+ */
+
+#include <cstddef>
+
+#include "matrix4x4.h"
+#include "span.h"
+#include "types.h"
+
+namespace crux::batch {
+	/**
+	 * @brief Transforms homogeneous vectors, out[i] = m * in[i].
+	 * The output may alias the input.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Transform(const mat4f& m, span<const vec4f> in, span<vec4f> out);
+
+	/**
+	 * @brief Transforms points with an implied w of 1, without a perspective divide.
+	 * The output may alias the input.
+	 * @return Number of elements written to out
+	*/
+	std::size_t TransformPoints(const mat4f& m, span<const vec3f> in, span<vec3f> out);
+
+	/**
+	 * @brief Transforms directions with an implied w of 0, ignoring translation.
+	 * The output may alias the input.
+	 * @return Number of elements written to out
+	*/
+	std::size_t TransformDirections(const mat4f& m, span<const vec3f> in, span<vec3f> out);
+
+	/**
+	 * @brief Concatenates a parent transform onto many children, out[i] = parent * in[i].
+	 * The output may alias the input.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Multiply(const mat4f& parent, span<const mat4f> in, span<mat4f> out);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+/*
+ * Allocation tracking, enabled by building with CRUX_TRACK_ALLOCATIONS=1
+ * (premake5 --track-allocations).
+ * When enabled the global operator new/delete are replaced to count every
+ * heap allocation, attributed to the calling thread's current MemoryTag,
+ * and the crux::memory allocators report their own traffic. Live
+ * allocations are kept in a list so leaks can be reported at shutdown.
+ * When disabled everything here compiles to no-ops and Stats() is empty.
+ */
+
+#include <cstdio>
+
+#include "types.h"
+
+#ifndef CRUX_TRACK_ALLOCATIONS
+	#define CRUX_TRACK_ALLOCATIONS 0
+#endif
+
+namespace crux::memory {
+	/**
+	 * @brief Category heap allocations are attributed to, see ScopedTag.
+	*/
+	enum class MemoryTag : uint8bit {
+		UNTAGGED = 0,
+		WINDOW,
+		EVENTS,
+		STRING,
+		PLATFORM,
+		JOBS,
+		USER,
+
+		COUNT
+	};
+
+	/**
+	 * @brief The crux allocators reporting their traffic.
+	 * Their memory comes from upstream (usually the heap, where it is
+	 * counted again), these count the sub-allocations made from it.
+	 * Arenas free in bulk, their frees stay 0 and only liveBytes drops.
+	*/
+	enum class AllocatorKind : uint8bit {
+		ARENA = 0,
+		POOL,
+		TLSF,
+
+		COUNT
+	};
+
+	constexpr std::size_t MemoryTagCount = (std::size_t)MemoryTag::COUNT;
+	constexpr std::size_t AllocatorKindCount = (std::size_t)AllocatorKind::COUNT;
+
+	/**
+	 * @brief Counters of one tag or allocator.
+	*/
+	struct AllocationCounters {
+		// Allocations made
+		uint64bit allocations = 0;
+
+		// Allocations freed
+		uint64bit frees = 0;
+
+		// Bytes currently allocated
+		uint64bit liveBytes = 0;
+
+		// Highest liveBytes seen
+		uint64bit peakBytes = 0;
+
+		// Bytes allocated over the whole run
+		uint64bit totalBytes = 0;
+
+		// @return Allocations not freed yet
+		inline uint64bit GetLiveCount() const { return allocations - frees; }
+	};
+
+	/**
+	 * @brief Snapshot of the tracked allocations, see Stats().
+	*/
+	struct MemoryStats {
+		// False when built without CRUX_TRACK_ALLOCATIONS, everything else is then zero
+		bool enabled = false;
+
+		// All heap allocations
+		AllocationCounters heap;
+
+		// Heap allocations by the tag active when they were made
+		AllocationCounters tags[MemoryTagCount];
+
+		// Sub-allocations made through the crux allocators
+		AllocationCounters allocators[AllocatorKindCount];
+
+		// Number of MarkFrame() calls
+		uint64bit frame = 0;
+
+		// Heap allocations and bytes since the last MarkFrame()
+		uint64bit frameAllocations = 0;
+		uint64bit frameBytes = 0;
+
+		// Heap allocations and bytes of the last complete frame
+		uint64bit lastFrameAllocations = 0;
+		uint64bit lastFrameBytes = 0;
+	};
+
+	/**
+	 * @brief Takes a snapshot of the allocation counters.
+	 * The counters are read without stopping other threads, so the
+	 * fields may be off by the allocations made while reading them.
+	*/
+	MemoryStats Stats();
+
+	/**
+	 * @brief Closes the current frame, moving its counts to lastFrame*.
+	 * Call once per frame, ie. next to FrameTimer::Tick().
+	*/
+	void MarkFrame();
+
+	/**
+	 * @brief Prints every live heap allocation, grouped by tag, with its size and sequence number.
+	 * @param out Stream to print to
+	 * @param maxListed Limit of individual allocations printed, the per tag totals are always printed
+	 * @return Number of live allocations
+	*/
+	uint64bit ReportLeaks(std::FILE* out = stderr, std::size_t maxListed = 32);
+
+	// @return Printable name of a tag
+	const char* GetTagName(MemoryTag tag);
+
+	// @return Printable name of an allocator kind
+	const char* GetAllocatorName(AllocatorKind kind);
+
+	// @return The calling thread's current tag
+	MemoryTag GetCurrentTag();
+
+	/**
+	 * @brief Attributes the calling thread's heap allocations to a tag for its scope.
+	 * Scopes nest, the previous tag is restored on destruction.
+	*/
+	class ScopedTag {
+	public:
+		explicit ScopedTag(MemoryTag tag);
+		~ScopedTag();
+
+		ScopedTag(const ScopedTag&) = delete;
+		ScopedTag& operator=(const ScopedTag&) = delete;
+
+	private:
+		MemoryTag previous;
+	};
+
+	namespace internal {
+		// Reports a sub-allocation by one of the crux allocators
+		void RecordAllocatorAllocation(AllocatorKind kind, std::size_t bytes);
+
+		// Reports a sub-allocation being freed, frees may cover several allocations at once (ie. Arena::Reset)
+		void RecordAllocatorFree(AllocatorKind kind, std::size_t bytes, std::size_t count);
+	}
+}
+
+/**
+ * @brief Tags the heap allocations of the rest of the enclosing scope.
+ * Compiles to nothing without CRUX_TRACK_ALLOCATIONS.
+*/
+#if CRUX_TRACK_ALLOCATIONS
+	#define CRUX_MEMORY_CONCAT_INNER(a, b) a##b
+	#define CRUX_MEMORY_CONCAT(a, b) CRUX_MEMORY_CONCAT_INNER(a, b)
+	#define CRUX_MEMORY_TAG(tag) ::crux::memory::ScopedTag CRUX_MEMORY_CONCAT(cruxMemoryTag, __LINE__)(::crux::memory::MemoryTag::tag)
+#else
+	#define CRUX_MEMORY_TAG(tag) ((void)0)
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "platform.h"
+
+#if CRUX_UNIX
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+namespace crux::internal::nix {
+	/**
+	 * @brief Wraps errno and dlerror() into a readable string,
+	 * the POSIX counterpart of the Win32 GetLastErrorString().
+	 * A pending dlerror() message takes priority over errno.
+	 * @return String of the last error to occure
+	*/
+	std::string GetLastErrorString();
+
+	/**
+	 * @brief GetLastErrorString() allocating from the given memory resource.
+	 * @param resource Resource for the returned string, ie. a frame arena
+	 * @return String of the last error to occure
+	*/
+	std::pmr::string GetLastErrorString(std::pmr::memory_resource* resource);
+
+	/**
+	 * @brief Reads errno without clearing it.
+	 * @return The calling thread's last error code
+	*/
+	uint32_t GetLastErrorCode();
+
+	/**
+	 * @brief Turns an errno value into its message, ie. one saved by GetLastErrorCode().
+	 * @param code Error code to describe
+	 * @return Message of the code, empty for 0
+	*/
+	std::string GetErrorString(uint32_t code);
+
+	/**
+	 * @brief Opens a shared library with dlopen(), without any bookkeeping.
+	 * crux::DynamicLibrary builds its reference counting on top of this.
+	 * @param name Library name (OS specific)
+	 * @return Handle returned by dlopen(), or nullptr on failure
+	*/
+	void* OpenLibrary(const std::string& name);
+
+	/**
+	 * @brief Closes a handle returned by OpenLibrary().
+	 * @param handle Handle to close
+	*/
+	void CloseLibrary(void* handle);
+
+	/**
+	 * @brief Looks up an exported symbol with dlsym().
+	 * @param handle Handle returned by OpenLibrary()
+	 * @param symbol Null terminated symbol name
+	 * @return Address of the symbol, or nullptr if not exported
+	*/
+	void* FindLibrarySymbol(void* handle, const char* symbol);
+
+	/**
+	 * @brief Checks if the given shared library has been loaded
+	 * @param name Library name (OS specific, ie. "libX11.so.6")
+	 * @return True if the library has been loaded
+	*/
+	bool HasNixLibrary(const std::string& name);
+
+	/**
+	 * @brief Attempts to load a shared library using dlopen().
+	 * If successful, the library name will be kept in an internal map for
+	 * handle retrieval and cleanup purposes.
+	 * If the library was already loaded, the existing handle is returned.
+	 * @param name Library name (OS specific)
+	 * @return Handle returned by dlopen(), or nullptr on failure
+	*/
+	void* LoadNixLibrary(const std::string& name);
+
+	/**
+	 * @brief Attempts to load shared libraries using dlopen().
+	 * If successful, the library name will be kept in an internal map for
+	 * handle retrieval and cleanup purposes.
+	 * @param names Vector of library names (OS specific)
+	 * @return Vector of names newly loaded
+	*/
+	const std::vector<std::string> LoadNixLibraries(const std::vector<std::string>& names);
+
+	/**
+	 * @brief LoadNixLibraries() allocating the returned names from the given memory resource.
+	 * @param names Vector of library names (OS specific)
+	 * @param resource Resource for the returned vector and its strings
+	 * @return Vector of names newly loaded
+	*/
+	std::pmr::vector<std::pmr::string> LoadNixLibraries(const std::vector<std::string>& names, std::pmr::memory_resource* resource);
+
+	/**
+	 * @brief Gets the handle of the library matching the given name.
+	 * If the library has not been loaded, then nullptr is returned instead.
+	 * @param name Library name (OS specific)
+	 * @return Handle returned by dlopen()
+	*/
+	void* GetNixLibrary(const std::string& name);
+
+	/**
+	 * @brief Closes the library loaded under the provided name.
+	 * If the library was not loaded, this will silently return.
+	 * @param name Library name (OS specific)
+	*/
+	void FreeNixLibrary(const std::string& name);
+
+	/**
+	 * @brief Closes all libraries loaded.
+	*/
+	void FreeAllNixLibraries();
+}
+
+#endif // CRUX_UNIX
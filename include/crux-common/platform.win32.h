@@ -4,23 +4,55 @@
 
 #if CRUX_WIN32
 
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
+
+#include "small_string.h"
+
 namespace crux::internal::win32 {
+	// Wide text buffer holding MAX_PATH characters inline, so paths and titles convert without allocating
+	using WideBuffer = small_string<wchar_t, 260>;
+
 	/**
-	 * @brief Converts an std::string into a std::wstring for use with Win32 API
+	 * @brief Converts a UTF-8 std::string into a UTF-16 std::wstring for use with Win32 API
 	 * @param input string to convert
 	 * @return Converted wide string
 	*/
 	std::wstring StringToWideString(const std::string&);
 
 	/**
-	 * @brief Converts an std::wstring into a std::string for use with Win32 API
+	 * @brief StringToWideString() allocating from the given memory resource.
+	 * @param input string to convert
+	 * @param resource Resource for the returned string, ie. a frame arena
+	 * @return Converted wide string
+	*/
+	std::pmr::wstring StringToWideString(std::string_view input, std::pmr::memory_resource* resource);
+
+	/**
+	 * @brief StringToWideString() into a caller owned buffer, ie. for a single API call.
+	 * @param input string to convert
+	 * @param output Buffer replaced with the null terminated wide string
+	*/
+	void StringToWideString(std::string_view input, WideBuffer& output);
+
+	/**
+	 * @brief Converts a UTF-16 std::wstring into a UTF-8 std::string for use with Win32 API
 	 * @param input wide string to convert
 	 * @return Converted string
 	*/
 	std::string WideStringToString(const std::wstring&);
 
+	/**
+	 * @brief WideStringToString() allocating from the given memory resource.
+	 * @param input wide string to convert
+	 * @param resource Resource for the returned string
+	 * @return Converted string
+	*/
+	std::pmr::string WideStringToString(std::wstring_view input, std::pmr::memory_resource* resource);
+
 	/**
 	 * @brief Wraps the Win32 API GetLastError() function to include
 	 * the appropriate FormatMessage code to return a string version.
@@ -28,6 +60,48 @@ namespace crux::internal::win32 {
 	*/
 	std::string GetLastErrorString();
 
+	/**
+	 * @brief GetLastErrorString() allocating from the given memory resource.
+	 * @param resource Resource for the returned string
+	 * @return String of the last Win32 API error to occure
+	*/
+	std::pmr::string GetLastErrorString(std::pmr::memory_resource* resource);
+
+	/**
+	 * @brief Reads GetLastError() without clearing it.
+	 * @return The calling thread's last Win32 error code
+	*/
+	uint32_t GetLastErrorCode();
+
+	/**
+	 * @brief Turns a Win32 error code into its message, ie. one saved by GetLastErrorCode().
+	 * @param code Error code to describe
+	 * @return Message of the code, empty for 0
+	*/
+	std::string GetErrorString(uint32_t code);
+
+	/**
+	 * @brief Loads a library with LoadLibraryW(), without any bookkeeping.
+	 * crux::DynamicLibrary builds its reference counting on top of this.
+	 * @param name Library name (OS specific), UTF-8
+	 * @return HMODULE of the library, or nullptr on failure
+	*/
+	void* OpenLibrary(const std::string& name);
+
+	/**
+	 * @brief Frees a handle returned by OpenLibrary().
+	 * @param handle Handle to free
+	*/
+	void CloseLibrary(void* handle);
+
+	/**
+	 * @brief Looks up an exported symbol with GetProcAddress().
+	 * @param handle Handle returned by OpenLibrary()
+	 * @param symbol Null terminated symbol name
+	 * @return Address of the symbol, or nullptr if not exported
+	*/
+	void* FindLibrarySymbol(void* handle, const char* symbol);
+
 	/**
 	 * @brief Checks if the given Windows library has been loaded
 	 * @param name Library name (OS specific)
@@ -54,6 +128,14 @@ namespace crux::internal::win32 {
 	*/
 	const std::vector<std::string> LoadWinLibraries(const std::vector<std::string>& names);
 
+	/**
+	 * @brief LoadWinLibraries() allocating the returned names from the given memory resource.
+	 * @param names Vector of library names (OS specific)
+	 * @param resource Resource for the returned vector and its strings
+	 * @return Vector of names successfully loaded
+	*/
+	std::pmr::vector<std::pmr::string> LoadWinLibraries(const std::vector<std::string>& names, std::pmr::memory_resource* resource);
+
 	/**
 	 * @brief Gets a pointer to the library process matching the given name.
 	 * If the library has not been loaded, then nullptr is returned instead.
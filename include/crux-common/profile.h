@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+ * Instrumented profiling, enabled by building with CRUX_PROFILE=1
+ * (premake5 --profile).
+ * CRUX_PROFILE_SCOPE records the begin and end time of the enclosing scope
+ * into a lock-free buffer owned by the calling thread. Collect(), called by
+ * every MarkFrame(), moves the buffered zones into the capture, which
+ * WriteChromeTrace() saves in the Chrome Trace Event format for
+ * chrome://tracing, Perfetto or Tracy's import-chrome tool.
+ * Building with CRUX_PROFILE_TRACY=1 instead forwards the macros to Tracy
+ * (Tracy's public directory must be on the include path and TracyClient.cpp
+ * built into the program), the capture functions then stay empty.
+ * When disabled the macros expand to nothing and the functions are no-ops.
+ */
+
+#include <cstddef>
+#include <cstdio>
+
+#include "clock.h"
+#include "types.h"
+
+#ifndef CRUX_PROFILE
+	#define CRUX_PROFILE 0
+#endif
+
+#ifndef CRUX_PROFILE_TRACY
+	#define CRUX_PROFILE_TRACY 0
+#endif
+
+namespace crux::profile {
+	/**
+	 * @brief Names the calling thread in the exported trace.
+	 * @param name Thread name, copied
+	*/
+	void SetThreadName(const char* name);
+
+	/**
+	 * @brief Marks the end of a frame, the time since the previous mark is
+	 * exported as a "Frame" zone on its own track. Also calls Collect().
+	 * crux::FrameTimer::Tick() marks frames on its own.
+	*/
+	void MarkFrame();
+
+	/**
+	 * @brief Moves the zones buffered by every thread into the capture.
+	 * A thread's buffer holds a limited number of zones, zones recorded
+	 * while it is full are dropped, so collect at least once per frame.
+	*/
+	void Collect();
+
+	/**
+	 * @brief Writes the capture as Chrome Trace Event JSON, collecting first.
+	 * @return False if the file could not be opened (or profiling is disabled)
+	*/
+	bool WriteChromeTrace(const string& path);
+
+	/**
+	 * @brief WriteChromeTrace() into an open file.
+	 * @return False if profiling is disabled
+	*/
+	bool WriteChromeTrace(std::FILE* out);
+
+	// Empties the capture, buffered zones not collected yet are kept
+	void Clear();
+
+	// @return Zones in the capture, frames included
+	std::size_t GetZoneCount();
+
+	// @return Zones lost to a full thread buffer or a full capture
+	uint64bit GetDroppedCount();
+
+	namespace internal {
+		// Buffers a finished zone on the calling thread
+		void RecordZone(const char* name, uint64bit start, uint64bit end);
+	}
+
+	/**
+	 * @brief Records the time between its construction and destruction, see CRUX_PROFILE_SCOPE.
+	*/
+	class Zone {
+	public:
+		// @param name Zone name, must outlive the capture (a literal)
+		explicit Zone(const char* name) : name(name), start(clock::Now()) {}
+		~Zone() { internal::RecordZone(name, start, clock::Now()); }
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* name;
+		uint64bit start;
+	};
+}
+
+#define CRUX_PROFILE_CONCAT_INNER(a, b) a##b
+#define CRUX_PROFILE_CONCAT(a, b) CRUX_PROFILE_CONCAT_INNER(a, b)
+
+#if CRUX_PROFILE_TRACY
+	#include <tracy/Tracy.hpp>
+
+	#define CRUX_PROFILE_SCOPE(name) ZoneScopedN(name)
+	#define CRUX_PROFILE_FUNCTION() ZoneScoped
+	#define CRUX_PROFILE_FRAME() FrameMark
+	#define CRUX_PROFILE_THREAD(name) tracy::SetThreadName(name)
+#elif CRUX_PROFILE
+	// Profiles the rest of the enclosing scope under the given name (a literal)
+	#define CRUX_PROFILE_SCOPE(name) ::crux::profile::Zone CRUX_PROFILE_CONCAT(cruxProfileZone, __LINE__)(name)
+
+	// Profiles the rest of the enclosing function under its name
+	#define CRUX_PROFILE_FUNCTION() CRUX_PROFILE_SCOPE(__func__)
+
+	// Marks the end of a frame
+	#define CRUX_PROFILE_FRAME() ::crux::profile::MarkFrame()
+
+	// Names the calling thread
+	#define CRUX_PROFILE_THREAD(name) ::crux::profile::SetThreadName(name)
+#else
+	#define CRUX_PROFILE_SCOPE(name) ((void)0)
+	#define CRUX_PROFILE_FUNCTION() ((void)0)
+	#define CRUX_PROFILE_FRAME() ((void)0)
+	#define CRUX_PROFILE_THREAD(name) ((void)0)
+#endif
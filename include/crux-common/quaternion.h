@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+#include "vector3.h"
+
+namespace crux {
+	/**
+	 * @brief Rotation quaternion, with x/y/z as the vector part and w as the scalar part.
+	 *
+	 * Default constructs to the identity rotation. The rotation functions
+	 * expect unit quaternions, use Normalize() after accumulating many products.
+	*/
+	template<typename T>
+	struct quaternion {
+		using value_type = T;
+
+		T x, y, z, w;
+
+		constexpr quaternion() : x(T{}), y(T{}), z(T{}), w(T{ 1 }) {}
+		constexpr quaternion(const T& initX, const T& initY, const T& initZ, const T& initW) : x(initX), y(initY), z(initZ), w(initW) {}
+
+		constexpr quaternion(const quaternion<T>&) = default;
+		constexpr quaternion(quaternion<T>&&) = default;
+		constexpr quaternion<T>& operator=(const quaternion<T>&) = default;
+		constexpr quaternion<T>& operator=(quaternion<T>&&) = default;
+
+		// Combines rotations, applying obj first and then this
+		constexpr quaternion<T>& operator*=(const quaternion<T>& obj) { return *this = *this * obj; }
+
+		// @return The identity (no rotation) quaternion
+		static constexpr quaternion<T> Identity() { return quaternion<T>(); }
+
+		/**
+		 * @brief Builds a rotation around an axis.
+		 * @param axis Unit-length rotation axis
+		 * @param radians Counter-clockwise angle, in radians
+		*/
+		static quaternion<T> FromAxisAngle(const vector3<T>& axis, T radians) {
+			const T s = (T)std::sin(radians * T(0.5));
+			return quaternion<T>(axis.x * s, axis.y * s, axis.z * s, (T)std::cos(radians * T(0.5)));
+		}
+
+		// @return The vector (imaginary) part
+		constexpr vector3<T> xyz() const { return vector3<T>(x, y, z); }
+	};
+
+	template<typename T>
+	constexpr bool operator==(const quaternion<T>& lhs, const quaternion<T>& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.w == rhs.w; }
+
+	template<typename T>
+	constexpr bool operator!=(const quaternion<T>& lhs, const quaternion<T>& rhs) { return !(lhs == rhs); }
+
+	// Hamilton product, the result applies rhs first and then lhs
+	template<typename T>
+	constexpr quaternion<T> operator*(const quaternion<T>& lhs, const quaternion<T>& rhs) {
+		return quaternion<T>(
+			lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+			lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z
+		);
+	}
+
+	template<typename T>
+	constexpr quaternion<T> operator+(const quaternion<T>& lhs, const quaternion<T>& rhs) { return quaternion<T>(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w); }
+
+	template<typename T>
+	constexpr quaternion<T> operator-(const quaternion<T>& obj) { return quaternion<T>(-obj.x, -obj.y, -obj.z, -obj.w); }
+
+	template<typename T>
+	constexpr quaternion<T> operator*(const quaternion<T>& lhs, const typename quaternion<T>::value_type& rhs) { return quaternion<T>(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs, lhs.w * rhs); }
+
+	template<typename T>
+	constexpr T Dot(const quaternion<T>& lhs, const quaternion<T>& rhs) { return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w; }
+
+	template<typename T>
+	constexpr T LengthSquared(const quaternion<T>& obj) { return Dot(obj, obj); }
+
+	// @return The conjugate, which is also the inverse of a unit quaternion
+	template<typename T>
+	constexpr quaternion<T> Conjugate(const quaternion<T>& obj) { return quaternion<T>(-obj.x, -obj.y, -obj.z, obj.w); }
+
+	// @return The inverse rotation, valid for non-unit quaternions as well
+	template<typename T>
+	constexpr quaternion<T> Inverse(const quaternion<T>& obj) { return Conjugate(obj) * (T{ 1 } / LengthSquared(obj)); }
+
+	// @return The quaternion scaled to unit length, or identity if it has no length
+	template<typename T>
+	quaternion<T> Normalize(const quaternion<T>& obj) {
+		const T len = (T)std::sqrt(LengthSquared(obj));
+		return len > T{} ? obj * (T{ 1 } / len) : quaternion<T>();
+	}
+
+	// @return The vector rotated by the unit quaternion
+	template<typename T>
+	constexpr vector3<T> Rotate(const quaternion<T>& rotation, const vector3<T>& v) {
+		const vector3<T> u = rotation.xyz();
+		const vector3<T> t = Cross(u, v) * T{ 2 };
+		return v + t * rotation.w + Cross(u, t);
+	}
+
+	/**
+	 * @brief Spherical interpolation between two unit quaternions, along the shortest arc.
+	 * @param t Interpolation factor, 0 returns from and 1 returns to
+	*/
+	template<typename T>
+	quaternion<T> Slerp(const quaternion<T>& from, const quaternion<T>& to, T t) {
+		quaternion<T> end = to;
+		T cosTheta = Dot(from, to);
+		if (cosTheta < T{}) {
+			end = -to;
+			cosTheta = -cosTheta;
+		}
+
+		//Nearly parallel, fall back to a normalized lerp to avoid dividing by sin(0)
+		if (cosTheta > T(0.9995))
+			return Normalize(from * (T{ 1 } - t) + end * t);
+
+		const T theta = (T)std::acos(cosTheta);
+		const T sinTheta = (T)std::sin(theta);
+		const T a = (T)std::sin((T{ 1 } - t) * theta) / sinTheta;
+		const T b = (T)std::sin(t * theta) / sinTheta;
+		return from * a + end * b;
+	}
+
+	template<typename T>
+	std::ostream& operator<<(std::ostream& out, const quaternion<T>& obj) {
+		out << "quaternion{" << obj.x << ", " << obj.y << ", " << obj.z << ", " << obj.w << "}";
+		return out;
+	}
+
+	static_assert(std::is_trivially_copyable_v<quaternion<float>>, "quaternion must be trivially copyable");
+}
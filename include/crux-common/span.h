@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+ * Wraps up the span from either STD, or if too early, a minimal crux version
+ */
+
+#if __cplusplus >= 202002L //CPP-20+
+	#include <span>
+	namespace crux {
+		template <typename T>
+		using span = std::span<T>;
+	}
+#else //CPP-17 and below
+	#include <cstddef>
+	#include <type_traits>
+	#include <utility>
+	namespace crux {
+		/**
+		 * @brief Non-owning view over a contiguous sequence of T.
+		 * Only covers the dynamic-extent subset of std::span that crux uses.
+		*/
+		template <typename T>
+		class span {
+		public:
+			using element_type = T;
+			using value_type = std::remove_cv_t<T>;
+			using size_type = std::size_t;
+			using pointer = T*;
+			using reference = T&;
+			using iterator = T*;
+
+			constexpr span() noexcept : ptr(nullptr), count(0) {}
+			constexpr span(T* first, size_type size) noexcept : ptr(first), count(size) {}
+			constexpr span(T* first, T* last) noexcept : ptr(first), count(static_cast<size_type>(last - first)) {}
+
+			template <std::size_t N>
+			constexpr span(T (&arr)[N]) noexcept : ptr(arr), count(N) {}
+
+			// Any contiguous container exposing data() and size(), ie. std::vector or std::array
+			template <typename Container, typename = std::enable_if_t<
+				!std::is_same_v<std::remove_cv_t<Container>, span> &&
+				std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+			constexpr span(Container& container) noexcept : ptr(container.data()), count(container.size()) {}
+
+			// Allows span<U> to become span<const U>
+			template <typename U, typename = std::enable_if_t<!std::is_same_v<U, T> && std::is_convertible_v<U(*)[], T(*)[]>>>
+			constexpr span(const span<U>& other) noexcept : ptr(other.data()), count(other.size()) {}
+
+			constexpr T* data() const noexcept { return ptr; }
+			constexpr size_type size() const noexcept { return count; }
+			constexpr size_type size_bytes() const noexcept { return count * sizeof(T); }
+			constexpr bool empty() const noexcept { return count == 0; }
+
+			constexpr T& operator[](size_type idx) const { return ptr[idx]; }
+			constexpr T& front() const { return ptr[0]; }
+			constexpr T& back() const { return ptr[count - 1]; }
+
+			constexpr iterator begin() const noexcept { return ptr; }
+			constexpr iterator end() const noexcept { return ptr + count; }
+
+			constexpr span first(size_type n) const { return { ptr, n }; }
+			constexpr span last(size_type n) const { return { ptr + (count - n), n }; }
+			constexpr span subspan(size_type offset, size_type n = static_cast<size_type>(-1)) const {
+				return { ptr + offset, n == static_cast<size_type>(-1) ? count - offset : n };
+			}
+
+		private:
+			T* ptr;
+			size_type count;
+		};
+	}
+#endif
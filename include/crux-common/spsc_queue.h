@@ -0,0 +1,153 @@
+#pragma once
+
+/*
+ * Bounded lock-free single-producer/single-consumer ring buffer.
+ * Exactly one thread may push and exactly one (possibly the same) thread may pop.
+ * Neither side takes a lock or allocates after construction.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "span.h"
+
+namespace crux {
+	/**
+	 * @brief Bounded lock-free single-producer/single-consumer queue.
+	 *
+	 * The capacity is rounded up to a power of two so indices wrap with a mask.
+	 * Head and tail live on their own cache lines, and each side keeps a cached
+	 * copy of the other's index so the shared atomics are only re-read when
+	 * the queue looks full (producer) or empty (consumer).
+	 * @tparam T Element type, must be trivially copyable
+	*/
+	template<typename T>
+	class spsc_queue {
+		static_assert(std::is_trivially_copyable<T>::value, "spsc_queue elements must be trivially copyable");
+
+	public:
+		// Assumed size of a cache line, used to keep the indices from false sharing
+		static constexpr std::size_t CacheLine = 64;
+
+		/**
+		 * @brief Construct a queue holding at least the given number of elements.
+		 * @param minCapacity Requested capacity, rounded up to a power of two (minimum 2)
+		*/
+		explicit spsc_queue(std::size_t minCapacity) {
+			std::size_t cap = 2;
+			while (cap < minCapacity)
+				cap <<= 1;
+			mask = cap - 1;
+			buffer = std::make_unique<T[]>(cap);
+		}
+
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		/**
+		 * @brief Producer side, appends an element.
+		 * @return False if the queue is full, the element is not added
+		*/
+		bool try_push(const T& value) {
+			const std::size_t t = tail.load(std::memory_order_relaxed);
+			if (t - headCache > mask) {
+				headCache = head.load(std::memory_order_acquire);
+				if (t - headCache > mask)
+					return false;
+			}
+
+			buffer[t & mask] = value;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Consumer side, removes the oldest element.
+		 * @return False if the queue is empty, out is untouched
+		*/
+		bool try_pop(T& out) {
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			if (h == tailCache) {
+				tailCache = tail.load(std::memory_order_acquire);
+				if (h == tailCache)
+					return false;
+			}
+
+			out = buffer[h & mask];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Consumer side, removes as many elements as fit in out
+		 * with a single release of the head index.
+		 * @return Number of elements written to out
+		*/
+		std::size_t pop_n(span<T> out) {
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			tailCache = tail.load(std::memory_order_acquire);
+
+			std::size_t n = tailCache - h;
+			if (n > out.size())
+				n = out.size();
+
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = buffer[(h + i) & mask];
+
+			if (n)
+				head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		/**
+		 * @brief Consumer side, hands up to max elements to fn, oldest first,
+		 * with a single release of the head index. For moving elements into a
+		 * destination that is not a plain span, without an intermediate copy.
+		 * @param fn Called as fn(const T&) for every element, must not touch the queue
+		 * @return Number of elements consumed
+		*/
+		template<typename Fn>
+		std::size_t consume_n(std::size_t max, Fn&& fn) {
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			tailCache = tail.load(std::memory_order_acquire);
+
+			std::size_t n = tailCache - h;
+			if (n > max)
+				n = max;
+
+			for (std::size_t i = 0; i < n; ++i)
+				fn(static_cast<const T&>(buffer[(h + i) & mask]));
+
+			if (n)
+				head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		// @return Approximate element count, exact only when called from one side with the other idle
+		std::size_t size_approx() const {
+			const std::size_t h = head.load(std::memory_order_acquire);
+			const std::size_t t = tail.load(std::memory_order_acquire);
+			return t - h;
+		}
+
+		// @return True if the queue looked empty at the time of the call
+		bool empty() const { return size_approx() == 0; }
+
+		// @return Maximum number of elements the queue can hold
+		std::size_t capacity() const { return mask + 1; }
+
+	private:
+		std::unique_ptr<T[]> buffer;
+		std::size_t mask = 0;
+
+		//Consumer owned
+		alignas(CacheLine) std::atomic<std::size_t> head{ 0 };
+		std::size_t tailCache = 0;
+
+		//Producer owned
+		alignas(CacheLine) std::atomic<std::size_t> tail{ 0 };
+		std::size_t headCache = 0;
+	};
+}
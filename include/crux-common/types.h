@@ -1,8 +1,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 
 #include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "matrix3x3.h"
+#include "matrix4x4.h"
+#include "quaternion.h"
 
 using string = std::string;
 
@@ -33,8 +39,8 @@ using uint32bit = uint32_t;
 /// 64bit unsigned integer, strictly sized
 using uint64bit = uint64_t;
 
-/// Alias of uint32 for easier readability
-using uint = uint32;
+/// Alias of uint32bit for easier readability, matching the glibc typedef of unsigned int
+using uint = uint32bit;
 
 
 /// 8bit signed integer, using the "fast" option (memory at least 8 bits)
@@ -74,3 +80,16 @@ using float64 = double;
 using vec2u = crux::vector2<uint>;
 using vec2i = crux::vector2<int>;
 using vec2f = crux::vector2<float>;
+
+using vec3u = crux::vector3<uint>;
+using vec3i = crux::vector3<int>;
+using vec3f = crux::vector3<float>;
+
+using vec4u = crux::vector4<uint>;
+using vec4i = crux::vector4<int>;
+using vec4f = crux::vector4<float>;
+
+using mat3f = crux::matrix3x3<float>;
+using mat4f = crux::matrix4x4<float>;
+
+using quatf = crux::quaternion<float>;
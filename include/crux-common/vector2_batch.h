@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+ * Batch kernels running over spans of vec2f.
+ * These process several vectors per SIMD register, and should be prefered
+ * over looping the vector2 operators when working on large arrays.
+ */
+
+#include <cstddef>
+
+#include "types.h"
+#include "span.h"
+
+namespace crux::batch {
+	/**
+	 * @brief Component-wise addition, out[i] = lhs[i] + rhs[i].
+	 * Only the shortest of the given spans worth of elements are processed.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Add(span<const vec2f> lhs, span<const vec2f> rhs, span<vec2f> out);
+
+	/**
+	 * @brief Component-wise multiplication, out[i] = lhs[i] * rhs[i].
+	 * Only the shortest of the given spans worth of elements are processed.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Mul(span<const vec2f> lhs, span<const vec2f> rhs, span<vec2f> out);
+
+	/**
+	 * @brief Uniform scale, out[i] = in[i] * scalar.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Mul(span<const vec2f> in, float scalar, span<vec2f> out);
+
+	/**
+	 * @brief Linear interpolation, out[i] = from[i] + (to[i] - from[i]) * t.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Lerp(span<const vec2f> from, span<const vec2f> to, float t, span<vec2f> out);
+
+	/**
+	 * @brief Dot product of each pair, out[i] = lhs[i].x * rhs[i].x + lhs[i].y * rhs[i].y.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Dot(span<const vec2f> lhs, span<const vec2f> rhs, span<float> out);
+
+	/**
+	 * @brief Euclidean length of each vector.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Length(span<const vec2f> in, span<float> out);
+
+	/**
+	 * @brief Scales each vector to unit length.
+	 * Zero-length vectors are written out as zero instead of NaN.
+	 * The output may alias the input.
+	 * @return Number of elements written to out
+	*/
+	std::size_t Normalize(span<const vec2f> in, span<vec2f> out);
+}
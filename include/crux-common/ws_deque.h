@@ -0,0 +1,135 @@
+#pragma once
+
+/*
+ * Bounded Chase-Lev work-stealing deque.
+ * The owning thread pushes and pops at the bottom like a stack, any
+ * number of other threads steal from the top. Only a pop racing a steal
+ * for the very last element costs a compare-exchange.
+ * Memory orderings follow Le, Pop, Cohen and Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (2013).
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace crux {
+	/**
+	 * @brief Bounded lock-free work-stealing deque.
+	 *
+	 * The capacity is fixed and rounded up to a power of two, a full deque
+	 * rejects pushes rather than growing so the owner never reallocates
+	 * under the thieves.
+	 * @tparam T Element type, must be trivially copyable and lock-free as an atomic (ie. a pointer)
+	*/
+	template<typename T>
+	class ws_deque {
+		static_assert(std::is_trivially_copyable<T>::value, "ws_deque elements must be trivially copyable");
+
+	public:
+		// Assumed size of a cache line, used to keep the indices from false sharing
+		static constexpr std::size_t CacheLine = 64;
+
+		/**
+		 * @brief Construct a deque holding at least the given number of elements.
+		 * @param minCapacity Requested capacity, rounded up to a power of two (minimum 2)
+		*/
+		explicit ws_deque(std::size_t minCapacity) {
+			std::size_t cap = 2;
+			while (cap < minCapacity)
+				cap <<= 1;
+			mask = (std::int64_t)cap - 1;
+			buffer = std::make_unique<std::atomic<T>[]>(cap);
+		}
+
+		ws_deque(const ws_deque&) = delete;
+		ws_deque& operator=(const ws_deque&) = delete;
+
+		/**
+		 * @brief Owner side, adds an element at the bottom.
+		 * @return False if the deque is full, the element is not added
+		*/
+		bool push(T value) {
+			const std::int64_t b = bottom.load(std::memory_order_relaxed);
+			const std::int64_t t = top.load(std::memory_order_acquire);
+			if (b - t > mask)
+				return false;
+
+			buffer[b & mask].store(value, std::memory_order_relaxed);
+
+			//Release publishes the element, and whatever it points to, to the thieves
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Owner side, removes the most recently pushed element.
+		 * @return False if the deque is empty or a thief took the last element
+		*/
+		bool pop(T& out) {
+			const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				//Empty, restore
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			out = buffer[b & mask].load(std::memory_order_relaxed);
+			if (t == b) {
+				//Last element, race the thieves for it
+				const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+			return true;
+		}
+
+		/**
+		 * @brief Thief side, removes the oldest element. Safe from any thread.
+		 * @return False if the deque is empty or another thread won the element
+		*/
+		bool steal(T& out) {
+			std::int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return false;
+
+			T value = buffer[t & mask].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return false;
+
+			out = value;
+			return true;
+		}
+
+		// @return Approximate element count, may be stale by the time it returns
+		std::size_t size_approx() const {
+			const std::int64_t b = bottom.load(std::memory_order_relaxed);
+			const std::int64_t t = top.load(std::memory_order_relaxed);
+			return b > t ? (std::size_t)(b - t) : 0;
+		}
+
+		// @return True if the deque looked empty at the time of the call
+		bool empty() const { return size_approx() == 0; }
+
+		// @return Maximum number of elements the deque can hold
+		std::size_t capacity() const { return (std::size_t)mask + 1; }
+
+	private:
+		std::unique_ptr<std::atomic<T>[]> buffer;
+		std::int64_t mask = 0;
+
+		//Thieves advance the top
+		alignas(CacheLine) std::atomic<std::int64_t> top{ 0 };
+
+		//Owner moves the bottom
+		alignas(CacheLine) std::atomic<std::int64_t> bottom{ 0 };
+	};
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+/*
+ * Tile based software rasterizer drawing into a Framebuffer, ie. the one
+ * behind Window::GetFramebuffer().
+ *
+ * Triangles are set up and binned into TileSize x TileSize screen tiles as
+ * they are submitted, then End() rasterizes every tile on its own job. A tile
+ * is only ever touched by one thread, and its triangles are drawn in
+ * submission order, so blending gives the same image for any worker count.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <crux-common/types.h>
+#include <crux-common/span.h>
+#include <crux-common/jobs.h>
+#include <crux-window/framebuffer.h>
+
+namespace crux::render {
+	namespace internal {
+		struct Chunk;
+	}
+
+	/**
+	 * @brief Packs 8bit channels into a vertex color.
+	 * Vertex colors are always RGBA8 with straight (not premultiplied) alpha,
+	 * the rasterizer converts them to the target's format.
+	*/
+	constexpr uint32bit Rgba(uint8bit r, uint8bit g, uint8bit b, uint8bit a = 255) {
+		return (uint32bit)r | ((uint32bit)g << 8) | ((uint32bit)b << 16) | ((uint32bit)a << 24);
+	}
+
+	/**
+	 * @brief A triangle corner in pixel coordinates, origin at the top-left
+	 * corner of the framebuffer. Pixel centers sit on the half-pixel.
+	*/
+	struct Vertex {
+		vec2f position{ 0.0f, 0.0f };
+
+		// RGBA8, see Rgba(). Interpolated across the triangle when the corners differ
+		uint32bit color = 0xFFFFFFFFu;
+	};
+
+	// Counters for the current frame, reset by Begin()
+	struct RasterizerStats {
+		// Triangles submitted to DrawTriangles/DrawIndexed
+		uint64bit triangles = 0;
+
+		// Triangles dropped during setup, degenerate, off screen or outside the guard band
+		uint64bit culled = 0;
+
+		// Triangle and tile pairs binned, each one is rasterized once
+		uint64bit binned = 0;
+	};
+
+	/**
+	 * @brief Draws 2D triangles into a framebuffer with flat or gouraud
+	 * shaded color and source-over alpha blending.
+	 *
+	 * Usage is Begin(), any number of Clear/Draw calls, End(). The target
+	 * is not written until End(), which returns once every tile is done.
+	 * A Rasterizer is not itself thread-safe, one thread submits.
+	*/
+	class Rasterizer {
+	public:
+		// Tile edge in pixels, a multiple of 4 so vector blocks never straddle two tiles
+		static constexpr uint TileSize = 64;
+
+		// Vertices further than this many pixels outside the target are culled, keeps the edge math in range
+		static constexpr float GuardBand = 4096.0f;
+
+		// Sub-pixel precision, vertices snap to 1/SubPixelSteps of a pixel
+		static constexpr int SubPixelBits = 4;
+		static constexpr int SubPixelSteps = 1 << SubPixelBits;
+
+		// Triangles set up and binned per job, larger draws are split across the workers
+		static constexpr std::size_t ChunkTriangles = 4096;
+
+		/**
+		 * @brief Construct a rasterizer.
+		 * @param jobs Job system to bin and rasterize on, null runs everything on the calling thread.
+		 * It must outlive the rasterizer.
+		*/
+		explicit Rasterizer(JobSystem* jobs = nullptr);
+		~Rasterizer();
+
+		Rasterizer(const Rasterizer&) = delete;
+		Rasterizer& operator=(const Rasterizer&) = delete;
+
+		/**
+		 * @brief Starts a frame drawing into the given framebuffer.
+		 * The framebuffer must not be resized or written until End() returns.
+		*/
+		void Begin(Framebuffer& target);
+
+		/**
+		 * @brief Fills the target with a color at End(), discarding anything
+		 * drawn since Begin().
+		 * @param color RGBA8, see Rgba()
+		*/
+		void Clear(uint32bit color);
+
+		/**
+		 * @brief Draws a triangle list, every three vertices form a triangle.
+		 * Either winding is accepted. Trailing vertices are ignored.
+		*/
+		void DrawTriangles(span<const Vertex> vertices);
+
+		/**
+		 * @brief Draws an indexed triangle list, every three indices form a triangle.
+		 * Triangles with an index out of range are culled.
+		*/
+		void DrawIndexed(span<const Vertex> vertices, span<const uint32bit> indices);
+
+		// Rasterizes everything binned since Begin() into the target, and ends the frame
+		void End();
+
+		// @return Counters for the current or last frame
+		inline const RasterizerStats& GetStats() const { return stats; }
+
+		// @return The tile grid of the current target, in tiles
+		inline vec2u GetTileCount() const { return tileCount; }
+
+	private:
+		template<typename Fetch>
+		void Draw(std::size_t count, const Fetch& fetch);
+
+		internal::Chunk& AcquireChunk();
+		void RasterizeTile(uint tile);
+
+		JobSystem* jobs;
+		Framebuffer* target = nullptr;
+
+		vec2u tileCount{ 0u, 0u };
+
+		// Bins per submission chunk, rasterized in order. Kept between frames to reuse the allocations
+		std::vector<std::unique_ptr<internal::Chunk>> chunks;
+		std::size_t usedChunks = 0;
+
+		bool clear = false;
+		uint32bit clearColor = 0;
+
+		RasterizerStats stats;
+	};
+}
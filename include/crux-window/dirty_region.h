@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * Rectangles of changed pixels, collected between presents so only the parts
+ * of a framebuffer that changed are copied or blitted to the screen.
+ */
+
+#include <algorithm>
+#include <cstddef>
+
+#include <crux-common/types.h>
+#include <crux-common/span.h>
+
+namespace crux {
+	/**
+	 * @brief Axis aligned rectangle of pixels, min inclusive and max exclusive.
+	*/
+	struct PixelRect {
+		// Top-left corner, the first pixel inside
+		vec2i min{ 0, 0 };
+
+		// Bottom-right corner, the first pixel past the right and bottom edges
+		vec2i max{ 0, 0 };
+
+		constexpr PixelRect() = default;
+		constexpr PixelRect(const vec2i& min, const vec2i& max) : min(min), max(max) {}
+
+		// @return Rectangle at (x, y) of the given size
+		static constexpr PixelRect FromSize(int x, int y, uint width, uint height) {
+			return PixelRect(vec2i(x, y), vec2i(x + (int)width, y + (int)height));
+		}
+
+		inline constexpr int GetWidth() const { return max.x > min.x ? max.x - min.x : 0; }
+		inline constexpr int GetHeight() const { return max.y > min.y ? max.y - min.y : 0; }
+		inline constexpr uint64bit GetArea() const { return (uint64bit)GetWidth() * (uint64bit)GetHeight(); }
+
+		// @return True if no pixel is inside
+		inline constexpr bool IsEmpty() const { return max.x <= min.x || max.y <= min.y; }
+
+		// @return True if every pixel of other is inside this rectangle
+		inline constexpr bool Contains(const PixelRect& other) const {
+			return other.min.x >= min.x && other.min.y >= min.y && other.max.x <= max.x && other.max.y <= max.y;
+		}
+
+		// @return True if the rectangles share at least one pixel
+		inline constexpr bool Overlaps(const PixelRect& other) const {
+			return other.min.x < max.x && other.max.x > min.x && other.min.y < max.y && other.max.y > min.y;
+		}
+
+		// @return The pixels inside both, empty if they do not overlap
+		inline constexpr PixelRect Intersect(const PixelRect& other) const {
+			return PixelRect(
+				vec2i(std::max(min.x, other.min.x), std::max(min.y, other.min.y)),
+				vec2i(std::min(max.x, other.max.x), std::min(max.y, other.max.y)));
+		}
+
+		// @return The smallest rectangle holding both
+		inline constexpr PixelRect Union(const PixelRect& other) const {
+			return PixelRect(
+				vec2i(std::min(min.x, other.min.x), std::min(min.y, other.min.y)),
+				vec2i(std::max(max.x, other.max.x), std::max(max.y, other.max.y)));
+		}
+	};
+
+	/**
+	 * @brief The changed parts of a framebuffer as a short list of disjoint rectangles.
+	 *
+	 * Overlapping rectangles are merged into their union, and so are neighbours
+	 * whose union costs no more pixels than the two apart. Past MaxRects the pair
+	 * whose union adds the fewest pixels is merged, bounding the per-present call
+	 * count. Storage is inline, adding never allocates.
+	*/
+	class DirtyRegion {
+	public:
+		// Rectangles kept before merging to stay under, each one is a separate copy or blit on present
+		static constexpr std::size_t MaxRects = 16;
+
+		/**
+		 * @brief Adds a changed rectangle, merging it with the ones held.
+		 * Empty rectangles are ignored.
+		*/
+		void Add(const PixelRect& rect);
+
+		// Forgets every rectangle
+		inline void Clear() { count = 0; }
+
+		// @return True if nothing is marked
+		inline bool IsEmpty() const { return count == 0; }
+
+		// @return The disjoint rectangles, in no particular order
+		inline span<const PixelRect> GetRects() const { return span<const PixelRect>(rects, count); }
+
+		// @return Pixels covered, each one counted once
+		uint64bit GetArea() const;
+
+		// @return The smallest rectangle holding every marked pixel, empty if nothing is marked
+		PixelRect GetBounds() const;
+
+	private:
+		void Remove(std::size_t index);
+
+		// One spare, a new rectangle lands there before the closest pair is merged
+		PixelRect rects[MaxRects + 1];
+		std::size_t count = 0;
+	};
+}
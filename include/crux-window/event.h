@@ -0,0 +1,163 @@
+#pragma once
+
+/*
+ * Typed window events, produced by the platform message handling and
+ * drained in batches through Window::PollEvents.
+ * Events are plain trivially copyable values so they can travel through
+ * a lock-free ring buffer without allocation.
+ */
+
+#include <crux-common/types.h>
+
+namespace crux {
+	/**
+	 * @brief Discriminator of the Event union.
+	*/
+	enum class EventType : uint8bit {
+		NONE = 0,
+
+		// The user or OS asked for the window to close, see Window::WantsToClose
+		CLOSE,
+
+		// The client area changed size, see Event::size
+		RESIZE,
+
+		// The window moved on screen, see Event::position
+		MOVE,
+
+		// The window gained keyboard focus
+		FOCUS_GAINED,
+
+		// The window lost keyboard focus
+		FOCUS_LOST,
+
+		// A key was pressed or auto-repeated, see Event::key
+		KEY_DOWN,
+
+		// A key was released, see Event::key
+		KEY_UP,
+
+		// The cursor moved within the client area, see Event::mouseMove
+		MOUSE_MOVE,
+
+		// A mouse button was pressed, see Event::mouseButton
+		MOUSE_DOWN,
+
+		// A mouse button was released, see Event::mouseButton
+		MOUSE_UP,
+
+		// The wheel was scrolled, see Event::mouseWheel
+		MOUSE_WHEEL,
+	};
+
+	/**
+	 * @brief Platform independant key identifiers.
+	 * Keys without a mapping are reported as UNKNOWN, with the
+	 * platform code still available in KeyEvent::scancode.
+	*/
+	enum class Key : uint16bit {
+		UNKNOWN = 0,
+
+		A, B, C, D, E, F, G, H, I, J, K, L, M,
+		N, O, P, Q, R, S, T, U, V, W, X, Y, Z,
+
+		NUM_0, NUM_1, NUM_2, NUM_3, NUM_4, NUM_5, NUM_6, NUM_7, NUM_8, NUM_9,
+
+		F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12,
+
+		ESCAPE, ENTER, TAB, BACKSPACE, SPACE,
+		INSERT, DEL, HOME, END, PAGE_UP, PAGE_DOWN,
+		LEFT, RIGHT, UP, DOWN,
+
+		LEFT_SHIFT, RIGHT_SHIFT, LEFT_CONTROL, RIGHT_CONTROL, LEFT_ALT, RIGHT_ALT,
+	};
+
+	/**
+	 * @brief Mouse buttons.
+	*/
+	enum class MouseButton : uint8bit {
+		LEFT = 0,
+		RIGHT,
+		MIDDLE,
+		X1,
+		X2,
+	};
+
+	/**
+	 * @brief Modifier keys held during an input event, as bit flags.
+	*/
+	enum KeyModifier : uint8bit {
+		KEYMOD_SHIFT = BIT(0),
+		KEYMOD_CONTROL = BIT(1),
+		KEYMOD_ALT = BIT(2),
+		KEYMOD_SUPER = BIT(3),
+	};
+
+	// Payload of EventType::RESIZE, the new client size in pixels
+	struct SizeEvent {
+		uint width;
+		uint height;
+	};
+
+	// Payload of EventType::MOVE, the new screen position in pixels
+	struct PositionEvent {
+		int x;
+		int y;
+	};
+
+	// Payload of EventType::KEY_DOWN and EventType::KEY_UP
+	struct KeyEvent {
+		Key key;
+
+		// Platform specific key code (Win32 virtual-key, X11 keycode)
+		uint32bit scancode;
+
+		// KeyModifier flags
+		uint8bit modifiers;
+
+		// True when generated by auto-repeat while held down
+		bool repeat;
+	};
+
+	// Payload of EventType::MOUSE_MOVE, the cursor position in client pixels
+	struct MouseMoveEvent {
+		int x;
+		int y;
+	};
+
+	// Payload of EventType::MOUSE_DOWN and EventType::MOUSE_UP
+	struct MouseButtonEvent {
+		MouseButton button;
+
+		// KeyModifier flags
+		uint8bit modifiers;
+
+		// Cursor position in client pixels
+		int x;
+		int y;
+	};
+
+	// Payload of EventType::MOUSE_WHEEL, in notches where one notch is 1.0
+	struct MouseWheelEvent {
+		float deltaX;
+		float deltaY;
+	};
+
+	/**
+	 * @brief A single window event, the payload to read depends on the type.
+	*/
+	struct Event {
+		EventType type = EventType::NONE;
+
+		union {
+			SizeEvent size;
+			PositionEvent position;
+			KeyEvent key;
+			MouseMoveEvent mouseMove;
+			MouseButtonEvent mouseButton;
+			MouseWheelEvent mouseWheel;
+		};
+
+		Event() : size{ 0, 0 } {}
+	};
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+/*
+ * Multi-buffered presentation of software rendered frames.
+ * The render thread draws into one of the swapchain's own framebuffers
+ * while earlier frames wait for, or are in the middle of, being copied to
+ * the window and presented, so drawing and presenting overlap.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <crux-common/types.h>
+#include <crux-common/optional.h>
+
+#include "framebuffer.h"
+#include "window.h"
+
+namespace crux {
+	/**
+	 * @brief How queued frames reach the window.
+	*/
+	enum class PresentMode {
+		// Swapchain::Present shows the frame right away on the calling thread, without queueing or pacing
+		IMMEDIATE = 0,
+
+		// Every frame is shown, in order, one per refresh period. Acquire blocks while all buffers are queued
+		FIFO,
+
+		// Only the newest queued frame is shown, a newer one replaces it while it waits. Acquire does not block with 3 buffers
+		MAILBOX,
+	};
+
+	/**
+	 * @brief Creation parameters of a Swapchain.
+	*/
+	struct SwapchainProperties {
+		// Number of buffers, 2 for double and 3 for triple buffering. Clamped to [2, Swapchain::MaxBuffers]
+		uint bufferCount = 3;
+
+		// How queued frames are shown
+		PresentMode mode = PresentMode::MAILBOX;
+
+		// Frames per second the present thread shows at most, 0 presents as soon as a frame is queued.
+		// Ignored by PresentMode::IMMEDIATE and by PresentQueued
+		double refreshRate = 60.0;
+
+		// When true, queued frames are presented by a thread owned by the swapchain.
+		// Otherwise the thread presenting the window calls Swapchain::PresentQueued.
+		// Ignored by PresentMode::IMMEDIATE
+		bool presentThread = true;
+	};
+
+	// Counters since creation
+	struct SwapchainStats {
+		// Frames copied to the window and presented
+		uint64 presented = 0;
+
+		// Frames never shown, replaced in the mailbox or drawn at a size the window no longer has
+		uint64 dropped = 0;
+	};
+
+	class Swapchain;
+
+	/**
+	 * @brief Smart-pointer for a swapchain.
+	*/
+	typedef std::unique_ptr<Swapchain> SwapchainPtr;
+
+	/**
+	 * @brief N-buffered CPU surfaces bound to a window.
+	 *
+	 * The render thread calls Acquire(), draws the whole frame into the
+	 * returned framebuffer, then Present() to queue it. Presenting copies
+	 * the frame into Window::GetFramebuffer() and calls Window::Present(),
+	 * and the buffer is free to be acquired again as soon as it is copied.
+	 *
+	 * Whichever thread presents becomes the thread drawing and presenting
+	 * the window, the only one allowed to touch its framebuffer. A present
+	 * thread therefore needs a window with a threaded message pump, or a
+	 * headless window which is not resized while the swapchain lives.
+	*/
+	class Swapchain {
+	public:
+		// Most buffers a swapchain holds
+		static constexpr uint MaxBuffers = 4;
+
+		/**
+		 * @brief Factory function to create a new Swapchain.
+		 * Must be called from the thread owning the window.
+		 * @param[in] window Window to present to, kept alive by the swapchain
+		 * @param[in] props Buffer count, present mode and pacing
+		 * @return A crux::optional resulting in the swapchain, empty if the window has no
+		 * framebuffer or cannot be presented from a present thread
+		*/
+		static crux::optional<SwapchainPtr> Create(WinPtr window, const SwapchainProperties& props);
+
+		/**
+		 * @brief Stops the present thread, frames still queued are dropped.
+		 * Must not be called while another thread is inside Acquire or Present.
+		*/
+		~Swapchain();
+
+		Swapchain(const Swapchain&) = delete;
+		Swapchain& operator=(const Swapchain&) = delete;
+
+		/**
+		 * @brief Takes a free buffer to draw the next frame into.
+		 * Blocks while every buffer is queued or being copied. The buffer has the
+		 * window's current size and pixel format, and holds whatever frame it was
+		 * last used for, so it must be drawn in full. Calling Acquire again before
+		 * Present returns the same buffer.
+		 * Only one thread, the render thread, may acquire and present. Without a
+		 * present thread, the thread calling PresentQueued uses TryAcquire instead.
+		 * @return The buffer to draw into
+		*/
+		Framebuffer* Acquire();
+
+		/**
+		 * @brief Non-blocking Acquire.
+		 * @return The buffer to draw into, or nullptr if none is free
+		*/
+		Framebuffer* TryAcquire();
+
+		/**
+		 * @brief Queues the acquired buffer for presentation, or with
+		 * PresentMode::IMMEDIATE presents it before returning.
+		 * @return False if no buffer was acquired, or the frame was dropped
+		*/
+		bool Present();
+
+		/**
+		 * @brief Presents the next queued frame, oldest first with FIFO and newest
+		 * with MAILBOX, on the calling thread. For swapchains without a present
+		 * thread, called once per loop by the thread presenting the window.
+		 * Does not wait for a frame nor pace, the caller's loop does.
+		 * @return True if a frame was presented
+		*/
+		bool PresentQueued();
+
+		// @return Frames presented and dropped since creation
+		SwapchainStats GetStats() const;
+
+		// @return Number of buffers in the chain
+		inline uint GetBufferCount() const { return bufferCount; }
+
+		// @return How queued frames are shown
+		inline PresentMode GetPresentMode() const { return mode; }
+
+		// @return The window presented to
+		inline const WinPtr& GetWindow() const { return window; }
+
+	private:
+		Swapchain(WinPtr window, const SwapchainProperties& props, PixelFormat format);
+
+		// Prepares a free buffer for the render thread, called without the lock held
+		Framebuffer* TakeBuffer(uint index);
+
+		// Copies a buffer into the window, frees it, then presents the window
+		bool PresentBuffer(uint index);
+
+		// Puts a buffer back on the free list and wakes Acquire, called with the lock held
+		void Release(uint index);
+
+		// Takes the oldest queued frame, called with the lock held and a frame queued
+		uint PopQueued();
+
+		// Body of the present thread, presents queued frames paced to the refresh rate
+		void PresentLoop(double refreshRate);
+
+		WinPtr window;
+		PresentMode mode;
+		uint bufferCount;
+
+		Framebuffer buffers[MaxBuffers];
+
+		// Buffer held by the render thread, -1 when none. Only touched by the render thread
+		int acquired = -1;
+
+		// Buffers nobody draws into nor waits to present, guarded by lock
+		uint freeList[MaxBuffers];
+		uint freeCount = 0;
+
+		// Buffers waiting to be presented, oldest first, guarded by lock
+		uint queue[MaxBuffers];
+		uint queueCount = 0;
+
+		bool stopping = false;
+
+		mutable std::mutex lock;
+
+		// Signalled when a buffer is freed
+		std::condition_variable bufferFreed;
+
+		// Signalled when a frame is queued, or the swapchain stops
+		std::condition_variable frameQueued;
+
+		std::atomic<uint64> presented{ 0 };
+		std::atomic<uint64> dropped{ 0 };
+
+		// Presents queued frames, when SwapchainProperties::presentThread is used
+		std::thread presentThread;
+	};
+}
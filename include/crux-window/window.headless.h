@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+
+#include "window.h"
+
+namespace crux {
+	/**
+	 * @brief Offscreen window backed only by CPU-side framebuffers.
+	 *
+	 * Has no display-server dependency, so render loops can run in CI or on
+	 * machines without a GPU. Present() swaps the back buffer into a front
+	 * buffer held in memory, which can be inspected or dumped to PPM files.
+	 * With a dirty region only the marked rectangles are copied over instead.
+	 * Created by Window::Create when WindowProperties::headless is set.
+	*/
+	class WindowHeadless : public Window {
+	public:
+		WindowHeadless(const WindowProperties& props);
+		virtual ~WindowHeadless() = default;
+
+		virtual void SetTitle(const string& newTitle) override;
+		virtual void SetPosition(const vec2i& pos) override;
+		virtual void SetSize(const vec2u& size) override;
+
+		virtual WindowProperties GetProperties() override;
+
+		virtual Framebuffer* GetFramebuffer() override { return &backBuffer; }
+		virtual bool Present() override;
+
+		/**
+		 * @brief Returns the most recently presented frame.
+		 * Empty until the first Present().
+		 * @return Framebuffer holding the presented pixels
+		*/
+		inline const Framebuffer& GetPresented() const { return frontBuffer; }
+
+		// @return Number of frames presented since creation
+		inline uint64 GetPresentCount() const { return presentCount; }
+
+		/**
+		 * @brief Dumps every presented frame to a PPM file.
+		 * The pattern is a printf format receiving the frame index as an
+		 * unsigned long long, ie. "frame_%05llu.ppm". Empty disables dumping.
+		 * @param pattern File path pattern
+		*/
+		void SetFrameDumpPattern(const std::string& pattern) { dumpPattern = pattern; }
+
+		/**
+		 * @brief Queues an event as if it came from the OS, ie. scripted input in tests.
+		 * Must be called from the thread calling PollEvents.
+		 * @return False if the queue was full and the event was dropped
+		*/
+		bool InjectEvent(const Event& event);
+
+	protected:
+		virtual void ApplyCommand(const WindowCommand& command, const string& newTitle) override;
+
+	private:
+		Framebuffer backBuffer;
+		Framebuffer frontBuffer;
+
+		uint64 presentCount = 0;
+		std::string dumpPattern;
+	};
+}
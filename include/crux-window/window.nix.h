@@ -0,0 +1,93 @@
+#pragma once
+#if CRUX_UNIX
+
+#include <memory>
+#include <vector>
+
+#include "window.h"
+#include "window_manager.h"
+
+namespace crux::internal::nix {
+	/**
+	 * @brief X11 implementation of the Window interface.
+	 *
+	 * Software rendered frames are presented through MIT-SHM, the framebuffer
+	 * returned by GetFramebuffer() lives directly in a shared memory segment
+	 * so presenting never copies pixels over the socket. Two segments are
+	 * used so drawing the next frame overlaps the server reading the last.
+	 * Falls back to XPutImage when the display is remote or lacks MIT-SHM.
+	 *
+	 * The windows a thread creates share one X connection, pumping any of
+	 * them reads the events of all and hands each to its own window.
+	 * With WindowProperties::threadedMessagePump the window gets a connection
+	 * of its own, a message thread waits on it and setters are queued to it.
+	 *
+	 * Xlib is kept out of this header, the X11 objects live in the source file.
+	*/
+	class WindowX11 : public Window {
+		friend class Window;
+	public:
+		WindowX11(const WindowProperties& props);
+		virtual ~WindowX11();
+
+		virtual void SetTitle(const string& newTitle) override;
+		virtual void SetPosition(const vec2i& pos) override;
+		virtual void SetSize(const vec2u& size) override;
+		virtual void SetWantsToClose(bool close) override;
+
+		/**
+		 * @brief Returns a pointer to the X11 window XID (an unsigned long),
+		 * or nothing if the display could not be opened.
+		*/
+		virtual optional<void*> GetPlatformHandle() override;
+
+		virtual Framebuffer* GetFramebuffer() override;
+		virtual bool Present() override;
+
+		// @return The Xlib Display* connection, or nullptr if not opened
+		void* GetDisplay() const;
+
+		// @return True if frames are presented through MIT-SHM
+		bool IsSharedMemory() const;
+
+		/**
+		 * @brief Pumps the messages of several windows in one pass, see WindowManager::PollEvents.
+		 * One poll() covers every display connection, each read once if it has input.
+		 * @param windows WindowX11 objects without a message thread
+		*/
+		static void PumpAll(span<Window* const> windows);
+
+		/**
+		 * @brief Enumerates monitors through XRandR, loading libXrandr at runtime,
+		 * or one per X screen when it is missing.
+		*/
+		static std::vector<MonitorInfo> EnumerateMonitors();
+
+	protected:
+		virtual void PumpMessages() override;
+		virtual void ApplyCommand(const WindowCommand& command, const string& newTitle) override;
+		virtual void WakeMessageThread() override;
+
+	private:
+		struct State;
+
+		// Body of the message thread, waits on the X connection and the wake eventfd
+		void MessageLoop();
+
+		void HandleEvent(const void* xevent);
+
+		void CreateSurfaces(const vec2u& clientSize);
+		void DestroySurfaces();
+		void EnsureSurfaces();
+		void WaitForSurface(int index);
+
+		std::unique_ptr<State> state;
+
+		// XID of the window, 0 when creation failed
+		unsigned long handle = 0;
+
+		Framebuffer framebuffer{ PixelFormat::BGRA8 };
+	};
+}
+
+#endif //CRUX_UNIX
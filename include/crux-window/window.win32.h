@@ -6,29 +6,76 @@
 #endif
 #include <windows.h>
 
+#include <future>
+#include <vector>
+
 #include "window.h"
+#include "window_manager.h"
 
 namespace crux::internal::win32{
 	class WindowWin32 : public Window {
 		friend class Window;
 	public:
 		WindowWin32(const WindowProperties& props);
-		virtual ~WindowWin32() = default;
+		virtual ~WindowWin32();
 
 		virtual void SetTitle(const string& newTitle) override;
 		virtual void SetPosition(const vec2i& pos) override;
 		virtual void SetSize(const vec2u& size) override;
 		virtual void SetWantsToClose(bool close) override;
 
-		virtual optional<void*> GetPlatformHandle() { return { &handle }; }
+		virtual optional<void*> GetPlatformHandle() override;
+
+		virtual Framebuffer* GetFramebuffer() override;
+		virtual bool Present() override;
+
+		/**
+		 * @brief Pumps the messages of several windows in one pass, see WindowManager::PollEvents.
+		 * The message loop of a thread serves every window it created, so a single loop runs.
+		 * @param windows WindowWin32 objects without a message thread, created on the calling thread
+		*/
+		static void PumpAll(span<Window* const> windows);
+
+		/**
+		 * @brief Enumerates monitors with EnumDisplayMonitors. The DPI comes from
+		 * GetDpiForMonitor where shcore.dll has it (Windows 8.1 and later), and is
+		 * only per monitor in a per-monitor DPI aware process.
+		*/
+		static std::vector<MonitorInfo> EnumerateMonitors();
 
 	protected:
+		virtual void PumpMessages() override;
+		virtual void ApplyCommand(const WindowCommand& command, const string& newTitle) override;
+		virtual void WakeMessageThread() override;
+
 		LRESULT CALLBACK MessageHandler(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
 		void WindowPaint(HWND handle);
 
 	private:
+		// Registered window procedure, forwards to the owning instance's MessageHandler
+		static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+
+		// Creates the HWND on the calling thread, which then owns its messages
+		bool CreateNativeWindow(const WindowProperties& props);
+
+		// Body of the message thread, creates the window then blocks in GetMessage until WM_QUIT
+		void MessageLoop(const WindowProperties& props, std::promise<bool>& created);
+
+		// Blits a rectangle of the framebuffer to the same place in the client area
+		void Blit(HDC dc, const PixelRect& rect);
+
+		// Pushes a key event translated from WM_KEYDOWN/WM_KEYUP and friends
+		void PushKeyEvent(EventType type, WPARAM wparam, LPARAM lparam);
+
+		// Pushes a mouse button event from the client coordinates in lparam
+		void PushMouseButtonEvent(EventType type, MouseButton button, LPARAM lparam);
+
 		HWND handle;
+
+		// Software rendered frame, blitted to the client area on Present and WM_PAINT.
+		// Only touched by the owning thread, and lazily resized by it to the window size
+		Framebuffer framebuffer{ PixelFormat::BGRA8 };
 	};
 }
 
-#endif //CRUX_WIN32
\ No newline at end of file
+#endif //CRUX_WIN32
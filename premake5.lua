@@ -1,24 +1,66 @@
+newoption {
+    trigger = "track-allocations",
+    description = "Count every heap allocation, see crux-common/include/memory_tracking.h"
+}
+
+newoption {
+    trigger = "profile",
+    description = "Record CRUX_PROFILE_SCOPE zones, see crux-common/include/profile.h"
+}
+
 workspace "crux"
     configurations { "debug", "release" }
     architecture "x86_64"
 
     flags { "MultiProcessorCompile" }
 
-    defines {
-        "CRUX_PLATFORM=\"None\"",
-        "CRUX_WIN32=0",
-        "CRUX_UNIX=0",
-        "CRUX_MAC=0",
-    }
-
     filter "system:windows"
         systemversion "latest"
 
         defines {
             "CRUX_PLATFORM=\"Win32\"",
-            "CRUX_WIN32=1"
+            "CRUX_WIN32=1",
+            "CRUX_UNIX=0",
+            "CRUX_MAC=0",
+        }
+
+    filter "system:linux"
+        defines {
+            "CRUX_PLATFORM=\"Linux\"",
+            "CRUX_WIN32=0",
+            "CRUX_UNIX=1",
+            "CRUX_MAC=0",
+        }
+
+    filter { "system:not windows", "system:not linux" }
+        defines {
+            "CRUX_PLATFORM=\"None\"",
+            "CRUX_WIN32=0",
+            "CRUX_UNIX=0",
+            "CRUX_MAC=0",
         }
 
+    -- MSVC reports __cplusplus as 199711L unless asked, optional.h and friends check it
+    filter "action:vs*"
+        buildoptions { "/Zc:__cplusplus" }
+
+    filter "options:track-allocations"
+        defines { "CRUX_TRACK_ALLOCATIONS=1" }
+
+    filter "options:profile"
+        defines { "CRUX_PROFILE=1" }
+
+    filter "configurations:debug"
+        defines { "CRUX_DEBUG=1" }
+        symbols "On"
+        optimize "Off"
+
+    -- "Speed" maps to /O2 on MSVC and -O3 on gcc/clang
+    filter "configurations:release"
+        defines { "NDEBUG" }
+        optimize "Speed"
+        flags { "LinkTimeOptimization" }
+
     filter ""
 
 RootDir = "%{wks.location}"
@@ -27,4 +69,6 @@ TmpDir = (RootDir.. "/tmp/%{cfg.architecture}/%{cfg.buildcfg}")
 
 include "crux-common"
 include "crux-window"
-include "crux-example"
\ No newline at end of file
+include "crux-render-sw"
+include "crux-example"
+include "crux-bench"